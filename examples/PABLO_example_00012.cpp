@@ -0,0 +1,216 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <chrono>
+#include <random>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+// =================================================================================== //
+/*!
+    \example PABLO_example_00012.cpp
+
+    \brief Benchmark of the evaluation of Morton numbers in PABLO
+
+    This example measures the time needed to encode and decode Morton numbers
+    using the different implementations available in PABLO:
+    - the "magic bits" algorithm, evaluated one point at a time;
+    - the BMI2 instructions (PDEP/PEXT), evaluated one point at a time (only
+      if the processor supports them);
+    - the batched functions, that process arrays of coordinates.
+
+    <b>To run</b>: ./PABLO_example_00012 \n
+*/
+// =================================================================================== //
+
+/**
+ * Measure the time needed to run the specified kernel.
+ *
+ * \param name is the name of the kernel
+ * \param nRepetitions is the number of times the kernel will be run
+ * \param nPoints is the number of points processed by the kernel
+ * \param kernel is the kernel
+ * \param checksum is the checksum of the results evaluated by the kernel, it
+ * is printed to avoid the compiler to optimize out the kernel
+ */
+template<typename Kernel>
+void benchmark(const std::string &name, int nRepetitions, std::size_t nPoints, Kernel kernel)
+{
+    uint64_t checksum = 0;
+
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    for (int n = 0; n < nRepetitions; ++n) {
+        checksum += kernel();
+    }
+    std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+
+    double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+    double timePerPoint = elapsed / (nRepetitions * nPoints);
+
+    log::cout() << "  " << name << " : " << timePerPoint << " ns/point (checksum " << checksum << ")" << std::endl;
+}
+
+/**
+ * Run the example.
+ */
+void run()
+{
+    const int N_REPETITIONS = 20;
+    const std::size_t N_POINTS = 1 << 20;
+
+    log::cout() << "BMI2 instructions enabled: " << PABLO::isMortonBMI2Enabled() << std::endl;
+
+    // Generate random coordinates
+    uint32_t maxCoordinate = (uint32_t(1) << PABLO::computeMaximumLevel(3)) - 1;
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<uint32_t> distribution(0, maxCoordinate);
+
+    std::vector<uint32_t> x(N_POINTS);
+    std::vector<uint32_t> y(N_POINTS);
+    std::vector<uint32_t> z(N_POINTS);
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        x[i] = distribution(generator);
+        y[i] = distribution(generator);
+        z[i] = distribution(generator);
+    }
+
+    std::vector<uint64_t> mortons(N_POINTS);
+
+    // Encoding
+    log::cout() << "3D Morton encoding" << std::endl;
+
+    benchmark("Magic bits", N_REPETITIONS, N_POINTS, [&]() {
+        for (std::size_t i = 0; i < N_POINTS; ++i) {
+            mortons[i] = PABLO::computeMorton3DMagicBits(x[i], y[i], z[i]);
+        }
+        return mortons[N_POINTS - 1];
+    });
+
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (PABLO::isMortonBMI2Enabled()) {
+        benchmark("BMI2      ", N_REPETITIONS, N_POINTS, [&]() {
+            for (std::size_t i = 0; i < N_POINTS; ++i) {
+                mortons[i] = PABLO::computeMorton3DBMI2(x[i], y[i], z[i]);
+            }
+            return mortons[N_POINTS - 1];
+        });
+    }
+#endif
+
+    benchmark("Dispatched", N_REPETITIONS, N_POINTS, [&]() {
+        for (std::size_t i = 0; i < N_POINTS; ++i) {
+            mortons[i] = PABLO::computeMorton3D(x[i], y[i], z[i]);
+        }
+        return mortons[N_POINTS - 1];
+    });
+
+    benchmark("Batch     ", N_REPETITIONS, N_POINTS, [&]() {
+        PABLO::computeMorton3D(N_POINTS, x.data(), y.data(), z.data(), mortons.data());
+        return mortons[N_POINTS - 1];
+    });
+
+    // Decoding
+    log::cout() << "3D Morton decoding" << std::endl;
+
+    benchmark("Magic bits", N_REPETITIONS, N_POINTS, [&]() {
+        for (std::size_t i = 0; i < N_POINTS; ++i) {
+            x[i] = PABLO::getThirdBitsMagicBits(mortons[i]);
+            y[i] = PABLO::getThirdBitsMagicBits(mortons[i] >> 1);
+            z[i] = PABLO::getThirdBitsMagicBits(mortons[i] >> 2);
+        }
+        return uint64_t(x[N_POINTS - 1]);
+    });
+
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (PABLO::isMortonBMI2Enabled()) {
+        benchmark("BMI2      ", N_REPETITIONS, N_POINTS, [&]() {
+            for (std::size_t i = 0; i < N_POINTS; ++i) {
+                x[i] = PABLO::getThirdBitsBMI2(mortons[i]);
+                y[i] = PABLO::getThirdBitsBMI2(mortons[i] >> 1);
+                z[i] = PABLO::getThirdBitsBMI2(mortons[i] >> 2);
+            }
+            return uint64_t(x[N_POINTS - 1]);
+        });
+    }
+#endif
+
+    benchmark("Scalar    ", N_REPETITIONS, N_POINTS, [&]() {
+        for (std::size_t i = 0; i < N_POINTS; ++i) {
+            x[i] = PABLO::computeCoordinate3D(mortons[i], 0);
+            y[i] = PABLO::computeCoordinate3D(mortons[i], 1);
+            z[i] = PABLO::computeCoordinate3D(mortons[i], 2);
+        }
+        return uint64_t(x[N_POINTS - 1]);
+    });
+
+    benchmark("Batch     ", N_REPETITIONS, N_POINTS, [&]() {
+        PABLO::computeCoordinates3D(N_POINTS, mortons.data(), x.data(), y.data(), z.data());
+        return uint64_t(x[N_POINTS - 1]);
+    });
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+
+    // Run the example
+    try {
+        run();
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,200 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+// =================================================================================== //
+// INCLUDES                                                                            //
+// =================================================================================== //
+#include "DataLBFields.hpp"
+
+#if BITPIT_ENABLE_MPI==1
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace bitpit {
+
+    // =================================================================================== //
+    // CLASS IMPLEMENTATION                                                                //
+    // =================================================================================== //
+
+    /*! Create an empty set of fields.
+     */
+    DataLBFields::DataLBFields()
+        : m_entrySize(0)
+    {
+    }
+
+    /*! Get the number of registered fields.
+     *
+     * \result The number of registered fields.
+     */
+    std::size_t DataLBFields::getFieldCount() const
+    {
+        return m_fields.size();
+    }
+
+    /*! Get the size of the data associated with a single octant.
+     *
+     * \result The size, expressed in bytes, of the data associated with a
+     * single octant over all the fields.
+     */
+    std::size_t DataLBFields::getEntrySize() const
+    {
+        return m_entrySize;
+    }
+
+    /*! Check if the sizes of the fields match the specified number of octants.
+     *
+     * \param[in] nOctants is the number of octants
+     * \result Returns true if all the fields hold exactly the data of the
+     * specified number of octants, false otherwise.
+     */
+    bool DataLBFields::isSizeValid(uint32_t nOctants) const
+    {
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            if (field->getSize() != nOctants * field->getEntrySize()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*! Check that the sizes of the fields match the specified number of
+     * octants, an exception is thrown if the size of a field doesn't match.
+     *
+     * \param[in] nOctants is the number of octants
+     */
+    void DataLBFields::validateSize(uint32_t nOctants) const
+    {
+        for (std::size_t k = 0; k < m_fields.size(); ++k) {
+            const std::unique_ptr<BaseField> &field = m_fields[k];
+            std::size_t expectedSize = nOctants * field->getEntrySize();
+            if (field->getSize() != expectedSize) {
+                throw std::runtime_error("Size of field " + std::to_string(k) + " is " + std::to_string(field->getSize()) +
+                                         " bytes, but the data of " + std::to_string(nOctants) + " octants need " +
+                                         std::to_string(expectedSize) + " bytes.");
+            }
+        }
+    }
+
+    /*! Write the data of a range of octants into the buffer.
+     *
+     * Data are written field by field, the data of the range are contiguous
+     * for each field.
+     *
+     * \param[in,out] buffer is the buffer
+     * \param[in] begin is the index of the first octant of the range
+     * \param[in] end is the index past the last octant of the range
+     */
+    void DataLBFields::gather(SendBuffer &buffer, uint32_t begin, uint32_t end) const
+    {
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            std::size_t entrySize = field->getEntrySize();
+            buffer.write(field->data() + begin * entrySize, (end - begin) * entrySize);
+        }
+    }
+
+    /*! Read the data of a range of octants from the buffer.
+     *
+     * Fields should be large enough to hold the data of the range.
+     *
+     * \param[in,out] buffer is the buffer
+     * \param[in] begin is the index of the first octant of the range
+     * \param[in] end is the index past the last octant of the range
+     */
+    void DataLBFields::scatter(RecvBuffer &buffer, uint32_t begin, uint32_t end)
+    {
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            std::size_t entrySize = field->getEntrySize();
+            buffer.read(field->data() + begin * entrySize, (end - begin) * entrySize);
+        }
+    }
+
+    /*! Move the data of a range of octants.
+     *
+     * Source and destination ranges may overlap.
+     *
+     * \param[in] from is the index of the first octant of the source range
+     * \param[in] to is the index of the first octant of the destination range
+     * \param[in] count is the number of octants to move
+     */
+    void DataLBFields::move(uint32_t from, uint32_t to, uint32_t count)
+    {
+        if (from == to || count == 0) {
+            return;
+        }
+
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            std::size_t entrySize = field->getEntrySize();
+            char *data = field->data();
+            std::memmove(data + to * entrySize, data + from * entrySize, count * entrySize);
+        }
+    }
+
+    /*! Resize the fields.
+     *
+     * \param[in] nOctants is the number of octants the fields should hold
+     */
+    void DataLBFields::resize(uint32_t nOctants)
+    {
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            field->resize(nOctants);
+        }
+    }
+
+    /*! Release the memory of the fields that is not used.
+     */
+    void DataLBFields::shrink()
+    {
+        for (const std::unique_ptr<BaseField> &field : m_fields) {
+            field->shrink();
+        }
+    }
+
+    /*! Create a field.
+     *
+     * \param[in] entrySize is the size, expressed in bytes, of the data
+     * associated with a single octant
+     */
+    DataLBFields::BaseField::BaseField(std::size_t entrySize)
+        : m_entrySize(entrySize)
+    {
+    }
+
+    /*! Get the size of the data associated with a single octant.
+     *
+     * \result The size, expressed in bytes, of the data associated with a
+     * single octant.
+     */
+    std::size_t DataLBFields::BaseField::getEntrySize() const
+    {
+        return m_entrySize;
+    }
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_PABLO_DATA_LB_FIELDS_HPP__
+#define __BITPIT_PABLO_DATA_LB_FIELDS_HPP__
+
+// =================================================================================== //
+// INCLUDES                                                                            //
+// =================================================================================== //
+#include "bitpit_common.hpp"
+
+#if BITPIT_ENABLE_MPI==1
+#include "bitpit_communications.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bitpit {
+
+    // =================================================================================== //
+    // CLASS DEFINITION                                                                    //
+    // =================================================================================== //
+
+    /*!
+     *	\ingroup		PABLO
+     *
+     *	\brief Fixed-size user data fields migrated by the load balance
+     *
+     *	This is a fast path for user data made of plain contiguous arrays with a
+     *	fixed number of components for each local octant, i.e., the data of the
+     *	i-th octant are stored starting from position i*nComponents of the
+     *	array. Data should be trivially copyable.
+     *
+     *	The fields are registered once and are then migrated together with the
+     *	octants: the data of a range of octants exchanged with a process are
+     *	copied with a single buffer write (read) for each field and octants
+     *	that remain on the process are shifted with a single memmove for each
+     *	field, no callback is invoked for the single octants. Only the data of
+     *	the internal octants are handled, fields are not resized to hold the
+     *	data of the ghosts.
+     *
+     *	Registered arrays are kept by pointer: they must outlive the load
+     *	balance and should not be replaced after registration. When the load
+     *	balance starts, each array should hold exactly the data of the local
+     *	octants, i.e., its size should be the number of local octants times
+     *	the number of components.
+     */
+    class DataLBFields {
+
+    public:
+        DataLBFields();
+
+        DataLBFields(const DataLBFields &other) = delete;
+        DataLBFields & operator=(const DataLBFields &other) = delete;
+
+        template<typename T>
+        void addField(std::vector<T> *field, std::size_t nComponents = 1);
+
+        std::size_t getFieldCount() const;
+        std::size_t getEntrySize() const;
+
+        bool isSizeValid(uint32_t nOctants) const;
+        void validateSize(uint32_t nOctants) const;
+
+        void gather(SendBuffer &buffer, uint32_t begin, uint32_t end) const;
+        void scatter(RecvBuffer &buffer, uint32_t begin, uint32_t end);
+        void move(uint32_t from, uint32_t to, uint32_t count);
+        void resize(uint32_t nOctants);
+        void shrink();
+
+    private:
+        /*!
+         * Type-erased access to a registered field.
+         */
+        class BaseField {
+
+        public:
+            virtual ~BaseField() = default;
+
+            std::size_t getEntrySize() const;
+
+            virtual char * data() = 0;
+            virtual std::size_t getSize() const = 0;
+            virtual void resize(uint32_t nOctants) = 0;
+            virtual void shrink() = 0;
+
+        protected:
+            BaseField(std::size_t entrySize);
+
+        private:
+            std::size_t m_entrySize;
+
+        };
+
+        template<typename T>
+        class Field : public BaseField {
+
+        public:
+            Field(std::vector<T> *field, std::size_t nComponents);
+
+            char * data() override;
+            std::size_t getSize() const override;
+            void resize(uint32_t nOctants) override;
+            void shrink() override;
+
+        private:
+            std::vector<T> *m_field;
+            std::size_t m_nComponents;
+
+        };
+
+        std::vector<std::unique_ptr<BaseField>> m_fields;	/**<Registered fields*/
+        std::size_t m_entrySize;							/**<Size, expressed in bytes, of the data of a single octant over all the fields*/
+
+    };
+
+}
+
+#include "DataLBFields.tpp"
+
+#endif
+
+#endif /* __BITPIT_PABLO_DATA_LB_FIELDS_HPP__ */
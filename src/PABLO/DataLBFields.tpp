@@ -0,0 +1,104 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_PABLO_DATA_LB_FIELDS_TPP__
+#define __BITPIT_PABLO_DATA_LB_FIELDS_TPP__
+
+#include <type_traits>
+
+namespace bitpit {
+
+    /*! Register a field.
+     *
+     * The array will be resized by the load balance to hold the data of the
+     * local octants of the new partition.
+     *
+     * \param[in,out] field is the array that holds the data of the local
+     * octants, the data of the i-th octant are stored starting from position
+     * i*nComponents
+     * \param[in] nComponents is the number of components associated with each
+     * octant
+     */
+    template<typename T>
+    void DataLBFields::addField(std::vector<T> *field, std::size_t nComponents)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Load balanced data should be trivially copyable");
+
+        m_fields.emplace_back(new Field<T>(field, nComponents));
+        m_entrySize += m_fields.back()->getEntrySize();
+    }
+
+    /*! Create a field.
+     *
+     * \param[in] field is the array that holds the data of the local octants
+     * \param[in] nComponents is the number of components associated with each
+     * octant
+     */
+    template<typename T>
+    DataLBFields::Field<T>::Field(std::vector<T> *field, std::size_t nComponents)
+        : BaseField(nComponents * sizeof(T)), m_field(field), m_nComponents(nComponents)
+    {
+    }
+
+    /*! Get a pointer to the raw data of the field.
+     *
+     * \result A pointer to the raw data of the field.
+     */
+    template<typename T>
+    char * DataLBFields::Field<T>::data()
+    {
+        return reinterpret_cast<char *>(m_field->data());
+    }
+
+    /*! Get the size of the field.
+     *
+     * \result The size, expressed in bytes, of the data stored in the field.
+     */
+    template<typename T>
+    std::size_t DataLBFields::Field<T>::getSize() const
+    {
+        return m_field->size() * sizeof(T);
+    }
+
+    /*! Resize the field.
+     *
+     * \param[in] nOctants is the number of octants the field should hold
+     */
+    template<typename T>
+    void DataLBFields::Field<T>::resize(uint32_t nOctants)
+    {
+        m_field->resize(nOctants * m_nComponents);
+    }
+
+    /*! Release the memory of the field that is not used.
+     */
+    template<typename T>
+    void DataLBFields::Field<T>::shrink()
+    {
+        m_field->shrink_to_fit();
+    }
+
+}
+
+#endif
@@ -26,6 +26,7 @@
 // INCLUDES                                                                            //
 // =================================================================================== //
 #include "Intersection.hpp"
+#include "LocalTree.hpp"
 
 namespace bitpit {
 
@@ -188,4 +189,95 @@ bool Intersection::getPbound() const {
 	return m_pbound;
 };
 
+// =================================================================================== //
+// CLASS IMPLEMENTATION (IntersectionIterator)
+// =================================================================================== //
+
+/*! Create an empty iterator.
+ */
+IntersectionIterator::IntersectionIterator()
+	: m_tree(nullptr), m_source(0), m_sourceEnd(0), m_position(0)
+{
+};
+
+/*! Create an iterator over the intersections owned by the specified range
+ * of octants.
+ * \param[in] tree Tree whose intersections will be iterated.
+ * \param[in] sourceBegin First octant whose intersections will be iterated.
+ * \param[in] sourceEnd Octant after the last one whose intersections will
+ * be iterated. Octants are identified by their position in the sequence made
+ * by the ghost octants followed by the internal octants.
+ */
+IntersectionIterator::IntersectionIterator(const LocalTree *tree, uint64_t sourceBegin, uint64_t sourceEnd)
+	: m_tree(tree), m_source(sourceBegin), m_sourceEnd(sourceEnd), m_position(0)
+{
+	evalNextIntersections();
+};
+
+/*! Get the current intersection.
+ * \return A reference to the current intersection.
+ */
+const Intersection & IntersectionIterator::operator*() const {
+	return m_intersections[m_position];
+};
+
+/*! Get the current intersection.
+ * \return A pointer to the current intersection.
+ */
+const Intersection * IntersectionIterator::operator->() const {
+	return &m_intersections[m_position];
+};
+
+/*! Move the iterator to the next intersection.
+ * \return The updated iterator.
+ */
+IntersectionIterator & IntersectionIterator::operator++() {
+	++m_position;
+	if (m_position == m_intersections.size()) {
+		evalNextIntersections();
+	}
+
+	return *this;
+};
+
+/*! Check if two iterators point to the same intersection.
+ * \param[in] other Iterator to compare with.
+ * \return True if the iterators point to the same intersection, false otherwise.
+ */
+bool IntersectionIterator::operator==(const IntersectionIterator &other) const {
+	if (m_tree != other.m_tree || m_source != other.m_source || m_position != other.m_position) {
+		return false;
+	}
+
+	// The end iterator has no intersections
+	return (m_intersections.empty() == other.m_intersections.empty());
+};
+
+/*! Check if two iterators point to different intersections.
+ * \param[in] other Iterator to compare with.
+ * \return True if the iterators point to different intersections, false otherwise.
+ */
+bool IntersectionIterator::operator!=(const IntersectionIterator &other) const {
+	return !(*this == other);
+};
+
+/*! Evaluate the intersections owned by the next octant that owns at least
+ * one intersection. If there are no more octants to visit, the iterator
+ * becomes equal to the end iterator.
+ */
+void IntersectionIterator::evalNextIntersections() {
+	m_intersections.clear();
+	m_position = 0;
+
+	uint64_t nGhosts = m_tree ? m_tree->getNumGhosts() : 0;
+	while (m_intersections.empty() && m_source < m_sourceEnd) {
+		if (m_source < nGhosts) {
+			m_tree->findGhostIntersections(static_cast<uint32_t>(m_source), m_neighbours, m_isGhost, &m_intersections);
+		} else {
+			m_tree->findOctantIntersections(static_cast<uint32_t>(m_source - nGhosts), m_neighbours, m_isGhost, &m_intersections);
+		}
+		++m_source;
+	}
+};
+
 }
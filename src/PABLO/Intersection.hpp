@@ -29,9 +29,14 @@
 // INCLUDES                                                                            //
 // =================================================================================== //
 #include <stdint.h>
+#include <cstddef>
+#include <iterator>
+#include <vector>
 
 namespace bitpit {
 
+class LocalTree;
+
 // =================================================================================== //
 // NAME SPACES                                                                         //
 // =================================================================================== //
@@ -117,6 +122,73 @@ private:
 
 };
 
+/*!
+ *	\ingroup		PABLO
+ *
+ *	\brief Iterator over the intersections of a local tree
+ *
+ *	The iterator evaluates the intersections on the fly from the neighbour
+ *	search, without storing the intersections of the whole tree. The
+ *	intersections are generated in the same order of the intersections
+ *	stored by ParaTree::computeIntersections: first the intersections owned
+ *	by the ghost octants, then the intersections owned by the internal
+ *	octants. Only the intersections owned by the octant being visited are
+ *	kept in memory.
+ */
+class IntersectionIterator{
+
+	// =================================================================================== //
+	// FRIENDSHIPS
+	// =================================================================================== //
+
+	friend class ParaTree;
+
+	// =================================================================================== //
+	// TYPEDEFS
+	// =================================================================================== //
+public:
+	typedef std::input_iterator_tag		iterator_category;
+	typedef Intersection				value_type;
+	typedef std::ptrdiff_t				difference_type;
+	typedef const Intersection *		pointer;
+	typedef const Intersection &		reference;
+
+	// =================================================================================== //
+	// MEMBERS
+	// =================================================================================== //
+private:
+	const LocalTree				*m_tree;			/**< Tree whose intersections are iterated */
+	uint64_t					m_source;			/**< Next octant whose intersections will be evaluated (ghosts come before internal octants) */
+	uint64_t					m_sourceEnd;		/**< Octant after the last one whose intersections will be evaluated */
+	std::vector<Intersection>	m_intersections;	/**< Intersections owned by the octant being visited */
+	std::size_t					m_position;			/**< Position of the current intersection */
+	std::vector<uint32_t>		m_neighbours;		/**< Scratch storage for the neighbour search */
+	std::vector<bool>			m_isGhost;			/**< Scratch storage for the neighbour search */
+
+	// =================================================================================== //
+	// CONSTRUCTORS AND OPERATORS
+	// =================================================================================== //
+public:
+	IntersectionIterator();
+
+	const Intersection & operator*() const;
+	const Intersection * operator->() const;
+
+	IntersectionIterator & operator++();
+
+	bool operator==(const IntersectionIterator &other) const;
+	bool operator!=(const IntersectionIterator &other) const;
+
+private:
+	IntersectionIterator(const LocalTree *tree, uint64_t sourceBegin, uint64_t sourceEnd);
+
+	// =================================================================================== //
+	// METHODS
+	// =================================================================================== //
+	void evalNextIntersections();
+
+};
+
 }
 
 #endif /* __BITPIT_PABLO_INTERSECTION_HPP__ */
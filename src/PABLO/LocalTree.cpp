@@ -28,9 +28,14 @@
 #include "LocalTree.hpp"
 #include "morton.hpp"
 
+#include <limits>
 #include <map>
 #include <unordered_map>
 
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
 namespace bitpit {
 
     // =================================================================================== //
@@ -42,6 +47,32 @@ namespace bitpit {
     // CLASS IMPLEMENTATION                                                                    //
     // =================================================================================== //
 
+    // =================================================================================== //
+    // STATIC MEMBERS
+    // =================================================================================== //
+
+#if BITPIT_ENABLE_OPENMP==1
+    /*! Minimum number of local octants needed to use the threaded adaption, smaller
+     * trees are adapted serially because the threading overhead would dominate.
+     */
+    const uint32_t LocalTree::THREADED_ADAPTION_MIN_OCTANTS = 8192;
+
+    /*! Minimum number of local and ghost octants needed to build the connectivity
+     * using multiple threads.
+     */
+    const uint32_t LocalTree::THREADED_CONNECTIVITY_MIN_OCTANTS = 8192;
+
+    /*! Minimum number of local octants needed to build the neighbour graph
+     * using multiple threads.
+     */
+    const uint32_t LocalTree::THREADED_NEIGHBOUR_GRAPH_MIN_OCTANTS = 8192;
+
+    /*! Minimum number of points needed to locate the points using multiple
+     * threads.
+     */
+    const std::size_t LocalTree::THREADED_POINT_LOCATION_MIN_POINTS = 8192;
+#endif
+
     // =================================================================================== //
     // CONSTRUCTORS AND OPERATORS
     // =================================================================================== //
@@ -369,6 +400,7 @@ namespace bitpit {
         m_firstGhostBros.clear();
 
         clearConnectivity();
+        clearNeighbourGraph();
         intervector().swap(m_intersections);
 
         std::fill(m_periodic.begin(), m_periodic.end(), false);
@@ -442,6 +474,13 @@ namespace bitpit {
             return false;
         }
 
+#if BITPIT_ENABLE_OPENMP==1
+        // Large trees are refined using the threaded implementation
+        if (isThreadedAdaptionEnabled(nOctants)) {
+            return threadedRefine(mapidx);
+        }
+#endif
+
         // Validate markers
         //
         // Not all octants marked for refinement can be really refined, for
@@ -526,7 +565,7 @@ namespace bitpit {
 
                 // Set children information
                 for (int i = 0; i < nChildren; ++i) {
-                    m_octants[firstChildIdx + i].m_info[Octant::INFO_NEW4REFINEMENT] = true;
+                    m_octants[firstChildIdx + i].setInfo(Octant::INFO_NEW4REFINEMENT, true);
                 }
 
                 // Update the mapping
@@ -565,17 +604,14 @@ namespace bitpit {
     bool
     LocalTree::coarse(u32vector & mapidx){
 
-        u32vector		first_child_index;
         Octant			father(m_dim);
-        uint32_t 		idx, idx2;
+        uint32_t 		idx;
         uint32_t 		offset;
         uint32_t 		idx1_gh;
         uint32_t 		idx2_gh;
-        uint32_t 		nidx;
         uint32_t		mapsize = mapidx.size();
         int8_t 			markerfather, marker;
         uint8_t 		nbro, nend, nstart;
-        uint8_t 		nchm1 = m_treeConstants->nChildren-1;
         bool 			docoarse = false;
         bool 			wstop = false;
 
@@ -590,7 +626,7 @@ namespace bitpit {
         uint32_t nInitialGhosts = getNumGhosts();
 
         nbro = nend = nstart = 0;
-        nidx = offset = 0;
+        offset = 0;
 
         idx2_gh = 0;
         idx1_gh = nInitialGhosts - 1;
@@ -619,79 +655,16 @@ namespace bitpit {
         }
 
         // Check and coarse internal octants
-        for (idx=0; idx<nInitialOctants; idx++){
-            if(m_octants[idx].getMarker() < 0 && m_octants[idx].getLevel() > 0){
-                nbro = 0;
-                father = m_octants[idx].buildFather();
-                // Check if family is to be refined
-                for (idx2=idx; idx2<idx+m_treeConstants->nChildren; idx2++){
-                    if (idx2<nInitialOctants){
-                        if(m_octants[idx2].getMarker() < 0 && m_octants[idx2].buildFather() == father){
-                            nbro++;
-                        }
-                    }
-                }
-                if (nbro == m_treeConstants->nChildren){
-                    nidx++;
-                    first_child_index.push_back(idx);
-                    idx = idx2-1;
-                }
-            }
-        }
-        uint32_t nblock = nInitialOctants;
-        uint32_t nfchild = first_child_index.size();
-        if (nidx!=0){
-            nblock = nInitialOctants - nidx*nchm1;
-            nidx = 0;
-            for (idx=0; idx<nblock; idx++){
-                if (idx+offset < nInitialOctants){
-                    if (nidx < nfchild){
-                        if (idx+offset == first_child_index[nidx]){
-                            markerfather = -m_treeConstants->maxLevel;
-                            father = m_octants[idx+offset].buildFather();
-                            for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
-                                father.m_info[iii] = false;
-                            }
-                            father.setGhostLayer(-1);
-                            for(idx2=0; idx2<m_treeConstants->nChildren; idx2++){
-                                if (idx2 < nInitialOctants){
-                                    if (markerfather < m_octants[idx+offset+idx2].getMarker()+1){
-                                        markerfather = m_octants[idx+offset+idx2].getMarker()+1;
-                                    }
-                                    for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
-                                        father.m_info[iii] = father.m_info[iii] || m_octants[idx+offset+idx2].m_info[iii];
-                                    }
-                                }
-                            }
-                            father.m_info[Octant::INFO_NEW4COARSENING] = true;
-                            father.setMarker(markerfather);
-                            //Impossible in this version
-//                            if (markerfather < 0 && mapsize == 0){
-//                                docoarse = true;
-//                            }
-                            m_octants[idx] = father;
-                            if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
-                            offset += nchm1;
-                            nidx++;
-                        }
-                        else{
-                            m_octants[idx] = m_octants[idx+offset];
-                            if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
-                        }
-                    }
-                    else{
-                        m_octants[idx] = m_octants[idx+offset];
-                        if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
-                    }
-                }
-            }
+#if BITPIT_ENABLE_OPENMP==1
+        if (isThreadedAdaptionEnabled(nInitialOctants)) {
+            threadedCoarseInternals(mapidx, &father);
+        } else {
+            coarseInternals(mapidx, &father);
         }
-        m_octants.resize(nblock, Octant(m_dim));
-        m_octants.shrink_to_fit();
+#else
+        coarseInternals(mapidx, &father);
+#endif
         nInitialOctants = m_octants.size();
-        if(mapsize > 0){
-            mapidx.resize(nInitialOctants);
-        }
 
         //Check ghosts
         if (m_ghosts.size()){
@@ -791,7 +764,7 @@ namespace bitpit {
                 if (m_ghosts[idx2_gh].buildFather() == m_octants[nInitialOctants-1].buildFather()){
                     father = m_ghosts[idx2_gh].buildFather();
                     for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
-                        father.m_info[iii] = false;
+                        father.setInfo(iii, false);
                     }
                     father.setGhostLayer(-1);
                     markerfather = m_ghosts[idx2_gh].getMarker()+1;
@@ -804,9 +777,9 @@ namespace bitpit {
                             markerfather = m_ghosts[idx].getMarker()+1;
                         }
                         for (uint32_t iii=0; iii<m_treeConstants->nFaces; iii++){
-                            father.m_info[iii] = father.m_info[iii] || m_ghosts[idx].m_info[iii];
+                            father.setInfo(iii, father.getInfo(iii) || m_ghosts[idx].getInfo(iii));
                         }
-                        father.m_info[Octant::INFO_BALANCED] = father.m_info[Octant::INFO_BALANCED] || m_ghosts[idx].m_info[Octant::INFO_BALANCED];
+                        father.setInfo(Octant::INFO_BALANCED, father.getInfo(Octant::INFO_BALANCED) || m_ghosts[idx].getInfo(Octant::INFO_BALANCED));
                         idx++;
                         if(idx == nInitialGhosts){
                             break;
@@ -842,10 +815,10 @@ namespace bitpit {
                 if (nend != 0){
                     for (idx=0; idx < nend; idx++){
                         for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT - 1; iii++){
-                            father.m_info[iii] = father.m_info[iii] || m_octants[nInitialOctants-idx-1].m_info[iii];
+                            father.setInfo(iii, father.getInfo(iii) || m_octants[nInitialOctants-idx-1].getInfo(iii));
                         }
                     }
-                    father.m_info[Octant::INFO_NEW4COARSENING] = true;
+                    father.setInfo(Octant::INFO_NEW4COARSENING, true);
                     father.setGhostLayer(-1);
                     //Impossible in this version
                     //                if (markerfather < 0 && mapsize == 0){
@@ -871,9 +844,453 @@ namespace bitpit {
         setFirstDescMorton();
         setLastDescMorton();
 
-        return docoarse;
+        return docoarse;
+
+    };
+
+    // =================================================================================== //
+
+    /*! Coarse the families of internal octants that have all their members
+     * marked for coarsening (families shared with other processes are handled
+     * by the caller).
+     * \param[in,out] mapidx mpaidx[i] = index in old octants vector of the new
+     * i-th octant (index of first child if octant is new after coarsening). If
+     * an empty mapping is provided, the mapping will not be filled.
+     * \param[in,out] lastFather on output will contain the father of the last
+     * family that has been coarsened or, if no family has been coarsened, the
+     * father of the last octant marked for coarsening. If there are no octants
+     * marked for coarsening, the father will not be modified.
+     */
+    void
+    LocalTree::coarseInternals(u32vector & mapidx, Octant *lastFather){
+
+        u32vector		first_child_index;
+        Octant			&father = *lastFather;
+        uint32_t 		idx, idx2;
+        uint32_t 		offset;
+        uint32_t 		nidx;
+        uint32_t		mapsize = mapidx.size();
+        int8_t 			markerfather;
+        uint8_t 		nbro;
+        uint8_t 		nchm1 = m_treeConstants->nChildren-1;
+
+        uint32_t nInitialOctants = getNumOctants();
+
+        nbro = 0;
+        nidx = offset = 0;
+
+        // Check and coarse internal octants
+        for (idx=0; idx<nInitialOctants; idx++){
+            if(m_octants[idx].getMarker() < 0 && m_octants[idx].getLevel() > 0){
+                nbro = 0;
+                father = m_octants[idx].buildFather();
+                // Check if family is to be refined
+                for (idx2=idx; idx2<idx+m_treeConstants->nChildren; idx2++){
+                    if (idx2<nInitialOctants){
+                        if(m_octants[idx2].getMarker() < 0 && m_octants[idx2].buildFather() == father){
+                            nbro++;
+                        }
+                    }
+                }
+                if (nbro == m_treeConstants->nChildren){
+                    nidx++;
+                    first_child_index.push_back(idx);
+                    idx = idx2-1;
+                }
+            }
+        }
+        uint32_t nblock = nInitialOctants;
+        uint32_t nfchild = first_child_index.size();
+        if (nidx!=0){
+            nblock = nInitialOctants - nidx*nchm1;
+            nidx = 0;
+            for (idx=0; idx<nblock; idx++){
+                if (idx+offset < nInitialOctants){
+                    if (nidx < nfchild){
+                        if (idx+offset == first_child_index[nidx]){
+                            markerfather = -m_treeConstants->maxLevel;
+                            father = m_octants[idx+offset].buildFather();
+                            for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                                father.setInfo(iii, false);
+                            }
+                            father.setGhostLayer(-1);
+                            for(idx2=0; idx2<m_treeConstants->nChildren; idx2++){
+                                if (idx2 < nInitialOctants){
+                                    if (markerfather < m_octants[idx+offset+idx2].getMarker()+1){
+                                        markerfather = m_octants[idx+offset+idx2].getMarker()+1;
+                                    }
+                                    for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                                        father.setInfo(iii, father.getInfo(iii) || m_octants[idx+offset+idx2].getInfo(iii));
+                                    }
+                                }
+                            }
+                            father.setInfo(Octant::INFO_NEW4COARSENING, true);
+                            father.setMarker(markerfather);
+                            //Impossible in this version
+//                            if (markerfather < 0 && mapsize == 0){
+//                                docoarse = true;
+//                            }
+                            m_octants[idx] = father;
+                            if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
+                            offset += nchm1;
+                            nidx++;
+                        }
+                        else{
+                            m_octants[idx] = m_octants[idx+offset];
+                            if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
+                        }
+                    }
+                    else{
+                        m_octants[idx] = m_octants[idx+offset];
+                        if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
+                    }
+                }
+            }
+        }
+        m_octants.resize(nblock, Octant(m_dim));
+        m_octants.shrink_to_fit();
+        if(mapsize > 0){
+            mapidx.resize(nblock);
+        }
+
+    };
+
+#if BITPIT_ENABLE_OPENMP==1
+    // =================================================================================== //
+
+    /*! Check if the threaded implementation of the adaption should be used.
+     * \param[in] nOctants Number of octants that will be processed.
+     * \return true if the threaded implementation of the adaption should be
+     * used, false otherwise.
+     */
+    bool
+    LocalTree::isThreadedAdaptionEnabled(uint32_t nOctants) const{
+        return (nOctants >= THREADED_ADAPTION_MIN_OCTANTS && omp_get_max_threads() > 1);
+    };
+
+    // =================================================================================== //
+
+    /*! Refine local tree using multiple threads: refine one time octants with marker >0.
+     *
+     * The octants are split in contiguous chunks, one for each thread. First
+     * the number of refinements of each chunk is evaluated, then a prefix sum
+     * over the chunks gives the position of the first octant generated by each
+     * chunk. Finally, each thread generates the children (and the mapping) of
+     * its chunk directly at their final position. The result is identical to
+     * the one obtained with the serial implementation.
+     *
+     * \param[in,out] mapidx mapidx[i] = index in old octants vector of the new i-th octant (index
+     * of father if octant is new after refinement). See LocalTree::refine for a detailed
+     * description of the mapping.
+     * \return	true if additional refinement is needed in order to satisfy
+     * the specified markers
+     */
+    bool
+    LocalTree::threadedRefine(u32vector & mapidx){
+        // Current number of octants
+        uint32_t nOctants = m_octants.size();
+
+        // Split octants in chunks
+        int nChunks = omp_get_max_threads();
+
+        std::vector<uint32_t> chunkBegins(nChunks + 1);
+        for (int chunk = 0; chunk <= nChunks; ++chunk) {
+            chunkBegins[chunk] = static_cast<uint32_t>((static_cast<uint64_t>(nOctants) * chunk) / nChunks);
+        }
+
+        // Validate markers and count the refinements of each chunk
+        //
+        // Not all octants marked for refinement can be really refined, for
+        // example octants cannot be refined further than the maximum level.
+        std::vector<uint32_t> chunkRefinementOffsets(nChunks + 1, 0);
+
+#pragma omp parallel for schedule(static)
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint32_t nChunkRefinements = 0;
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                // Skip octants not marked for refinement
+                Octant &octant = m_octants[idx];
+                if(octant.getMarker()<= 0){
+                    continue;
+                }
+
+                // Octants cannot be refined further than the maximum level
+                if(octant.getLevel()>=m_treeConstants->maxLevel){
+                    octant.setMarker(0);
+                    continue;
+                }
+
+                // The octant will be refined
+                ++nChunkRefinements;
+            }
+
+            chunkRefinementOffsets[chunk + 1] = nChunkRefinements;
+        }
+
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            chunkRefinementOffsets[chunk + 1] += chunkRefinementOffsets[chunk];
+        }
+
+        // Early return if no octants need to be refined
+        uint32_t nValidRefinements = chunkRefinementOffsets[nChunks];
+        if (nValidRefinements == 0) {
+            return false;
+        }
+
+        // Initialize refined containers
+        uint8_t  nChildren      = m_treeConstants->nChildren;
+        uint32_t nFutureOctants = nOctants + (nChildren - 1) * nValidRefinements;
+
+        octvector refinedOctants(nFutureOctants);
+
+        bool hasMapping = !mapidx.empty();
+        u32vector refinedMapidx;
+        if (hasMapping) {
+            refinedMapidx.resize(nFutureOctants);
+        }
+
+        // Refine the octants
+        //
+        // Each chunk knows the position of its first octant in the refined
+        // container, hence all the chunks can be processed concurrently.
+        bool refinementCompleted = true;
+        int  localMaxDepth       = m_localMaxDepth;
+
+#pragma omp parallel for schedule(static) reduction(&&:refinementCompleted) reduction(max:localMaxDepth)
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint32_t futureIdx = chunkBegins[chunk] + (nChildren - 1) * chunkRefinementOffsets[chunk];
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                Octant &octant = m_octants[idx];
+                if(octant.getMarker()<=0){
+                    // The octant is not refined, we only need to move it to
+                    // its new position.
+                    refinedOctants[futureIdx] = std::move(octant);
+
+                    // Update the mapping
+                    if(hasMapping){
+                        refinedMapidx[futureIdx] = mapidx[idx];
+                    }
+
+                    // Update future octant index
+                    ++futureIdx;
+                } else {
+                    // Create children
+                    octant.buildChildren(refinedOctants.data() + futureIdx);
+
+                    // Set children information
+                    for (int i = 0; i < nChildren; ++i) {
+                        refinedOctants[futureIdx + i].setInfo(Octant::INFO_NEW4REFINEMENT, true);
+                    }
+
+                    // Update the mapping
+                    if(hasMapping){
+                        for (uint8_t i=0; i<nChildren; i++){
+                            refinedMapidx[futureIdx + i] = mapidx[idx];
+                        }
+                    }
+
+                    // Check if more refinement is needed to satisfy the markers
+                    if (refinementCompleted) {
+                        refinementCompleted = (refinedOctants[futureIdx].getMarker() <= 0);
+                    }
+
+                    // Update local max depth
+                    int childrenLevel = refinedOctants[futureIdx].getLevel();
+                    if (childrenLevel > localMaxDepth){
+                        localMaxDepth = childrenLevel;
+                    }
+
+                    // Update future octant index
+                    futureIdx += nChildren;
+                }
+            }
+        }
+
+        // Replace the original octants with the refined ones
+        m_octants.swap(refinedOctants);
+        if(hasMapping){
+            mapidx.swap(refinedMapidx);
+        }
+
+        m_localMaxDepth = static_cast<int8_t>(localMaxDepth);
+
+        return (!refinementCompleted);
+
+    };
+
+    // =================================================================================== //
+
+    /*! Coarse the families of internal octants that have all their members
+     * marked for coarsening using multiple threads.
+     *
+     * Families of internal octants cannot overlap, hence the first octant of
+     * each family that will be coarsened can be identified independently. The
+     * octants are split in contiguous chunks, one for each thread, a prefix sum
+     * over the number of octants that each chunk will retain gives the position
+     * of the first coarsened octant generated by each chunk. The result is
+     * identical to the one obtained with LocalTree::coarseInternals.
+     *
+     * \param[in,out] mapidx mpaidx[i] = index in old octants vector of the new
+     * i-th octant (index of first child if octant is new after coarsening). If
+     * an empty mapping is provided, the mapping will not be filled.
+     * \param[in,out] lastFather on output will contain the father of the last
+     * family that has been coarsened or, if no family has been coarsened, the
+     * father of the last octant marked for coarsening. If there are no octants
+     * marked for coarsening, the father will not be modified.
+     */
+    void
+    LocalTree::threadedCoarseInternals(u32vector & mapidx, Octant *lastFather){
+
+        enum FamilyRole {
+            ROLE_NONE = 0,
+            ROLE_FIRST_CHILD,
+            ROLE_SIBLING
+        };
+
+        uint32_t nOctants  = getNumOctants();
+        uint8_t  nChildren = m_treeConstants->nChildren;
+
+        // Split octants in chunks
+        int nChunks = omp_get_max_threads();
+
+        std::vector<uint32_t> chunkBegins(nChunks + 1);
+        for (int chunk = 0; chunk <= nChunks; ++chunk) {
+            chunkBegins[chunk] = static_cast<uint32_t>((static_cast<uint64_t>(nOctants) * chunk) / nChunks);
+        }
+
+        // Identify the families that will be coarsened
+        //
+        // An octant is the first child of a family that will be coarsened if
+        // it and the following siblings are all marked for coarsening.
+        std::vector<uint8_t> familyRoles(nOctants, ROLE_NONE);
+
+        int64_t lastCandidateIdx   = -1;
+        int64_t lastFirstChildIdx  = -1;
+
+#pragma omp parallel for schedule(static) reduction(max:lastCandidateIdx) reduction(max:lastFirstChildIdx)
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                const Octant &octant = m_octants[idx];
+                if (octant.getMarker() >= 0 || octant.getLevel() == 0) {
+                    continue;
+                }
+
+                lastCandidateIdx = idx;
+
+                if (idx + nChildren > nOctants) {
+                    continue;
+                }
+
+                Octant father = octant.buildFather();
+                uint8_t nbro = 1;
+                for (uint32_t idx2 = idx + 1; idx2 < idx + nChildren; ++idx2) {
+                    if (m_octants[idx2].getMarker() >= 0 || !(m_octants[idx2].buildFather() == father)) {
+                        break;
+                    }
+                    ++nbro;
+                }
+
+                if (nbro == nChildren) {
+                    familyRoles[idx] = ROLE_FIRST_CHILD;
+                    for (uint32_t idx2 = idx + 1; idx2 < idx + nChildren; ++idx2) {
+                        familyRoles[idx2] = ROLE_SIBLING;
+                    }
+
+                    lastFirstChildIdx = idx;
+                }
+            }
+        }
+
+        // Update the father
+        if (lastFirstChildIdx >= 0) {
+            *lastFather = m_octants[lastFirstChildIdx].buildFather();
+        } else if (lastCandidateIdx >= 0) {
+            *lastFather = m_octants[lastCandidateIdx].buildFather();
+        }
+
+        // Early return if no families needs to be coarsened
+        if (lastFirstChildIdx < 0) {
+            return;
+        }
+
+        // Count the octants retained by each chunk
+        std::vector<uint32_t> chunkOffsets(nChunks + 1, 0);
+
+#pragma omp parallel for schedule(static)
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint32_t nChunkOctants = 0;
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                if (familyRoles[idx] != ROLE_SIBLING) {
+                    ++nChunkOctants;
+                }
+            }
+
+            chunkOffsets[chunk + 1] = nChunkOctants;
+        }
+
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+        }
+
+        // Initialize coarsened containers
+        uint32_t nCoarsenedOctants = chunkOffsets[nChunks];
+
+        octvector coarsenedOctants(nCoarsenedOctants);
+
+        bool hasMapping = !mapidx.empty();
+        u32vector coarsenedMapidx;
+        if (hasMapping) {
+            coarsenedMapidx.resize(nCoarsenedOctants);
+        }
+
+        // Coarse the families
+#pragma omp parallel for schedule(static)
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint32_t futureIdx = chunkOffsets[chunk];
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                FamilyRole role = static_cast<FamilyRole>(familyRoles[idx]);
+                if (role == ROLE_SIBLING) {
+                    continue;
+                } else if (role == ROLE_FIRST_CHILD) {
+                    int8_t markerfather = -m_treeConstants->maxLevel;
+                    Octant father = m_octants[idx].buildFather();
+                    for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                        father.setInfo(iii, false);
+                    }
+                    father.setGhostLayer(-1);
+                    for(uint32_t idx2=0; idx2<nChildren; idx2++){
+                        const Octant &child = m_octants[idx+idx2];
+                        if (markerfather < child.getMarker()+1){
+                            markerfather = child.getMarker()+1;
+                        }
+                        for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                            father.setInfo(iii, father.getInfo(iii) || child.getInfo(iii));
+                        }
+                    }
+                    father.setInfo(Octant::INFO_NEW4COARSENING, true);
+                    father.setMarker(markerfather);
+
+                    coarsenedOctants[futureIdx] = std::move(father);
+                } else {
+                    coarsenedOctants[futureIdx] = m_octants[idx];
+                }
+
+                if(hasMapping){
+                    coarsenedMapidx[futureIdx] = mapidx[idx];
+                }
+
+                ++futureIdx;
+            }
+        }
+
+        // Replace the original octants with the coarsened ones
+        m_octants.swap(coarsenedOctants);
+        if(hasMapping){
+            mapidx.swap(coarsenedMapidx);
+        }
 
     };
+#endif
 
     // =================================================================================== //
 
@@ -989,6 +1406,26 @@ namespace bitpit {
      * \param[in] append A boolean flag to specify if neighbours will be appended to the given vector or if the given vectors will be cleared before adding the neighbours.
      */
     void
+    LocalTree::findNeighbours(const Octant* oct, uint8_t iface, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const{
+        if (m_dim == 3) {
+            findNeighbours<3>(oct, iface, neighbours, isghost, onlyinternal, append);
+        } else {
+            findNeighbours<2>(oct, iface, neighbours, isghost, onlyinternal, append);
+        }
+    };
+
+    /** Finds local and ghost or only local neighbours of octant(both local and ghost ones) through iface face.
+     * The dimension of the tree is given at compile time, it should match the
+     * runtime dimension of the tree.
+     * \param[in] oct Pointer to the current octant
+     * \param[in] iface Index of face passed through for neighbours finding
+     * \param[in,out] neighbours Vector of neighbours indices in octants/ghosts structure
+     * \param[in,out] isghost Vector with boolean flag; true if the respective octant in neighbours is a ghost octant
+     * \param[in] onlyinternal A boolean flag to specify if neighbours have to be found among all the octants (false) or only among the internal ones (true).
+     * \param[in] append A boolean flag to specify if neighbours will be appended to the given vector or if the given vectors will be cleared before adding the neighbours.
+     */
+    template<int dim>
+    void
     LocalTree::findNeighbours(const Octant* oct, uint8_t iface, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const{
 
         if (!append) {
@@ -1030,7 +1467,7 @@ namespace bitpit {
 
         uint32_t size = oct->getLogicalSize();
 
-        std::array<uint32_t, 3> coord = oct->getLogicalCoordinates();
+        std::array<uint32_t, 3> coord = oct->getLogicalCoordinates<dim>();
         if (isperiodic) {
             std::array<int64_t, 3> periodicOffset = getPeriodicOffset(*oct, iface);
             coord[0] = static_cast<uint32_t>(coord[0] + periodicOffset[0]);
@@ -1046,7 +1483,7 @@ namespace bitpit {
         sameSizeVirtualNeighCoord[0] = static_cast<uint32_t>(sameSizeVirtualNeighCoord[0] + sameSizeVirtualNeighOffset[0]);
         sameSizeVirtualNeighCoord[1] = static_cast<uint32_t>(sameSizeVirtualNeighCoord[1] + sameSizeVirtualNeighOffset[1]);
         sameSizeVirtualNeighCoord[2] = static_cast<uint32_t>(sameSizeVirtualNeighCoord[2] + sameSizeVirtualNeighOffset[2]);
-        uint64_t sameSizeVirtualNeighMorton = PABLO::computeMorton(m_dim, sameSizeVirtualNeighCoord[0], sameSizeVirtualNeighCoord[1], sameSizeVirtualNeighCoord[2]);
+        uint64_t sameSizeVirtualNeighMorton = PABLO::computeMorton<dim>(sameSizeVirtualNeighCoord[0], sameSizeVirtualNeighCoord[1], sameSizeVirtualNeighCoord[2]);
 
         //
         // Search in the internal octants
@@ -1072,7 +1509,7 @@ namespace bitpit {
         lastCandidateCoord[0] = static_cast<uint32_t>(lastCandidateCoord[0] + lastCandidateOffset[0]);
         lastCandidateCoord[1] = static_cast<uint32_t>(lastCandidateCoord[1] + lastCandidateOffset[1]);
         lastCandidateCoord[2] = static_cast<uint32_t>(lastCandidateCoord[2] + lastCandidateOffset[2]);
-        uint64_t lastCandidateMorton = PABLO::computeMorton(m_dim, lastCandidateCoord[0], lastCandidateCoord[1], lastCandidateCoord[2]);
+        uint64_t lastCandidateMorton = PABLO::computeMorton<dim>(lastCandidateCoord[0], lastCandidateCoord[1], lastCandidateCoord[2]);
 
         // Search for neighbours of different sizes
         if (candidateIdx < getNumOctants()){
@@ -1080,8 +1517,8 @@ namespace bitpit {
                 // Detect if the candidate is a neighbour
                 u32array3 coordtry = {{0, 0, 0}};
                 bool isNeighbourCandidate = true;
-                for (int8_t idim=0; idim<m_dim; idim++){
-                    coordtry[idim] = m_octants[candidateIdx].getLogicalCoordinates(idim);
+                for (int8_t idim=0; idim<dim; idim++){
+                    coordtry[idim] = PABLO::computeCoordinate<dim>(m_octants[candidateIdx].getMorton(), idim);
 
                     int32_t Dx     = int32_t(int32_t(abs(cxyz[idim]))*(coordtry[idim] - coord[idim]));
                     int32_t Dxstar = int32_t((cxyz[idim]-1)/2)*(m_octants[candidateIdx].getLogicalSize()) + int32_t((cxyz[idim]+1)/2)*size;
@@ -1096,7 +1533,7 @@ namespace bitpit {
                     uint8_t leveltry = m_octants[candidateIdx].getLevel();
                     if (leveltry > level){
                         array<int64_t,3> coord1 ={{1, 1, 1}} ;
-                        for (int8_t idim=0; idim<m_dim; idim++){
+                        for (int8_t idim=0; idim<dim; idim++){
                             coord1[idim] = coord[idim] + size;
                         }
 
@@ -1106,7 +1543,7 @@ namespace bitpit {
                     }
                     else if (leveltry < level){
                         u32array3 coordtry1 = {{1, 1, 1}};
-                        for (int8_t idim=0; idim<m_dim; idim++){
+                        for (int8_t idim=0; idim<dim; idim++){
                             coordtry1[idim] = coordtry[idim] + m_octants[candidateIdx].getLogicalSize();
                         }
 
@@ -1172,8 +1609,8 @@ namespace bitpit {
                     // Detect if the candidate is a neighbour
                     u32array3 coordtry = {{0, 0, 0}};
                     bool isNeighbourCandidate = true;
-                    for (int8_t idim=0; idim<m_dim; idim++){
-                        coordtry[idim] = m_ghosts[candidateIdx].getLogicalCoordinates(idim);
+                    for (int8_t idim=0; idim<dim; idim++){
+                        coordtry[idim] = PABLO::computeCoordinate<dim>(m_ghosts[candidateIdx].getMorton(), idim);
 
                         int32_t Dx     = int32_t(int32_t(abs(cxyz[idim]))*(coordtry[idim] - coord[idim]));
                         int32_t Dxstar = int32_t((cxyz[idim]-1)/2)*(m_ghosts[candidateIdx].getLogicalSize()) + int32_t((cxyz[idim]+1)/2)*size;
@@ -1188,7 +1625,7 @@ namespace bitpit {
                         uint8_t leveltry = m_ghosts[candidateIdx].getLevel();
                         if (leveltry > level){
                             array<int64_t, 3> coord1 = {{1, 1, 1}};
-                            for (int8_t idim=0; idim<m_dim; idim++){
+                            for (int8_t idim=0; idim<dim; idim++){
                                 coord1[idim] = coord[idim] + size;
                             }
 
@@ -1198,7 +1635,7 @@ namespace bitpit {
                         }
                         else if (leveltry < level){
                             u32array3 coordtry1 = {{1, 1, 1}};
-                            for (int8_t idim=0; idim<m_dim; idim++){
+                            for (int8_t idim=0; idim<dim; idim++){
                                 coordtry1[idim] = coordtry[idim] + m_ghosts[candidateIdx].getLogicalSize();
                             }
 
@@ -1925,13 +2362,37 @@ namespace bitpit {
      * \param[in] doNew Set to true the balance is enforced also on new octants.
      * \param[in] checkInterior Set to true if interior octants should be checked.
      * \param[in] checkGhost Set to true if ghost octants should be checked.
+     * \param[in] ghostsToCheck If a valid pointer is provided and ghost octants should
+     * be checked, only the ghosts in the specified list will be checked, otherwise all
+     * the ghosts of the first layer will be checked.
+     * \return True if balanced done with some markers modification.
+     */
+    bool
+    LocalTree::localBalance(bool doNew, bool checkInterior, bool checkGhost, const u32vector *ghostsToCheck){
+        if (m_dim == 3) {
+            return localBalance<3>(doNew, checkInterior, checkGhost, ghostsToCheck);
+        } else {
+            return localBalance<2>(doNew, checkInterior, checkGhost, ghostsToCheck);
+        }
+    };
+
+    /*! 2:1 balancing on level a local tree (refinement wins!). The dimension
+     * of the tree is given at compile time, it should match the runtime
+     * dimension of the tree.
+     * \param[in] doNew Set to true the balance is enforced also on new octants.
+     * \param[in] checkInterior Set to true if interior octants should be checked.
+     * \param[in] checkGhost Set to true if ghost octants should be checked.
+     * \param[in] ghostsToCheck If a valid pointer is provided and ghost octants should
+     * be checked, only the ghosts in the specified list will be checked, otherwise all
+     * the ghosts of the first layer will be checked.
      * \return True if balanced done with some markers modification.
      */
+    template<int dim>
     bool
-    LocalTree::localBalance(bool doNew, bool checkInterior, bool checkGhost){
+    LocalTree::localBalance(bool doNew, bool checkInterior, bool checkGhost, const u32vector *ghostsToCheck){
 
-        bool balanceEdges = ((m_balanceCodim>1) && (m_dim==3));
-        bool balanceNodes = (m_balanceCodim==m_dim);
+        bool balanceEdges = ((m_balanceCodim>1) && (dim==3));
+        bool balanceNodes = (m_balanceCodim==dim);
 
         std::vector<Octant *> processOctants;
         std::vector<bool> processGhostFlags;
@@ -1967,16 +2428,36 @@ namespace bitpit {
         // because it's faster to process all the ghost octants that may affect balacning
         // of internal octants, rather than find the ones that actually affect balacing of
         // internal octants.
+        //
+        // When a list of ghosts to check is provided (e.g., the ghosts whose markers have
+        // been updated since the last balancing), only those ghosts are processed. Markers
+        // are only increased by the balancing, hence the constraints imposed by the ghosts
+        // that have not been modified are already satisfied.
         if (checkGhost) {
-            for (Octant &octant : m_ghosts){
-                // Only ghosts of the first layer can affect load balance
-                if (octant.getGhostLayer() > 0) {
-                    continue;
+            if (ghostsToCheck) {
+                for (uint32_t ghostIdx : *ghostsToCheck){
+                    Octant &octant = m_ghosts[ghostIdx];
+
+                    // Only ghosts of the first layer can affect load balance
+                    if (octant.getGhostLayer() > 0) {
+                        continue;
+                    }
+
+                    // Add octant to the process list
+                    processOctants.push_back(&octant);
+                    processGhostFlags.push_back(true);
                 }
+            } else {
+                for (Octant &octant : m_ghosts){
+                    // Only ghosts of the first layer can affect load balance
+                    if (octant.getGhostLayer() > 0) {
+                        continue;
+                    }
 
-                // Add octant to the process list
-                processOctants.push_back(&octant);
-                processGhostFlags.push_back(true);
+                    // Add octant to the process list
+                    processOctants.push_back(&octant);
+                    processGhostFlags.push_back(true);
+                }
             }
         }
 
@@ -2005,7 +2486,7 @@ namespace bitpit {
                 neighGhostFlags.clear();
 
                 for (int iface=0; iface < m_treeConstants->nFaces; iface++) {
-                    findNeighbours(&octant, iface, neighs, neighGhostFlags, ghostFlag, true);
+                    findNeighbours<dim>(&octant, iface, neighs, neighGhostFlags, ghostFlag, true);
                 }
 
                 if (balanceNodes) {
@@ -2142,6 +2623,23 @@ namespace bitpit {
 	* \param[in] neighLevel The level of the virtual neighbours.
 	* \param[out] neighOffsets On output will contain the offsets.
 	*/
+	void LocalTree::computeVirtualNeighOffsets(uint8_t level, uint8_t iface, uint8_t neighLevel, std::vector<std::array<int64_t, 3>> *neighOffsets) const {
+		if (m_dim == 3) {
+			computeVirtualNeighOffsets<3>(level, iface, neighLevel, neighOffsets);
+		} else {
+			computeVirtualNeighOffsets<2>(level, iface, neighLevel, neighOffsets);
+		}
+	}
+
+	/*! Compute the offsets from the origin of an octant to its virtual face neighoburs.
+	* The dimension of the tree is given at compile time, it should match the runtime
+	* dimension of the tree.
+	* \param[in] level The level of the octant.
+	* \param[in] iface Local index of the face.
+	* \param[in] neighLevel The level of the virtual neighbours.
+	* \param[out] neighOffsets On output will contain the offsets.
+	*/
+	template<int dim>
 	void LocalTree::computeVirtualNeighOffsets(uint8_t level, uint8_t iface, uint8_t neighLevel, std::vector<std::array<int64_t, 3>> *neighOffsets) const {
 
 		// Get octant sizes
@@ -2171,7 +2669,7 @@ namespace bitpit {
 
 		// Compute the coordinates of the virtual neighbour
 		int nNeighsDirection1 = 1 << (neighLevel - level);
-		int nNeighsDirection2 = (m_dim > 2) ? nNeighsDirection1 : 1;
+		int nNeighsDirection2 = (dim > 2) ? nNeighsDirection1 : 1;
 		int nNeighs           = nNeighsDirection1 * nNeighsDirection2;
 
 		neighOffsets->assign(nNeighs, computeFirstVirtualNeighOffset(level, iface, neighLevel));
@@ -2490,143 +2988,192 @@ namespace bitpit {
     void
     LocalTree::computeIntersections() {
 
-		octvector::iterator 	it, obegin, oend;
-		Intersection 			intersection;
 		u32vector 				neighbours;
 		vector<bool>			isghost;
-		uint32_t 				idx;
-		uint32_t 				i, nsize;
-		uint8_t 				iface, iface2;
 
 		m_intersections.clear();
 		m_intersections.reserve(2*3*m_octants.size());
 
-		idx = 0;
-
 		// Loop on ghosts
-		obegin = m_ghosts.begin();
-		oend = m_ghosts.end();
-		for (it = obegin; it != oend; ++it){
-			for (iface = 0; iface < m_dim; iface++){
-				iface2 = iface*2;
-				findNeighbours(m_ghosts.data() + idx, iface2, neighbours, isghost, true, false);
-				nsize = neighbours.size();
-				if (!(it->m_info[iface2])){
+		uint32_t nGhosts = m_ghosts.size();
+		for (uint32_t idx = 0; idx < nGhosts; ++idx){
+			findGhostIntersections(idx, neighbours, isghost, &m_intersections);
+		}
+
+		// Loop on octants
+		uint32_t nOctants = m_octants.size();
+		for (uint32_t idx = 0; idx < nOctants; ++idx){
+			findOctantIntersections(idx, neighbours, isghost, &m_intersections);
+		}
+		intervector(m_intersections).swap(m_intersections);
+	}
+
+    // =================================================================================== //
+
+    /*! Find the intersections owned by the specified ghost octant, i.e., the
+     * intersections between the ghost and the internal octants on its
+     * negative faces.
+     * \param[in] idx Index of the ghost octant.
+     * \param[in,out] neighbours Scratch storage for the neighbour search.
+     * \param[in,out] isghost Scratch storage for the neighbour search.
+     * \param[in,out] intersections Intersections found will be appended to this list.
+     */
+    void
+    LocalTree::findGhostIntersections(uint32_t idx, u32vector &neighbours, bvector &isghost, intervector *intersections) const {
+
+		const Octant			&octant = m_ghosts[idx];
+		Intersection 			intersection;
+		uint32_t 				i, nsize;
+		uint8_t 				iface, iface2;
+
+		for (iface = 0; iface < m_dim; iface++){
+			iface2 = iface*2;
+			findNeighbours(&octant, iface2, neighbours, isghost, true, false);
+			nsize = neighbours.size();
+			if (!(octant.getInfo(iface2))){
+				//Internal intersection
+				for (i = 0; i < nsize; i++){
+					intersection.m_dim = m_dim;
+					intersection.m_finer = getGhostLevel(idx) >= getLevel((int)neighbours[i]);
+					intersection.m_out = intersection.m_finer;
+					intersection.m_outisghost = intersection.m_finer;
+					intersection.m_owners[0]  = neighbours[i];
+					intersection.m_owners[1] = idx;
+					intersection.m_iface = m_treeConstants->oppositeFace[iface2] - (getGhostLevel(idx) >= getLevel((int)neighbours[i]));
+					intersection.m_isnew = false;
+					intersection.m_isghost = true;
+					intersection.m_bound = false;
+					intersection.m_pbound = true;
+					intersections->push_back(intersection);
+				}
+			}
+			else{
+				//Periodic intersection
+				for (i = 0; i < nsize; i++){
+					intersection.m_dim = m_dim;
+					intersection.m_finer = getGhostLevel(idx) >= getLevel((int)neighbours[i]);
+					intersection.m_out = intersection.m_finer;
+					intersection.m_outisghost = intersection.m_finer;
+					intersection.m_owners[0]  = neighbours[i];
+					intersection.m_owners[1] = idx;
+					intersection.m_iface = m_treeConstants->oppositeFace[iface2] - (getGhostLevel(idx) >= getLevel((int)neighbours[i]));
+					intersection.m_isnew = false;
+					intersection.m_isghost = true;
+					intersection.m_bound = true;
+					intersection.m_pbound = true;
+					intersections->push_back(intersection);
+				}
+			}
+		}
+	}
+
+    // =================================================================================== //
+
+    /*! Find the intersections owned by the specified internal octant, i.e.,
+     * the intersections on its negative faces and the boundary intersections
+     * on its positive faces.
+     * \param[in] idx Index of the internal octant.
+     * \param[in,out] neighbours Scratch storage for the neighbour search.
+     * \param[in,out] isghost Scratch storage for the neighbour search.
+     * \param[in,out] intersections Intersections found will be appended to this list.
+     */
+    void
+    LocalTree::findOctantIntersections(uint32_t idx, u32vector &neighbours, bvector &isghost, intervector *intersections) const {
+
+		const Octant			&octant = m_octants[idx];
+		Intersection 			intersection;
+		uint32_t 				i, nsize;
+		uint8_t 				iface, iface2;
+
+		for (iface = 0; iface < m_dim; iface++){
+			iface2 = iface*2;
+			findNeighbours(&octant, iface2, neighbours, isghost, false, false);
+			nsize = neighbours.size();
+			if (nsize) {
+				if (!(octant.getInfo(iface2))){
 					//Internal intersection
 					for (i = 0; i < nsize; i++){
-						intersection.m_dim = m_dim;
-						intersection.m_finer = getGhostLevel(idx) >= getLevel((int)neighbours[i]);
-						intersection.m_out = intersection.m_finer;
-						intersection.m_outisghost = intersection.m_finer;
-						intersection.m_owners[0]  = neighbours[i];
-						intersection.m_owners[1] = idx;
-						intersection.m_iface = m_treeConstants->oppositeFace[iface2] - (getGhostLevel(idx) >= getLevel((int)neighbours[i]));
-						intersection.m_isnew = false;
-						intersection.m_isghost = true;
-						intersection.m_bound = false;
-						intersection.m_pbound = true;
-						m_intersections.push_back(intersection);
+						if (isghost[i]){
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = (nsize>1);
+							intersection.m_outisghost = (nsize>1);
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = true;
+							intersection.m_bound = false;
+							intersection.m_pbound = true;
+							intersections->push_back(intersection);
+						}
+						else{
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = (nsize>1);
+							intersection.m_outisghost = false;
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = false;
+							intersection.m_bound = false;
+							intersection.m_pbound = false;
+							intersections->push_back(intersection);
+						}
 					}
 				}
 				else{
 					//Periodic intersection
 					for (i = 0; i < nsize; i++){
-						intersection.m_dim = m_dim;
-						intersection.m_finer = getGhostLevel(idx) >= getLevel((int)neighbours[i]);
-						intersection.m_out = intersection.m_finer;
-						intersection.m_outisghost = intersection.m_finer;
-						intersection.m_owners[0]  = neighbours[i];
-						intersection.m_owners[1] = idx;
-						intersection.m_iface = m_treeConstants->oppositeFace[iface2] - (getGhostLevel(idx) >= getLevel((int)neighbours[i]));
-						intersection.m_isnew = false;
-						intersection.m_isghost = true;
-						intersection.m_bound = true;
-						intersection.m_pbound = true;
-						m_intersections.push_back(intersection);
-					}
-				}
-			}
-			idx++;
-		}
-
-		// Loop on octants
-		idx=0;
-		obegin = m_octants.begin();
-		oend = m_octants.end();
-		for (it = obegin; it != oend; ++it){
-			for (iface = 0; iface < m_dim; iface++){
-				iface2 = iface*2;
-				findNeighbours(m_octants.data() + idx, iface2, neighbours, isghost, false, false);
-				nsize = neighbours.size();
-				if (nsize) {
-					if (!(it->m_info[iface2])){
-						//Internal intersection
-						for (i = 0; i < nsize; i++){
-							if (isghost[i]){
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = (nsize>1);
-								intersection.m_outisghost = (nsize>1);
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = true;
-								intersection.m_bound = false;
-								intersection.m_pbound = true;
-								m_intersections.push_back(intersection);
-							}
-							else{
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = (nsize>1);
-								intersection.m_outisghost = false;
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = false;
-								intersection.m_bound = false;
-								intersection.m_pbound = false;
-								m_intersections.push_back(intersection);
-							}
+						if (isghost[i]){
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = intersection.m_finer;
+							intersection.m_outisghost = intersection.m_finer;
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = true;
+							intersection.m_bound = true;
+							intersection.m_pbound = true;
+							intersections->push_back(intersection);
 						}
-					}
-					else{
-						//Periodic intersection
-						for (i = 0; i < nsize; i++){
-							if (isghost[i]){
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = intersection.m_finer;
-								intersection.m_outisghost = intersection.m_finer;
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = true;
-								intersection.m_bound = true;
-								intersection.m_pbound = true;
-								m_intersections.push_back(intersection);
-							}
-							else{
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = intersection.m_finer;
-								intersection.m_outisghost = false;
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = false;
-								intersection.m_bound = true;
-								intersection.m_pbound = false;
-								m_intersections.push_back(intersection);
-							}
+						else{
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = intersection.m_finer;
+							intersection.m_outisghost = false;
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = false;
+							intersection.m_bound = true;
+							intersection.m_pbound = false;
+							intersections->push_back(intersection);
 						}
 					}
 				}
-				else{
+			}
+			else{
+				//Boundary intersection
+				intersection.m_dim = m_dim;
+				intersection.m_owners[0] = idx;
+				intersection.m_owners[1] = idx;
+				intersection.m_finer = 0;
+				intersection.m_out = 0;
+				intersection.m_outisghost = false;
+				intersection.m_iface = iface2;
+				intersection.m_isnew = false;
+				intersection.m_isghost = false;
+				intersection.m_bound = true;
+				intersection.m_pbound = false;
+				intersections->push_back(intersection);
+			}
+			if (octant.getInfo(iface2+1)){
+				if (!(m_periodic[iface2+1])){
 					//Boundary intersection
 					intersection.m_dim = m_dim;
 					intersection.m_owners[0] = idx;
@@ -2634,69 +3181,50 @@ namespace bitpit {
 					intersection.m_finer = 0;
 					intersection.m_out = 0;
 					intersection.m_outisghost = false;
-					intersection.m_iface = iface2;
+					intersection.m_iface = iface2+1;
 					intersection.m_isnew = false;
 					intersection.m_isghost = false;
 					intersection.m_bound = true;
 					intersection.m_pbound = false;
-					m_intersections.push_back(intersection);
+					intersections->push_back(intersection);
 				}
-				if (it->m_info[iface2+1]){
-					if (!(m_periodic[iface2+1])){
-						//Boundary intersection
-						intersection.m_dim = m_dim;
-						intersection.m_owners[0] = idx;
-						intersection.m_owners[1] = idx;
-						intersection.m_finer = 0;
-						intersection.m_out = 0;
-						intersection.m_outisghost = false;
-						intersection.m_iface = iface2+1;
-						intersection.m_isnew = false;
-						intersection.m_isghost = false;
-						intersection.m_bound = true;
-						intersection.m_pbound = false;
-						m_intersections.push_back(intersection);
-					}
-					else{
-						//Periodic intersection
-						findNeighbours(m_octants.data() + idx, iface2+1, neighbours, isghost, false, false);
-						nsize = neighbours.size();
-						for (i = 0; i < nsize; i++){
-							if (isghost[i]){
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = intersection.m_finer;
-								intersection.m_outisghost = intersection.m_finer;
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = true;
-								intersection.m_bound = true;
-								intersection.m_pbound = true;
-								m_intersections.push_back(intersection);
-							}
-							else{
-								intersection.m_dim = m_dim;
-								intersection.m_owners[0] = idx;
-								intersection.m_owners[1] = neighbours[i];
-								intersection.m_finer = (nsize>1);
-								intersection.m_out = intersection.m_finer;
-								intersection.m_outisghost = false;
-								intersection.m_iface = iface2 + (nsize>1);
-								intersection.m_isnew = false;
-								intersection.m_isghost = false;
-								intersection.m_bound = true;
-								intersection.m_pbound = false;
-								m_intersections.push_back(intersection);
-							}
+				else{
+					//Periodic intersection
+					findNeighbours(&octant, iface2+1, neighbours, isghost, false, false);
+					nsize = neighbours.size();
+					for (i = 0; i < nsize; i++){
+						if (isghost[i]){
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = intersection.m_finer;
+							intersection.m_outisghost = intersection.m_finer;
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = true;
+							intersection.m_bound = true;
+							intersection.m_pbound = true;
+							intersections->push_back(intersection);
+						}
+						else{
+							intersection.m_dim = m_dim;
+							intersection.m_owners[0] = idx;
+							intersection.m_owners[1] = neighbours[i];
+							intersection.m_finer = (nsize>1);
+							intersection.m_out = intersection.m_finer;
+							intersection.m_outisghost = false;
+							intersection.m_iface = iface2 + (nsize>1);
+							intersection.m_isnew = false;
+							intersection.m_isghost = false;
+							intersection.m_bound = true;
+							intersection.m_pbound = false;
+							intersections->push_back(intersection);
 						}
 					}
 				}
 			}
-			idx++;
 		}
-		intervector(m_intersections).swap(m_intersections);
 	}
 
     // =================================================================================== //
@@ -2853,82 +3381,249 @@ namespace bitpit {
 
     // =================================================================================== //
 
+    /** Find the internal octants that contain the specified anchor Morton numbers.
+     *
+     * Morton numbers are sorted and then merged with the octants, which are
+     * already sorted by Morton number. When the distance between consecutive
+     * Morton numbers is large, the merge falls back to a binary search. When
+     * OpenMP is enabled, Morton numbers are split in chunks that are sorted
+     * and merged independently by different threads.
+     * \param[in] nMortons is the number of Morton numbers
+     * \param[in] mortons are the anchor Morton numbers of the points, all the
+     * valid Morton numbers should belong to the partition of the local tree
+     * \param[out] owners on output will contain the index of the internal octant
+     * that contains each Morton number, if the Morton number is invalid the
+     * maximum value representable by uint32_t will be returned
+     */
+    void
+    LocalTree::findMortonOwners(std::size_t nMortons, const uint64_t *mortons, uint32_t *owners) const {
+
+        // Maximum number of octants skipped linearly during the merge
+        const uint32_t MAX_LINEAR_STEPS = 16;
+
+        uint32_t nOctants = m_octants.size();
+
+        // Split Morton numbers in chunks
+        int nChunks = 1;
+#if BITPIT_ENABLE_OPENMP==1
+        if (nMortons >= THREADED_POINT_LOCATION_MIN_POINTS) {
+            nChunks = omp_get_max_threads();
+        }
+#endif
+
+        std::vector<std::size_t> chunkBegins(nChunks + 1);
+        for (int chunk = 0; chunk <= nChunks; ++chunk) {
+            chunkBegins[chunk] = (nMortons * chunk) / nChunks;
+        }
+
+        // Sort and merge each chunk
+        std::vector<std::pair<uint64_t, std::size_t>> sortedMortons(nMortons);
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            std::size_t chunkBegin = chunkBegins[chunk];
+            std::size_t chunkEnd   = chunkBegins[chunk + 1];
+            for (std::size_t n = chunkBegin; n < chunkEnd; ++n) {
+                sortedMortons[n] = std::make_pair(mortons[n], n);
+            }
+
+            std::sort(sortedMortons.begin() + chunkBegin, sortedMortons.begin() + chunkEnd);
+
+            uint32_t upperBoundIdx = 0;
+            bool upperBoundValid = false;
+            for (std::size_t n = chunkBegin; n < chunkEnd; ++n) {
+                uint64_t morton = sortedMortons[n].first;
+                std::size_t position = sortedMortons[n].second;
+                if (morton == PABLO::INVALID_MORTON || nOctants == 0) {
+                    owners[position] = std::numeric_limits<uint32_t>::max();
+                    continue;
+                }
+
+                // Advance the upper bound
+                bool linearSearch = upperBoundValid;
+                uint32_t nSteps = 0;
+                while (linearSearch && upperBoundIdx < nOctants && m_octants[upperBoundIdx].getMorton() <= morton) {
+                    ++upperBoundIdx;
+                    if (++nSteps == MAX_LINEAR_STEPS) {
+                        linearSearch = false;
+                    }
+                }
+
+                if (!linearSearch) {
+                    uint64_t upperBoundMorton;
+                    findMortonUpperBound(morton, m_octants, &upperBoundIdx, &upperBoundMorton);
+                    upperBoundValid = true;
+                }
+
+                // The owner is the octant that precedes the upper bound
+                if (upperBoundIdx > 0) {
+                    owners[position] = upperBoundIdx - 1;
+                } else {
+                    owners[position] = std::numeric_limits<uint32_t>::max();
+                }
+            }
+        }
+    }
+
+    // =================================================================================== //
+
     /** Compute the connectivity of octants and store the coordinates of nodes.
+     *
+     * The connectivity is stored in flat containers (an offset for each octant
+     * and a contiguous list of node indices). The nodes are identified by
+     * sorting all the pairs (node key, octant vertex) and by assigning a new
+     * index every time the key changes. Both the gathering of the keys and the
+     * sort are performed in chunks, when OpenMP is enabled each chunk is
+     * processed by a different thread and the sorted chunks are then merged.
+     * The nodes are ordered by their persistent key, the vertices of each
+     * octant are listed following the local node numbering.
      */
     void
     LocalTree::computeConnectivity(){
-        vector<uint64_t>                             nodeKeys;
-        unordered_map<uint64_t, array<uint32_t, 3> > nodeCoords;
-        unordered_map<uint64_t, vector<uint64_t> >   nodeOctants;
-        uint32_t                                     noctants = getNumOctants();
-        uint32_t                                     nghosts  = getNumGhosts();
-
+        uint32_t noctants     = getNumOctants();
+        uint32_t nghosts      = getNumGhosts();
+        uint64_t nAllOctants  = static_cast<uint64_t>(noctants) + nghosts;
+        uint8_t  nOctantNodes = m_treeConstants->nNodes;
+        uint64_t nVertices    = nAllOctants * nOctantNodes;
 
+        // Split octants in chunks
+        int nChunks = 1;
+#if BITPIT_ENABLE_OPENMP==1
+        if (nAllOctants >= THREADED_CONNECTIVITY_MIN_OCTANTS) {
+            nChunks = omp_get_max_threads();
+        }
+#endif
 
-        // Gather node information
-        nodeKeys.reserve(noctants);
-        nodeCoords.reserve(noctants);
-        nodeOctants.reserve(noctants);
+        std::vector<uint64_t> chunkBegins(nChunks + 1);
+        for (int chunk = 0; chunk <= nChunks; ++chunk) {
+            chunkBegins[chunk] = nOctantNodes * ((nAllOctants * chunk) / nChunks);
+        }
 
-        for (uint64_t n = 0; n < (noctants + nghosts); n++){
-            const Octant *octant;
-            if (n < noctants) {
-                uint32_t octantId = static_cast<uint32_t>(n);
-                octant = &(m_octants[octantId]);
+        // Gather and sort the keys of the vertices
+        //
+        // Vertices are identified by their position in the concatenation of
+        // the connectivity of internal octants and ghost octants.
+        std::vector<std::pair<uint64_t, uint64_t>> vertexKeys(nVertices);
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            if (m_dim == 3) {
+                computeVertexKeys<3>(chunkBegins[chunk], chunkBegins[chunk + 1], vertexKeys.data());
             } else {
-                uint32_t octantId = static_cast<uint32_t>(n - noctants);
-                octant = &(m_ghosts[octantId]);
+                computeVertexKeys<2>(chunkBegins[chunk], chunkBegins[chunk + 1], vertexKeys.data());
             }
 
-            for (uint8_t i = 0; i < m_treeConstants->nNodes; ++i){
-                u32array3 node;
-                octant->getLogicalNode(node, i);
+            std::sort(vertexKeys.begin() + chunkBegins[chunk], vertexKeys.begin() + chunkBegins[chunk + 1]);
+        }
 
-                uint64_t nodeKey = octant->computeNodePersistentKey(node);
-                if (nodeCoords.count(nodeKey) == 0) {
-                    nodeKeys.push_back(nodeKey);
-                    nodeCoords.insert({{nodeKey, std::move(node)}});
-                    nodeOctants[nodeKey].reserve(m_treeConstants->nNodes);
-                }
+        for (int width = 1; width < nChunks; width *= 2) {
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static)
+#endif
+            for (int chunk = 0; chunk < nChunks - width; chunk += 2 * width) {
+                auto chunkBegin = vertexKeys.begin() + chunkBegins[chunk];
+                auto chunkMid   = vertexKeys.begin() + chunkBegins[chunk + width];
+                auto chunkEnd   = vertexKeys.begin() + chunkBegins[std::min(chunk + 2 * width, nChunks)];
+                std::inplace_merge(chunkBegin, chunkMid, chunkEnd);
+            }
+        }
+
+        // Count the unique nodes of each chunk
+        std::vector<uint64_t> chunkNodeOffsets(nChunks + 1, 0);
 
-                nodeOctants[nodeKey].push_back(n);
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint64_t nChunkNodes = 0;
+            for (uint64_t k = chunkBegins[chunk]; k < chunkBegins[chunk + 1]; ++k) {
+                if (k == 0 || vertexKeys[k].first != vertexKeys[k - 1].first) {
+                    ++nChunkNodes;
+                }
             }
+
+            chunkNodeOffsets[chunk + 1] = nChunkNodes;
+        }
+
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            chunkNodeOffsets[chunk + 1] += chunkNodeOffsets[chunk];
         }
-        std::sort(nodeKeys.begin(), nodeKeys.end());
 
         // Build node list and connectivity
-        m_nodes.clear();
-        m_connectivity.clear();
-        m_ghostsConnectivity.clear();
-
-        m_nodes.reserve(nodeKeys.size());
-        m_connectivity.resize(noctants);
-        m_ghostsConnectivity.resize(nghosts);
-
-        uint32_t nodeId = 0;
-        for (uint64_t nodeKey : nodeKeys) {
-            m_nodes.emplace_back(std::move(nodeCoords.at(nodeKey)));
-            for (uint64_t n : nodeOctants.at(nodeKey)) {
-                std::vector<uint32_t> *octantConnect;
-                if (n < noctants) {
-                    uint32_t octantId = static_cast<uint32_t>(n);
-                    octantConnect = &(m_connectivity[octantId]);
-                } else {
-                    uint32_t octantId = static_cast<uint32_t>(n - noctants);
-                    octantConnect = &(m_ghostsConnectivity[octantId]);
+        m_nodes.resize(chunkNodeOffsets[nChunks]);
+        m_connectivity.initialize(noctants, nOctantNodes, 0);
+        m_ghostsConnectivity.initialize(nghosts, nOctantNodes, 0);
+
+        uint64_t nInternalVertices = static_cast<uint64_t>(noctants) * nOctantNodes;
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            // The first vertex of the first chunk always defines a new node,
+            // the initial value of the node index will never be used as is.
+            uint32_t nodeId = static_cast<uint32_t>(chunkNodeOffsets[chunk] - 1);
+            for (uint64_t k = chunkBegins[chunk]; k < chunkBegins[chunk + 1]; ++k) {
+                uint64_t vertex = vertexKeys[k].second;
+                if (k == 0 || vertexKeys[k].first != vertexKeys[k - 1].first) {
+                    ++nodeId;
+                    getVertexOctant(vertex)->getLogicalNode(m_nodes[nodeId], static_cast<uint8_t>(vertex % nOctantNodes));
                 }
 
-                if (octantConnect->size() == 0) {
-                    octantConnect->reserve(m_treeConstants->nNodes);
+                if (vertex < nInternalVertices) {
+                    m_connectivity.rawSetItem(vertex, nodeId);
+                } else {
+                    m_ghostsConnectivity.rawSetItem(vertex - nInternalVertices, nodeId);
                 }
-                octantConnect->push_back(nodeId);
             }
-            nodeId++;
         }
 
         m_nodes.shrink_to_fit();
     };
 
+    /** Compute the persistent keys of the specified range of vertices.
+     * Vertices are numbered by listing, one octant after the other, the nodes
+     * of the internal octants followed by the nodes of the ghost octants. The
+     * range should contain all the vertices of the octants it spans. The
+     * dimension of the tree is given at compile time, it should match the
+     * runtime dimension of the tree.
+     * \param[in] begin Index of the first vertex of the range
+     * \param[in] end Index past the last vertex of the range
+     * \param[out] vertexKeys On output will contain, for each vertex of the
+     * range, the pair made by its persistent key and its index
+     */
+    template<int dim>
+    void
+    LocalTree::computeVertexKeys(uint64_t begin, uint64_t end, std::pair<uint64_t, uint64_t> *vertexKeys) const{
+        constexpr uint8_t nOctantNodes = (1 << dim);
+        for (uint64_t vertex = begin; vertex < end; vertex += nOctantNodes) {
+            const Octant *octant = getVertexOctant(vertex);
+            for (uint8_t i = 0; i < nOctantNodes; ++i){
+                vertexKeys[vertex + i] = std::make_pair(octant->computeNodePersistentKey<dim>(i), vertex + i);
+            }
+        }
+    };
+
+    /** Get the octant (internal or ghost) that owns the specified vertex.
+     * Vertices are numbered by listing, one octant after the other, the nodes
+     * of the internal octants followed by the nodes of the ghost octants.
+     * \param[in] vertex Index of the vertex
+     * \return Pointer to the octant that owns the vertex.
+     */
+    const Octant *
+    LocalTree::getVertexOctant(uint64_t vertex) const{
+        uint64_t n = vertex / m_treeConstants->nNodes;
+        if (n < m_octants.size()) {
+            return &(m_octants[static_cast<uint32_t>(n)]);
+        } else {
+            return &(m_ghosts[static_cast<uint32_t>(n - m_octants.size())]);
+        }
+    };
+
     /*! Clear nodes vector and connectivity of octants of local tree
      * \param[in] release if it's true the memory hold by the connectivity will be
      * released, otherwise the connectivity will be cleared but its memory will
@@ -2938,12 +3633,12 @@ namespace bitpit {
     LocalTree::clearConnectivity(bool release){
         if (release) {
             u32arr3vector().swap(m_nodes);
-            u32vector2D().swap(m_connectivity);
-            u32vector2D().swap(m_ghostsConnectivity);
+            m_connectivity.clear(true);
+            m_ghostsConnectivity.clear(true);
         } else {
             m_nodes.clear();
-            m_connectivity.clear();
-            m_ghostsConnectivity.clear();
+            m_connectivity.clear(false);
+            m_ghostsConnectivity.clear(false);
         }
     };
 
@@ -2957,4 +3652,254 @@ namespace bitpit {
 
     // =================================================================================== //
 
+    /*! Clear the neighbours stored in the graph.
+     * \param[in] release if it's true the memory hold by the graph will be
+     * released, otherwise the graph will be cleared but its memory will
+     * not be released
+     */
+    void
+    LocalTree::NeighbourGraph::clear(bool release){
+        if (release) {
+            u64vector().swap(offsets);
+            u32vector().swap(neighbours);
+            bvector().swap(ghostFlags);
+        } else {
+            offsets.clear();
+            neighbours.clear();
+            ghostFlags.clear();
+        }
+    };
+
+    /*! Get the number of entities of the specified codimension of an octant.
+     * \param[in] codim Codimension of the entities (1=face, 2=edge and 3=vertex
+     * for 3D trees, 1=face, 2=vertex for 2D trees)
+     * \return The number of entities of the specified codimension.
+     */
+    uint8_t
+    LocalTree::getNeighbourGraphEntityCount(uint8_t codim) const{
+        if (codim == 1) {
+            return m_treeConstants->nFaces;
+        } else if (codim == 2 && m_dim == 3) {
+            return m_treeConstants->nEdges;
+        } else if (codim == m_dim) {
+            return m_treeConstants->nNodes;
+        }
+
+        return 0;
+    };
+
+    /*! Compute the neighbour graph of the local octants, i.e., the neighbours
+     * (both local and ghost ones) of all the local octants through all their
+     * entities up to the specified codimension.
+     * \param[in] maxCodim Maximum codimension of the entities (1=faces only,
+     * 2=faces and edges for 3D trees or faces and nodes for 2D trees, 3=faces,
+     * edges and nodes for 3D trees)
+     */
+    void
+    LocalTree::computeNeighbourGraph(uint8_t maxCodim){
+        clearNeighbourGraph(false);
+
+        m_neighGraphCodim = std::min(maxCodim, m_dim);
+        for (uint8_t codim = 1; codim <= m_neighGraphCodim; ++codim) {
+            evalNeighbourGraph(codim, nullptr, nullptr, nullptr, &(m_neighGraphs[codim - 1]));
+        }
+    };
+
+    /*! Update the neighbour graph after an adaption with tracking of the
+     * changes.
+     *
+     * The neighbours of an entity of an octant that has not been modified
+     * by the adaption are reused (after renumbering) if they were all local
+     * octants that have not been modified as well: they still cover the same
+     * region across the entity, hence the set of neighbours is unchanged. The
+     * neighbours of all other entities are searched again. If no mapping is
+     * available the graph is computed from scratch.
+     *
+     * \param[in] mapidx mapidx[i] = index in old octants vector of the new i-th
+     * octant. See LocalTree::refine for a detailed description of the mapping.
+     */
+    void
+    LocalTree::updateNeighbourGraph(const u32vector & mapidx){
+        if (m_neighGraphCodim == 0) {
+            return;
+        }
+
+        uint32_t nOctants = getNumOctants();
+        if (mapidx.size() != nOctants) {
+            computeNeighbourGraph(m_neighGraphCodim);
+            return;
+        }
+
+        // Map previous octants that have not been modified to their current
+        // position
+        uint64_t nPreviousOctants = (m_neighGraphs[0].offsets.size() - 1) / getNeighbourGraphEntityCount(1);
+
+        u32vector previousToCurrent(nPreviousOctants, std::numeric_limits<uint32_t>::max());
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            const Octant &octant = m_octants[idx];
+            if (octant.getIsNewR() || octant.getIsNewC()) {
+                continue;
+            }
+
+            previousToCurrent[mapidx[idx]] = idx;
+        }
+
+        // Update the graphs
+        for (uint8_t codim = 1; codim <= m_neighGraphCodim; ++codim) {
+            NeighbourGraph previousGraph;
+            std::swap(previousGraph, m_neighGraphs[codim - 1]);
+            evalNeighbourGraph(codim, &previousGraph, &mapidx, &previousToCurrent, &(m_neighGraphs[codim - 1]));
+        }
+    };
+
+    /*! Clear the neighbour graph of the local octants.
+     * \param[in] release if it's true the memory hold by the graph will be
+     * released, otherwise the graph will be cleared but its memory will
+     * not be released
+     */
+    void
+    LocalTree::clearNeighbourGraph(bool release){
+        m_neighGraphCodim = 0;
+        for (NeighbourGraph &graph : m_neighGraphs) {
+            graph.clear(release);
+        }
+    };
+
+    /*! Evaluate the neighbour graph of the local octants through the entities
+     * of the specified codimension.
+     *
+     * Octants are processed in Morton order, split in contiguous chunks; when
+     * OpenMP is enabled and the tree is large enough each chunk is processed
+     * by a different thread. If a previous graph is given, the neighbours of
+     * the entities that were not affected by the adaption are taken from the
+     * previous graph (see LocalTree::updateNeighbourGraph).
+     *
+     * \param[in] codim Codimension of the entities
+     * \param[in] previousGraph Graph before the adaption, can be null
+     * \param[in] mapidx Mapping from current octants to previous octants,
+     * can be null if no previous graph is given
+     * \param[in] previousToCurrent Position of the previous octants in the
+     * current tree (maximum uint32_t value if the octant has been modified),
+     * can be null if no previous graph is given
+     * \param[out] graph On output will contain the neighbour graph
+     */
+    void
+    LocalTree::evalNeighbourGraph(uint8_t codim, const NeighbourGraph *previousGraph, const u32vector *mapidx,
+                                  const u32vector *previousToCurrent, NeighbourGraph *graph) const{
+        uint32_t nOctants  = getNumOctants();
+        uint8_t  nEntities = getNeighbourGraphEntityCount(codim);
+        uint64_t nItems    = static_cast<uint64_t>(nOctants) * nEntities;
+
+        // Split octants in chunks
+        int nChunks = 1;
+#if BITPIT_ENABLE_OPENMP==1
+        if (nOctants >= THREADED_NEIGHBOUR_GRAPH_MIN_OCTANTS) {
+            nChunks = omp_get_max_threads();
+        }
+#endif
+
+        std::vector<uint32_t> chunkBegins(nChunks + 1);
+        for (int chunk = 0; chunk <= nChunks; ++chunk) {
+            chunkBegins[chunk] = static_cast<uint32_t>((static_cast<uint64_t>(nOctants) * chunk) / nChunks);
+        }
+
+        // Find the neighbours of each chunk
+        //
+        // The offsets of each chunk are evaluated relative to the beginning
+        // of the chunk, they will be shifted once the size of all the chunks
+        // is known.
+        graph->offsets.resize(nItems + 1);
+        graph->offsets[0] = 0;
+
+        std::vector<u32vector> chunkNeighbours(nChunks);
+        std::vector<bvector>   chunkGhostFlags(nChunks);
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            u32vector &neighbours  = chunkNeighbours[chunk];
+            bvector   &ghostFlags  = chunkGhostFlags[chunk];
+
+            for (uint32_t idx = chunkBegins[chunk]; idx < chunkBegins[chunk + 1]; ++idx) {
+                const Octant *octant = &(m_octants[idx]);
+
+                bool isReusable = (previousGraph && !octant->getIsNewR() && !octant->getIsNewC());
+                uint64_t previousItem = 0;
+                if (isReusable) {
+                    previousItem = static_cast<uint64_t>((*mapidx)[idx]) * nEntities;
+                }
+
+                for (uint8_t entity = 0; entity < nEntities; ++entity) {
+                    // Reuse the previous neighbours
+                    bool isEntityReused = false;
+                    if (isReusable) {
+                        uint64_t previousBegin = previousGraph->offsets[previousItem + entity];
+                        uint64_t previousEnd   = previousGraph->offsets[previousItem + entity + 1];
+
+                        isEntityReused = (previousEnd > previousBegin);
+                        for (uint64_t k = previousBegin; k < previousEnd; ++k) {
+                            if (previousGraph->ghostFlags[k] || (*previousToCurrent)[previousGraph->neighbours[k]] == std::numeric_limits<uint32_t>::max()) {
+                                isEntityReused = false;
+                                break;
+                            }
+                        }
+
+                        if (isEntityReused) {
+                            for (uint64_t k = previousBegin; k < previousEnd; ++k) {
+                                neighbours.push_back((*previousToCurrent)[previousGraph->neighbours[k]]);
+                                ghostFlags.push_back(false);
+                            }
+                        }
+                    }
+
+                    // Search the neighbours
+                    if (!isEntityReused) {
+                        if (codim == 1) {
+                            findNeighbours(octant, entity, neighbours, ghostFlags, false, true);
+                        } else if (codim == 2 && m_dim == 3) {
+                            findEdgeNeighbours(octant, entity, neighbours, ghostFlags, false, true);
+                        } else {
+                            findNodeNeighbours(octant, entity, neighbours, ghostFlags, false, true);
+                        }
+                    }
+
+                    graph->offsets[static_cast<uint64_t>(idx) * nEntities + entity + 1] = neighbours.size();
+                }
+            }
+        }
+
+        // Evaluate the beginning of each chunk
+        std::vector<uint64_t> chunkOffsets(nChunks + 1, 0);
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            chunkOffsets[chunk + 1] = chunkOffsets[chunk] + chunkNeighbours[chunk].size();
+        }
+
+        // Assemble the graph
+        graph->neighbours.resize(chunkOffsets[nChunks]);
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            uint64_t chunkItemBegin = static_cast<uint64_t>(chunkBegins[chunk]) * nEntities;
+            uint64_t chunkItemEnd   = static_cast<uint64_t>(chunkBegins[chunk + 1]) * nEntities;
+            for (uint64_t k = chunkItemBegin; k < chunkItemEnd; ++k) {
+                graph->offsets[k + 1] += chunkOffsets[chunk];
+            }
+
+            std::copy(chunkNeighbours[chunk].begin(), chunkNeighbours[chunk].end(), graph->neighbours.begin() + chunkOffsets[chunk]);
+            u32vector().swap(chunkNeighbours[chunk]);
+        }
+
+        // Ghost flags are packed, hence they are assembled serially
+        graph->ghostFlags.clear();
+        graph->ghostFlags.reserve(chunkOffsets[nChunks]);
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            graph->ghostFlags.insert(graph->ghostFlags.end(), chunkGhostFlags[chunk].begin(), chunkGhostFlags[chunk].end());
+        }
+    };
+
+    // =================================================================================== //
+
 }
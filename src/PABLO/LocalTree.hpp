@@ -75,6 +75,7 @@ class LocalTree{
 	// =================================================================================== //
 
 	friend class ParaTree;
+	friend class IntersectionIterator;
 
 	// =================================================================================== //
 	// TYPEDEFS
@@ -109,6 +110,36 @@ public:
 	 */
 	typedef std::vector<u32array3>				u32arr3vector;
 
+	// =================================================================================== //
+	// STATIC MEMBERS
+	// =================================================================================== //
+
+private:
+#if BITPIT_ENABLE_OPENMP==1
+	static const uint32_t	THREADED_ADAPTION_MIN_OCTANTS;	/**< Minimum number of octants for using the threaded adaption */
+	static const uint32_t	THREADED_CONNECTIVITY_MIN_OCTANTS;	/**< Minimum number of octants for using the threaded connectivity build */
+	static const uint32_t	THREADED_NEIGHBOUR_GRAPH_MIN_OCTANTS;	/**< Minimum number of octants for using the threaded neighbour graph build */
+	static const std::size_t	THREADED_POINT_LOCATION_MIN_POINTS;	/**< Minimum number of points for using the threaded point location */
+#endif
+
+	// =================================================================================== //
+	// TYPES
+	// =================================================================================== //
+
+private:
+	/*! Neighbours of the octants through the entities of a given codimension,
+	 * stored in compressed sparse row format. The neighbours of the e-th entity
+	 * of the i-th octant are stored in the range [offsets[k], offsets[k+1]), with
+	 * k = i * nEntities + e.
+	 */
+	struct NeighbourGraph {
+		u64vector	offsets;		/**< Position of the first neighbour of each (octant, entity) pair */
+		u32vector	neighbours;		/**< Indices of the neighbours in their container */
+		bvector		ghostFlags;		/**< Ghost flags of the neighbours */
+
+		void		clear(bool release);
+	};
+
 	// =================================================================================== //
 	// MEMBERS
 	// =================================================================================== //
@@ -126,11 +157,13 @@ private:
 	 	 	 	 	 	 	 	 	 	 	 	 	 	 3 = 2:1 balance through nodes, edges and faces)*/
 	u32vector 				m_lastGhostBros;		/**<Index of ghost brothers in case of broken family coarsened (tail of local octants)*/
 	u32vector 				m_firstGhostBros;		/**<Index of ghost brothers in case of broken family coarsened (head of local octants)*/
-	u32vector2D				m_connectivity;			/**<Local vector of connectivity (node1, node2, ...) ordered with Morton-order.
+	FlatVector2D<uint32_t>	m_connectivity;			/**<Local flat storage of connectivity (node1, node2, ...) ordered with Morton-order.
 	 	 	 	 	 	 	 	 	 	 	 	 	 	 The nodes are stored as index of vector nodes*/
-	u32vector2D				m_ghostsConnectivity;	/**<Local vector of ghosts connectivity (node1, node2, ...) ordered with Morton-order.
+	FlatVector2D<uint32_t>	m_ghostsConnectivity;	/**<Local flat storage of ghosts connectivity (node1, node2, ...) ordered with Morton-order.
 	 	 	 	 	 	 	 	 	 	 	 	 	 	 The nodes are stored as index of vector nodes*/
 	u32arr3vector			m_nodes;				/**<Local vector of nodes (x,y,z) ordered with Morton Number*/
+	uint8_t					m_neighGraphCodim;		/**<Maximum codimension of the entities stored in the neighbour graph (0 = no graph)*/
+	std::array<NeighbourGraph, 3>	m_neighGraphs;	/**<Neighbour graphs, the i-th graph stores neighbours through entities of codimension i+1*/
 
 	uint8_t					m_dim;					/**<Space dimension. Only 2D or 3D space accepted*/
 	const TreeConstants	   *m_treeConstants;		/**<Tree constants*/
@@ -151,6 +184,8 @@ protected:
 	std::array<int64_t, 3> computeFirstVirtualNeighOffset(uint8_t level, uint8_t iface, uint8_t neighLevel) const;
 	std::array<int64_t, 3> computeLastVirtualNeighOffset(uint8_t level, uint8_t iface, uint8_t neighLevel) const;
 	void computeVirtualNeighOffsets(uint8_t level, uint8_t iface, uint8_t neighLevel, std::vector<std::array<int64_t, 3>> *neighOffsets) const;
+	template<int dim>
+	void computeVirtualNeighOffsets(uint8_t level, uint8_t iface, uint8_t neighLevel, std::vector<std::array<int64_t, 3>> *neighOffsets) const;
 
 	std::array<int64_t, 3> computeFirstVirtualNodeNeighOffset(uint8_t level, uint8_t inode, uint8_t neighLevel) const;
 	std::array<int64_t, 3> computeLastVirtualNodeNeighOffset(uint8_t level, uint8_t inode, uint8_t neighLevel) const;
@@ -216,33 +251,55 @@ private:
 
 	bool 		refine(u32vector & mapidx);
 	bool 		coarse(u32vector & mapidx);
+	void 		coarseInternals(u32vector & mapidx, Octant *lastFather);
+#if BITPIT_ENABLE_OPENMP==1
+	bool 		isThreadedAdaptionEnabled(uint32_t nOctants) const;
+	bool 		threadedRefine(u32vector & mapidx);
+	void 		threadedCoarseInternals(u32vector & mapidx, Octant *lastFather);
+#endif
 	bool 		globalRefine(u32vector & mapidx);
 	bool 		globalCoarse(u32vector & mapidx);
 	void 		checkCoarse(uint64_t partLastDesc, u32vector & mapidx);
 	void 		updateLocalMaxDepth();
 
+    void        findNeighbours(const Octant* oct, uint8_t iface, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const;
+    template<int dim>
     void        findNeighbours(const Octant* oct, uint8_t iface, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const;
     void        findEdgeNeighbours(const Octant* oct, uint8_t iedge, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const;
     void        findNodeNeighbours(const Octant* oct, uint8_t inode, u32vector & neighbours, bvector & isghost, bool onlyinternal, bool append) const;
 
 	void 		computeNeighSearchBegin(uint64_t sameSizeVirtualNeighMorton, const octvector &octants, uint32_t *searchBeginIdx, uint64_t *searchBeginMorton) const;
 
-	bool 		localBalance(bool doNew, bool checkInterior, bool checkGhost);
+	bool 		localBalance(bool doNew, bool checkInterior, bool checkGhost, const u32vector *ghostsToCheck = nullptr);
+	template<int dim>
+	bool 		localBalance(bool doNew, bool checkInterior, bool checkGhost, const u32vector *ghostsToCheck = nullptr);
 
 	bool 		fixBrokenFamiliesMarkers(std::vector<Octant *> *updatedOctants = nullptr, std::vector<bool> *updatedGhostFlags = nullptr);
 
 	void 		computeIntersections();
+	void 		findGhostIntersections(uint32_t idx, u32vector &neighbours, bvector &isghost, intervector *intersections) const;
+	void 		findOctantIntersections(uint32_t idx, u32vector &neighbours, bvector &isghost, intervector *intersections) const;
 
 	uint32_t 	findMorton(uint64_t targetMorton) const;
 	uint32_t 	findGhostMorton(uint64_t targetMorton) const;
 	uint32_t 	findMorton(uint64_t targetMorton, const octvector &octants) const;
 	void 		findMortonLowerBound(uint64_t targetMorton, const octvector &octants, uint32_t *lowerBoundIdx, uint64_t *lowerBoundMorton) const;
 	void 		findMortonUpperBound(uint64_t targetMorton, const octvector &octants, uint32_t *upperBoundIdx, uint64_t *upperBoundMorton) const;
+	void 		findMortonOwners(std::size_t nMortons, const uint64_t *mortons, uint32_t *owners) const;
 
 	void 		computeConnectivity();
+	template<int dim>
+	void 		computeVertexKeys(uint64_t begin, uint64_t end, std::pair<uint64_t, uint64_t> *vertexKeys) const;
+	const Octant *	getVertexOctant(uint64_t vertex) const;
 	void 		clearConnectivity(bool release = true);
 	void 		updateConnectivity();
 
+	uint8_t		getNeighbourGraphEntityCount(uint8_t codim) const;
+	void		computeNeighbourGraph(uint8_t maxCodim);
+	void		updateNeighbourGraph(const u32vector & mapidx);
+	void		clearNeighbourGraph(bool release = true);
+	void		evalNeighbourGraph(uint8_t codim, const NeighbourGraph *previousGraph, const u32vector *mapidx, const u32vector *previousToCurrent, NeighbourGraph *graph) const;
+
 	// =================================================================================== //
 
 };
@@ -32,6 +32,7 @@
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace bitpit {
 
@@ -57,12 +58,14 @@ IBinaryStream& operator>>(IBinaryStream &buffer, Octant &octant)
 
     buffer >> octant.m_marker;
 
-    buffer >> octant.m_ghost;
+    int ghostLayer;
+    buffer >> ghostLayer;
+    octant.setGhostLayer(ghostLayer);
 
     for(int i = 0; i < Octant::INFO_ITEM_COUNT; ++i){
         bool value;
         buffer >> value;
-        octant.m_info[i] = value;
+        octant.setInfo(i, value);
     }
 
     return buffer;
@@ -85,10 +88,10 @@ OBinaryStream& operator<<(OBinaryStream  &buffer, const Octant &octant)
 
     buffer << octant.m_marker;
 
-    buffer << octant.m_ghost;
+    buffer << octant.getGhostLayer();
 
     for(int i = 0; i < Octant::INFO_ITEM_COUNT; ++i){
-        buffer << (bool) octant.m_info[i];
+        buffer << octant.getInfo(i);
     }
 
     return buffer;
@@ -212,8 +215,8 @@ Octant::initialize(uint8_t dim, uint8_t level, bool bound) {
 	m_morton = 0;
 
 	// Initialize octant info
-	m_info.reset();
-	m_info[OctantInfo::INFO_BALANCED] = true;
+	m_info = 0;
+	setInfo(OctantInfo::INFO_BALANCED, true);
 	m_ghost = -1;
 
 	// If this is the root octant we need to set the boundary condition bound
@@ -221,7 +224,7 @@ Octant::initialize(uint8_t dim, uint8_t level, bool bound) {
 	if (m_dim >= 2 && m_level == 0) {
 		uint8_t nf = m_dim*2;
 		for (uint8_t i=0; i<nf; i++){
-			m_info[i] = bound;
+			setInfo(i, bound);
 		}
 	}
 };
@@ -270,7 +273,7 @@ Octant::getMarker() const{return m_marker;};
  */
 bool
 Octant::getBound(uint8_t face) const{
-	return (m_info[OctantInfo::INFO_BOUNDFACE0 + face]);
+	return (getInfo(OctantInfo::INFO_BOUNDFACE0 + face));
 };
 
 /*! Get the bound flag on an octant edge.
@@ -322,7 +325,7 @@ Octant::getBound() const{
  */
 void
 Octant::setBound(uint8_t face) {
-	m_info[INFO_BOUNDFACE0 + face] = true;
+	setInfo(INFO_BOUNDFACE0 + face, true);
 };
 
 /*! Get the pbound flag on an octant face.
@@ -331,7 +334,7 @@ Octant::setBound(uint8_t face) {
  */
 bool
 Octant::getPbound(uint8_t face) const{
-	return m_info[INFO_PBOUNDFACE0 + face];
+	return getInfo(INFO_PBOUNDFACE0 + face);
 };
 
 /*! Get the pbound flag on an octant face.
@@ -352,13 +355,13 @@ Octant::getPbound() const{
  * \return true if the the octant is new after a refinement.
  */
 bool
-Octant::getIsNewR() const{return m_info[OctantInfo::INFO_NEW4REFINEMENT];};
+Octant::getIsNewR() const{return getInfo(OctantInfo::INFO_NEW4REFINEMENT);};
 
 /*! Get if the octant is new after a coarsening.
  * \return true if the the octant is new after a coarsening.
  */
 bool
-Octant::getIsNewC() const{return m_info[OctantInfo::INFO_NEW4COARSENING];};
+Octant::getIsNewC() const{return getInfo(OctantInfo::INFO_NEW4COARSENING);};
 
 /*! Get if the octant is a scary ghost octant.
  * \return true if the octant is a ghost octant.
@@ -376,7 +379,7 @@ Octant::getGhostLayer() const{return m_ghost;};
  * \return true if the octant has to be balanced.
  */
 bool
-Octant::getBalance() const{return (m_info[OctantInfo::INFO_BALANCED]);};
+Octant::getBalance() const{return (getInfo(OctantInfo::INFO_BALANCED));};
 
 /*! Set the refinement marker of an octant.
  * \param[in] marker Refinement marker of octant (n=n refinement in adapt, -n=n coarsening in adapt, default=0).
@@ -391,7 +394,7 @@ Octant::setMarker(int8_t marker){
  */
 void
 Octant::setBalance(bool balance){
-	m_info[OctantInfo::INFO_BALANCED] = balance;
+	setInfo(OctantInfo::INFO_BALANCED, balance);
 };
 
 /*! Set the level of an octant.
@@ -408,7 +411,7 @@ Octant::setLevel(uint8_t level){
  */
 void
 Octant::setPbound(uint8_t face, bool flag){
-	m_info[INFO_PBOUNDFACE0 + face] = flag;
+	setInfo(INFO_PBOUNDFACE0 + face, flag);
 };
 
 /*! Set the ghost specifier of an octant.
@@ -417,7 +420,8 @@ Octant::setPbound(uint8_t face, bool flag){
  */
 void
 Octant::setGhostLayer(int ghostLayer){
-    m_ghost = ghostLayer;
+    assert(ghostLayer >= std::numeric_limits<int16_t>::min() && ghostLayer <= std::numeric_limits<int16_t>::max());
+    m_ghost = static_cast<int16_t>(ghostLayer);
 };
 
 
@@ -589,6 +593,15 @@ uint64_t	Octant::computeLastDescMorton() const {
 	return PABLO::computeMorton(m_dim, lastDescCoordinates[0], lastDescCoordinates[1], lastDescCoordinates[2]);
 };
 
+/** Compute the Morton index of the octant that follows this octant in a
+ * complete linear octree, i.e., the Morton index of the first octant after
+ * the last descendant of this octant.
+ * \return Morton index of the octant that follows this octant.
+ */
+uint64_t	Octant::computeNextMorton() const {
+	return m_morton + (uint64_t(1) << (m_dim * (sm_treeConstants[m_dim].maxLevel - m_level)));
+};
+
 /** Compute the coordinates (i.e. the coordinates of the node 0) of the last
  * descendant octant of this octant.
  * \return The coordinates (i.e. the coordinates of the node 0) of the last
@@ -634,9 +647,11 @@ u32array3	Octant::computeFatherCoordinates() const {
  */
 uint64_t	Octant::computeNodePersistentKey(uint8_t inode) const{
 
-	u32array3 node = getLogicalNode(inode);
-
-	return computeNodePersistentKey(node);
+	if (m_dim == 3) {
+		return computeNodePersistentKey<3>(inode);
+	} else {
+		return computeNodePersistentKey<2>(inode);
+	}
 };
 
 /** Compute the persistent XYZ key of the given node (without level).
@@ -670,6 +685,123 @@ unsigned int Octant::getBinarySize()
 
 // =================================================================================== //
 // OTHER METHODS
+/** Get the size of the compact binary representation of the octant.
+ * \param[in] expectedMorton Expected Morton number of the octant (see
+ * encodeCompactBinary)
+ * \return Returns the size (in bytes) of the compact binary representation.
+ */
+unsigned int Octant::getCompactBinarySize(uint64_t expectedMorton) const
+{
+	char data[COMPACT_BINARY_MAX_SIZE];
+	return encodeCompactBinary(expectedMorton, data);
+}
+
+namespace {
+
+/*! Write an unsigned integer using a variable-length encoding (seven bits
+ * per byte, the most significant bit of each byte tells if more bytes
+ * follow).
+ * \param[in] value Value to encode
+ * \param[out] data Buffer the encoded value will be written to
+ * \return The number of bytes written.
+ */
+unsigned int writeVarint(uint64_t value, char *data)
+{
+	unsigned int size = 0;
+	while (value >= 0x80) {
+		data[size++] = static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	data[size++] = static_cast<char>(value);
+
+	return size;
+}
+
+/*! Read an unsigned integer written using writeVarint.
+ * \param[in] data Buffer containing the encoded value
+ * \param[out] value Decoded value
+ * \return The number of bytes read.
+ */
+unsigned int readVarint(const char *data, uint64_t *value)
+{
+	unsigned int size = 0;
+	unsigned int shift = 0;
+	*value = 0;
+	while (true) {
+		uint64_t byte = static_cast<unsigned char>(data[size++]);
+		*value |= (byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			break;
+		}
+		shift += 7;
+	}
+
+	return size;
+}
+
+}
+
+/** Encode the octant using a compact binary representation.
+ *
+ * The Morton number is stored as a variable-length difference from the
+ * expected Morton number: in a Morton-ordered sequence of octants the
+ * expected Morton number of an octant is the one that follows the previous
+ * octant (see computeNextMorton), for a complete linear octree the
+ * difference is zero. The other octant data (level, info flags, marker and
+ * ghost layer) is stored using variable-length encodings optimized for the
+ * most common values. The first byte contains the size of the remaining
+ * data, hence the representation can be read without knowing its size.
+ *
+ * \param[in] expectedMorton Expected Morton number of the octant
+ * \param[out] data Buffer the representation will be written to, it should
+ * be able to contain COMPACT_BINARY_MAX_SIZE bytes
+ * \return Returns the size (in bytes) of the compact binary representation.
+ */
+unsigned int Octant::encodeCompactBinary(uint64_t expectedMorton, char *data) const
+{
+	const uint16_t DEFAULT_INFO = static_cast<uint16_t>(1u << INFO_BALANCED);
+
+	unsigned int size = 1;
+	size += writeVarint(m_morton - expectedMorton, data + size);
+	data[size++] = static_cast<char>(m_level);
+	size += writeVarint(static_cast<uint16_t>(m_info ^ DEFAULT_INFO), data + size);
+	data[size++] = static_cast<char>(m_marker);
+	size += writeVarint(static_cast<uint64_t>(m_ghost + 1), data + size);
+
+	data[0] = static_cast<char>(size - 1);
+
+	return size;
+}
+
+/** Initialize the octant from its compact binary representation (see
+ * encodeCompactBinary).
+ * \param[in] dim Dimension of the octant
+ * \param[in] expectedMorton Expected Morton number of the octant
+ * \param[in] data Buffer containing the compact binary representation
+ */
+void Octant::decodeCompactBinary(uint8_t dim, uint64_t expectedMorton, const char *data)
+{
+	const uint16_t DEFAULT_INFO = static_cast<uint16_t>(1u << INFO_BALANCED);
+
+	uint64_t value;
+	unsigned int pos = 1;
+
+	pos += readVarint(data + pos, &value);
+	uint64_t morton = expectedMorton + value;
+
+	uint8_t level = static_cast<uint8_t>(data[pos++]);
+	initialize(dim, level, true);
+	m_morton = morton;
+
+	pos += readVarint(data + pos, &value);
+	m_info = static_cast<uint16_t>(value ^ DEFAULT_INFO);
+
+	m_marker = static_cast<int8_t>(data[pos++]);
+
+	readVarint(data + pos, &value);
+	m_ghost = static_cast<int16_t>(static_cast<int>(value) - 1);
+}
+
 // =================================================================================== //
 
 /** Build the last descendant octant of this octant.
@@ -844,13 +976,13 @@ void	Octant::buildChildren(Octant *children) const {
 		uint32_t dh = oct.getLogicalSize();
 		oct.m_morton = PABLO::computeMorton(m_dim, coords[0] + dh * dx, coords[1] + dh * dy, coords[2] + dh * dz);
 
-		oct.m_info[INFO_BOUNDFACE0 + xf] = false;
-		oct.m_info[INFO_BOUNDFACE0 + yf] = false;
-		oct.m_info[INFO_BOUNDFACE0 + zf] = false;
+		oct.setInfo(INFO_BOUNDFACE0 + xf, false);
+		oct.setInfo(INFO_BOUNDFACE0 + yf, false);
+		oct.setInfo(INFO_BOUNDFACE0 + zf, false);
 
-		oct.m_info[INFO_PBOUNDFACE0 + xf] = false;
-		oct.m_info[INFO_PBOUNDFACE0 + yf] = false;
-		oct.m_info[INFO_PBOUNDFACE0 + zf] = false;
+		oct.setInfo(INFO_PBOUNDFACE0 + xf, false);
+		oct.setInfo(INFO_PBOUNDFACE0 + yf, false);
+		oct.setInfo(INFO_PBOUNDFACE0 + zf, false);
 	}
 };
 
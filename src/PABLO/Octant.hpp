@@ -27,9 +27,9 @@
 
 // INCLUDES                                                                            //
 #include "tree_constants.hpp"
+#include "morton.hpp"
 
 #include <vector>
-#include <bitset>
 #include <array>
 
 #include "bitpit_containers.hpp"
@@ -94,6 +94,7 @@ class Octant{
 
     friend class LocalTree;
     friend class ParaTree;
+    friend class TreeHierarchy;
     friend class Global;
 
     friend OBinaryStream& (operator<<) (OBinaryStream& buf, const Octant& octant);
@@ -131,19 +132,20 @@ class Octant{
 
 private:
     uint64_t                        m_morton;       /**< Morton number */
-    uint8_t                         m_level;        /**< Refinement level (0=root) */
-    int8_t                          m_marker;       /**< Set for Refinement(m>0) or Coarsening(m<0) |m|-times */
-    std::bitset<INFO_ITEM_COUNT>    m_info;         /**< -Info[0..5]: true if 0..5 face is a boundary face [bound] \n
+    uint16_t                        m_info;         /**< Packed info flags (one bit for each OctantInfo item):\n
+                                                         -Info[0..5]: true if 0..5 face is a boundary face [bound] \n
                                                          -Info[6..11]: true if 0..6 face is a process boundary face [pbound] \n
                                                          -Info[12/13]: true if octant is new after refinement/coarsening \n
                                                          -Info[14]   : true if balancing is required for this octant \n */
-    uint8_t                         m_dim;          /**< Dimension of octant (2D/3D) */
-    int                             m_ghost;        /**< Ghost specifier:\n
+    int16_t                         m_ghost;        /**< Ghost specifier:\n
                                                          -1 : internal, \n
                                                           0 : ghost in the 0-th layer of the halo, \n
                                                           1 : ghost in the 1-st layer of the halo, \n
                                                           ... \n
                                                           n : ghost in the n-th layer of the halo. */
+    uint8_t                         m_level;        /**< Refinement level (0=root) */
+    int8_t                          m_marker;       /**< Set for Refinement(m>0) or Coarsening(m<0) |m|-times */
+    uint8_t                         m_dim;          /**< Dimension of octant (2D/3D) */
 
     //TODO add bitset for edge & node
 
@@ -165,6 +167,9 @@ private:
 public:
     static unsigned int getBinarySize();
 
+private:
+    static const unsigned int COMPACT_BINARY_MAX_SIZE = 19; /**< Maximum size of the compact binary representation of an octant */
+
 private:
     // =================================================================================== //
     // PRIVATE METHODS
@@ -172,11 +177,18 @@ private:
     void initialize();
     void initialize(uint8_t dim, uint8_t level, bool bound);
 
+    unsigned int encodeCompactBinary(uint64_t expectedMorton, char *data) const;
+    void decodeCompactBinary(uint8_t dim, uint64_t expectedMorton, const char *data);
+
+    bool getInfo(int item) const;
+    void setInfo(int item, bool value);
+
 public:
     // =================================================================================== //
     // PUBLIC METHODS
     // =================================================================================== //
     uint64_t        computeLastDescMorton() const;
+    uint64_t        computeNextMorton() const;
     u32array3       computeLastDescCoordinates() const;
     uint64_t        computeFatherMorton() const;
     u32array3       computeFatherCoordinates() const;
@@ -227,6 +239,15 @@ public:
     uint64_t        computeNodePersistentKey(uint8_t inode) const;
     uint64_t        computeNodePersistentKey(const u32array3 &node) const;
 
+    template<int dim>
+    u32array3       getLogicalCoordinates() const;
+    template<int dim>
+    void            getLogicalNode(u32array3 & node, uint8_t inode) const;
+    template<int dim>
+    uint64_t        computeNodePersistentKey(uint8_t inode) const;
+    template<int dim>
+    uint64_t        computeNodePersistentKey(const u32array3 &node) const;
+
     // =================================================================================== //
     // OTHER METHODS                                                                   //
     // =================================================================================== //
@@ -235,10 +256,120 @@ public:
     uint8_t                countChildren() const;
     std::vector<Octant>    buildChildren() const;
     void                   buildChildren(Octant *children) const;
+
+    unsigned int           getCompactBinarySize(uint64_t expectedMorton) const;
+    template<typename stream_t>
+    void                   writeCompactBinary(stream_t &stream, uint64_t expectedMorton) const;
+    template<typename stream_t>
+    void                   readCompactBinary(stream_t &stream, uint8_t dim, uint64_t expectedMorton);
 protected:
     uint8_t getFamilySplittingNode() const;
 };
 
+/*! Get the value of the specified info flag.
+ * \param[in] item Identifier of the info flag (see OctantInfo)
+ * \return The value of the info flag.
+ */
+inline bool Octant::getInfo(int item) const{
+	return ((m_info >> item) & 1u);
+};
+
+/*! Set the value of the specified info flag.
+ * \param[in] item Identifier of the info flag (see OctantInfo)
+ * \param[in] value Value of the info flag
+ */
+inline void Octant::setInfo(int item, bool value){
+	if (value) {
+		m_info = static_cast<uint16_t>(m_info | (1u << item));
+	} else {
+		m_info = static_cast<uint16_t>(m_info & ~(1u << item));
+	}
+};
+
+/*! Get the coordinates of the octant, i.e. the coordinates of its node 0.
+ * The dimension of the octant is given at compile time, it should match the
+ * runtime dimension of the octant.
+ * \return Coordinates of node 0.
+ */
+template<int dim>
+u32array3 Octant::getLogicalCoordinates() const{
+	if constexpr (dim == 3) {
+		return {{PABLO::computeCoordinate<dim>(m_morton, 0), PABLO::computeCoordinate<dim>(m_morton, 1), PABLO::computeCoordinate<dim>(m_morton, 2)}};
+	} else {
+		return {{PABLO::computeCoordinate<dim>(m_morton, 0), PABLO::computeCoordinate<dim>(m_morton, 1), 0}};
+	}
+};
+
+/*! Get the logical coordinates of a node of the octant. The dimension of the
+ * octant is given at compile time, it should match the runtime dimension of
+ * the octant.
+ * \param[out] node Array[3] with the logical coordinates of the node of the octant.
+ * \param[in] inode Local index of the node
+ */
+template<int dim>
+void Octant::getLogicalNode(u32array3 & node, uint8_t inode) const{
+	const TreeConstants &treeConstants = sm_treeConstants[dim];
+	uint32_t dh = treeConstants.lengths[m_level];
+
+	node = getLogicalCoordinates<dim>();
+	for (int i = 0; i < dim; ++i) {
+		node[i] += treeConstants.nodeCoordinates[inode][i]*dh;
+	}
+};
+
+/*! Compute the persistent XYZ key of the given node (without level). The
+ * dimension of the octant is given at compile time, it should match the
+ * runtime dimension of the octant.
+ * \param[in] inode Local index of the node
+ * \return persistent XYZ key of the node.
+ */
+template<int dim>
+uint64_t Octant::computeNodePersistentKey(uint8_t inode) const{
+	u32array3 node;
+	getLogicalNode<dim>(node, inode);
+
+	return computeNodePersistentKey<dim>(node);
+};
+
+/*! Compute the persistent XYZ key of the given node (without level). The
+ * dimension of the octant is given at compile time, it should match the
+ * runtime dimension of the octant.
+ * \param[in] node Logical coordinates of the node
+ * \return persistent XYZ key of the node.
+ */
+template<int dim>
+uint64_t Octant::computeNodePersistentKey(const u32array3 &node) const{
+	return PABLO::computeXYZKey<dim>(node[0], node[1], node[2]);
+};
+
+/*! Write the compact binary representation of the octant into the specified
+ * stream (see encodeCompactBinary).
+ * \param[in] stream Stream to write to, it should provide a write(const char *, size) method
+ * \param[in] expectedMorton Expected Morton number of the octant, usually the
+ * value returned by computeNextMorton for the previous octant of the sequence
+ */
+template<typename stream_t>
+void Octant::writeCompactBinary(stream_t &stream, uint64_t expectedMorton) const{
+	char data[COMPACT_BINARY_MAX_SIZE];
+	unsigned int size = encodeCompactBinary(expectedMorton, data);
+	stream.write(data, size);
+};
+
+/*! Read the octant from its compact binary representation contained in the
+ * specified stream (see encodeCompactBinary).
+ * \param[in] stream Stream to read from, it should provide a read(char *, size) method
+ * \param[in] dim Dimension of the octant
+ * \param[in] expectedMorton Expected Morton number of the octant, it should
+ * be the same value used for writing the octant
+ */
+template<typename stream_t>
+void Octant::readCompactBinary(stream_t &stream, uint8_t dim, uint64_t expectedMorton){
+	char data[COMPACT_BINARY_MAX_SIZE];
+	stream.read(data, 1);
+	stream.read(data + 1, static_cast<unsigned char>(data[0]));
+	decodeCompactBinary(dim, expectedMorton, data);
+};
+
 }
 
 #endif /* __BITPIT_PABLO_OCTANT_HPP__ */
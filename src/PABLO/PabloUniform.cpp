@@ -853,6 +853,80 @@ namespace bitpit {
         return ParaTree::getPointOwnerRank(point);
     };
     
+    /** Get the internal octants that contain the specified points.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerIdx On output will contain the indices of the octants that
+     * contain the points (max uint32_t representable if a point is outside of the
+     * local partition).
+     */
+    void
+    PabloUniform::getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, uint32_t *ownerIdx) const {
+        std::vector<darray3> logicalPoints = evalLogicalPoints(nPoints, points);
+        ParaTree::getPointsOwnerIdx(nPoints, logicalPoints.data(), ownerIdx);
+    };
+
+    /** Get the internal octants that contain the specified points.
+     * \param[in] points Coordinates of the points.
+     * \return The indices of the octants that contain the points (max uint32_t
+     * representable if a point is outside of the local partition).
+     */
+    u32vector
+    PabloUniform::getPointsOwnerIdx(const std::vector<darray3> &points) const {
+        u32vector ownerIdx(points.size());
+        getPointsOwnerIdx(points.size(), points.data(), ownerIdx.data());
+
+        return ownerIdx;
+    };
+
+    /** Get the ranks of the processes that own the specified points.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerRanks On output will contain the owner ranks of the points
+     * (negative if a point is outside of global domain).
+     */
+    void
+    PabloUniform::getPointsOwnerRank(std::size_t nPoints, const darray3 *points, int *ownerRanks) const {
+        std::vector<darray3> logicalPoints = evalLogicalPoints(nPoints, points);
+        ParaTree::getPointsOwnerRank(nPoints, logicalPoints.data(), ownerRanks);
+    };
+
+#if BITPIT_ENABLE_MPI==1
+    /** Locate the specified points in the distributed tree.
+     *
+     * This is a collective function, see ParaTree::locatePoints.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerRanks On output will contain the owner ranks of the points
+     * (negative if a point is outside of global domain).
+     * \param[out] ownerIdx On output will contain the indices, on the owner processes,
+     * of the octants that contain the points (max uint32_t representable if a point
+     * is outside of global domain).
+     */
+    void
+    PabloUniform::locatePoints(std::size_t nPoints, const darray3 *points, int *ownerRanks, uint32_t *ownerIdx) {
+        std::vector<darray3> logicalPoints = evalLogicalPoints(nPoints, points);
+        ParaTree::locatePoints(nPoints, logicalPoints.data(), ownerRanks, ownerIdx);
+    };
+#endif
+
+    /** Evaluate the logical coordinates of the specified points.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Physical coordinates of the points.
+     * \return The logical coordinates of the points.
+     */
+    std::vector<darray3>
+    PabloUniform::evalLogicalPoints(std::size_t nPoints, const darray3 *points) const {
+        std::vector<darray3> logicalPoints(nPoints);
+        for (std::size_t n = 0; n < nPoints; ++n) {
+            for (int i=0; i<3; i++){
+                logicalPoints[n][i] = (points[n][i] - m_origin[i])/m_L;
+            }
+        }
+
+        return logicalPoints;
+    };
+
     // =================================================================================== //
     // OTHER PARATREE BASED METHODS												    	   //
     // =================================================================================== //
@@ -880,7 +954,7 @@ namespace bitpit {
     void
     PabloUniform::write(const std::string &filename) {
 
-        if (getConnectivity().size() == 0) {
+        if (getConnectivityFlat().size() == 0) {
             computeConnectivity();
         }
 
@@ -901,7 +975,7 @@ namespace bitpit {
         out << "<?xml version=\"1.0\"?>" << endl
             << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << endl
             << "  <UnstructuredGrid>" << endl
-            << "    <Piece NumberOfCells=\"" << getConnectivity().size() + getGhostConnectivity().size() << "\" NumberOfPoints=\"" << getNumNodes() << "\">" << endl;
+            << "    <Piece NumberOfCells=\"" << getConnectivityFlat().size() + getGhostConnectivityFlat().size() << "\" NumberOfPoints=\"" << getNumNodes() << "\">" << endl;
         out << "      <Points>" << endl
             << "        <DataArray type=\"Float64\" Name=\"Coordinates\" NumberOfComponents=\""<< 3 <<"\" format=\"ascii\">" << endl
             << "          " << std::fixed;
@@ -935,7 +1009,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getConnectivity()[i][jj] << " ";
+                        out << getConnectivityFlat().getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
@@ -956,7 +1030,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getGhostConnectivity()[i][jj] << " ";
+                        out << getGhostConnectivityFlat().getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofGhosts-1)
                     out << endl << "          ";
@@ -1034,7 +1108,7 @@ namespace bitpit {
     void
     PabloUniform::writeTest(const std::string &filename, vector<double> data) {
 
-        if (getConnectivity().size() == 0) {
+        if (getConnectivityFlat().size() == 0) {
             computeConnectivity();
         }
 
@@ -1100,7 +1174,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getConnectivity()[i][jj] << " ";
+                        out << getConnectivityFlat().getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
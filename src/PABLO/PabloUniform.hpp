@@ -77,6 +77,7 @@ namespace bitpit {
         // METHODS
         // =================================================================================== //
         void	__reset();
+        std::vector<darray3> evalLogicalPoints(std::size_t nPoints, const darray3 *points) const;
     public:
 #if BITPIT_ENABLE_MPI==1
         PabloUniform(const std::string &logfile = DEFAULT_LOG_FILE, MPI_Comm comm = MPI_COMM_WORLD);
@@ -175,6 +176,12 @@ namespace bitpit {
         Octant* getPointOwner(darray3 point, bool & isghost);
         uint32_t getPointOwnerIdx(darray3 point, bool & isghost) const;
         int getPointOwnerRank(darray3 point);
+        void getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, uint32_t *ownerIdx) const;
+        u32vector getPointsOwnerIdx(const std::vector<darray3> &points) const;
+        void getPointsOwnerRank(std::size_t nPoints, const darray3 *points, int *ownerRanks) const;
+#if BITPIT_ENABLE_MPI==1
+        void locatePoints(std::size_t nPoints, const darray3 *points, int *ownerRanks, uint32_t *ownerIdx);
+#endif
 
         // =================================================================================== //
         // OTHER PARATREE BASED METHODS												    	   //
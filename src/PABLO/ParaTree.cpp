@@ -30,11 +30,19 @@
 #include "morton.hpp"
 #include "ParaTree.hpp"
 
+#include <algorithm>
 #include <climits>
+#include <cmath>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
 #include <iterator>
+#include <limits>
+
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
 
 namespace bitpit {
 
@@ -116,6 +124,72 @@ namespace bitpit {
         recvRanges.clear();
     }
 
+    // =================================================================================== //
+    // CLASS PerformanceCounters IMPLEMENTATION                                            //
+    // =================================================================================== //
+
+    /*! Default constructor that initializes all the counters to zero.
+     */
+    ParaTree::PerformanceCounters::PerformanceCounters()
+    {
+        clear();
+    }
+
+    /*! Reset all the counters to zero.
+     */
+    void ParaTree::PerformanceCounters::clear()
+    {
+        time           = 0.;
+        nCalls         = 0;
+        nOctants       = 0;
+        nSentBytes     = 0;
+        nReceivedBytes = 0;
+        nRounds        = 0;
+    }
+
+    // =================================================================================== //
+    // CLASS PerformanceTimer IMPLEMENTATION                                               //
+    // =================================================================================== //
+
+    /*! Start timing a phase.
+     *
+     * If the performance counters of the tree are disabled, the timer does
+     * nothing.
+     * \param[in] tree is the tree whose counters will be updated
+     * \param[in] phase is the phase that will be timed
+     * \param[in] nOctants is the number of octants processed by the phase
+     * \param[in] newCall if set to true the phase is counted as a new call,
+     * otherwise the time is added to the current call (this is useful for
+     * phases split among multiple functions)
+     */
+    ParaTree::PerformanceTimer::PerformanceTimer(ParaTree *tree, PerformancePhase phase, uint64_t nOctants, bool newCall)
+        : m_counters(nullptr)
+    {
+        if (!tree->m_performanceCountersEnabled) {
+            return;
+        }
+
+        m_counters = &(tree->m_performanceCounters[phase]);
+        if (newCall) {
+            ++(m_counters->nCalls);
+        }
+        m_counters->nOctants += nOctants;
+
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    /*! Stop timing the phase and add the elapsed time to its counters.
+     */
+    ParaTree::PerformanceTimer::~PerformanceTimer()
+    {
+        if (!m_counters) {
+            return;
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_counters->time += elapsed.count();
+    }
+
     // =================================================================================== //
     // CLASS IMPLEMENTATION                                                                //
     // =================================================================================== //
@@ -138,7 +212,7 @@ namespace bitpit {
     ParaTree::ParaTree(const std::string &logfile )
 #endif
 #if BITPIT_ENABLE_MPI==1
-        : m_comm(MPI_COMM_NULL)
+        : m_comm(MPI_COMM_NULL), m_ghostCommunicatorEntrySize(0)
 #endif
     {
 #if BITPIT_ENABLE_MPI==1
@@ -164,7 +238,7 @@ namespace bitpit {
 #endif
         : m_octree(dim), m_trans(dim)
 #if BITPIT_ENABLE_MPI==1
-          , m_comm(MPI_COMM_NULL)
+          , m_comm(MPI_COMM_NULL), m_ghostCommunicatorEntrySize(0)
 #endif
     {
 #if BITPIT_ENABLE_MPI==1
@@ -193,7 +267,7 @@ namespace bitpit {
     ParaTree::ParaTree(std::istream &stream, const std::string &logfile)
 #endif
 #if BITPIT_ENABLE_MPI==1
-        : m_comm(MPI_COMM_NULL)
+        : m_comm(MPI_COMM_NULL), m_ghostCommunicatorEntrySize(0)
 #endif
     {
 #if BITPIT_ENABLE_MPI==1
@@ -229,6 +303,11 @@ namespace bitpit {
           m_maxDepth(other.m_maxDepth),
           m_treeConstants(other.m_treeConstants),
           m_nofGhostLayers(other.m_nofGhostLayers),
+          m_partitionTolerance(other.m_partitionTolerance),
+          m_octantCompression(other.m_octantCompression),
+          m_nodeAwarePartitioning(other.m_nodeAwarePartitioning),
+          m_nodePartitionTolerance(other.m_nodePartitionTolerance),
+          m_partitionNodeOffsets(other.m_partitionNodeOffsets),
           m_octree(other.m_octree),
           m_bordersPerProc(other.m_bordersPerProc),
           m_internals(other.m_internals),
@@ -241,11 +320,15 @@ namespace bitpit {
           m_trans(other.m_trans),
           m_dim(other.m_dim),
           m_periodic(other.m_periodic),
+          m_brickSize(other.m_brickSize),
+          m_brickLevel(other.m_brickLevel),
+          m_performanceCountersEnabled(other.m_performanceCountersEnabled),
+          m_performanceCounters(other.m_performanceCounters),
           m_status(other.m_status),
           m_lastOp(other.m_lastOp),
           m_log(other.m_log)
 #if BITPIT_ENABLE_MPI==1
-          , m_comm(MPI_COMM_NULL)
+          , m_comm(MPI_COMM_NULL), m_ghostCommunicatorEntrySize(0)
 #endif
     {
 #if BITPIT_ENABLE_MPI==1
@@ -352,6 +435,25 @@ namespace bitpit {
 
         // Initialize the number of ghost layers
         m_nofGhostLayers = 1;
+
+        // Initialize the partition tolerance
+        m_partitionTolerance = 0.;
+
+        // Initialize octant compression
+        m_octantCompression = false;
+
+        // Initialize node-aware partitioning
+        m_nodeAwarePartitioning = false;
+        m_nodePartitionTolerance = 0.05;
+        m_partitionNodeOffsets.clear();
+
+        // Initialize the brick
+        m_brickSize = {{1, 1, 1}};
+        m_brickLevel = 0;
+
+        // Initialize performance counters
+        m_performanceCountersEnabled = false;
+        resetPerformanceCounters();
     }
 
     /*! Initialize a dummy octree
@@ -471,29 +573,57 @@ namespace bitpit {
         m_bordersPerProc.clear();
         m_internals.clear();
         m_pborders.clear();
+#if BITPIT_ENABLE_MPI==1
+        clearGhostCommunicator();
+#endif
 
         m_loadBalanceRanges.clear();
 
         std::fill(m_periodic.begin(), m_periodic.end(), false);
 
+        m_brickSize = {{1, 1, 1}};
+        m_brickLevel = 0;
+
         _initializePartitions();
     }
 
     // =============================================================================== //
 
     /*! Get the version associated to the binary dumps.
+     *
+     *  Dumps that store the octants using their compact representation (see
+     *  setOctantCompression) are written with the version returned by
+     *  getCompactDumpVersion.
      *
      *  \result The version associated to the binary dumps.
      */
     int ParaTree::getDumpVersion() const
     {
-        const int DUMP_VERSION = 1;
+        const int DUMP_VERSION = 2;
 
         return DUMP_VERSION;
     }
 
     // =============================================================================== //
 
+    /*! Get the version associated to the binary dumps that store the octants
+     *  using their compact representation.
+     *
+     *  The layout of these dumps differs from the layout of the default dumps
+     *  only in the representation of the octants.
+     *
+     *  \result The version associated to the binary dumps that store the
+     *  octants using their compact representation.
+     */
+    int ParaTree::getCompactDumpVersion() const
+    {
+        const int COMPACT_DUMP_VERSION_OFFSET = 1000;
+
+        return (COMPACT_DUMP_VERSION_OFFSET + getDumpVersion());
+    }
+
+    // =============================================================================== //
+
     /*! Write the octree to the specified stream.
      *
      *  \param stream is the stream to write to
@@ -502,7 +632,11 @@ namespace bitpit {
     void ParaTree::dump(std::ostream &stream, bool full)
     {
         // Version
-        utils::binary::write(stream, getDumpVersion());
+        if (m_octantCompression) {
+            utils::binary::write(stream, getCompactDumpVersion());
+        } else {
+            utils::binary::write(stream, getDumpVersion());
+        }
 
         // Tree data
         utils::binary::write(stream, getNproc());
@@ -519,6 +653,11 @@ namespace bitpit {
             utils::binary::write(stream, getPeriodic(i));
         }
 
+        for (int d = 0; d < 3; d++) {
+            utils::binary::write(stream, m_brickSize[d]);
+        }
+        utils::binary::write(stream, m_brickLevel);
+
         // Octant data
         uint32_t nOctants = getNumOctants();
         utils::binary::write(stream, nOctants);
@@ -526,21 +665,30 @@ namespace bitpit {
         uint64_t nGlobalOctants = getGlobalNumOctants();
         utils::binary::write(stream, nGlobalOctants);
 
-        for (uint32_t i = 0; i < nOctants; i++) {
-            const Octant &octant = m_octree.m_octants[i];
+        if (m_octantCompression) {
+            uint64_t expectedMorton = 0;
+            for (uint32_t i = 0; i < nOctants; i++) {
+                const Octant &octant = m_octree.m_octants[i];
+                octant.writeCompactBinary(stream, expectedMorton);
+                expectedMorton = octant.computeNextMorton();
+            }
+        } else {
+            for (uint32_t i = 0; i < nOctants; i++) {
+                const Octant &octant = m_octree.m_octants[i];
 
-            utils::binary::write(stream, octant.getLevel());
-            utils::binary::write(stream, octant.getLogicalCoordinates(0));
-            utils::binary::write(stream, octant.getLogicalCoordinates(1));
-            utils::binary::write(stream, octant.getLogicalCoordinates(2));
-            utils::binary::write(stream, octant.getGhostLayer());
+                utils::binary::write(stream, octant.getLevel());
+                utils::binary::write(stream, octant.getLogicalCoordinates(0));
+                utils::binary::write(stream, octant.getLogicalCoordinates(1));
+                utils::binary::write(stream, octant.getLogicalCoordinates(2));
+                utils::binary::write(stream, octant.getGhostLayer());
 
-            for (size_t k = 0; k < Octant::INFO_ITEM_COUNT; ++k) {
-                utils::binary::write(stream, (bool) octant.m_info[k]);
-            }
+                for (size_t k = 0; k < Octant::INFO_ITEM_COUNT; ++k) {
+                    utils::binary::write(stream, octant.getInfo(k));
+                }
 
-            utils::binary::write(stream, octant.getBalance());
-            utils::binary::write(stream, octant.getMarker());
+                utils::binary::write(stream, octant.getBalance());
+                utils::binary::write(stream, octant.getMarker());
+            }
         }
 
         // Information about partitioning
@@ -590,7 +738,13 @@ namespace bitpit {
         // Version
         int version;
         utils::binary::read(stream, version);
-        if (version != getDumpVersion()) {
+
+        bool compressed;
+        if (version == getDumpVersion()) {
+            compressed = false;
+        } else if (version == getCompactDumpVersion()) {
+            compressed = true;
+        } else {
             throw std::runtime_error ("The version of the file does not match the required version");
         }
 
@@ -628,6 +782,11 @@ namespace bitpit {
             }
         }
 
+        for (int d = 0; d < 3; d++) {
+            utils::binary::read(stream, m_brickSize[d]);
+        }
+        utils::binary::read(stream, m_brickLevel);
+
         // Restore octants
         uint32_t nOctants;
         utils::binary::read(stream, nOctants);
@@ -637,46 +796,57 @@ namespace bitpit {
         m_globalNumOctants = nGlobalOctants;
 
         m_octree.m_octants.clear();
-        m_octree.m_octants.reserve(nOctants);
-        for (uint32_t i = 0; i < nOctants; i++) {
-            // Create octant
-            uint8_t level;
-            utils::binary::read(stream, level);
+        if (compressed) {
+            m_octree.m_octants.resize(nOctants);
+
+            uint64_t expectedMorton = 0;
+            for (uint32_t i = 0; i < nOctants; i++) {
+                Octant &octant = m_octree.m_octants[i];
+                octant.readCompactBinary(stream, dimension, expectedMorton);
+                expectedMorton = octant.computeNextMorton();
+            }
+        } else {
+            m_octree.m_octants.reserve(nOctants);
+            for (uint32_t i = 0; i < nOctants; i++) {
+                // Create octant
+                uint8_t level;
+                utils::binary::read(stream, level);
 
-            uint32_t x;
-            utils::binary::read(stream, x);
+                uint32_t x;
+                utils::binary::read(stream, x);
 
-            uint32_t y;
-            utils::binary::read(stream, y);
+                uint32_t y;
+                utils::binary::read(stream, y);
 
-            uint32_t z;
-            utils::binary::read(stream, z);
+                uint32_t z;
+                utils::binary::read(stream, z);
 
-            Octant octant(false, m_dim, level, x, y, z);
+                Octant octant(false, m_dim, level, x, y, z);
 
-            int ghost;
-            utils::binary::read(stream, ghost);
-            octant.setGhostLayer(ghost);
+                int ghost;
+                utils::binary::read(stream, ghost);
+                octant.setGhostLayer(ghost);
 
-            // Set octant info
-            for (size_t k = 0; k < Octant::INFO_ITEM_COUNT; ++k) {
-                bool bit;
-                utils::binary::read(stream, bit);
-                octant.m_info.set(k, bit);
-            }
+                // Set octant info
+                for (size_t k = 0; k < Octant::INFO_ITEM_COUNT; ++k) {
+                    bool bit;
+                    utils::binary::read(stream, bit);
+                    octant.setInfo(k, bit);
+                }
 
-            // Set octant 2:1 balance
-            bool balance21;
-            utils::binary::read(stream, balance21);
-            octant.setBalance(balance21);
+                // Set octant 2:1 balance
+                bool balance21;
+                utils::binary::read(stream, balance21);
+                octant.setBalance(balance21);
 
-            // Set marker
-            int8_t marker;
-            utils::binary::read(stream, marker);
-            octant.setMarker(marker);
+                // Set marker
+                int8_t marker;
+                utils::binary::read(stream, marker);
+                octant.setMarker(marker);
 
-            // Add octant to the list
-            m_octree.m_octants.push_back(std::move(octant));
+                // Add octant to the list
+                m_octree.m_octants.push_back(std::move(octant));
+            }
         }
 
         m_octree.updateLocalMaxDepth();
@@ -747,6 +917,243 @@ namespace bitpit {
         }
     }
 
+#if BITPIT_ENABLE_MPI==1
+    // =============================================================================== //
+
+    /*! Get the version associated to the collective checkpoints.
+     *
+     *  \result The version associated to the collective checkpoints.
+     */
+    int ParaTree::getCheckpointVersion() const
+    {
+        const int CHECKPOINT_VERSION = 2;
+
+        return CHECKPOINT_VERSION;
+    }
+
+    // =============================================================================== //
+
+    /*! Write the octree to the specified file using collective MPI-IO.
+     *
+     *  All the processes write into a single shared file: a header written
+     *  by the first process is followed by the global sequence of the
+     *  octants, each process writes its octants at the offset defined by
+     *  its partition range. For each octant the Morton number, the level,
+     *  the info flags and the marker are saved, the resulting file does not
+     *  depend on the number of processes and can be restored with a different
+     *  number of processes using restart().
+     *
+     *  Only the information stored in the base tree is saved, the geometry
+     *  of derived trees (e.g., the origin of a PabloUniform) is not.
+     *
+     *  \param filename is the name of the file
+     */
+    void ParaTree::checkpoint(const std::string &filename)
+    {
+        // Header
+        std::stringstream headerStream;
+        utils::binary::write(headerStream, getDim());
+        utils::binary::write(headerStream, getNofGhostLayers());
+        utils::binary::write(headerStream, getBalanceCodimension());
+        for (int i = 0; i < m_treeConstants->nFaces; i++) {
+            utils::binary::write(headerStream, getPeriodic(i));
+        }
+        for (int d = 0; d < 3; d++) {
+            utils::binary::write(headerStream, m_brickSize[d]);
+        }
+        utils::binary::write(headerStream, m_brickLevel);
+        utils::binary::write(headerStream, getGlobalNumOctants());
+
+        std::string headerData = headerStream.str();
+        uint64_t headerSize = CHECKPOINT_PREAMBLE_SIZE + headerData.size();
+
+        std::vector<char> header(headerSize);
+        int version = getCheckpointVersion();
+        std::memcpy(header.data(), &version, sizeof(version));
+        std::memcpy(header.data() + sizeof(version), &headerSize, sizeof(headerSize));
+        std::memcpy(header.data() + CHECKPOINT_PREAMBLE_SIZE, headerData.data(), headerData.size());
+
+        // Octant records
+        uint32_t nOctants = getNumOctants();
+        std::vector<char> records(nOctants * CHECKPOINT_RECORD_SIZE);
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            const Octant &octant = m_octree.m_octants[i];
+
+            char *record = records.data() + i * CHECKPOINT_RECORD_SIZE;
+            std::memcpy(record, &octant.m_morton, sizeof(octant.m_morton));
+            record += sizeof(octant.m_morton);
+            std::memcpy(record, &octant.m_info, sizeof(octant.m_info));
+            record += sizeof(octant.m_info);
+            std::memcpy(record, &octant.m_level, sizeof(octant.m_level));
+            record += sizeof(octant.m_level);
+            std::memcpy(record, &octant.m_marker, sizeof(octant.m_marker));
+        }
+
+        uint64_t globalOffset = (m_rank > 0 && !m_serial) ? m_partitionRangeGlobalIdx[m_rank - 1] + 1 : 0;
+        if (m_serial && m_rank > 0) {
+            nOctants = 0;
+        }
+
+        // Write the file
+        MPI_File file;
+        if (MPI_File_open(m_comm, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+            throw std::runtime_error ("Unable to open the checkpoint file " + filename);
+        }
+
+        MPI_Datatype recordType;
+        MPI_Type_contiguous(CHECKPOINT_RECORD_SIZE, MPI_BYTE, &recordType);
+        MPI_Type_commit(&recordType);
+
+        int writeStatus = MPI_File_set_size(file, 0);
+        if (writeStatus == MPI_SUCCESS && m_rank == 0) {
+            writeStatus = MPI_File_write_at(file, 0, header.data(), headerSize, MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+
+        MPI_Offset recordsOffset = headerSize + globalOffset * CHECKPOINT_RECORD_SIZE;
+        if (MPI_File_write_at_all(file, recordsOffset, records.data(), nOctants, recordType, MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+            writeStatus = MPI_ERR_IO;
+        }
+
+        MPI_Type_free(&recordType);
+        MPI_File_close(&file);
+
+        MPI_Allreduce(MPI_IN_PLACE, &writeStatus, 1, MPI_INT, MPI_MAX, m_comm);
+        if (writeStatus != MPI_SUCCESS) {
+            throw std::runtime_error ("Unable to write the checkpoint file " + filename);
+        }
+    }
+
+    // =============================================================================== //
+
+    /*! Restore the octree from a file written by checkpoint().
+     *
+     *  The number of processes is not required to match the one used for
+     *  writing the file: the global sequence of octants is distributed
+     *  uniformly among the processes and each process reads only its own
+     *  slice of the file using collective MPI-IO. Ghost halo and partition
+     *  information are rebuilt before returning.
+     *
+     *  \param filename is the name of the file
+     */
+    void ParaTree::restart(const std::string &filename)
+    {
+        MPI_File file;
+        if (MPI_File_open(m_comm, filename.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {
+            throw std::runtime_error ("Unable to open the checkpoint file " + filename);
+        }
+
+        // Header
+        std::vector<char> preamble(CHECKPOINT_PREAMBLE_SIZE);
+        MPI_File_read_at_all(file, 0, preamble.data(), CHECKPOINT_PREAMBLE_SIZE, MPI_BYTE, MPI_STATUS_IGNORE);
+
+        int version;
+        std::memcpy(&version, preamble.data(), sizeof(version));
+        if (version != getCheckpointVersion()) {
+            MPI_File_close(&file);
+            throw std::runtime_error ("The version of the file does not match the required version");
+        }
+
+        uint64_t headerSize;
+        std::memcpy(&headerSize, preamble.data() + sizeof(version), sizeof(headerSize));
+
+        std::string headerData(headerSize - CHECKPOINT_PREAMBLE_SIZE, '\0');
+        MPI_File_read_at_all(file, CHECKPOINT_PREAMBLE_SIZE, &headerData[0], headerData.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+
+        std::stringstream headerStream(headerData);
+
+        uint8_t dimension;
+        utils::binary::read(headerStream, dimension);
+
+        m_octree.initialize(dimension);
+        m_trans.initialize(dimension);
+        reinitialize(dimension, m_log->getName());
+        reset(false);
+
+        utils::binary::read(headerStream, m_nofGhostLayers);
+
+        uint8_t balanceCodimension;
+        utils::binary::read(headerStream, balanceCodimension);
+        setBalanceCodimension(balanceCodimension);
+
+        for (int i = 0; i < m_treeConstants->nFaces; i++) {
+            bool periodicBorder;
+            utils::binary::read(headerStream, periodicBorder);
+            if (periodicBorder){
+                setPeriodic(i);
+            }
+        }
+        for (int d = 0; d < 3; d++) {
+            utils::binary::read(headerStream, m_brickSize[d]);
+        }
+        utils::binary::read(headerStream, m_brickLevel);
+
+        uint64_t nGlobalOctants;
+        utils::binary::read(headerStream, nGlobalOctants);
+
+        // Octants
+        //
+        // Octants are distributed uniformly among the processes.
+        initializeUniformPartitionRanges(nGlobalOctants);
+
+        uint64_t beginGlobalIdx = (m_rank > 0) ? m_partitionRangeGlobalIdx[m_rank - 1] + 1 : 0;
+        uint32_t nOctants = static_cast<uint32_t>(m_partitionRangeGlobalIdx[m_rank] + 1 - beginGlobalIdx);
+
+        MPI_Datatype recordType;
+        MPI_Type_contiguous(CHECKPOINT_RECORD_SIZE, MPI_BYTE, &recordType);
+        MPI_Type_commit(&recordType);
+
+        std::vector<char> records(nOctants * CHECKPOINT_RECORD_SIZE);
+        MPI_Offset recordsOffset = headerSize + beginGlobalIdx * CHECKPOINT_RECORD_SIZE;
+        int readStatus = MPI_File_read_at_all(file, recordsOffset, records.data(), nOctants, recordType, MPI_STATUS_IGNORE);
+
+        MPI_Type_free(&recordType);
+        MPI_File_close(&file);
+
+        MPI_Allreduce(MPI_IN_PLACE, &readStatus, 1, MPI_INT, MPI_MAX, m_comm);
+        if (readStatus != MPI_SUCCESS) {
+            throw std::runtime_error ("Unable to read the checkpoint file " + filename);
+        }
+
+        // Process boundary information depends on the partitioning and will
+        // be evaluated when the ghost halo is built.
+        uint16_t pboundMask = 0;
+        for (int i = 0; i < m_treeConstants->nFaces; i++) {
+            pboundMask = static_cast<uint16_t>(pboundMask | (1u << (Octant::INFO_PBOUNDFACE0 + i)));
+        }
+
+        m_octree.m_octants.resize(nOctants);
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            const char *record = records.data() + i * CHECKPOINT_RECORD_SIZE;
+
+            uint64_t morton;
+            std::memcpy(&morton, record, sizeof(morton));
+            record += sizeof(morton);
+
+            uint16_t info;
+            std::memcpy(&info, record, sizeof(info));
+            record += sizeof(info);
+
+            uint8_t level;
+            std::memcpy(&level, record, sizeof(level));
+            record += sizeof(level);
+
+            int8_t marker;
+            std::memcpy(&marker, record, sizeof(marker));
+
+            Octant &octant = m_octree.m_octants[i];
+            octant = Octant(m_dim, level, morton);
+            octant.m_info   = static_cast<uint16_t>(info & ~pboundMask);
+            octant.m_marker = marker;
+        }
+
+        // Update tree information
+        initializePartitionedOctants();
+
+        m_mapIdx.clear();
+        m_lastOp = OP_INIT;
+    }
+#endif
+
     // =============================================================================== //
 
     /*! Print the initial PABLO header.
@@ -919,12 +1326,19 @@ namespace bitpit {
         }
 
         // Free MPI communicator
+        //
+        // The ghost communicator uses the communicator of the tree, hence it
+        // should be destroyed first. If MPI has already been finalized, the
+        // ghost communicator cannot be properly destroyed and it is released.
         int finalizedCalled;
         MPI_Finalized(&finalizedCalled);
         if (finalizedCalled) {
+            m_ghostCommunicator.release();
             return;
         }
 
+        m_ghostCommunicator.reset();
+
         MPI_Comm_free(&m_comm);
     }
 
@@ -1250,9 +1664,14 @@ namespace bitpit {
      */
     void
     ParaTree::setPeriodic(uint8_t i){
+        if (m_brickLevel > 0) {
+            throw std::runtime_error ("Periodic boundaries are not supported by brick trees");
+        }
+
         m_periodic[i] = true;
         m_periodic[m_treeConstants->oppositeFace[i]] = true;
         m_octree.setPeriodic(m_periodic);
+        updateNeighbourGraph(false);
     };
 
     /*!Set the tolerance used in geometric operations.
@@ -1263,6 +1682,25 @@ namespace bitpit {
         m_tol = tol;
     };
 
+    /*! Get the number of root octants of the brick along each direction.
+     * If the tree has not been built as a brick, the whole domain is a
+     * single root octant.
+     * \return Number of root octants of the brick along each direction.
+     */
+    const u32array3 &
+    ParaTree::getBrickSize() const {
+        return m_brickSize;
+    };
+
+    /*! Get the level of the root octants of the brick.
+     * If the tree has not been built as a brick, the level is zero.
+     * \return Level of the root octants of the brick.
+     */
+    uint8_t
+    ParaTree::getBrickLevel() const {
+        return m_brickLevel;
+    };
+
     // =================================================================================== //
     // INDEX BASED METHODS
     // =================================================================================== //
@@ -2266,6 +2704,51 @@ namespace bitpit {
         return NULL;
     }
 
+    /*! Get an iterator pointing to the first intersection of the tree.
+     *
+     * Iterators evaluate intersections on the fly, without requiring the
+     * intersections to be computed and stored by computeIntersections. The
+     * intersections are generated in the same order of the stored ones.
+     * Only the intersections owned by the octant being visited are kept in
+     * memory, hence iterators are suited for visiting the intersections once
+     * without paying for the storage of all the intersections of the tree.
+     *
+     * Intersections can be split in chunks that can be iterated independently
+     * (e.g., by different threads): chunks are built splitting the octants in
+     * contiguous ranges of similar size, the concatenation of the chunks gives
+     * all the intersections of the tree.
+     *
+     * Iterators are invalidated by any modification of the tree.
+     *
+     * \param[in] chunk Index of the chunk.
+     * \param[in] nChunks Number of chunks the intersections are split into.
+     * \return An iterator pointing to the first intersection of the chunk.
+     */
+    IntersectionIterator
+    ParaTree::getIntersectionsBegin(int chunk, int nChunks) const {
+        uint64_t nSources = uint64_t(m_octree.getNumGhosts()) + m_octree.getNumOctants();
+        uint64_t sourceBegin = nSources * chunk / nChunks;
+        uint64_t sourceEnd   = nSources * (chunk + 1) / nChunks;
+
+        return IntersectionIterator(&m_octree, sourceBegin, sourceEnd);
+    }
+
+    /*! Get an iterator pointing past the last intersection of the tree.
+     *
+     * See getIntersectionsBegin for a description of the iterators.
+     *
+     * \param[in] chunk Index of the chunk.
+     * \param[in] nChunks Number of chunks the intersections are split into.
+     * \return An iterator pointing past the last intersection of the chunk.
+     */
+    IntersectionIterator
+    ParaTree::getIntersectionsEnd(int chunk, int nChunks) const {
+        uint64_t nSources = uint64_t(m_octree.getNumGhosts()) + m_octree.getNumOctants();
+        uint64_t sourceEnd = nSources * (chunk + 1) / nChunks;
+
+        return IntersectionIterator(&m_octree, sourceEnd, sourceEnd);
+    }
+
     /*! Get the level of an intersection.
      * \param[in] inter Pointer to target intersection.
      * \return Level of intersection.
@@ -2554,6 +3037,168 @@ namespace bitpit {
         m_nofGhostLayers = nofGhostLayers;
     };
 
+    /*! Get the tolerance used for reducing the fragmentation of the partitions.
+     * \return The maximum allowed relative change of the weight of a partition
+     * boundary with respect to the average weight of the partitions.
+     */
+    double
+    ParaTree::getPartitionTolerance() const {
+        return m_partitionTolerance;
+    };
+
+    /*! Set the tolerance used for reducing the fragmentation of the partitions.
+     *
+     * When the tolerance is greater than zero, the boundaries between partitions
+     * evaluated by the load balance are moved to the boundaries of the coarsest
+     * possible blocks of the tree. This produces more compact partitions, with
+     * fewer ghost octants, at the price of a small imbalance between processes.
+     * Each boundary is moved by at most the specified fraction of the average
+     * weight of the partitions. A zero tolerance (the default) disables the
+     * compaction of the partitions.
+     * \param[in] tolerance The maximum allowed relative change of the weight of
+     * a partition boundary with respect to the average weight of the partitions.
+     */
+    void
+    ParaTree::setPartitionTolerance(double tolerance) {
+        if (tolerance < 0.) {
+            throw std::runtime_error ("Partition tolerance should be non-negative.");
+        }
+
+        m_partitionTolerance = tolerance;
+    };
+
+    /*! Check if octants are serialized using their compact binary
+     * representation.
+     * \return Returns true if octants are serialized using their compact
+     * binary representation, false otherwise.
+     */
+    bool
+    ParaTree::getOctantCompression() const {
+        return m_octantCompression;
+    };
+
+    /*! Control if octants are serialized using their compact binary
+     * representation.
+     *
+     * The compact representation (see Octant::writeCompactBinary) stores the
+     * Morton number of an octant as a variable-length difference from the
+     * Morton number that follows the previous octant, together with a
+     * variable-length encoding of the other octant data. It is used for the
+     * dumps and for the octants exchanged during the load balance; when it is
+     * disabled, octants are serialized with their fixed-size representation
+     * (see Octant::getBinarySize). Compression is disabled by default.
+     * \param[in] enable Set to true to enable the compact representation,
+     * false to use the fixed-size representation
+     */
+    void
+    ParaTree::setOctantCompression(bool enable) {
+        m_octantCompression = enable;
+    };
+
+    /*! Enable or disable the performance counters.
+     *
+     * When the counters are enabled, the tree keeps track of the cumulative
+     * wall time, of the number of calls, of the number of octants processed
+     * and of the point-to-point traffic (bytes sent/received and number of
+     * communication rounds) of its main phases (see PerformancePhase). Times
+     * are measured on the calling process and include the time spent in the
+     * phases nested inside the timed one (e.g., the load balance includes
+     * the construction of the ghost halo). Collective operations are not
+     * accounted for in the traffic counters. Counters are disabled by default
+     * and disabling them doesn't reset their values.
+     * \param[in] enable Set to true to enable the counters, false to disable
+     * them
+     */
+    void
+    ParaTree::enablePerformanceCounters(bool enable) {
+        m_performanceCountersEnabled = enable;
+    }
+
+    /*! Check if the performance counters are enabled.
+     * \return Returns true if the performance counters are enabled, false
+     * otherwise.
+     */
+    bool
+    ParaTree::arePerformanceCountersEnabled() const {
+        return m_performanceCountersEnabled;
+    }
+
+    /*! Get the local performance counters of a phase.
+     * \param[in] phase Phase whose counters are requested
+     * \return Constant reference to the counters of the phase collected by
+     * the local process.
+     */
+    const ParaTree::PerformanceCounters &
+    ParaTree::getPerformanceCounters(PerformancePhase phase) const {
+        return m_performanceCounters[phase];
+    }
+
+    /*! Reset the performance counters of all phases.
+     */
+    void
+    ParaTree::resetPerformanceCounters() {
+        for (PerformanceCounters &counters : m_performanceCounters) {
+            counters.clear();
+        }
+    }
+
+    /*! Reduce the performance counters of a phase among the processes.
+     *
+     * Each counter is reduced independently, hence the minimum (or maximum)
+     * counters may be collected from different processes. Average values of
+     * the integer counters are truncated. This is a collective function that
+     * has to be called by all the processes of the tree communicator.
+     * \param[in] phase Phase whose counters will be reduced
+     * \param[out] minCounters if a valid pointer is provided, on output will
+     * contain the minimum values of the counters among the processes
+     * \param[out] maxCounters if a valid pointer is provided, on output will
+     * contain the maximum values of the counters among the processes
+     * \param[out] avgCounters if a valid pointer is provided, on output will
+     * contain the average values of the counters among the processes
+     */
+    void
+    ParaTree::reducePerformanceCounters(PerformancePhase phase, PerformanceCounters *minCounters,
+                                        PerformanceCounters *maxCounters, PerformanceCounters *avgCounters) const {
+
+        const PerformanceCounters &counters = m_performanceCounters[phase];
+
+        const int N_VALUES = 6;
+        std::array<double, N_VALUES> values = {{counters.time,
+                                                static_cast<double>(counters.nCalls),
+                                                static_cast<double>(counters.nOctants),
+                                                static_cast<double>(counters.nSentBytes),
+                                                static_cast<double>(counters.nReceivedBytes),
+                                                static_cast<double>(counters.nRounds)}};
+
+        std::array<double, N_VALUES> minValues = values;
+        std::array<double, N_VALUES> maxValues = values;
+        std::array<double, N_VALUES> sumValues = values;
+#if BITPIT_ENABLE_MPI==1
+        if (isCommSet()) {
+            MPI_Allreduce(values.data(), minValues.data(), N_VALUES, MPI_DOUBLE, MPI_MIN, m_comm);
+            MPI_Allreduce(values.data(), maxValues.data(), N_VALUES, MPI_DOUBLE, MPI_MAX, m_comm);
+            MPI_Allreduce(values.data(), sumValues.data(), N_VALUES, MPI_DOUBLE, MPI_SUM, m_comm);
+        }
+#endif
+
+        auto fillCounters = [](const std::array<double, N_VALUES> &source, double scale, PerformanceCounters *target) {
+            if (!target) {
+                return;
+            }
+
+            target->time           = scale * source[0];
+            target->nCalls         = static_cast<uint64_t>(scale * source[1]);
+            target->nOctants       = static_cast<uint64_t>(scale * source[2]);
+            target->nSentBytes     = static_cast<uint64_t>(scale * source[3]);
+            target->nReceivedBytes = static_cast<uint64_t>(scale * source[4]);
+            target->nRounds        = static_cast<uint64_t>(scale * source[5]);
+        };
+
+        fillCounters(minValues, 1., minCounters);
+        fillCounters(maxValues, 1., maxCounters);
+        fillCounters(sumValues, 1. / m_nproc, avgCounters);
+    }
+
     /*! Get a map of border octants per process
      * \return A map of border octants per process
      */
@@ -3135,11 +3780,234 @@ namespace bitpit {
         return findOwner(morton);
     };
 
-    /** Evaluate the Morton number of the anchor associated with the specified point.
-     * The anchor of a point is the lower-left-back vertex of the smallest octant that
-     * contains the point.
-     * \param[in] point Coordinates of target point.
-     * \return The Morton number of the anchor associated with the specified point.
+    /** Get the internal octants that contain the specified points.
+     *
+     * Points are located all together: the Morton numbers of the anchors of
+     * the points are evaluated, sorted and merged with the octants of the local
+     * tree. When OpenMP is enabled, the location is performed by multiple
+     * threads.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerIdx On output will contain the indices of the octants that
+     * contain the points (max uint32_t representable if a point is outside of the
+     * local partition).
+     */
+    void
+    ParaTree::getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, uint32_t *ownerIdx) const {
+        // Evaluate the Morton associated with the points
+        std::vector<uint64_t> mortons(nPoints);
+        std::vector<int> ownerRanks(nPoints);
+        evalPointsAnchorMorton(nPoints, points, mortons.data(), ownerRanks.data());
+
+        // Discard the points that belong to other partitions
+        if (!m_serial) {
+            for (std::size_t n = 0; n < nPoints; ++n) {
+                if (ownerRanks[n] != m_rank) {
+                    mortons[n] = PABLO::INVALID_MORTON;
+                }
+            }
+        }
+
+        // Identify the octants that contain the points
+        m_octree.findMortonOwners(nPoints, mortons.data(), ownerIdx);
+    }
+
+    /** Get the internal octants that contain the specified points.
+     * \param[in] points Coordinates of the points.
+     * \return The indices of the octants that contain the points (max uint32_t
+     * representable if a point is outside of the local partition).
+     */
+    u32vector
+    ParaTree::getPointsOwnerIdx(const std::vector<darray3> &points) const {
+        u32vector ownerIdx(points.size());
+        getPointsOwnerIdx(points.size(), points.data(), ownerIdx.data());
+
+        return ownerIdx;
+    }
+
+    /** Get the ranks of the processes that own the specified points.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerRanks On output will contain the owner ranks of the points
+     * (negative if a point is outside of global domain).
+     */
+    void
+    ParaTree::getPointsOwnerRank(std::size_t nPoints, const darray3 *points, int *ownerRanks) const {
+        std::vector<uint64_t> mortons(nPoints);
+        evalPointsAnchorMorton(nPoints, points, mortons.data(), ownerRanks);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    /** Locate the specified points in the distributed tree.
+     *
+     * For each point, the rank of the process that owns the point and the index,
+     * on that process, of the octant that contains the point are evaluated. Points
+     * that belong to the local partition are located locally. The anchor Morton
+     * numbers of the other points are sent directly to the processes that own
+     * them, the owners are identified through the Morton ranges of the partitions.
+     * Only the processes that exchange points will communicate with each other.
+     *
+     * This is a collective function, it should be called by all the processes,
+     * also by the ones that have no points to locate. If the tree is serial,
+     * all the points are located locally.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerRanks On output will contain the owner ranks of the points
+     * (negative if a point is outside of global domain).
+     * \param[out] ownerIdx On output will contain the indices, on the owner processes,
+     * of the octants that contain the points (max uint32_t representable if a point
+     * is outside of global domain).
+     */
+    void
+    ParaTree::locatePoints(std::size_t nPoints, const darray3 *points, int *ownerRanks, uint32_t *ownerIdx) {
+        // Evaluate the Morton associated with the points
+        std::vector<uint64_t> mortons(nPoints);
+        evalPointsAnchorMorton(nPoints, points, mortons.data(), ownerRanks);
+
+        // If the tree is serial, all the points are local
+        if (m_serial) {
+            for (std::size_t n = 0; n < nPoints; ++n) {
+                if (ownerRanks[n] >= 0) {
+                    ownerRanks[n] = m_rank;
+                }
+            }
+
+            m_octree.findMortonOwners(nPoints, mortons.data(), ownerIdx);
+
+            return;
+        }
+
+        // Identify the points owned by other processes
+        std::map<int, std::vector<std::size_t>> remotePoints;
+        std::vector<uint64_t> localMortons(mortons);
+        for (std::size_t n = 0; n < nPoints; ++n) {
+            int rank = ownerRanks[n];
+            if (rank >= 0 && rank != m_rank) {
+                remotePoints[rank].push_back(n);
+                localMortons[n] = PABLO::INVALID_MORTON;
+            }
+        }
+
+        // Send the Morton numbers of the remote points to their owners
+        DataCommunicator queryCommunicator(m_comm);
+        for (const auto &remoteEntry : remotePoints) {
+            int rank = remoteEntry.first;
+            const std::vector<std::size_t> &rankPoints = remoteEntry.second;
+
+            queryCommunicator.setSend(rank, rankPoints.size() * sizeof(uint64_t));
+            SendBuffer &queryBuffer = queryCommunicator.getSendBuffer(rank);
+            for (std::size_t n : rankPoints) {
+                queryBuffer << mortons[n];
+            }
+        }
+
+        queryCommunicator.discoverRecvs();
+        queryCommunicator.startAllRecvs();
+        queryCommunicator.startAllSends();
+
+        // Set up the replies
+        //
+        // All the replies are set before starting any communication, the number
+        // of octants to be sent back is the number of received Morton numbers.
+        DataCommunicator replyCommunicator(m_comm);
+        for (const auto &remoteEntry : remotePoints) {
+            int rank = remoteEntry.first;
+            std::size_t nRankPoints = remoteEntry.second.size();
+
+            replyCommunicator.setRecv(rank, nRankPoints * sizeof(uint32_t));
+        }
+
+        for (int rank : queryCommunicator.getRecvRanks()) {
+            std::size_t nRankQueries = queryCommunicator.getRecvBuffer(rank).getSize() / sizeof(uint64_t);
+            replyCommunicator.setSend(rank, nRankQueries * sizeof(uint32_t));
+        }
+
+        replyCommunicator.startAllRecvs();
+
+        // Locate local points
+        m_octree.findMortonOwners(nPoints, localMortons.data(), ownerIdx);
+
+        // Locate the points received from other processes
+        std::vector<uint64_t> queryMortons;
+        std::vector<uint32_t> queryOwners;
+        int nQueries = queryCommunicator.getRecvCount();
+        for (int i = 0; i < nQueries; ++i) {
+            int rank = queryCommunicator.waitAnyRecv();
+            RecvBuffer &queryBuffer = queryCommunicator.getRecvBuffer(rank);
+
+            std::size_t nRankQueries = queryBuffer.getSize() / sizeof(uint64_t);
+            queryMortons.resize(nRankQueries);
+            for (std::size_t k = 0; k < nRankQueries; ++k) {
+                queryBuffer >> queryMortons[k];
+            }
+
+            queryOwners.resize(nRankQueries);
+            m_octree.findMortonOwners(nRankQueries, queryMortons.data(), queryOwners.data());
+
+            SendBuffer &replyBuffer = replyCommunicator.getSendBuffer(rank);
+            for (std::size_t k = 0; k < nRankQueries; ++k) {
+                replyBuffer << queryOwners[k];
+            }
+            replyCommunicator.startSend(rank);
+        }
+
+        // Receive the owners of the remote points
+        int nReplies = replyCommunicator.getRecvCount();
+        for (int i = 0; i < nReplies; ++i) {
+            int rank = replyCommunicator.waitAnyRecv();
+            RecvBuffer &replyBuffer = replyCommunicator.getRecvBuffer(rank);
+            for (std::size_t n : remotePoints.at(rank)) {
+                replyBuffer >> ownerIdx[n];
+            }
+        }
+
+        queryCommunicator.waitAllSends();
+        replyCommunicator.waitAllSends();
+    }
+#endif
+
+    /** Evaluate the Morton numbers of the anchors associated with the specified
+     * points and the ranks of the processes that own the points.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] mortons On output will contain the Morton numbers of the anchors
+     * associated with the points.
+     * \param[out] ownerRanks On output will contain the owner ranks of the points
+     * (negative if a point is outside of global domain).
+     */
+    void
+    ParaTree::evalPointsAnchorMorton(std::size_t nPoints, const darray3 *points, uint64_t *mortons, int *ownerRanks) const {
+        // Split points in chunks
+        int nChunks = 1;
+#if BITPIT_ENABLE_OPENMP==1
+        if (nPoints >= LocalTree::THREADED_POINT_LOCATION_MIN_POINTS) {
+            nChunks = omp_get_max_threads();
+        }
+#endif
+
+#if BITPIT_ENABLE_OPENMP==1
+#pragma omp parallel for schedule(static) if(nChunks > 1)
+#endif
+        for (int chunk = 0; chunk < nChunks; ++chunk) {
+            std::size_t chunkBegin = (nPoints * chunk) / nChunks;
+            std::size_t chunkEnd   = (nPoints * (chunk + 1)) / nChunks;
+            for (std::size_t n = chunkBegin; n < chunkEnd; ++n) {
+                uint64_t morton = evalPointAnchorMorton(points[n].data());
+                mortons[n] = morton;
+                if (morton == PABLO::INVALID_MORTON) {
+                    ownerRanks[n] = -1;
+                } else {
+                    ownerRanks[n] = findOwner(morton);
+                }
+            }
+        }
+    }
+
+    /** Evaluate the Morton number of the anchor associated with the specified point.
+     * The anchor of a point is the lower-left-back vertex of the smallest octant that
+     * contains the point.
+     * \param[in] point Coordinates of target point.
+     * \return The Morton number of the anchor associated with the specified point.
      */
     uint64_t
     ParaTree::evalPointAnchorMorton(const double * point) const {
@@ -3149,21 +4017,33 @@ namespace bitpit {
         }
 
         // Early return if the point is outside the domain
-        if (point[0] > 1+m_tol || point[1] > 1+m_tol || point[2] > 1+m_tol) {
+        //
+        // When the tree is a brick, the domain is the portion of the logical
+        // domain covered by the brick.
+        uint32_t maxLength = getMaxLength();
+        uint8_t rootShift = m_treeConstants->maxLevel - m_brickLevel;
+
+        u32array3 brickLength;
+        darray3 brickLimit;
+        for (int d = 0; d < 3; ++d) {
+            brickLength[d] = (d < m_dim) ? (m_brickSize[d] << rootShift) : maxLength;
+            brickLimit[d]  = double(brickLength[d]) / double(maxLength);
+        }
+
+        if (point[0] > brickLimit[0]+m_tol || point[1] > brickLimit[1]+m_tol || point[2] > brickLimit[2]+m_tol) {
             return PABLO::INVALID_MORTON;
         } else if (point[0] < -m_tol || point[1] < -m_tol || point[2] < -m_tol) {
             return PABLO::INVALID_MORTON;
         }
 
         // Evaluate the Morton associated to the point
-        uint32_t x = m_trans.mapX(std::min(std::max(point[0], 0.0), 1.0));
-        uint32_t y = m_trans.mapY(std::min(std::max(point[1], 0.0), 1.0));
-        uint32_t z = m_trans.mapZ(std::min(std::max(point[2], 0.0), 1.0));
+        uint32_t x = m_trans.mapX(std::min(std::max(point[0], 0.0), brickLimit[0]));
+        uint32_t y = m_trans.mapY(std::min(std::max(point[1], 0.0), brickLimit[1]));
+        uint32_t z = m_trans.mapZ(std::min(std::max(point[2], 0.0), brickLimit[2]));
 
-        uint32_t maxLength = getMaxLength();
-        if (x == maxLength) x = x - 1;
-        if (y == maxLength) y = y - 1;
-        if (z == maxLength) z = z - 1;
+        if (x >= brickLength[0]) x = brickLength[0] - 1;
+        if (y >= brickLength[1]) y = brickLength[1] - 1;
+        if (z >= brickLength[2]) z = brickLength[2] - 1;
 
         return PABLO::computeMorton(m_dim, x, y, z);
     }
@@ -3576,8 +4456,8 @@ namespace bitpit {
         vector<Octant>::iterator iter, iterend = m_octree.m_octants.end();
 
         for (iter = m_octree.m_octants.begin(); iter != iterend; ++iter){
-            iter->m_info[Octant::INFO_NEW4REFINEMENT] = false;
-            iter->m_info[Octant::INFO_NEW4COARSENING] = false;
+            iter->setInfo(Octant::INFO_NEW4REFINEMENT, false);
+            iter->setInfo(Octant::INFO_NEW4COARSENING, false);
         }
 
         // Initialize mapping
@@ -3600,7 +4480,10 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(getNumOctants())) << endl;
 
             // Refine
-            while(m_octree.globalRefine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.globalRefine(m_mapIdx));
+            }
 
             if (getNumOctants() > nocts0)
                 globalDone = true;
@@ -3620,7 +4503,10 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(m_globalNumOctants)) << endl;
 
             // Refine
-            while(m_octree.globalRefine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.globalRefine(m_mapIdx));
+            }
 
             bool localDone = false;
             if (getNumOctants() > nocts0)
@@ -3643,6 +4529,9 @@ namespace bitpit {
             m_lastOp = OP_ADAPT_UNMAPPED;
         }
 
+        // Update the neighbour graph
+        updateNeighbourGraph(mapper_flag);
+
         return globalDone;
     }
 
@@ -3657,8 +4546,8 @@ namespace bitpit {
         vector<Octant>::iterator iter, iterend = m_octree.m_octants.end();
 
         for (iter = m_octree.m_octants.begin(); iter != iterend; ++iter){
-            iter->m_info[Octant::INFO_NEW4REFINEMENT] = false;
-            iter->m_info[Octant::INFO_NEW4COARSENING] = false;
+            iter->setInfo(Octant::INFO_NEW4REFINEMENT, false);
+            iter->setInfo(Octant::INFO_NEW4COARSENING, false);
         }
 
         if (mapper_flag){
@@ -3686,10 +4575,16 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(getNumOctants())) << endl;
 
             // Coarse
-            while(m_octree.globalCoarse(m_mapIdx));
-            updateAfterCoarse();
+            {
+                PerformanceTimer timer(this, PHASE_COARSEN, getNumOctants());
+                while(m_octree.globalCoarse(m_mapIdx));
+                updateAfterCoarse();
+            }
             balance21(false, true);
-            while(m_octree.refine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.refine(m_mapIdx));
+            }
             updateAdapt();
 
             if (getNumOctants() < nocts0){
@@ -3713,11 +4608,17 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(m_globalNumOctants)) << endl;
 
             // Coarse
-            while(m_octree.globalCoarse(m_mapIdx));
-            updateAfterCoarse();
+            {
+                PerformanceTimer timer(this, PHASE_COARSEN, getNumOctants());
+                while(m_octree.globalCoarse(m_mapIdx));
+                updateAfterCoarse();
+            }
             computeGhostHalo();
             balance21(false, true);
-            while(m_octree.refine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.refine(m_mapIdx));
+            }
             updateAdapt();
 
             computeGhostHalo();
@@ -3732,9 +4633,280 @@ namespace bitpit {
             (*m_log) << "---------------------------------------------" << endl;
         }
 #endif
+
+        // Update the neighbour graph
+        updateNeighbourGraph(mapper_flag);
+
         return globalDone;
     }
 
+    /** Replace the octree with a uniform tree whose octants are all at the
+     * specified refinement level.
+     *
+     * The octants are created directly in their final partition: global
+     * octants are distributed among the processes using the same uniform
+     * distribution used by loadBalance and each process creates only the
+     * octants it owns, without building intermediate trees. When the tree
+     * is distributed, the ghost halo is built before returning. The
+     * connectivity of the octants and of the ghosts is computed as well.
+     * When there are more processes than octants, the last processes get no
+     * octants.
+     *
+     * Periodic conditions, tolerance, balance codimension and number of
+     * ghost layers set on the tree are retained, all other information is
+     * discarded.
+     *
+     * \param[in] level Refinement level of the octants
+     */
+    void
+    ParaTree::buildUniform(uint8_t level) {
+        if (level > m_treeConstants->maxLevel) {
+            throw std::runtime_error ("Requested refinement level exceeds the maximum allowed level");
+        }
+
+        (*m_log) << "---------------------------------------------" << endl;
+        (*m_log) << " BUILD UNIFORM TREE " << endl;
+        (*m_log) << " " << endl;
+
+        // Reset the tree, keeping the settings that are not related to the
+        // octants
+        double tol = m_tol;
+        bvector periodic = m_periodic;
+
+        reset(false);
+
+        m_tol = tol;
+        m_periodic = periodic;
+        m_octree.setPeriodic(m_periodic);
+
+        // Evaluate the global indexes of the octants owned by this process
+        uint64_t nGlobalOctants = uint64_t(1) << (m_dim * level);
+        initializeUniformPartitionRanges(nGlobalOctants);
+
+        uint64_t beginGlobalIdx = (m_rank > 0) ? m_partitionRangeGlobalIdx[m_rank - 1] + 1 : 0;
+        uint64_t endGlobalIdx   = m_partitionRangeGlobalIdx[m_rank] + 1;
+
+        // Create the octants
+        //
+        // At uniform level, the Morton number of an octant is its global index
+        // shifted by the bits of the levels below the octant one.
+        uint8_t mortonShift = m_dim * (m_treeConstants->maxLevel - level);
+        uint32_t maxLength = uint32_t(1) << m_treeConstants->maxLevel;
+
+        m_octree.m_octants.resize(endGlobalIdx - beginGlobalIdx);
+        for (uint64_t globalIdx = beginGlobalIdx; globalIdx < endGlobalIdx; ++globalIdx) {
+            Octant &octant = m_octree.m_octants[globalIdx - beginGlobalIdx];
+            octant = Octant(m_dim, level, globalIdx << mortonShift);
+
+            uint32_t size = octant.getLogicalSize();
+            for (int d = 0; d < m_dim; ++d) {
+                uint32_t coordinate = octant.getLogicalCoordinates(d);
+                octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d, coordinate == 0);
+                octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d + 1, coordinate + size == maxLength);
+            }
+        }
+
+        // Update tree information
+        initializePartitionedOctants();
+
+        m_lastOp = OP_INIT;
+
+        // Build the connectivity
+        computeConnectivity();
+
+        (*m_log) << " Number of octants		:	" + to_string(static_cast<unsigned long long>(m_globalNumOctants)) << endl;
+        (*m_log) << " " << endl;
+        (*m_log) << "---------------------------------------------" << endl;
+    }
+
+    /*! Build a brick of root octants, each one uniformly refined to the
+     * specified level.
+     *
+     * The brick is made of size[0] x size[1] x size[2] root octants embedded
+     * in the logical domain of the tree: the root octants have the level of
+     * the largest octants that allow to fit the whole brick in the domain and
+     * only the octants inside the brick are created. The octants of all the
+     * roots are ordered along a single space-filling curve, hence adaption,
+     * 2:1 balance, neighbour search and load balance work across the faces
+     * shared by the roots. The faces on the boundary of the brick are flagged
+     * as boundary faces and points outside the brick are not located.
+     *
+     * Since a brick with n root octants along its longest direction is
+     * embedded in a domain with 2^ceil(log2(n)) root octants along each
+     * direction, the physical size of a root octant is the length of the
+     * domain (e.g., the length L of a PabloUniform tree) divided by
+     * 2^ceil(log2(n)).
+     *
+     * Periodic boundaries are not supported by brick trees. Complete families
+     * of root octants can be coarsened as any other family of octants.
+     *
+     * The tree is reset before building the brick, only the tolerance is
+     * preserved.
+     *
+     * \param[in] size number of root octants along each direction (for 2D
+     * trees the number of root octants along z should be one)
+     * \param[in] level refinement level of the octants inside the root octants
+     */
+    void
+    ParaTree::buildBrick(const u32array3 &size, uint8_t level) {
+        for (int d = 0; d < 3; ++d) {
+            if (size[d] == 0) {
+                throw std::runtime_error ("The brick should contain at least one root octant along each direction");
+            }
+        }
+
+        if (m_dim == 2 && size[2] != 1) {
+            throw std::runtime_error ("Two-dimensional bricks should contain a single root octant along z");
+        }
+
+        for (bool periodic : m_periodic) {
+            if (periodic) {
+                throw std::runtime_error ("Periodic boundaries are not supported by brick trees");
+            }
+        }
+
+        uint32_t maxSize = std::max(std::max(size[0], size[1]), size[2]);
+        uint8_t brickLevel = 0;
+        while ((uint64_t(1) << brickLevel) < maxSize) {
+            ++brickLevel;
+        }
+
+        if (brickLevel + level > m_treeConstants->maxLevel) {
+            throw std::runtime_error ("Requested brick exceeds the maximum allowed level");
+        }
+
+        (*m_log) << "---------------------------------------------" << endl;
+        (*m_log) << " BUILD BRICK TREE " << endl;
+        (*m_log) << " " << endl;
+
+        // Reset the tree, keeping the settings that are not related to the
+        // octants
+        double tol = m_tol;
+
+        reset(false);
+
+        m_tol = tol;
+
+        m_brickSize  = size;
+        m_brickLevel = brickLevel;
+
+        // Evaluate the Morton numbers of the root octants
+        uint8_t rootShift = m_treeConstants->maxLevel - brickLevel;
+
+        u32array3 brickLength;
+        for (int d = 0; d < 3; ++d) {
+            brickLength[d] = size[d] << rootShift;
+        }
+
+        std::vector<uint64_t> rootMortons;
+        rootMortons.reserve(uint64_t(size[0]) * size[1] * size[2]);
+        for (uint32_t k = 0; k < size[2]; ++k) {
+            for (uint32_t j = 0; j < size[1]; ++j) {
+                for (uint32_t i = 0; i < size[0]; ++i) {
+                    rootMortons.push_back(PABLO::computeMorton(m_dim, i << rootShift, j << rootShift, k << rootShift));
+                }
+            }
+        }
+        std::sort(rootMortons.begin(), rootMortons.end());
+
+        // Evaluate the global indexes of the octants owned by this process
+        uint64_t nRootOctants = uint64_t(1) << (m_dim * level);
+        uint64_t nGlobalOctants = rootMortons.size() * nRootOctants;
+        initializeUniformPartitionRanges(nGlobalOctants);
+
+        uint64_t beginGlobalIdx = (m_rank > 0) ? m_partitionRangeGlobalIdx[m_rank - 1] + 1 : 0;
+        uint64_t endGlobalIdx   = m_partitionRangeGlobalIdx[m_rank] + 1;
+
+        // Create the octants
+        //
+        // Inside a root octant, the Morton number of an octant is the Morton
+        // number of the root shifted by the local index of the octant, scaled
+        // by the bits of the levels below the octant one.
+        uint8_t octantLevel = brickLevel + level;
+        uint8_t mortonShift = m_dim * (m_treeConstants->maxLevel - octantLevel);
+
+        m_octree.m_octants.resize(endGlobalIdx - beginGlobalIdx);
+        for (uint64_t globalIdx = beginGlobalIdx; globalIdx < endGlobalIdx; ++globalIdx) {
+            uint64_t rootMorton = rootMortons[globalIdx / nRootOctants];
+            uint64_t localIdx   = globalIdx % nRootOctants;
+
+            Octant &octant = m_octree.m_octants[globalIdx - beginGlobalIdx];
+            octant = Octant(m_dim, octantLevel, rootMorton + (localIdx << mortonShift));
+
+            uint32_t octantSize = octant.getLogicalSize();
+            for (int d = 0; d < m_dim; ++d) {
+                uint32_t coordinate = octant.getLogicalCoordinates(d);
+                octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d, coordinate == 0);
+                octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d + 1, coordinate + octantSize == brickLength[d]);
+            }
+        }
+
+        // Update tree information
+        initializePartitionedOctants();
+
+        m_lastOp = OP_INIT;
+
+        (*m_log) << " Number of root octants	:	" + to_string(static_cast<unsigned long long>(rootMortons.size())) << endl;
+        (*m_log) << " Number of octants		:	" + to_string(static_cast<unsigned long long>(m_globalNumOctants)) << endl;
+        (*m_log) << " " << endl;
+        (*m_log) << "---------------------------------------------" << endl;
+    }
+
+    /** Initialize the partition ranges distributing the specified number of
+     * global octants uniformly among the processes.
+     *
+     * The distribution is the same used by loadBalance when no weights are
+     * specified.
+     *
+     * \param[in] nGlobalOctants Global number of octants
+     */
+    void
+    ParaTree::initializeUniformPartitionRanges(uint64_t nGlobalOctants) {
+        uint64_t division = nGlobalOctants / m_nproc;
+        uint64_t remainder = nGlobalOctants % m_nproc;
+        for (int p = 0; p < m_nproc; ++p) {
+            uint64_t nPartitionOctants = division + ((uint64_t) p < remainder ? 1 : 0);
+            if (nPartitionOctants > std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error ("Too many octants per process");
+            }
+
+            uint64_t previousRange = (p > 0) ? m_partitionRangeGlobalIdx[p - 1] : uint64_t(-1);
+            m_partitionRangeGlobalIdx[p] = previousRange + nPartitionOctants;
+            m_partitionRangeGlobalIdx0[p] = 0;
+        }
+
+        m_globalNumOctants = nGlobalOctants;
+    }
+
+    /** Initialize tree information after the local octants have been created
+     * directly in the partition described by the current partition ranges.
+     *
+     * When the tree is distributed among multiple processes, the partition
+     * descriptors and the ghost halo are built.
+     */
+    void
+    ParaTree::initializePartitionedOctants() {
+        m_octree.updateLocalMaxDepth();
+        m_octree.setFirstDescMorton();
+        m_octree.setLastDescMorton();
+
+#if BITPIT_ENABLE_MPI==1
+        if (m_nproc > 1) {
+            m_serial = false;
+            m_errorFlag = MPI_Allreduce(&m_octree.m_localMaxDepth,&m_maxDepth,1,MPI_INT8_T,MPI_MAX,m_comm);
+            updateGlobalFirstDescMorton();
+            updateGlobalLasttDescMorton();
+            computeGhostHalo();
+        } else {
+#endif
+            m_partitionFirstDesc[0] = m_octree.getFirstDescMorton();
+            m_partitionLastDesc[0]  = m_octree.getLastDescMorton();
+            updateAdapt();
+#if BITPIT_ENABLE_MPI==1
+        }
+#endif
+    }
+
     /*! Get the current maximum size of the octree.
      *  If the tree is empty a negative number is returned.
      * \return Current maximum size of the octree.
@@ -3813,6 +4985,7 @@ namespace bitpit {
      */
     void
     ParaTree::computeConnectivity() {
+        PerformanceTimer timer(this, PHASE_CONNECTIVITY, getNumOctants());
         m_octree.computeConnectivity();
     }
 
@@ -3830,35 +5003,50 @@ namespace bitpit {
      */
     void
     ParaTree::updateConnectivity() {
+        PerformanceTimer timer(this, PHASE_CONNECTIVITY, getNumOctants());
         m_octree.updateConnectivity();
     }
 
     /** Get the connectivity of the octants
-     * \return Constant reference to the connectivity matrix of noctants*nnodes with
-     * the connectivity of each octant (4/8 indices of nodes for 2D/3D case).
+     * \return Constant reference to the flat (compressed row) container with
+     * the connectivity of each octant (4/8 indices of nodes for 2D/3D case),
+     * the indices of the nodes of the i-th octant can be accessed through
+     * getItem(i, j).
      */
-    const u32vector2D &
+    const FlatVector2D<uint32_t> &
     ParaTree::getConnectivity() const {
         return m_octree.m_connectivity;
     }
 
     /** Get the local connectivity of an octant
      * \param[in] idx Local index of octant
-     * \return Constant reference to the connectivity of the octant
-     * (4/8 indices of nodes for 2D/3D case).
+     * \return A view over the connectivity of the octant (4/8 indices of
+     * nodes for 2D/3D case).
      */
-    const u32vector &
+    ConstProxyVector<uint32_t>
     ParaTree::getConnectivity(uint32_t idx) const {
-        return m_octree.m_connectivity[idx];
+        return ConstProxyVector<uint32_t>(m_octree.m_connectivity.get(idx), m_octree.m_connectivity.getItemCount(idx));
     }
 
     /** Get the local connectivity of an octant
      * \param[in] oct Pointer to an octant
-     * \return Constant reference to the connectivity of the octant (4/8 indices of nodes for 2D/3D case).
+     * \return A view over the connectivity of the octant (4/8 indices of
+     * nodes for 2D/3D case).
      */
-    const u32vector &
+    ConstProxyVector<uint32_t>
     ParaTree::getConnectivity(Octant* oct) const {
-        return m_octree.m_connectivity[getIdx(oct)];
+        return getConnectivity(getIdx(oct));
+    }
+
+    /** Get the connectivity of the octants stored in a flat container
+     * \return Constant reference to the flat (compressed row) container with
+     * the connectivity of each octant (4/8 indices of nodes for 2D/3D case),
+     * the indices of the nodes of the i-th octant can be accessed through
+     * getItem(i, j).
+     */
+    const FlatVector2D<uint32_t> &
+    ParaTree::getConnectivityFlat() const {
+        return m_octree.m_connectivity;
     }
 
     /** Get the logical coordinates of the nodes
@@ -3888,32 +5076,127 @@ namespace bitpit {
     }
 
     /** Get the connectivity of the ghost octants
-     * \return Constant reference to connectivity matrix [nghostoctants*nnodes] with
-     * the connectivity of each octant (4/8 indices of nodes for 2D/3D case).
+     * \return Constant reference to the flat (compressed row) container with
+     * the connectivity of each ghost octant (4/8 indices of nodes for 2D/3D
+     * case), the indices of the nodes of the i-th ghost octant can be accessed
+     * through getItem(i, j).
      */
-    const u32vector2D &
+    const FlatVector2D<uint32_t> &
     ParaTree::getGhostConnectivity() const {
         return m_octree.m_ghostsConnectivity;
     }
 
     /** Get the local connectivity of a ghost octant
      * \param[in] idx Local index of ghost octant
-     * \return Constant reference to the connectivity of the ghost octant
-     * (4/8 indices of nodes for 2D/3D case).
+     * \return A view over the connectivity of the ghost octant (4/8 indices
+     * of nodes for 2D/3D case).
      */
-    const u32vector &
+    ConstProxyVector<uint32_t>
     ParaTree::getGhostConnectivity(uint32_t idx) const {
-        return m_octree.m_ghostsConnectivity[idx];
+        return ConstProxyVector<uint32_t>(m_octree.m_ghostsConnectivity.get(idx), m_octree.m_ghostsConnectivity.getItemCount(idx));
     }
 
     /** Get the local connectivity of a ghost octant
      * \param[in] oct Pointer to a ghost octant
-     * \return Constant reference to the connectivity of the ghost octant
-     * (4/8 indices of nodes for 2D/3D case).
+     * \return A view over the connectivity of the ghost octant (4/8 indices
+     * of nodes for 2D/3D case).
      */
-    const u32vector &
+    ConstProxyVector<uint32_t>
     ParaTree::getGhostConnectivity(const Octant* oct) const {
-        return m_octree.m_ghostsConnectivity[getIdx(oct)];
+        return getGhostConnectivity(getIdx(oct));
+    }
+
+    /** Get the connectivity of the ghost octants stored in a flat container
+     * \return Constant reference to the flat (compressed row) container with
+     * the connectivity of each ghost octant (4/8 indices of nodes for 2D/3D
+     * case), the indices of the nodes of the i-th ghost octant can be accessed
+     * through getItem(i, j).
+     */
+    const FlatVector2D<uint32_t> &
+    ParaTree::getGhostConnectivityFlat() const {
+        return m_octree.m_ghostsConnectivity;
+    }
+
+    /** Compute the neighbour graph of the local octants.
+     * The graph stores the neighbours (both local and ghost ones) of all the
+     * local octants through all their entities up to the specified
+     * codimension; once computed, the graph is kept up to date by the
+     * methods that modify the tree. After an adapt with tracking of the
+     * changes the graph is updated incrementally, i.e., only the neighbours
+     * of the entities affected by the adaption are searched again.
+     * \param[in] maxCodim Maximum codimension of the entities (1=faces only,
+     * 2=faces and edges for 3D trees or faces and nodes for 2D trees, 3=faces,
+     * edges and nodes for 3D trees)
+     */
+    void
+    ParaTree::computeNeighbourGraph(uint8_t maxCodim) {
+        PerformanceTimer timer(this, PHASE_CONNECTIVITY, getNumOctants());
+        m_octree.computeNeighbourGraph(maxCodim);
+    }
+
+    /** Clear the neighbour graph of the local octants.
+     * \param[in] release if it's true the memory hold by the graph will be
+     * released, otherwise the graph will be cleared but its memory will
+     * not be released
+     */
+    void
+    ParaTree::clearNeighbourGraph(bool release) {
+        m_octree.clearNeighbourGraph(release);
+    }
+
+    /** Get the maximum codimension of the entities stored in the neighbour
+     * graph.
+     * \return The maximum codimension of the entities stored in the neighbour
+     * graph, zero if the graph has not been computed.
+     */
+    uint8_t
+    ParaTree::getNeighbourGraphCodimension() const {
+        return m_octree.m_neighGraphCodim;
+    }
+
+    /** Get the neighbours of a local octant through the specified entity
+     * (face/edge/node) from the neighbour graph.
+     * \param[in] idx Index of current octant
+     * \param[in] entityIdx Index of face/edge/node
+     * \param[in] entityCodim Codimension of the entity (1=face, 2=edge and 3=vertex for 3D trees, 1=face, 2=vertex for 2D trees)
+     * \return Constant proxy to the indices of the neighbours in their container,
+     * the same neighbours returned by findNeighbours are listed in the same order.
+     */
+    ConstProxyVector<uint32_t>
+    ParaTree::getGraphNeighbours(uint32_t idx, uint8_t entityIdx, uint8_t entityCodim) const {
+
+        assert(entityCodim >= 1 && entityCodim <= m_octree.m_neighGraphCodim);
+        const LocalTree::NeighbourGraph &graph = m_octree.m_neighGraphs[entityCodim - 1];
+
+        uint64_t item  = static_cast<uint64_t>(idx) * m_octree.getNeighbourGraphEntityCount(entityCodim) + entityIdx;
+        uint64_t begin = graph.offsets[item];
+        uint64_t end   = graph.offsets[item + 1];
+
+        return ConstProxyVector<uint32_t>(graph.neighbours.data() + begin, end - begin);
+
+    }
+
+    /** Get the neighbours of a local octant through the specified entity
+     * (face/edge/node) from the neighbour graph.
+     * \param[in] idx Index of current octant
+     * \param[in] entityIdx Index of face/edge/node
+     * \param[in] entityCodim Codimension of the entity (1=face, 2=edge and 3=vertex for 3D trees, 1=face, 2=vertex for 2D trees)
+     * \param[out] neighbours Vector with the index of the neighbours in their container
+     * \param[out] isghost Vector with boolean flag; true if the respective octant in neighbours is a ghost octant. Can be ignored in serial runs.
+     */
+    void
+    ParaTree::getGraphNeighbours(uint32_t idx, uint8_t entityIdx, uint8_t entityCodim, u32vector & neighbours, bvector & isghost) const {
+
+        assert(entityCodim >= 1 && entityCodim <= m_octree.m_neighGraphCodim);
+        const LocalTree::NeighbourGraph &graph = m_octree.m_neighGraphs[entityCodim - 1];
+
+        uint64_t item  = static_cast<uint64_t>(idx) * m_octree.getNeighbourGraphEntityCount(entityCodim) + entityIdx;
+        uint64_t begin = graph.offsets[item];
+        uint64_t end   = graph.offsets[item + 1];
+
+        neighbours.assign(graph.neighbours.begin() + begin, graph.neighbours.begin() + end);
+        isghost.assign(graph.ghostFlags.begin() + begin, graph.ghostFlags.begin() + end);
+
     }
 
 
@@ -3995,6 +5278,20 @@ namespace bitpit {
      */
     void
     ParaTree::loadBalance(const dvector* weight){
+        DataLBFields fields;
+        loadBalance(fields, weight);
+    }
+
+    /** Distribute Load-Balancing the octants (with user defined weights) of the whole tree and
+     * fixed-size fields provided by the user over the processes of the job following the Morton order.
+     * Until loadBalance is not called for the first time the mesh is serial.
+     * The data of the octants exchanged with a process, as well as the data of the octants that
+     * remain on the process, are copied with a single operation for each field.
+     * \param[in,out] fields Fixed-size fields to distribute during loadBalance.
+     * \param[in] weight Pointer to a vector of weights of the local octants (weight=NULL is uniform distribution).
+     */
+    void
+    ParaTree::loadBalance(DataLBFields & fields, const dvector* weight){
 
         //Write info on log
         (*m_log) << "---------------------------------------------" << endl;
@@ -4011,7 +5308,7 @@ namespace bitpit {
 
             weight = NULL;
 
-            privateLoadBalance<DummyDataLBImpl>(partition.data(), nullptr);
+            privateLoadBalance<DummyDataLBImpl>(partition.data(), nullptr, &fields);
 
             //Write info of final partition on log
             (*m_log) << " " << endl;
@@ -4042,6 +5339,20 @@ namespace bitpit {
      */
     void
     ParaTree::loadBalance(uint8_t & level, const dvector* weight){
+        DataLBFields fields;
+        loadBalance(fields, level, weight);
+    }
+
+    /** Distribute Load-Balanced the octants (with user defined weights) of the whole tree and
+     * fixed-size fields provided by the user over the processes of the job. Until loadBalance
+     * is not called for the first time the mesh is serial.
+     * The families of octants of a desired level are retained compact on the same process.
+     * \param[in,out] fields Fixed-size fields to distribute during loadBalance.
+     * \param[in] level Number of level over the max depth reached in the tree at which families of octants are fixed compact on the same process (level=0 is classic LoadBalance).
+     * \param[in] weight Pointer to a vector of weights of the local octants (weight=NULL is uniform distribution).
+     */
+    void
+    ParaTree::loadBalance(DataLBFields & fields, uint8_t & level, const dvector* weight){
 
         //Write info on log
         (*m_log) << "---------------------------------------------" << endl;
@@ -4053,7 +5364,7 @@ namespace bitpit {
             std::vector<uint32_t> partition(m_nproc);
             computePartition(level, weight, partition.data());
 
-            privateLoadBalance<DummyDataLBImpl>(partition.data(), nullptr);
+            privateLoadBalance<DummyDataLBImpl>(partition.data(), nullptr, &fields);
 
             //Write info of final partition on log
             (*m_log) << " " << endl;
@@ -4076,6 +5387,115 @@ namespace bitpit {
 
     };
 
+    /*! Enable or disable the node-aware partitioning.
+     *
+     * When node-aware partitioning is enabled, the load balance partitions the
+     * Morton-ordered sequence of octants in two levels: octants are first
+     * split among the nodes and then the chunk of each node is split among
+     * its processes. Boundaries between nodes are moved only when the weight
+     * of a node differs from its target weight by more than the node tolerance
+     * (see setNodePartitionTolerance), otherwise octants migrate only among the
+     * processes of the same node, where the exchanges are cheaper. Since
+     * partitions follow the order of the ranks, a node is made by consecutive
+     * ranks: processes of the same node with non-consecutive ranks are treated
+     * as different nodes.
+     *
+     * This is a collective function.
+     * \param[in] enable Set to true to enable the node-aware partitioning,
+     * false to disable it
+     * \param[in] nodeComm Communicator that groups the processes of the same
+     * node, if a null communicator is given nodes are detected splitting the
+     * communicator of the tree with MPI_COMM_TYPE_SHARED
+     */
+    void
+    ParaTree::enableNodeAwarePartitioning(bool enable, MPI_Comm nodeComm) {
+        m_nodeAwarePartitioning = enable;
+        m_partitionNodeOffsets.clear();
+        if (!enable || !isCommSet()) {
+            return;
+        }
+
+        // Identify the node of each process
+        //
+        // A node is identified by the rank, in the communicator of the tree,
+        // of its first process.
+        MPI_Comm sharedComm = nodeComm;
+        if (nodeComm == MPI_COMM_NULL) {
+            MPI_Comm_split_type(m_comm, MPI_COMM_TYPE_SHARED, m_rank, MPI_INFO_NULL, &sharedComm);
+        }
+
+        int nodeId = m_rank;
+        MPI_Allreduce(&m_rank, &nodeId, 1, MPI_INT, MPI_MIN, sharedComm);
+
+        if (nodeComm == MPI_COMM_NULL) {
+            MPI_Comm_free(&sharedComm);
+        }
+
+        std::vector<int> nodeIds(m_nproc);
+        MPI_Allgather(&nodeId, 1, MPI_INT, nodeIds.data(), 1, MPI_INT, m_comm);
+
+        // Evaluate node offsets
+        m_partitionNodeOffsets.push_back(0);
+        for (int i = 1; i < m_nproc; ++i) {
+            if (nodeIds[i] != nodeIds[i - 1]) {
+                m_partitionNodeOffsets.push_back(i);
+            }
+        }
+        m_partitionNodeOffsets.push_back(m_nproc);
+    }
+
+    /*! Check if the node-aware partitioning is enabled.
+     * \return Returns true if the node-aware partitioning is enabled, false
+     * otherwise.
+     */
+    bool
+    ParaTree::isNodeAwarePartitioningEnabled() const {
+        return m_nodeAwarePartitioning;
+    }
+
+    /*! Get the number of nodes used by the node-aware partitioning.
+     * \return The number of nodes used by the node-aware partitioning, zero
+     * if node-aware partitioning is disabled.
+     */
+    int
+    ParaTree::getPartitionNodeCount() const {
+        if (m_partitionNodeOffsets.empty()) {
+            return 0;
+        }
+
+        return static_cast<int>(m_partitionNodeOffsets.size()) - 1;
+    }
+
+    /*! Get the tolerance on the weight of the nodes used by the node-aware
+     * partitioning.
+     * \return The maximum allowed relative difference between the weight of a
+     * node and its target weight.
+     */
+    double
+    ParaTree::getNodePartitionTolerance() const {
+        return m_nodePartitionTolerance;
+    }
+
+    /*! Set the tolerance on the weight of the nodes used by the node-aware
+     * partitioning.
+     *
+     * Boundaries between nodes are kept unchanged by the load balance as long
+     * as the weight of every node differs from its target weight by no more
+     * than the specified fraction of the target. A zero tolerance moves the
+     * boundaries between nodes at every load balance. The default tolerance
+     * is 0.05.
+     * \param[in] tolerance The maximum allowed relative difference between the
+     * weight of a node and its target weight.
+     */
+    void
+    ParaTree::setNodePartitionTolerance(double tolerance) {
+        if (tolerance < 0.) {
+            throw std::runtime_error ("Node partition tolerance should be non-negative.");
+        }
+
+        m_nodePartitionTolerance = tolerance;
+    }
+
     /**
      * Evaluate the elements of the current partition that will be exchanged
      * with other processes during the load balance.
@@ -4382,8 +5802,8 @@ namespace bitpit {
         vector<Octant >::iterator iter, iterend = m_octree.m_octants.end();
 
         for (iter = m_octree.m_octants.begin(); iter != iterend; ++iter){
-            iter->m_info[Octant::INFO_NEW4REFINEMENT] = false;
-            iter->m_info[Octant::INFO_NEW4COARSENING] = false;
+            iter->setInfo(Octant::INFO_NEW4REFINEMENT, false);
+            iter->setInfo(Octant::INFO_NEW4COARSENING, false);
         }
 
         // m_mapIdx init
@@ -4414,7 +5834,10 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(getNumOctants())) << endl;
 
             // Refine
-            while(m_octree.refine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.refine(m_mapIdx));
+            }
             if (getNumOctants() > nocts0)
                 globalDone = true;
             (*m_log) << " Number of octants after Refine	:	" + to_string(static_cast<unsigned long long>(getNumOctants())) << endl;
@@ -4422,8 +5845,11 @@ namespace bitpit {
             updateAdapt();
 
             // Coarse
-            while(m_octree.coarse(m_mapIdx));
-            updateAfterCoarse();
+            {
+                PerformanceTimer timer(this, PHASE_COARSEN, getNumOctants());
+                while(m_octree.coarse(m_mapIdx));
+                updateAfterCoarse();
+            }
             if (getNumOctants() < nocts0){
                 globalDone = true;
             }
@@ -4447,7 +5873,10 @@ namespace bitpit {
             (*m_log) << " Initial Number of octants		:	" + to_string(static_cast<unsigned long long>(m_globalNumOctants)) << endl;
 
             // Refine
-            while(m_octree.refine(m_mapIdx));
+            {
+                PerformanceTimer timer(this, PHASE_REFINE, getNumOctants());
+                while(m_octree.refine(m_mapIdx));
+            }
             bool localDone = false;
             if (getNumOctants() > nocts0)
                 localDone = true;
@@ -4458,8 +5887,11 @@ namespace bitpit {
 
 
             // Coarse
-            while(m_octree.coarse(m_mapIdx));
-            updateAfterCoarse();
+            {
+                PerformanceTimer timer(this, PHASE_COARSEN, getNumOctants());
+                while(m_octree.coarse(m_mapIdx));
+                updateAfterCoarse();
+            }
             computeGhostHalo();
             if (getNumOctants() < nocts0){
                 localDone = true;
@@ -4480,7 +5912,30 @@ namespace bitpit {
             m_lastOp = OP_ADAPT_UNMAPPED;
         }
 
-        return globalDone;
+        // Update the neighbour graph
+        updateNeighbourGraph(mapflag);
+
+        return globalDone;
+    }
+
+    /*! Update the neighbour graph after a modification of the tree.
+     * Nothing is done if the neighbour graph has not been computed.
+     * \param[in] mapped True if the modification was an adaption with tracking
+     * of the changes, in this case the graph is updated incrementally,
+     * otherwise the graph is computed from scratch.
+     */
+    void
+    ParaTree::updateNeighbourGraph(bool mapped){
+        if (m_octree.m_neighGraphCodim == 0) {
+            return;
+        }
+
+        PerformanceTimer timer(this, PHASE_CONNECTIVITY, getNumOctants());
+        if (mapped) {
+            m_octree.updateNeighbourGraph(m_mapIdx);
+        } else {
+            m_octree.computeNeighbourGraph(m_octree.m_neighGraphCodim);
+        }
     }
 
     /*!Update the local tree after an adapt.
@@ -4541,18 +5996,26 @@ namespace bitpit {
     void
     ParaTree::computePartition(uint32_t* partition){
 
-        uint32_t division_result = 0;
-        uint32_t remind = 0;
+        if (m_nodeAwarePartitioning) {
+            computeNodeAwarePartition(nullptr, partition);
+        } else {
+            uint32_t division_result = 0;
+            uint32_t remind = 0;
 
-        division_result = uint32_t(m_globalNumOctants/(uint64_t)m_nproc);
-        remind = (uint32_t)(m_globalNumOctants%(uint64_t)m_nproc);
+            division_result = uint32_t(m_globalNumOctants/(uint64_t)m_nproc);
+            remind = (uint32_t)(m_globalNumOctants%(uint64_t)m_nproc);
 
-        for(uint32_t i = 0; i < (uint32_t)m_nproc; ++i)
-            if(i<remind)
-                partition[i] = division_result + 1;
-            else
-                partition[i] = division_result;
+            for(uint32_t i = 0; i < (uint32_t)m_nproc; ++i)
+                if(i<remind)
+                    partition[i] = division_result + 1;
+                else
+                    partition[i] = division_result;
+        }
 
+        // Move partition boundaries to reduce fragmentation
+        if (m_partitionTolerance > 0.) {
+            compactPartition(nullptr, partition);
+        }
     }
 
     /*! Compute the partition of the octree over the processes (only compute the information about
@@ -4568,14 +6031,18 @@ namespace bitpit {
 
         // Evaluate global weights
         //
-        // If the tree is serial, all process have all the octants, hence
-        // global weights and local weights are the same.
+        // The node-aware partitioning works on the local weights, global
+        // weights are gathered only if needed by the compaction of the
+        // partitions. If the tree is serial, all process have all the
+        // octants, hence global weights and local weights are the same.
         std::vector<double> globalWeightsStorage;
 
-        const double *globalWeights;
-        if (m_serial) {
+        bool gatherWeights = !m_nodeAwarePartitioning || (m_partitionTolerance > 0.);
+
+        const double *globalWeights = nullptr;
+        if (gatherWeights && m_serial) {
             globalWeights = weight->data();
-        } else {
+        } else if (gatherWeights) {
             // Information about current partitioning and displacements should
             // be stored using uint32_t, however the maximum number of items
             // that can be exchanged using MPI funcitons is limited to INT_MAX.
@@ -4596,42 +6063,514 @@ namespace bitpit {
                            currentPartition.data(), displacements.data(), MPI_DOUBLE, m_comm);
         }
 
-        // Initialize partitioning
+        // Assign octants to partitions
+        if (m_nodeAwarePartitioning) {
+            computeNodeAwarePartition(weight, partition);
+        } else {
+            // Initialize partitioning
+            for (int i = 0; i < m_nproc; ++i) {
+                partition[i] = 0;
+            }
+
+            // Assign octants to partitions
+            //
+            // After evaluationg the target weight of a partition, octants will
+            // be added to that partition until the weigth of the partition is
+            // greater or equal the target weigth or until all the octant are
+            // assigned
+            uint32_t nAssigendOctants = 0;
+            for (int i = 0; i < m_nproc - 1; ++i) {
+                double unassignedWeight = 0.;
+                for (uint32_t n=nAssigendOctants; n<m_globalNumOctants; n++){
+                    unassignedWeight += globalWeights[n];
+                }
+                double targetWeight = unassignedWeight / (m_nproc - i);
+
+                double partitionWeight = 0.;
+                while(partitionWeight < targetWeight){
+                    partitionWeight += globalWeights[nAssigendOctants];
+                    partition[i]++;
+
+                    nAssigendOctants++;
+                    if (nAssigendOctants == m_globalNumOctants) {
+                        break;
+                    }
+                }
+
+                if (nAssigendOctants == m_globalNumOctants) {
+                        break;
+                }
+            }
+            partition[m_nproc-1] = static_cast<uint32_t>(m_globalNumOctants - nAssigendOctants);
+        }
+
+        // Move partition boundaries to reduce fragmentation
+        if (m_partitionTolerance > 0.) {
+            compactPartition(globalWeights, partition);
+        }
+    };
+
+    /*! Compute a two-level partition of the octree: the Morton-ordered sequence
+     * of octants is first split among the nodes, proportionally to the number
+     * of processes of each node, then the chunk of each node is split among its
+     * processes.
+     *
+     * If the tree is already distributed and the weight of every node is
+     * within the node tolerance from its target weight, the boundaries between
+     * the nodes are kept and only the boundaries between the processes of the
+     * same node are moved; in this case octants are exchanged only among the
+     * processes of the same node.
+     *
+     * Weights are never gathered: every process evaluates the prefix sum of
+     * the weights of its own octants, the boundaries that fall among them are
+     * located locally and then shared with a reduction over the processes.
+     * \param[in] weight Pointer to the weights of the local octants (a null
+     * pointer means uniform weights).
+     * \param[out] partition Pointer to partition information array. partition[i]
+     * = number of octants to be stored on the i-th process (i-th rank).
+     */
+    void
+    ParaTree::computeNodeAwarePartition(const dvector *weight, uint32_t *partition){
+
+        // Evaluate the cumulative weights of the local octants
+        //
+        // The position and the cumulative weight of the first local octant
+        // are evaluated from the number of octants and from the weight of the
+        // previous processes. The weights of the processes are gathered, so
+        // that all processes evaluate the total weight summing the same values
+        // in the same order. If the tree is serial, all process have all the
+        // octants, hence no communication is needed.
+        //
+        // With uniform weights the cumulative weight of a position is the
+        // position itself, hence the cumulative weights are stored only when
+        // the weights are given.
+        uint64_t nOctants = m_octree.getNumOctants();
+        uint64_t globalOffset = 0;
+        double weightOffset = 0.;
+        double totalWeight = static_cast<double>(m_globalNumOctants);
+
+        std::vector<double> cumulativeWeights;
+        if (weight) {
+            assert(weight->size() >= nOctants);
+
+            cumulativeWeights.resize(nOctants + 1);
+            cumulativeWeights[0] = 0.;
+            for (uint64_t n = 0; n < nOctants; ++n) {
+                cumulativeWeights[n + 1] = cumulativeWeights[n] + (*weight)[n];
+            }
+
+            totalWeight = cumulativeWeights.back();
+            if (!m_serial) {
+                MPI_Exscan(&nOctants, &globalOffset, 1, MPI_UINT64_T, MPI_SUM, m_comm);
+                if (m_rank == 0) {
+                    globalOffset = 0;
+                }
+
+                std::vector<double> processWeights(m_nproc);
+                MPI_Allgather(&totalWeight, 1, MPI_DOUBLE, processWeights.data(), 1, MPI_DOUBLE, m_comm);
+
+                totalWeight = 0.;
+                for (int i = 0; i < m_nproc; ++i) {
+                    if (i == m_rank) {
+                        weightOffset = totalWeight;
+                    }
+                    totalWeight += processWeights[i];
+                }
+            }
+        }
+
+        uint64_t globalEnd = globalOffset + nOctants;
+
+        // Evaluate the cumulative weights of the given positions
+        //
+        // Every position is evaluated by the process that owns the octant
+        // starting at that position, the cumulative weight of the end of the
+        // tree is the total weight.
+        auto evalCumulativeWeights = [&](const std::vector<uint64_t> &positions) -> std::vector<double> {
+            std::size_t nPositions = positions.size();
+            std::vector<double> values(nPositions, std::numeric_limits<double>::lowest());
+            for (std::size_t k = 0; k < nPositions; ++k) {
+                uint64_t position = positions[k];
+                if (!weight) {
+                    values[k] = static_cast<double>(position);
+                } else if (position == m_globalNumOctants) {
+                    values[k] = totalWeight;
+                } else if (position >= globalOffset && position < globalEnd) {
+                    values[k] = weightOffset + cumulativeWeights[position - globalOffset];
+                }
+            }
+
+            if (weight && !m_serial && nPositions > 0) {
+                MPI_Allreduce(MPI_IN_PLACE, values.data(), static_cast<int>(nPositions), MPI_DOUBLE, MPI_MAX, m_comm);
+            }
+
+            return values;
+        };
+
+        // Find the boundaries closest to the given target weights
+        //
+        // The boundary of the k-th target is the position in the range
+        // [begins[k], ends[k]] whose cumulative weight is closest to the
+        // target. The first position whose cumulative weight is not less than
+        // the target is searched among the local octants, then the minimum
+        // over the processes is taken. Positions and cumulative weights of
+        // the boundaries are returned.
+        auto findBoundaries = [&](const std::vector<double> &targets, const std::vector<uint64_t> &begins, const std::vector<uint64_t> &ends,
+                                  std::vector<uint64_t> *boundaries, std::vector<double> *boundaryWeights) {
+            auto isBelowTarget = [weightOffset](double cumulativeWeight, double targetWeight) -> bool {
+                return (weightOffset + cumulativeWeight < targetWeight);
+            };
+
+            std::size_t nTargets = targets.size();
+            std::vector<uint64_t> positions(nTargets, std::numeric_limits<uint64_t>::max());
+            for (std::size_t k = 0; k < nTargets; ++k) {
+                double targetWeight = targets[k];
+                if (!weight) {
+                    positions[k] = static_cast<uint64_t>(std::max(std::ceil(targetWeight), 0.));
+                } else {
+                    auto itr = std::lower_bound(cumulativeWeights.begin(), cumulativeWeights.begin() + nOctants, targetWeight, isBelowTarget);
+                    if (itr != cumulativeWeights.begin() + nOctants) {
+                        positions[k] = globalOffset + static_cast<uint64_t>(itr - cumulativeWeights.begin());
+                    }
+                }
+            }
+
+            if (weight && !m_serial && nTargets > 0) {
+                MPI_Allreduce(MPI_IN_PLACE, positions.data(), static_cast<int>(nTargets), MPI_UINT64_T, MPI_MIN, m_comm);
+            }
+
+            std::vector<uint64_t> candidates(2 * nTargets);
+            for (std::size_t k = 0; k < nTargets; ++k) {
+                positions[k] = std::min(std::max(positions[k], begins[k]), ends[k]);
+
+                candidates[2 * k]     = (positions[k] > begins[k]) ? positions[k] - 1 : positions[k];
+                candidates[2 * k + 1] = positions[k];
+            }
+
+            std::vector<double> candidateWeights = evalCumulativeWeights(candidates);
+
+            boundaries->resize(nTargets);
+            boundaryWeights->resize(nTargets);
+            for (std::size_t k = 0; k < nTargets; ++k) {
+                double targetWeight = targets[k];
+                if (positions[k] > begins[k] && (targetWeight - candidateWeights[2 * k]) <= (candidateWeights[2 * k + 1] - targetWeight)) {
+                    (*boundaries)[k]      = candidates[2 * k];
+                    (*boundaryWeights)[k] = candidateWeights[2 * k];
+                } else {
+                    (*boundaries)[k]      = candidates[2 * k + 1];
+                    (*boundaryWeights)[k] = candidateWeights[2 * k + 1];
+                }
+            }
+        };
+
+        // Nodes
+        //
+        // If node information is not available, every process is considered
+        // a node by itself.
+        std::vector<int> nodeOffsets = m_partitionNodeOffsets;
+        if (nodeOffsets.empty() || nodeOffsets.back() != m_nproc) {
+            nodeOffsets.resize(m_nproc + 1);
+            for (int i = 0; i <= m_nproc; ++i) {
+                nodeOffsets[i] = i;
+            }
+        }
+
+        int nNodes = static_cast<int>(nodeOffsets.size()) - 1;
+
+        // Evaluate the boundaries between the nodes
+        //
+        // The i-th boundary is the position of the first octant of the i-th
+        // node.
+        std::vector<uint64_t> nodeBoundaries(nNodes + 1);
+        nodeBoundaries[0]      = 0;
+        nodeBoundaries[nNodes] = m_globalNumOctants;
+
+        std::vector<double> nodeBoundaryWeights;
+
+        bool keepNodeBoundaries = !m_serial && (m_nodePartitionTolerance > 0.);
+        if (keepNodeBoundaries) {
+            for (int i = 1; i < nNodes; ++i) {
+                nodeBoundaries[i] = m_partitionRangeGlobalIdx[nodeOffsets[i] - 1] + 1;
+            }
+
+            nodeBoundaryWeights = evalCumulativeWeights(nodeBoundaries);
+            for (int i = 0; i < nNodes; ++i) {
+                double targetWeight = totalWeight * (nodeOffsets[i + 1] - nodeOffsets[i]) / m_nproc;
+                double nodeWeight   = nodeBoundaryWeights[i + 1] - nodeBoundaryWeights[i];
+                if (std::abs(nodeWeight - targetWeight) > m_nodePartitionTolerance * targetWeight) {
+                    keepNodeBoundaries = false;
+                    break;
+                }
+            }
+        }
+
+        // Boundaries are searched all together, starting from the beginning
+        // of the tree. Since target weights are increasing, the boundaries
+        // found are the same that would be found searching each boundary
+        // after the previous one, once they are made non-decreasing.
+        if (!keepNodeBoundaries) {
+            std::vector<double> targets(nNodes - 1);
+            for (int i = 1; i < nNodes; ++i) {
+                targets[i - 1] = totalWeight * nodeOffsets[i] / m_nproc;
+            }
+
+            std::vector<uint64_t> begins(nNodes - 1, 0);
+            std::vector<uint64_t> ends(nNodes - 1, m_globalNumOctants);
+
+            std::vector<uint64_t> boundaries;
+            std::vector<double> boundaryWeights;
+            findBoundaries(targets, begins, ends, &boundaries, &boundaryWeights);
+
+            nodeBoundaryWeights.resize(nNodes + 1);
+            nodeBoundaryWeights[0]      = 0.;
+            nodeBoundaryWeights[nNodes] = totalWeight;
+            for (int i = 1; i < nNodes; ++i) {
+                if (boundaries[i - 1] > nodeBoundaries[i - 1]) {
+                    nodeBoundaries[i]      = boundaries[i - 1];
+                    nodeBoundaryWeights[i] = boundaryWeights[i - 1];
+                } else {
+                    nodeBoundaries[i]      = nodeBoundaries[i - 1];
+                    nodeBoundaryWeights[i] = nodeBoundaryWeights[i - 1];
+                }
+            }
+        }
+
+        // Split the chunk of each node among its processes
+        //
+        // The boundaries of all the nodes are searched together, the
+        // boundaries of each node are then made non-decreasing.
+        std::vector<double> targets;
+        std::vector<uint64_t> begins;
+        std::vector<uint64_t> ends;
+        for (int i = 0; i < nNodes; ++i) {
+            int nNodeProcs = nodeOffsets[i + 1] - nodeOffsets[i];
+            double nodeWeight = nodeBoundaryWeights[i + 1] - nodeBoundaryWeights[i];
+            for (int k = 1; k < nNodeProcs; ++k) {
+                targets.push_back(nodeBoundaryWeights[i] + nodeWeight * k / nNodeProcs);
+                begins.push_back(nodeBoundaries[i]);
+                ends.push_back(nodeBoundaries[i + 1]);
+            }
+        }
+
+        std::vector<uint64_t> boundaries;
+        std::vector<double> boundaryWeights;
+        findBoundaries(targets, begins, ends, &boundaries, &boundaryWeights);
+
+        std::size_t nextBoundary = 0;
+        for (int i = 0; i < nNodes; ++i) {
+            int nNodeProcs = nodeOffsets[i + 1] - nodeOffsets[i];
+
+            uint64_t nodeEnd = nodeBoundaries[i + 1];
+
+            uint64_t previousBoundary = nodeBoundaries[i];
+            for (int k = 1; k <= nNodeProcs; ++k) {
+                uint64_t boundary = nodeEnd;
+                if (k < nNodeProcs) {
+                    boundary = std::max(boundaries[nextBoundary], previousBoundary);
+                    ++nextBoundary;
+                }
+
+                partition[nodeOffsets[i] + k - 1] = static_cast<uint32_t>(boundary - previousBoundary);
+                previousBoundary = boundary;
+            }
+        }
+    }
+
+    /*! Modify the partition of the octree over the processes to reduce the
+     * fragmentation of the partitions.
+     *
+     * Partitions are contiguous ranges of the Morton-ordered sequence of octants.
+     * A range that starts and ends on the boundary of a coarse block of the tree
+     * is the union of few complete blocks, whereas a range that cuts through a
+     * coarse block is made of many small pieces, whose boundaries increase the
+     * number of ghosts. Each boundary between partitions is moved, within the
+     * allowed tolerance on the weight of the partitions, to the position where
+     * the coarsest possible block starts; among the positions with the same
+     * alignment, the one closest to the original boundary is chosen.
+     *
+     * Each boundary is searched only inside a window around its original
+     * position: the window is limited by the tolerance and by the midpoints
+     * of the two neighbouring partitions, hence windows of different
+     * boundaries never overlap and boundaries can be moved independently.
+     * Every process evaluates the candidates among its own octants, then the
+     * best candidate of each boundary is selected with a reduction over the
+     * processes; the alignment of the octants is never gathered.
+     * \param[in] globalWeights Pointer to the weights of all the octants of the
+     * tree (a null pointer means uniform weights).
+     * \param[in,out] partition Pointer to partition information array. partition[i]
+     * = number of octants to be stored on the i-th process (i-th rank).
+     */
+    void
+    ParaTree::compactPartition(const double *globalWeights, uint32_t *partition){
+
+        // Evaluate the position of the first local octant
+        //
+        // If the tree is serial, all process have all the octants, hence
+        // global positions and local positions are the same.
+        uint64_t nOctants = m_octree.getNumOctants();
+        uint64_t globalOffset = 0;
+        if (!m_serial) {
+            MPI_Exscan(&nOctants, &globalOffset, 1, MPI_UINT64_T, MPI_SUM, m_comm);
+            if (m_rank == 0) {
+                globalOffset = 0;
+            }
+        }
+
+        uint64_t globalEnd = globalOffset + nOctants;
+
+        // Evaluate the alignment of a local octant
+        //
+        // The alignment of an octant is the coarsest level of the blocks of the
+        // tree that start with the octant.
+        auto evalAlignment = [this](uint32_t n) -> uint8_t {
+            const Octant &octant = m_octree.m_octants[n];
+            std::array<uint32_t, 3> coords = octant.getLogicalCoordinates();
+
+            uint8_t alignment = octant.getLevel();
+            while (alignment > 0) {
+                uint32_t blockSize = m_treeConstants->lengths[alignment - 1];
+                bool aligned = true;
+                for (int d = 0; d < m_dim; ++d) {
+                    aligned = aligned && (coords[d] % blockSize == 0);
+                }
+
+                if (!aligned) {
+                    break;
+                }
+
+                --alignment;
+            }
+
+            return alignment;
+        };
+
+        // Evaluate the maximum weight that can be moved across a boundary
+        double totalWeight = static_cast<double>(m_globalNumOctants);
+        if (globalWeights) {
+            totalWeight = 0.;
+            for (uint64_t n = 0; n < m_globalNumOctants; ++n) {
+                totalWeight += globalWeights[n];
+            }
+        }
+
+        double maxWeightShift = m_partitionTolerance * totalWeight / m_nproc;
+
+        // Evaluate the original boundaries
+        //
+        // The i-th boundary is the position of the first octant of the (i+1)-th
+        // partition.
+        std::vector<uint64_t> boundaries(m_nproc + 1);
+        boundaries[0] = 0;
         for (int i = 0; i < m_nproc; ++i) {
-            partition[i] = 0;
+            boundaries[i + 1] = boundaries[i] + partition[i];
         }
 
-        // Assign octants to partitions
+        // Find the best local candidate of each boundary
         //
-        // After evaluationg the target weight of a partition, octants will
-        // be added to that partition until the weigth of the partition is
-        // greater or equal the target weigth or until all the octant are
-        // assigned
-        uint32_t nAssigendOctants = 0;
-        for (int i = 0; i < m_nproc - 1; ++i) {
-            double unassignedWeight = 0.;
-            for (uint32_t n=nAssigendOctants; n<m_globalNumOctants; n++){
-                unassignedWeight += globalWeights[n];
-            }
-            double targetWeight = unassignedWeight / (m_nproc - i);
-
-            double partitionWeight = 0.;
-            while(partitionWeight < targetWeight){
-                partitionWeight += globalWeights[nAssigendOctants];
-                partition[i]++;
-
-                nAssigendOctants++;
-                if (nAssigendOctants == m_globalNumOctants) {
+        // Candidates are sorted by alignment, then by the weight moved across
+        // the boundary, then by position. Boundaries of empty partitions are
+        // not moved.
+        int nMovableBoundaries = m_nproc - 1;
+        std::vector<int> bestAlignments(nMovableBoundaries, INT_MAX);
+        std::vector<double> bestShifts(nMovableBoundaries, std::numeric_limits<double>::max());
+        std::vector<uint64_t> bestPositions(nMovableBoundaries, std::numeric_limits<uint64_t>::max());
+        for (int i = 1; i < m_nproc; ++i) {
+            uint64_t boundary = boundaries[i];
+            if (boundary == boundaries[i - 1] || boundary == boundaries[i + 1]) {
+                bestAlignments[i - 1] = 0;
+                bestShifts[i - 1]     = 0.;
+                bestPositions[i - 1]  = boundary;
+                continue;
+            }
+
+            // Window of the boundary
+            //
+            // Partitions that were not empty will not become empty: the
+            // boundary stays after the midpoint of the previous partition
+            // and not after the midpoint of the next one.
+            uint64_t lowest  = (boundaries[i - 1] + boundary) / 2 + 1;
+            uint64_t highest = (boundary + boundaries[i + 1]) / 2;
+            if (highest < globalOffset || lowest >= globalEnd) {
+                continue;
+            }
+
+            auto evalCandidate = [&](uint64_t position, double shift) {
+                if (position < globalOffset || position >= globalEnd) {
+                    return;
+                }
+
+                int alignment = evalAlignment(static_cast<uint32_t>(position - globalOffset));
+                int k = i - 1;
+                if (alignment > bestAlignments[k]) {
+                    return;
+                } else if (alignment == bestAlignments[k]) {
+                    if (shift > bestShifts[k]) {
+                        return;
+                    } else if (shift == bestShifts[k] && position > bestPositions[k]) {
+                        return;
+                    }
+                }
+
+                bestAlignments[k] = alignment;
+                bestShifts[k]     = shift;
+                bestPositions[k]  = position;
+            };
+
+            evalCandidate(boundary, 0.);
+
+            double shift = 0.;
+            for (uint64_t position = boundary; position > lowest; --position) {
+                shift += (globalWeights ? globalWeights[position - 1] : 1.);
+                if (shift > maxWeightShift || position - 1 < globalOffset) {
                     break;
                 }
+                evalCandidate(position - 1, shift);
             }
 
-            if (nAssigendOctants == m_globalNumOctants) {
+            shift = 0.;
+            for (uint64_t position = boundary + 1; position <= highest; ++position) {
+                shift += (globalWeights ? globalWeights[position - 1] : 1.);
+                if (shift > maxWeightShift || position >= globalEnd) {
                     break;
+                }
+                evalCandidate(position, shift);
             }
         }
-        partition[m_nproc-1] = static_cast<uint32_t>(m_globalNumOctants - nAssigendOctants);
-    };
+
+        // Select the best candidate among all the processes
+        if (!m_serial && nMovableBoundaries > 0) {
+            std::vector<int> globalAlignments(nMovableBoundaries);
+            MPI_Allreduce(bestAlignments.data(), globalAlignments.data(), nMovableBoundaries, MPI_INT, MPI_MIN, m_comm);
+            for (int k = 0; k < nMovableBoundaries; ++k) {
+                if (bestAlignments[k] != globalAlignments[k]) {
+                    bestShifts[k] = std::numeric_limits<double>::max();
+                }
+            }
+
+            std::vector<double> globalShifts(nMovableBoundaries);
+            MPI_Allreduce(bestShifts.data(), globalShifts.data(), nMovableBoundaries, MPI_DOUBLE, MPI_MIN, m_comm);
+            for (int k = 0; k < nMovableBoundaries; ++k) {
+                if (bestShifts[k] != globalShifts[k]) {
+                    bestPositions[k] = std::numeric_limits<uint64_t>::max();
+                }
+            }
+
+            MPI_Allreduce(MPI_IN_PLACE, bestPositions.data(), nMovableBoundaries, MPI_UINT64_T, MPI_MIN, m_comm);
+        }
+
+        // Update the partition
+        uint64_t previousBoundary = 0;
+        for (int i = 0; i < m_nproc; ++i) {
+            uint64_t boundary = (i < nMovableBoundaries) ? bestPositions[i] : m_globalNumOctants;
+            uint64_t partitionSize = boundary - previousBoundary;
+            if (partitionSize > std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error("The number of octants of a partition exceeds the maximum number of octants per process");
+            }
+
+            partition[i] = static_cast<uint32_t>(partitionSize);
+            previousBoundary = boundary;
+        }
+    }
 
     /*! Compute the partition of the octree over the processes (only compute the information about
      * how distribute the mesh). This is a "compact families" method: the families of octants
@@ -4855,6 +6794,8 @@ namespace bitpit {
         //
         // TODO: provide an estimate of the border octants in order to reserve
         // the vectors that will contain them.
+        clearGhostCommunicator();
+
         m_bordersPerProc.clear();
         m_internals.resize(getNumOctants());
         m_pborders.resize(getNumOctants());
@@ -5006,6 +6947,8 @@ namespace bitpit {
      */
     void
     ParaTree::computeGhostHalo(){
+        PerformanceTimer timer(this, PHASE_GHOST_HALO, getNumOctants());
+
         // Build first layer of ghosts
         setPboundGhosts();
 
@@ -5414,6 +7357,7 @@ namespace bitpit {
 
         // Wait until all exchanges are completed
         dataCommunicator->waitAllSends();
+        countPerformanceCommunication(PHASE_GHOST_HALO, dataCommunicator);
     }
 
     /*! Build ghost octants.
@@ -5542,62 +7486,110 @@ namespace bitpit {
 
         // Wait for the communications to complete
         ghostDataCommunicator.waitAllSends();
+        countPerformanceCommunication(PHASE_GHOST_HALO, &ghostDataCommunicator);
+    }
+
+    /*! Setup a communicator for exchanging fixed-size data between the border
+     * octants and the ghosts.
+     *
+     * The size of the exchanged data only depends on the ghost halo, hence it
+     * is known in advance on both sides of the communication: the octants sent
+     * to a process are the ones listed in the borders of that process, whereas
+     * the ghosts received from a process are the ones owned by that process.
+     * The same communicator can be used for all the exchanges performed until
+     * the ghost halo changes, without the need of discovering the receives.
+     * \param[in,out] communicator is the communicator that will be set up
+     * \param[in] entrySize is the size, expressed in bytes, of the data associated
+     * with a single octant
+     * \param[in] headerSize is the size, expressed in bytes, of the additional data
+     * that will be exchanged with every process
+     */
+    void
+    ParaTree::setupFixedSizeGhostExchange(DataCommunicator *communicator, std::size_t entrySize, std::size_t headerSize) const {
+        // Clear previous exchanges
+        communicator->clearAllSends();
+        communicator->clearAllRecvs();
+
+        // Set sends
+        for(const auto &bordersPerProcEntry : m_bordersPerProc){
+            int rank = bordersPerProcEntry.first;
+            const std::size_t nRankBorders = bordersPerProcEntry.second.size();
+
+            std::size_t buffSize = headerSize + nRankBorders * entrySize;
+            communicator->setSend(rank, buffSize);
+        }
+
+        // Set receives
+        //
+        // Ghosts are sorted by Morton, hence the ghosts owned by the same process
+        // are contiguous and the blocks are sorted by rank.
+        uint32_t nGhosts = m_octree.getNumGhosts();
+        uint32_t ghostIdx = 0;
+        while (ghostIdx < nGhosts) {
+            int rank = getOwnerRank(m_octree.m_globalIdxGhosts[ghostIdx]);
+
+            std::size_t nRankGhosts = 0;
+            while (ghostIdx < nGhosts && getOwnerRank(m_octree.m_globalIdxGhosts[ghostIdx]) == rank) {
+                ++nRankGhosts;
+                ++ghostIdx;
+            }
+
+            std::size_t buffSize = headerSize + nRankGhosts * entrySize;
+            communicator->setRecv(rank, buffSize);
+        }
     }
 
     /*! Communicate the marker of the octants.
+     * \param[in,out] markerCommunicator is the communicator that will be used for
+     * exchanging the markers, it should have been set up using setupFixedSizeGhostExchange
+     * \param[out] updatedGhosts if a valid pointer is provided, the indexes of the
+     * ghosts whose markers have been updated will be added to the specified list
      * \return True if markers of the current process have been updated (this is a local
      * information).
      */
     bool
-    ParaTree::commMarker() {
+    ParaTree::commMarker(DataCommunicator *markerCommunicator, u32vector *updatedGhosts) {
         // If the tree is not partitioned, there is nothing to communicate.
         if (m_serial) {
             return false;
         }
 
-        // Binary size of a marker entry in the communication buffer
-        const std::size_t MARKER_ENTRY_BINARY_SIZE = sizeof(Octant::m_marker);
+        // Start the receives
+        markerCommunicator->startAllRecvs();
 
         // Fill communication buffer with level and marker
         //
         // It visits every element in m_bordersPerProc (one for every neighbor proc)
         // for every element it visits the border octants it contains and write them in the bitpit communication structure, DataCommunicator
         // this structure has a buffer for every proc containing the octants to be sent to that proc written in a char* buffer
-        DataCommunicator markerCommunicator(m_comm);
-
         for(const auto &bordersPerProcEntry : m_bordersPerProc){
             int rank = bordersPerProcEntry.first;
-            const std::vector<uint32_t> &rankBordersPerProc = m_bordersPerProc.at(rank);
+            const std::vector<uint32_t> &rankBordersPerProc = bordersPerProcEntry.second;
             const std::size_t nRankBorders = rankBordersPerProc.size();
 
-            std::size_t buffSize = nRankBorders * MARKER_ENTRY_BINARY_SIZE;
-            markerCommunicator.setSend(rank, buffSize);
-
-            SendBuffer &sendBuffer = markerCommunicator.getSendBuffer(rank);
+            SendBuffer &sendBuffer = markerCommunicator->getSendBuffer(rank);
             for(std::size_t i = 0; i < nRankBorders; ++i){
                 const Octant &octant = m_octree.m_octants[rankBordersPerProc[i]];
                 sendBuffer << octant.getMarker();
             }
         }
 
-        markerCommunicator.discoverRecvs();
-        markerCommunicator.startAllRecvs();
-        markerCommunicator.startAllSends();
+        markerCommunicator->startAllSends();
 
         // Read level and marker from communication buffer
         //
         // every receive buffer is visited, and read octant by octant.
         // every ghost octant level and marker are updated
-        std::vector<int> recvRanks = markerCommunicator.getRecvRanks();
+        std::vector<int> recvRanks = markerCommunicator->getRecvRanks();
         std::sort(recvRanks.begin(), recvRanks.end());
 
         bool updated = false;
         uint32_t ghostIdx = 0;
         for(int rank : recvRanks){
-            markerCommunicator.waitRecv(rank);
-            RecvBuffer &recvBuffer = markerCommunicator.getRecvBuffer(rank);
+            markerCommunicator->waitRecv(rank);
+            RecvBuffer &recvBuffer = markerCommunicator->getRecvBuffer(rank);
 
-            const std::size_t nRankGhosts = recvBuffer.getSize() / MARKER_ENTRY_BINARY_SIZE;
+            const std::size_t nRankGhosts = recvBuffer.getSize() / sizeof(Octant::m_marker);
             for(std::size_t i = 0; i < nRankGhosts; ++i){
                 int8_t marker;
                 recvBuffer >> marker;
@@ -5605,6 +7597,9 @@ namespace bitpit {
                 Octant &octant = m_octree.m_ghosts[ghostIdx];
                 if (octant.getMarker() != marker) {
                     octant.setMarker(marker);
+                    if (updatedGhosts) {
+                        updatedGhosts->push_back(ghostIdx);
+                    }
                     updated = true;
                 }
 
@@ -5612,10 +7607,85 @@ namespace bitpit {
             }
         }
 
-        markerCommunicator.waitAllSends();
+        markerCommunicator->waitAllSends();
+        countPerformanceCommunication(PHASE_BALANCE, markerCommunicator);
 
         return updated;
     }
+
+    /*! Get the communicator used for exchanging user data between the border
+     * octants and the ghosts.
+     *
+     * The communicator is created the first time it is requested and it is
+     * kept until the communicator of the tree is freed. When the ghost halo
+     * changes, the communicator is cleared, but not destroyed.
+     * \return The communicator used for exchanging user data with the ghosts.
+     */
+    DataCommunicator *
+    ParaTree::getGhostCommunicator() {
+        if (!m_ghostCommunicator) {
+            m_ghostCommunicator = std::unique_ptr<DataCommunicator>(new DataCommunicator(m_comm));
+        }
+
+        return m_ghostCommunicator.get();
+    }
+
+    /*! Setup the ghost communicator for exchanging fixed-size user data.
+     *
+     * Along with the data of the octants, the number of octants is exchanged
+     * with every process. If the communicator is already set up for the
+     * specified entry size, its buffers will be reused.
+     * \param[in] entrySize is the size, expressed in bytes, of the data
+     * associated with a single octant
+     */
+    void
+    ParaTree::setupGhostCommunicator(std::size_t entrySize) {
+        if (entrySize == m_ghostCommunicatorEntrySize) {
+            return;
+        }
+
+        setupFixedSizeGhostExchange(getGhostCommunicator(), entrySize, sizeof(std::size_t));
+        m_ghostCommunicatorEntrySize = entrySize;
+    }
+
+    /*! Clear the sends and the receives of the ghost communicator.
+     *
+     * The communicator itself is not destroyed, therefore this function
+     * doesn't involve any communication.
+     */
+    void
+    ParaTree::clearGhostCommunicator() {
+        m_ghostCommunicatorEntrySize = 0;
+
+        if (m_ghostCommunicator) {
+            m_ghostCommunicator->clearAllSends();
+            m_ghostCommunicator->clearAllRecvs();
+        }
+    }
+
+    /*! Add the point-to-point traffic of a completed exchange to the
+     * performance counters of the specified phase.
+     *
+     * The function should be called after all the sends and receives of
+     * the communicator have been completed.
+     * \param[in] phase Phase the exchange belongs to
+     * \param[in] communicator Communicator used for the exchange
+     */
+    void
+    ParaTree::countPerformanceCommunication(PerformancePhase phase, DataCommunicator *communicator) {
+        if (!m_performanceCountersEnabled) {
+            return;
+        }
+
+        PerformanceCounters &counters = m_performanceCounters[phase];
+        for (int rank : communicator->getSendRanks()) {
+            counters.nSentBytes += communicator->getSendBuffer(rank).getSize();
+        }
+        for (int rank : communicator->getRecvRanks()) {
+            counters.nReceivedBytes += communicator->getRecvBuffer(rank).getSize();
+        }
+        ++counters.nRounds;
+    }
 #endif
 
     /*! Update the distributed octree over the processes after a coarsening procedure
@@ -5643,6 +7713,8 @@ namespace bitpit {
     void
     ParaTree::balance21(bool verbose, bool balanceNewOctants){
 
+        PerformanceTimer timer(this, PHASE_BALANCE, getNumOctants());
+
         // Print header
         if (verbose){
             (*m_log) << "---------------------------------------------" << endl;
@@ -5652,48 +7724,51 @@ namespace bitpit {
             (*m_log) << " " << endl;
         }
 
-        bool initialStep = true;
-        while (true) {
+        // Balance 2:1 the tree
+        //
+        // Balancing is performed iteratively: the markers of the ghosts are updated, the
+        // local tree is balanced and, if some markers have been modified by any process,
+        // a new iteration is performed. The first balance step checks all the internal
+        // octants and all the ghosts of the first layer. Starting from the second step,
+        // we only need to propagate marker information across the processes, hence only
+        // the ghosts whose markers have been updated by the last exchange are checked.
 #if BITPIT_ENABLE_MPI==1
-            // Exchange markers across processes
-            if (!m_serial) {
-                bool markersUpdated = commMarker();
-                if (!initialStep) {
-                    MPI_Allreduce(MPI_IN_PLACE, &markersUpdated, 1, MPI_C_BOOL, MPI_LOR, m_comm);
-                    if (!markersUpdated) {
-                        break;
-                    }
-                }
-            }
+        // Setup the communicator for exchanging markers
+        //
+        // The ghost halo doesn't change during balancing, hence the same communicator
+        // can be used for all the iterations.
+        std::unique_ptr<DataCommunicator> markerCommunicator;
+        if (!m_serial) {
+            markerCommunicator = std::unique_ptr<DataCommunicator>(new DataCommunicator(m_comm));
+            setupFixedSizeGhostExchange(markerCommunicator.get(), sizeof(Octant::m_marker));
+
+            commMarker(markerCommunicator.get());
+        }
 #endif
 
-            // Balance 2:1 the tree
-            //
-            // After the first step only ghost octants are checked for balance, that's because
-            // starting from the second step we only need to propagate marker information across
-            // the processes.
-            bool checkInterior = initialStep;
-            bool checkGhosts   = true;
+        bool balanceUpdated = m_octree.localBalance(balanceNewOctants, true, true);
 
-            bool balanceUpdated = m_octree.localBalance(balanceNewOctants, checkInterior, checkGhosts);
 #if BITPIT_ENABLE_MPI==1
-            if (!m_serial) {
+        if (!m_serial) {
+            u32vector updatedGhosts;
+            while (true) {
+                // Check if markers have been modified by some process
                 MPI_Allreduce(MPI_IN_PLACE, &balanceUpdated, 1, MPI_C_BOOL, MPI_LOR, m_comm);
                 if (!balanceUpdated) {
                     break;
                 }
-            } else {
-                break;
-            }
-#else
-            BITPIT_UNUSED(balanceUpdated);
-            break;
-#endif
 
-            // This is not anymore the first balance step
-            initialStep = false;
+                // Exchange markers across processes
+                updatedGhosts.clear();
+                commMarker(markerCommunicator.get(), &updatedGhosts);
 
+                // Balance the octants affected by the updated ghosts
+                balanceUpdated = m_octree.localBalance(balanceNewOctants, false, true, &updatedGhosts);
+            }
         }
+#else
+        BITPIT_UNUSED(balanceUpdated);
+#endif
 
         // Print footer
         if (verbose){
@@ -5771,7 +7846,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_connectivity[i][jj] << " ";
+                        out << m_octree.m_connectivity.getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
@@ -5792,7 +7867,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_ghostsConnectivity[i][jj] << " ";
+                        out << m_octree.m_ghostsConnectivity.getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofGhosts-1)
                     out << endl << "          ";
@@ -5937,7 +8012,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_connectivity[i][jj] << " ";
+                        out << m_octree.m_connectivity.getItem(i, jj) << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
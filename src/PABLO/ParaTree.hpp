@@ -62,6 +62,7 @@
 #include <mpi.h>
 #include "DataLBInterface.hpp"
 #include "DataCommInterface.hpp"
+#include "DataLBFields.hpp"
 #include "bitpit_communications.hpp"
 #endif
 #include "tree_constants.hpp"
@@ -73,6 +74,10 @@
 #include <set>
 #include <bitset>
 #include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <chrono>
+#include <array>
 
 #include "bitpit_common.hpp"
 
@@ -151,7 +156,55 @@ namespace bitpit {
             void clear();
         };
 
+        /*!
+         * Phases of the tree operations tracked by the performance counters.
+         */
+        enum PerformancePhase {
+            PHASE_REFINE = 0,       /**<Refinement of the marked octants*/
+            PHASE_COARSEN,          /**<Coarsening of the marked families*/
+            PHASE_BALANCE,          /**<2:1 balance of the markers*/
+            PHASE_GHOST_HALO,       /**<Construction of the ghost halo*/
+            PHASE_CONNECTIVITY,     /**<Computation of nodes connectivity and neighbour graph*/
+            PHASE_LOAD_BALANCE,     /**<Redistribution of the octants among the processes*/
+            PHASE_COMMUNICATE,      /**<Exchange of user data between border octants and ghosts*/
+            PHASE_COUNT             /**<Number of phases*/
+        };
+
+        /*!
+         * Cumulative performance counters of a phase.
+         */
+        struct PerformanceCounters {
+            double   time;              /**<Cumulative wall time spent in the phase, in seconds*/
+            uint64_t nCalls;            /**<Number of times the phase has been executed*/
+            uint64_t nOctants;          /**<Number of local octants processed by the phase*/
+            uint64_t nSentBytes;        /**<Bytes sent to other processes*/
+            uint64_t nReceivedBytes;    /**<Bytes received from other processes*/
+            uint64_t nRounds;           /**<Number of point-to-point communication rounds*/
+
+            PerformanceCounters();
+
+            void clear();
+        };
+
     private:
+        /*!
+         * Scoped timer that accumulates the time spent in a phase into the
+         * performance counters of the tree, it does nothing if the counters
+         * are disabled.
+         */
+        class PerformanceTimer {
+        public:
+            PerformanceTimer(ParaTree *tree, PerformancePhase phase, uint64_t nOctants = 0, bool newCall = true);
+            ~PerformanceTimer();
+
+            PerformanceTimer(const PerformanceTimer &other) = delete;
+            PerformanceTimer & operator=(const PerformanceTimer &other) = delete;
+
+        private:
+            PerformanceCounters *m_counters;
+            std::chrono::steady_clock::time_point m_start;
+        };
+
         typedef std::unordered_map<int, std::array<uint64_t, 2>> PartitionIntersections;
 
         struct AccretionData {
@@ -161,6 +214,11 @@ namespace bitpit {
             std::unordered_map<uint64_t, int> population;
         };
 
+#if BITPIT_ENABLE_MPI==1
+        static const std::size_t CHECKPOINT_PREAMBLE_SIZE = sizeof(int) + sizeof(uint64_t);	/**<Size of the checkpoint preamble (version and header size)*/
+        static const std::size_t CHECKPOINT_RECORD_SIZE   = sizeof(uint64_t) + sizeof(uint16_t) + 2 * sizeof(uint8_t); /**<Size of the checkpoint record of an octant (Morton, info, level and marker)*/
+#endif
+
         //undistributed members
         std::vector<uint64_t>	m_partitionFirstDesc; 			/**<Global array containing position of the first possible octant in each process*/
         std::vector<uint64_t>	m_partitionLastDesc; 			/**<Global array containing position of the last possible octant in each process*/
@@ -171,6 +229,11 @@ namespace bitpit {
         int8_t 					m_maxDepth;						/**<Global max existing level in the parallel octree*/
         const TreeConstants	   *m_treeConstants;				/**<Tree constants*/
         std::size_t 			m_nofGhostLayers;				/**<Global number of ghost layers from the process boundary expressing the depth of the ghost halo*/
+        double 					m_partitionTolerance;			/**<Tolerance on the weight of the partition boundaries used for reducing the fragmentation of the partitions*/
+        bool 					m_octantCompression;			/**<Controls if octants are serialized using their compact binary representation*/
+        bool 					m_nodeAwarePartitioning;		/**<Controls if the partitioning is evaluated first among the nodes and then among the processes of each node*/
+        double 					m_nodePartitionTolerance;		/**<Maximum relative imbalance of the weight of a node before its boundaries are moved*/
+        std::vector<int>		m_partitionNodeOffsets;			/**<Rank of the first process of each node (the last entry is the number of processes)*/
 
         //distributed members
         int 					m_rank;							/**<Local m_rank of process*/
@@ -200,6 +263,14 @@ namespace bitpit {
         //boundary conditions members
         bvector 				m_periodic;						/**<Boolvector: i-th element is true if the i-th boundary face is a periodic interface.*/
 
+        //brick members
+        u32array3				m_brickSize;					/**<Number of root octants of the brick along each direction (a single root octant if the tree is not a brick).*/
+        uint8_t					m_brickLevel;					/**<Level of the root octants of the brick.*/
+
+        //performance members
+        bool					m_performanceCountersEnabled;	/**<Controls if the performance counters are updated*/
+        std::array<PerformanceCounters, PHASE_COUNT> m_performanceCounters;	/**<Performance counters of each phase*/
+
         //info member
         uint64_t				m_status;						/**<Label of actual m_status of octree (incremental after an adpat
                                                                    with at least one modifyed element).*/
@@ -212,6 +283,8 @@ namespace bitpit {
 #if BITPIT_ENABLE_MPI==1
         //TODO Duplicate communicator
         MPI_Comm 				m_comm;							/**<MPI communicator*/
+        std::unique_ptr<DataCommunicator> m_ghostCommunicator;	/**<Communicator used for exchanging user data between border octants and ghosts*/
+        std::size_t				m_ghostCommunicatorEntrySize;	/**<Entry size the ghost communicator has been set up for (zero if it is not set up for fixed-size data)*/
 #endif
 
         // =================================================================================== //
@@ -244,6 +317,12 @@ namespace bitpit {
         virtual void	dump(std::ostream &stream, bool full = true);
         virtual void	restore(std::istream &stream);
 
+#if BITPIT_ENABLE_MPI==1
+        int		getCheckpointVersion() const;
+        void	checkpoint(const std::string &filename);
+        void	restart(const std::string &filename);
+#endif
+
         void	printHeader();
 
         // =================================================================================== //
@@ -298,6 +377,8 @@ namespace bitpit {
         bool		getPeriodic(uint8_t i) const;
         void		setPeriodic(uint8_t i);
         void		setTol(double tol = 1.0e-14);
+        const u32array3 & getBrickSize() const;
+        uint8_t		getBrickLevel() const;
 
         // =================================================================================== //
         // INDEX BASED METHODS																   //
@@ -405,6 +486,8 @@ namespace bitpit {
         // =================================================================================== //
         uint32_t 	getNumIntersections() const;
         Intersection* getIntersection(uint32_t idx);
+        IntersectionIterator getIntersectionsBegin(int chunk = 0, int nChunks = 1) const;
+        IntersectionIterator getIntersectionsEnd(int chunk = 0, int nChunks = 1) const;
         uint8_t 	getLevel(const Intersection* inter) const;
         bool 		getFiner(const Intersection* inter) const;
         bool 		getBound(const Intersection* inter) const;
@@ -433,6 +516,15 @@ namespace bitpit {
         const LoadBalanceRanges & getLoadBalanceRanges() const;
         std::size_t getNofGhostLayers() const;
         void setNofGhostLayers(std::size_t nofGhostLayers);
+        double getPartitionTolerance() const;
+        void setPartitionTolerance(double tolerance);
+        bool getOctantCompression() const;
+        void setOctantCompression(bool enable);
+        void enablePerformanceCounters(bool enable = true);
+        bool arePerformanceCountersEnabled() const;
+        const PerformanceCounters & getPerformanceCounters(PerformancePhase phase) const;
+        void resetPerformanceCounters();
+        void reducePerformanceCounters(PerformancePhase phase, PerformanceCounters *minCounters, PerformanceCounters *maxCounters, PerformanceCounters *avgCounters) const;
         const std::map<int, std::vector<uint32_t>> & getBordersPerProc() const;
 
         // =================================================================================== //
@@ -440,6 +532,7 @@ namespace bitpit {
         // =================================================================================== //
     private:
         void		setDim(uint8_t dim);
+        int		getCompactDumpVersion() const;
 #if BITPIT_ENABLE_MPI==1
         void 		updateGlobalFirstDescMorton();
         void 		updateGlobalLasttDescMorton();
@@ -469,7 +562,11 @@ namespace bitpit {
 
         void	reset(bool createRoot);
 
+        void	initializeUniformPartitionRanges(uint64_t nGlobalOctants);
+        void	initializePartitionedOctants();
+
         uint64_t	evalPointAnchorMorton(const double * point) const;
+        void		evalPointsAnchorMorton(std::size_t nPoints, const darray3 *points, uint64_t *mortons, int *ownerRanks) const;
 
         // =================================================================================== //
         // OTHER OCTANT BASED METHODS												    	   //
@@ -506,6 +603,12 @@ namespace bitpit {
         bool 		isEdgeOnOctant(const Octant* edgeOctant, uint8_t edgeIndex, const Octant* octant) const;
         bool 		isFaceOnOctant(const Octant* faceOctant, uint8_t faceIndex, const Octant* octant) const;
         int 		getPointOwnerRank(const darray3 &point);
+        void 		getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, uint32_t *ownerIdx) const;
+        u32vector 	getPointsOwnerIdx(const std::vector<darray3> &points) const;
+        void 		getPointsOwnerRank(std::size_t nPoints, const darray3 *points, int *ownerRanks) const;
+#if BITPIT_ENABLE_MPI==1
+        void 		locatePoints(std::size_t nPoints, const darray3 *points, int *ownerRanks, uint32_t *ownerIdx);
+#endif
         uint8_t		getFamilySplittingNode(const Octant*) const;
         void		expectedOctantAdapt(const Octant* octant, int8_t marker, octvector* result) const;
 
@@ -521,22 +624,39 @@ namespace bitpit {
         bool        adapt(bool mapper_flag = false);
         bool 		adaptGlobalRefine(bool mapper_flag = false);
         bool 		adaptGlobalCoarse(bool mapper_flag = false);
+        void 		buildUniform(uint8_t level);
+        void 		buildBrick(const u32array3 &size, uint8_t level = 0);
         void 		computeConnectivity();
         void 		clearConnectivity(bool release = true);
         void 		updateConnectivity();
-        const u32vector2D & getConnectivity() const;
-        const u32vector & getConnectivity(uint32_t idx) const;
-        const u32vector & getConnectivity(Octant* oct) const;
+        const FlatVector2D<uint32_t> & getConnectivity() const;
+        ConstProxyVector<uint32_t> getConnectivity(uint32_t idx) const;
+        ConstProxyVector<uint32_t> getConnectivity(Octant* oct) const;
+        const FlatVector2D<uint32_t> & getConnectivityFlat() const;
         const u32arr3vector & getNodes() const;
         const u32array3 & getNodeLogicalCoordinates(uint32_t node) const;
         darray3 	getNodeCoordinates(uint32_t node) const;
-        const u32vector2D & getGhostConnectivity() const;
-        const u32vector & getGhostConnectivity(uint32_t idx) const;
-        const u32vector & getGhostConnectivity(const Octant* oct) const;
+        const FlatVector2D<uint32_t> & getGhostConnectivity() const;
+        ConstProxyVector<uint32_t> getGhostConnectivity(uint32_t idx) const;
+        ConstProxyVector<uint32_t> getGhostConnectivity(const Octant* oct) const;
+        const FlatVector2D<uint32_t> & getGhostConnectivityFlat() const;
+        void 		computeNeighbourGraph(uint8_t maxCodim = 1);
+        void 		clearNeighbourGraph(bool release = true);
+        uint8_t 	getNeighbourGraphCodimension() const;
+        ConstProxyVector<uint32_t> getGraphNeighbours(uint32_t idx, uint8_t entityIdx, uint8_t entityCodim) const;
+        void 		getGraphNeighbours(uint32_t idx, uint8_t entityIdx, uint8_t entityCodim, u32vector & neighbours, bvector & isghost) const;
         bool        check21Balance();
 #if BITPIT_ENABLE_MPI==1
         void 		loadBalance(const dvector* weight = NULL);
         void 		loadBalance(uint8_t & level, const dvector* weight = NULL);
+        void 		loadBalance(DataLBFields & fields, const dvector* weight = NULL);
+        void 		loadBalance(DataLBFields & fields, uint8_t & level, const dvector* weight = NULL);
+
+        void 		enableNodeAwarePartitioning(bool enable = true, MPI_Comm nodeComm = MPI_COMM_NULL);
+        bool 		isNodeAwarePartitioningEnabled() const;
+        int 		getPartitionNodeCount() const;
+        double 		getNodePartitionTolerance() const;
+        void 		setNodePartitionTolerance(double tolerance);
 
         LoadBalanceRanges evalLoadBalanceRanges(dvector *weights);
         LoadBalanceRanges evalLoadBalanceRanges(uint8_t level, dvector *weights);
@@ -563,10 +683,13 @@ namespace bitpit {
         Octant& extractOctant(uint32_t idx);
         bool 		private_adapt_mapidx(bool mapflag);
         void 		updateAdapt();
+        void 		updateNeighbourGraph(bool mapped);
 #if BITPIT_ENABLE_MPI==1
         void 		computePartition(uint32_t *partition);
         void 		computePartition(const dvector *weight, uint32_t *partition);
         void 		computePartition(uint8_t level_, const dvector *weight, uint32_t *partition);
+        void 		computeNodeAwarePartition(const dvector *weight, uint32_t *partition);
+        void 		compactPartition(const double *globalWeights, uint32_t *partition);
         void 		updateLoadBalance();
         void 		setPboundGhosts();
         void 		buildGhostOctants(const std::map<int, u32vector> &bordersPerProc, const std::vector<AccretionData> &accretions);
@@ -575,7 +698,12 @@ namespace bitpit {
         void 		exchangeGhostHaloAccretions(DataCommunicator *dataCommunicator, std::vector<AccretionData> *accretions);
 
         void 		computeGhostHalo();
-        bool 		commMarker();
+        void 		setupFixedSizeGhostExchange(DataCommunicator *communicator, std::size_t entrySize, std::size_t headerSize = 0) const;
+        bool 		commMarker(DataCommunicator *markerCommunicator, u32vector *updatedGhosts = nullptr);
+        DataCommunicator * getGhostCommunicator();
+        void 		setupGhostCommunicator(std::size_t entrySize);
+        void 		clearGhostCommunicator();
+        void 		countPerformanceCommunication(PerformancePhase phase, DataCommunicator *communicator);
 #endif
         void 		updateAfterCoarse();
         void 		balance21(bool verbose, bool balanceNewOctants);
@@ -596,54 +724,97 @@ namespace bitpit {
 #if BITPIT_ENABLE_MPI==1
 
         /** Communicate data provided by the user between the processes.
+         * \param[in] userData User interface to communicate the data.
          */
         template<class Impl>
         void
         communicate(DataCommInterface<Impl> & userData){
-            //BUILD SEND BUFFERS
-            DataCommunicator communicator(m_comm);
+            communicateBegin(userData);
+            communicateEnd(userData);
+        }
+
+        /** Start the communication of the data provided by the user between the
+         * processes.
+         *
+         * Receives and sends are posted and the function returns without waiting
+         * for the communication to complete, this allows to overlap the exchange
+         * of ghost data with computations that don't involve the ghosts. Data of
+         * the border octants are gathered by this function, data of the ghost
+         * octants will be scattered by communicateEnd. Only one communication
+         * can be active at a time.
+         *
+         * If the user data has a fixed size, the communication buffers are kept
+         * and reused by subsequent communications until the ghost halo changes.
+         * \param[in] userData User interface to communicate the data.
+         */
+        template<class Impl>
+        void
+        communicateBegin(DataCommInterface<Impl> & userData){
+            PerformanceTimer timer(this, PHASE_COMMUNICATE, getNumOctants());
+
+            DataCommunicator *communicator = getGhostCommunicator();
+
+            //SET UP THE COMMUNICATOR
             size_t fixedDataSize = userData.fixedSize();
-            std::map<int,u32vector >::iterator bitend = m_bordersPerProc.end();
-            std::map<int,u32vector >::iterator bitbegin = m_bordersPerProc.begin();
-            for(std::map<int,u32vector >::iterator bit = bitbegin; bit != bitend; ++bit){
-                int  key = bit->first;
-                const u32vector & pborders = bit->second;
-                size_t buffSize = 0;
-                size_t nofPbordersPerProc = pborders.size();
-                if(fixedDataSize != 0){
-                    buffSize = fixedDataSize*nofPbordersPerProc;
-                }
-                else{
+            if(fixedDataSize != 0){
+                setupGhostCommunicator(fixedDataSize);
+            }
+            else{
+                clearGhostCommunicator();
+                for(const auto &bordersPerProcEntry : m_bordersPerProc){
+                    int  key = bordersPerProcEntry.first;
+                    const u32vector & pborders = bordersPerProcEntry.second;
+                    size_t buffSize = 0;
+                    size_t nofPbordersPerProc = pborders.size();
                     for(size_t i = 0; i < nofPbordersPerProc; ++i){
                         buffSize += userData.size(pborders[i]);
                     }
+                    //enlarge buffer to store number of pborders from this proc
+                    buffSize += sizeof(size_t);
+                    //build buffer for this proc
+                    communicator->setSend(key,buffSize);
                 }
-                //enlarge buffer to store number of pborders from this proc
-                buffSize += sizeof(size_t);
-                //build buffer for this proc
-                communicator.setSend(key,buffSize);
-                SendBuffer & sendBuffer = communicator.getSendBuffer(key);
+
+                communicator->discoverRecvs();
+            }
+
+            communicator->startAllRecvs();
+
+            //WRITE SEND BUFFERS
+            for(const auto &bordersPerProcEntry : m_bordersPerProc){
+                int  key = bordersPerProcEntry.first;
+                const u32vector & pborders = bordersPerProcEntry.second;
+                size_t nofPbordersPerProc = pborders.size();
+                SendBuffer & sendBuffer = communicator->getSendBuffer(key);
                 //store number of pborders from this proc at the begining
                 sendBuffer << nofPbordersPerProc;
-
-                //WRITE SEND BUFFERS
                 for(size_t j = 0; j < nofPbordersPerProc; ++j){
                     userData.gather(sendBuffer,pborders[j]);
                 }
             }
 
-            communicator.discoverRecvs();
-            communicator.startAllRecvs();
+            communicator->startAllSends();
+        }
 
-            communicator.startAllSends();
+        /** Complete the communication of the data provided by the user between
+         * the processes started with communicateBegin.
+         * \param[in] userData User interface to communicate the data, it should
+         * be the same interface passed to communicateBegin.
+         */
+        template<class Impl>
+        void
+        communicateEnd(DataCommInterface<Impl> & userData){
+            PerformanceTimer timer(this, PHASE_COMMUNICATE, 0, false);
+
+            DataCommunicator *communicator = getGhostCommunicator();
 
             //READ RECEIVE BUFFERS
             int ghostOffset = 0;
-            std::vector<int> recvRanks = communicator.getRecvRanks();
+            std::vector<int> recvRanks = communicator->getRecvRanks();
             std::sort(recvRanks.begin(),recvRanks.end());
             for(int rank : recvRanks){
-                communicator.waitRecv(rank);
-                RecvBuffer & recvBuffer = communicator.getRecvBuffer(rank);
+                communicator->waitRecv(rank);
+                RecvBuffer & recvBuffer = communicator->getRecvBuffer(rank);
                 size_t nofGhostFromThisProc = 0;
                 recvBuffer >> nofGhostFromThisProc;
                 for(size_t k = 0; k < nofGhostFromThisProc; ++k){
@@ -651,7 +822,100 @@ namespace bitpit {
                 }
                 ghostOffset += nofGhostFromThisProc;
             }
-            communicator.waitAllSends();
+            communicator->waitAllSends();
+            countPerformanceCommunication(PHASE_COMMUNICATE, communicator);
+        }
+
+        /** Communicate fixed-size data stored in contiguous arrays between the
+         * processes.
+         * \param[in] data Data of the internal octants, the data of the i-th octant
+         * are stored starting from position i*nComponents.
+         * \param[out] ghostData Data of the ghost octants, the data of the i-th ghost
+         * will be stored starting from position i*nComponents.
+         * \param[in] nComponents Number of components associated with each octant.
+         */
+        template<typename T>
+        void
+        communicate(const T *data, T *ghostData, std::size_t nComponents = 1){
+            communicateBegin(data, nComponents);
+            communicateEnd(ghostData, nComponents);
+        }
+
+        /** Start the communication of fixed-size data stored in contiguous arrays
+         * between the processes.
+         *
+         * This is a fast path for data that can be copied bitwise: data of the
+         * border octants are copied directly from the array, without calling a
+         * gather function for each octant, and data of the ghosts received from
+         * a process are copied into the ghost array with a single copy. Buffers
+         * are reused by subsequent communications until the ghost halo changes.
+         * Only one communication can be active at a time.
+         * \param[in] data Data of the internal octants, the data of the i-th octant
+         * are stored starting from position i*nComponents.
+         * \param[in] nComponents Number of components associated with each octant.
+         */
+        template<typename T>
+        void
+        communicateBegin(const T *data, std::size_t nComponents = 1){
+            static_assert(std::is_trivially_copyable<T>::value, "Communicated data should be trivially copyable");
+
+            PerformanceTimer timer(this, PHASE_COMMUNICATE, getNumOctants());
+
+            const std::size_t entrySize = nComponents * sizeof(T);
+            setupGhostCommunicator(entrySize);
+
+            DataCommunicator *communicator = getGhostCommunicator();
+            communicator->startAllRecvs();
+
+            //WRITE SEND BUFFERS
+            for(const auto &bordersPerProcEntry : m_bordersPerProc){
+                int  key = bordersPerProcEntry.first;
+                const u32vector & pborders = bordersPerProcEntry.second;
+                size_t nofPbordersPerProc = pborders.size();
+                SendBuffer & sendBuffer = communicator->getSendBuffer(key);
+                sendBuffer << nofPbordersPerProc;
+                for(uint32_t idx : pborders){
+                    sendBuffer.write(reinterpret_cast<const char *>(data + idx * nComponents), entrySize);
+                }
+            }
+
+            communicator->startAllSends();
+        }
+
+        /** Complete the communication of fixed-size data stored in contiguous
+         * arrays started with communicateBegin.
+         * \param[out] ghostData Data of the ghost octants, the data of the i-th ghost
+         * will be stored starting from position i*nComponents.
+         * \param[in] nComponents Number of components associated with each octant,
+         * it should be the same number passed to communicateBegin.
+         */
+        template<typename T>
+        void
+        communicateEnd(T *ghostData, std::size_t nComponents = 1){
+            static_assert(std::is_trivially_copyable<T>::value, "Communicated data should be trivially copyable");
+
+            PerformanceTimer timer(this, PHASE_COMMUNICATE, 0, false);
+
+            const std::size_t entrySize = nComponents * sizeof(T);
+            DataCommunicator *communicator = getGhostCommunicator();
+
+            //READ RECEIVE BUFFERS
+            //
+            //ghosts received from a process are contiguous, hence they can be
+            //copied all together.
+            std::size_t ghostOffset = 0;
+            std::vector<int> recvRanks = communicator->getRecvRanks();
+            std::sort(recvRanks.begin(),recvRanks.end());
+            for(int rank : recvRanks){
+                communicator->waitRecv(rank);
+                RecvBuffer & recvBuffer = communicator->getRecvBuffer(rank);
+                size_t nofGhostFromThisProc = 0;
+                recvBuffer >> nofGhostFromThisProc;
+                recvBuffer.read(reinterpret_cast<char *>(ghostData + ghostOffset * nComponents), nofGhostFromThisProc * entrySize);
+                ghostOffset += nofGhostFromThisProc;
+            }
+            communicator->waitAllSends();
+            countPerformanceCommunication(PHASE_COMMUNICATE, communicator);
         }
 
         /** Distribute Load-Balancing the octants (with user defined weights) of the whole tree and data provided by the user
@@ -759,10 +1023,31 @@ namespace bitpit {
         * \param[in] partition Target distribution of octants over processes.
         * \param[in,out] userData User data that will be distributed among the
         * processes.
+        * \param[in,out] fields Fixed-size fields that will be distributed among
+        * the processes, the data of ranges of octants are copied with a single
+        * operation for each field.
         */
         template<class Impl>
         void
-        privateLoadBalance(const uint32_t *partition, DataLBInterface<Impl> *userData = nullptr){
+        privateLoadBalance(const uint32_t *partition, DataLBInterface<Impl> *userData = nullptr, DataLBFields *fields = nullptr){
+
+            PerformanceTimer timer(this, PHASE_LOAD_BALANCE, getNumOctants());
+
+            // Validate the sizes of the fixed-size fields
+            //
+            // Fields are copied in ranges without further checks, hence a
+            // field that doesn't hold exactly the data of the local octants
+            // would be accessed out of bounds. The check is collective, so
+            // that all the processes throw if a field of any process has
+            // a wrong size.
+            if (fields) {
+                int fieldsValid = fields->isSizeValid(getNumOctants()) ? 1 : 0;
+                MPI_Allreduce(MPI_IN_PLACE, &fieldsValid, 1, MPI_INT, MPI_MIN, m_comm);
+                if (!fieldsValid) {
+                    fields->validateSize(getNumOctants());
+                    throw std::runtime_error("Fixed-size fields of another process don't match the number of its octants.");
+                }
+            }
 
             (*m_log) << " " << std::endl;
             if (m_serial) {
@@ -812,6 +1097,10 @@ namespace bitpit {
                             userData->move(newFirstOctantGlobalIdx + i, i);
                         }
                     }
+
+                    if (fields) {
+                        fields->move(static_cast<uint32_t>(newFirstOctantGlobalIdx), 0, newSizeOctants);
+                    }
                 }
 
                 m_octree.m_octants.resize(newSizeOctants);
@@ -821,15 +1110,24 @@ namespace bitpit {
                     userData->resize(newSizeOctants);
                     userData->shrink();
                 }
+
+                if (fields) {
+                    fields->resize(newSizeOctants);
+                    fields->shrink();
+                }
             } else {
                 // Compute information about the current partitioning
                 uint64_t lastOctantGlobalIdx  = m_partitionRangeGlobalIdx[m_rank];
                 uint64_t firstOctantGlobalIdx = lastOctantGlobalIdx - m_octree.m_octants.size() + 1;
 
                 // Initialize communications
+                //
+                // When octants are compressed, the size of the received buffers
+                // is not known in advance and has to be discovered.
                 DataCommunicator lbCommunicator(m_comm);
 
-                if (!userData || userData->fixedSize()) {
+                bool discoverRecvs = m_octantCompression || (userData && !userData->fixedSize());
+                if (!discoverRecvs) {
                     for (const auto &entry : recvRanges) {
                         int rank = entry.first;
                         uint32_t beginRecvIdx = entry.second[0];
@@ -840,6 +1138,9 @@ namespace bitpit {
                         if (userData) {
                             buffSize += nOctantsToReceive * userData->fixedSize();
                         }
+                        if (fields) {
+                            buffSize += nOctantsToReceive * fields->getEntrySize();
+                        }
 
                         lbCommunicator.setRecv(rank, buffSize);
                         lbCommunicator.startRecv(rank);
@@ -852,7 +1153,18 @@ namespace bitpit {
                     uint32_t endSendIdx   = entry.second[1];
 
                     uint32_t nOctantsToSend = endSendIdx - beginSendIdx;
-                    std::size_t buffSize = nOctantsToSend * Octant::getBinarySize();
+                    std::size_t buffSize = 0;
+                    if (m_octantCompression) {
+                        uint64_t expectedMorton = 0;
+                        for (uint32_t i = beginSendIdx; i < endSendIdx; ++i) {
+                            const Octant &octant = m_octree.m_octants[i];
+                            buffSize += octant.getCompactBinarySize(expectedMorton);
+                            expectedMorton = octant.computeNextMorton();
+                        }
+                    } else {
+                        buffSize += nOctantsToSend * Octant::getBinarySize();
+                    }
+
                     if (userData) {
                         if (userData->fixedSize()) {
                             buffSize += nOctantsToSend * userData->fixedSize();
@@ -862,18 +1174,32 @@ namespace bitpit {
                             }
                         }
                     }
+                    if (fields) {
+                        buffSize += nOctantsToSend * fields->getEntrySize();
+                    }
                     lbCommunicator.setSend(rank, buffSize);
 
                     SendBuffer &sendBuffer = lbCommunicator.getSendBuffer(rank);
+                    uint64_t expectedMorton = 0;
                     for (uint32_t i = beginSendIdx; i < endSendIdx; ++i) {
-                        sendBuffer << m_octree.m_octants[i];
+                        const Octant &octant = m_octree.m_octants[i];
+                        if (m_octantCompression) {
+                            octant.writeCompactBinary(sendBuffer, expectedMorton);
+                            expectedMorton = octant.computeNextMorton();
+                        } else {
+                            sendBuffer << octant;
+                        }
                         userData->gather(sendBuffer, i);
                     }
 
+                    if (fields) {
+                        fields->gather(sendBuffer, beginSendIdx, endSendIdx);
+                    }
+
                     lbCommunicator.startSend(rank);
                 }
 
-                if (userData && !userData->fixedSize()) {
+                if (discoverRecvs) {
                     lbCommunicator.discoverRecvs();
                     lbCommunicator.startAllRecvs();
                 }
@@ -886,6 +1212,10 @@ namespace bitpit {
                     if (userData) {
                         userData->resize(newSizeOctants);
                     }
+
+                    if (fields) {
+                        fields->resize(newSizeOctants);
+                    }
                 }
 
                 bool hasResidentOctants;
@@ -927,6 +1257,10 @@ namespace bitpit {
                                 userData->move(firstResidentOffsetIdx + residentIdx, newFirstResidentOffsetIdx + residentIdx);
                             }
                         }
+
+                        if (fields) {
+                            fields->move(firstResidentOffsetIdx, newFirstResidentOffsetIdx, nofResidents);
+                        }
                     }
                 }
 
@@ -938,6 +1272,11 @@ namespace bitpit {
                         userData->resize(newSizeOctants);
                         userData->shrink();
                     }
+
+                    if (fields) {
+                        fields->resize(newSizeOctants);
+                        fields->shrink();
+                    }
                 }
 
                 // Read buffers and build new octants
@@ -949,20 +1288,34 @@ namespace bitpit {
                     const std::array<uint32_t, 2> &recvRange = recvRanges.at(senderRank);
                     uint32_t beginRecvIdx = recvRange[0];
                     uint32_t endRecvIdx   = recvRange[1];
-                    assert(userData || ((endRecvIdx - beginRecvIdx) == (recvBuffer.getSize() / (Octant::getBinarySize()))));
-                    assert(!userData || !userData->fixedSize() || ((endRecvIdx - beginRecvIdx) == (recvBuffer.getSize() / (Octant::getBinarySize() + userData->fixedSize()))));
+                    assert(m_octantCompression || userData || fields || ((endRecvIdx - beginRecvIdx) == (recvBuffer.getSize() / (Octant::getBinarySize()))));
+                    assert(m_octantCompression || userData || !fields || ((endRecvIdx - beginRecvIdx) == (recvBuffer.getSize() / (Octant::getBinarySize() + fields->getEntrySize()))));
+                    assert(m_octantCompression || !userData || !userData->fixedSize() || ((endRecvIdx - beginRecvIdx) == (recvBuffer.getSize() / (Octant::getBinarySize() + userData->fixedSize()))));
 
+                    uint64_t expectedMorton = 0;
                     for (uint32_t i = beginRecvIdx; i < endRecvIdx; ++i) {
-                        recvBuffer >> m_octree.m_octants[i];
+                        Octant &octant = m_octree.m_octants[i];
+                        if (m_octantCompression) {
+                            octant.readCompactBinary(recvBuffer, m_dim, expectedMorton);
+                            expectedMorton = octant.computeNextMorton();
+                        } else {
+                            recvBuffer >> octant;
+                        }
+
                         if (userData) {
                             userData->scatter(recvBuffer, i);
                         }
                     }
 
+                    if (fields) {
+                        fields->scatter(recvBuffer, beginRecvIdx, endRecvIdx);
+                    }
+
                     ++nCompletedRecvs;
                 }
 
                 lbCommunicator.waitAllSends();
+                countPerformanceCommunication(PHASE_LOAD_BALANCE, &lbCommunicator);
             }
 
             // Update load balance information
@@ -976,6 +1329,9 @@ namespace bitpit {
             if (userData) {
                 userData->resizeGhost(m_octree.getNumGhosts());
             }
+
+            // Update the neighbour graph
+            updateNeighbourGraph(false);
         }
 #endif
 
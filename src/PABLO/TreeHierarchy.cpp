@@ -0,0 +1,383 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// =================================================================================== //
+// INCLUDES                                                                            //
+// =================================================================================== //
+#include "TreeHierarchy.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace bitpit {
+
+    // =================================================================================== //
+    // CLASS IMPLEMENTATION                                                                    //
+    // =================================================================================== //
+
+    // =================================================================================== //
+    // CONSTRUCTORS AND OPERATORS
+    // =================================================================================== //
+
+    /*! Build the hierarchy of the levels of the specified tree.
+     *
+     * Coarse levels are built one after the other, each one with a single
+     * pass over the octants of the previous level; since the number of octants
+     * decreases level by level, the overall cost is proportional to the number
+     * of leaves of the tree. Building the hierarchy is a collective operation.
+     *
+     * \param[in] tree is the tree
+     * \param[in] minDepth is the depth of the coarsest level of the hierarchy,
+     * if the tree is a brick the coarsest level cannot be coarser than the
+     * level of the root octants of the brick
+     */
+    TreeHierarchy::TreeHierarchy(const ParaTree &tree, uint8_t minDepth)
+    {
+        // Evaluate the number of levels
+        int maxDepth = std::max(static_cast<int>(tree.getMaxDepth()), 0);
+        minDepth = std::max(minDepth, tree.getBrickLevel());
+
+        std::size_t nLevels = 1;
+        if (maxDepth > minDepth) {
+            nLevels += maxDepth - minDepth;
+        }
+        m_levels.resize(nLevels);
+
+        // The finest level contains the leaves of the tree
+        Level &finest = m_levels[0];
+        finest.depth = maxDepth;
+
+        uint32_t nOctants = tree.getNumOctants();
+        finest.octants.reserve(nOctants);
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            finest.octants.push_back(*(tree.getOctant(i)));
+        }
+
+        int rank = tree.getRank();
+        finest.partitionRangeGlobalIdx = tree.getPartitionRangeGlobalIdx();
+        finest.globalOffset = (rank > 0 && !tree.getSerial()) ? finest.partitionRangeGlobalIdx[rank - 1] + 1 : 0;
+
+        // Coarse levels
+        for (std::size_t level = 1; level < nLevels; ++level) {
+            buildCoarseLevel(tree, m_levels[level - 1], &(m_levels[level]));
+        }
+    }
+
+    // =================================================================================== //
+    // METHODS
+    // =================================================================================== //
+
+    /*! Build a coarse level truncating the octants of the specified finer
+     * level one depth above its depth.
+     *
+     * \param[in] tree is the tree
+     * \param[in] fine is the finer level
+     * \param[out] coarse on output will contain the coarse level
+     */
+    void
+    TreeHierarchy::buildCoarseLevel(const ParaTree &tree, const Level &fine, Level *coarse)
+    {
+        uint8_t dim = tree.getDim();
+        int maxLevel = tree.getMaxLevel();
+        uint8_t depth = fine.depth - 1;
+
+        coarse->depth = depth;
+
+        // Boundary of the domain
+        const u32array3 &brickSize = tree.getBrickSize();
+        uint8_t rootShift = maxLevel - tree.getBrickLevel();
+
+        u32array3 brickLength;
+        for (int d = 0; d < 3; ++d) {
+            brickLength[d] = brickSize[d] << rootShift;
+        }
+
+        // Truncate the octants of the finer level
+        //
+        // Ancestors of consecutive octants are consecutive along the Morton
+        // curve, hence duplicate ancestors can be identified comparing each
+        // ancestor with the previous one. Only the first ancestor can be owned
+        // by a previous process: this happens when the first local octant of
+        // the finer level is not the first child of its parent.
+        uint64_t mortonMask = ~((uint64_t(1) << (dim * (maxLevel - depth))) - 1);
+
+        std::size_t nFineOctants = fine.octants.size();
+        std::vector<uint32_t> parents(nFineOctants);
+
+        bool hasHead = false;
+        coarse->octants.clear();
+        coarse->octants.reserve(nFineOctants);
+        for (std::size_t i = 0; i < nFineOctants; ++i) {
+            const Octant &fineOctant = fine.octants[i];
+
+            uint8_t level = std::min(fineOctant.getLevel(), depth);
+            uint64_t morton = fineOctant.getMorton();
+            if (level < fineOctant.getLevel()) {
+                morton &= mortonMask;
+            }
+
+            if (coarse->octants.empty() || coarse->octants.back().getMorton() != morton) {
+                if (coarse->octants.empty()) {
+                    hasHead = (morton != fineOctant.getMorton());
+                }
+
+                coarse->octants.push_back(Octant(dim, level, morton));
+
+                Octant &octant = coarse->octants.back();
+                uint32_t size = octant.getLogicalSize();
+                for (int d = 0; d < dim; ++d) {
+                    uint32_t coordinate = octant.getLogicalCoordinates(d);
+                    octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d, coordinate == 0);
+                    octant.setInfo(Octant::INFO_BOUNDFACE0 + 2 * d + 1, coordinate + size == brickLength[d]);
+                }
+            }
+
+            parents[i] = coarse->octants.size() - 1;
+        }
+
+        if (hasHead) {
+            coarse->octants.erase(coarse->octants.begin());
+        }
+
+        // Partitioning and global numbering
+        uint64_t nOctants = coarse->octants.size();
+
+        int nProcs = tree.getNproc();
+        int rank   = tree.getRank();
+
+        std::vector<uint64_t> nPartitionOctants(nProcs, nOctants);
+#if BITPIT_ENABLE_MPI==1
+        if (!tree.getSerial()) {
+            MPI_Allgather(&nOctants, 1, MPI_UINT64_T, nPartitionOctants.data(), 1, MPI_UINT64_T, tree.getComm());
+        }
+#endif
+
+        coarse->partitionRangeGlobalIdx.resize(nProcs);
+        for (int p = 0; p < nProcs; ++p) {
+            if (tree.getSerial()) {
+                coarse->partitionRangeGlobalIdx[p] = nOctants - 1;
+            } else {
+                uint64_t previousRange = (p > 0) ? coarse->partitionRangeGlobalIdx[p - 1] : uint64_t(-1);
+                coarse->partitionRangeGlobalIdx[p] = previousRange + nPartitionOctants[p];
+            }
+        }
+
+        coarse->globalOffset = (rank > 0 && !tree.getSerial()) ? coarse->partitionRangeGlobalIdx[rank - 1] + 1 : 0;
+
+        // Transfer maps
+        //
+        // Children of the first ancestor, when it is owned by a previous
+        // process, are sent to the owner of the ancestor.
+        std::vector<uint64_t> headChildren;
+
+        coarse->restriction.clear();
+        coarse->restriction.reserve(nOctants, nFineOctants);
+
+        coarse->prolongation.clear();
+        coarse->prolongation.initialize(nFineOctants, 1, 0);
+
+        uint32_t hasHeadOffset = (hasHead ? 1 : 0);
+        uint64_t *prolongationData = coarse->prolongation.data();
+        for (std::size_t i = 0; i < nFineOctants; ++i) {
+            uint64_t fineGlobalIdx = fine.globalOffset + i;
+            if (hasHead && parents[i] == 0) {
+                prolongationData[i] = coarse->globalOffset - 1;
+                headChildren.push_back(fineGlobalIdx);
+                continue;
+            }
+
+            uint32_t parent = parents[i] - hasHeadOffset;
+            prolongationData[i] = coarse->globalOffset + parent;
+
+            if (coarse->restriction.size() == parent) {
+                coarse->restriction.pushBack();
+            }
+            coarse->restriction.pushBackItem(fineGlobalIdx);
+        }
+
+#if BITPIT_ENABLE_MPI==1
+        if (!tree.getSerial()) {
+            // Children of the first ancestor are sent to the owner of the
+            // ancestor, which is the closest previous process that owns some
+            // octants of the coarse level. Every process whose first octant
+            // is not the first octant of the level sends a message, possibly
+            // with no children, hence the owner can set up the receives
+            // without further communications: it receives a message from each
+            // following process until the first one that owns some octants.
+            //
+            // The message contains the number of children followed by their
+            // global indices.
+            std::size_t messageSize = (1 + tree.getNchildren()) * sizeof(uint64_t);
+
+            DataCommunicator headCommunicator(tree.getComm());
+            if (coarse->globalOffset > 0) {
+                auto ownerItr = std::lower_bound(coarse->partitionRangeGlobalIdx.begin(), coarse->partitionRangeGlobalIdx.end(), coarse->globalOffset - 1);
+                int owner = static_cast<int>(ownerItr - coarse->partitionRangeGlobalIdx.begin());
+
+                headCommunicator.setSend(owner, messageSize);
+                SendBuffer &buffer = headCommunicator.getSendBuffer(owner);
+                buffer << static_cast<uint64_t>(headChildren.size());
+                for (std::size_t k = 0; k < tree.getNchildren(); ++k) {
+                    buffer << ((k < headChildren.size()) ? headChildren[k] : uint64_t(0));
+                }
+            }
+
+            if (nOctants > 0) {
+                for (int p = rank + 1; p < nProcs; ++p) {
+                    headCommunicator.setRecv(p, messageSize);
+                    if (nPartitionOctants[p] > 0) {
+                        break;
+                    }
+                }
+            }
+
+            headCommunicator.startAllRecvs();
+            headCommunicator.startAllSends();
+
+            // Only the last local octant can have children owned by the
+            // following processes. Messages are processed in rank order, so
+            // that the children are stored following the global numbering.
+            headCommunicator.waitAllRecvs();
+            for (int p : headCommunicator.getRecvRanks()) {
+                RecvBuffer &buffer = headCommunicator.getRecvBuffer(p);
+
+                uint64_t nRemoteChildren;
+                buffer >> nRemoteChildren;
+                for (uint64_t k = 0; k < nRemoteChildren; ++k) {
+                    uint64_t child;
+                    buffer >> child;
+                    coarse->restriction.pushBackItem(child);
+                }
+            }
+
+            headCommunicator.waitAllSends();
+        }
+#endif
+    }
+
+    /*! Get the number of levels of the hierarchy.
+     * \return The number of levels of the hierarchy.
+     */
+    std::size_t
+    TreeHierarchy::getNofLevels() const {
+        return m_levels.size();
+    }
+
+    /*! Get the depth of the specified level, i.e., the maximum level of its
+     * octants.
+     * \param[in] level is the level of the hierarchy
+     * \return The depth of the specified level.
+     */
+    uint8_t
+    TreeHierarchy::getDepth(std::size_t level) const {
+        return m_levels[level].depth;
+    }
+
+    /*! Get the number of local octants of the specified level.
+     * \param[in] level is the level of the hierarchy
+     * \return The number of local octants of the specified level.
+     */
+    uint32_t
+    TreeHierarchy::getNumOctants(std::size_t level) const {
+        return static_cast<uint32_t>(m_levels[level].octants.size());
+    }
+
+    /*! Get the global number of octants of the specified level.
+     * \param[in] level is the level of the hierarchy
+     * \return The global number of octants of the specified level.
+     */
+    uint64_t
+    TreeHierarchy::getGlobalNumOctants(std::size_t level) const {
+        return m_levels[level].partitionRangeGlobalIdx.back() + 1;
+    }
+
+    /*! Get the local octants of the specified level.
+     * Geometric information about the octants can be evaluated using the
+     * pointer based methods of the tree the hierarchy was built from.
+     * \param[in] level is the level of the hierarchy
+     * \return The local octants of the specified level.
+     */
+    const std::vector<Octant> &
+    TreeHierarchy::getOctants(std::size_t level) const {
+        return m_levels[level].octants;
+    }
+
+    /*! Get a local octant of the specified level.
+     * \param[in] level is the level of the hierarchy
+     * \param[in] idx is the local index of the octant
+     * \return A pointer to the requested octant.
+     */
+    const Octant *
+    TreeHierarchy::getOctant(std::size_t level, uint32_t idx) const {
+        return &(m_levels[level].octants[idx]);
+    }
+
+    /*! Get the global index of a local octant of the specified level.
+     * \param[in] level is the level of the hierarchy
+     * \param[in] idx is the local index of the octant
+     * \return The global index of the octant.
+     */
+    uint64_t
+    TreeHierarchy::getGlobalIdx(std::size_t level, uint32_t idx) const {
+        return m_levels[level].globalOffset + idx;
+    }
+
+    /*! Get the partitioning of the specified level.
+     * \param[in] level is the level of the hierarchy
+     * \return For each process, the global index of the last octant of the
+     * specified level it owns.
+     */
+    const std::vector<uint64_t> &
+    TreeHierarchy::getPartitionRangeGlobalIdx(std::size_t level) const {
+        return m_levels[level].partitionRangeGlobalIdx;
+    }
+
+    /*! Get the restriction map of the specified level.
+     * The map has a row for each local octant of the specified level that
+     * contains the global indices of its children on the next finer level
+     * (i.e., level - 1). Octants that are not refined on the finer level have
+     * a single child, the octant itself.
+     * \param[in] level is the level of the hierarchy, it should be greater
+     * than zero
+     * \return The restriction map, stored in CSR format.
+     */
+    const FlatVector2D<uint64_t> &
+    TreeHierarchy::getRestriction(std::size_t level) const {
+        return m_levels[level].restriction;
+    }
+
+    /*! Get the prolongation map of the specified level.
+     * The map has a row for each local octant of the next finer level (i.e.,
+     * level - 1) that contains the global index of its parent on the specified
+     * level.
+     * \param[in] level is the level of the hierarchy, it should be greater
+     * than zero
+     * \return The prolongation map, stored in CSR format.
+     */
+    const FlatVector2D<uint64_t> &
+    TreeHierarchy::getProlongation(std::size_t level) const {
+        return m_levels[level].prolongation;
+    }
+
+}
@@ -0,0 +1,109 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#ifndef __BITPIT_PABLO_TREE_HIERARCHY_HPP__
+#define __BITPIT_PABLO_TREE_HIERARCHY_HPP__
+
+// =================================================================================== //
+// INCLUDES                                                                            //
+// =================================================================================== //
+#include "ParaTree.hpp"
+
+#include "bitpit_containers.hpp"
+
+#include <vector>
+
+namespace bitpit {
+
+    // =================================================================================== //
+    // CLASS DEFINITION                                                                    //
+    // =================================================================================== //
+
+    /*!
+     *	\ingroup		PABLO
+     *
+     *	\brief Tree hierarchy is the geometric multigrid hierarchy of the levels
+     *	of a ParaTree
+     *
+     *	The hierarchy is derived from the current leaves of the tree without
+     *	modifying the tree. Level zero of the hierarchy contains the leaves of
+     *	the tree, the k-th level contains the octants obtained by truncating the
+     *	leaves at depth (maxDepth - k): each leaf deeper than this depth is
+     *	replaced by its ancestor at that depth, whereas coarser leaves are kept
+     *	unchanged. Truncating a 2:1 balanced tree gives 2:1 balanced levels.
+     *
+     *	Octants of each level are ordered along the Morton curve and are
+     *	partitioned among the processes: a coarse octant is owned by the process
+     *	that owns its first child (i.e., the child that shares its Morton number).
+     *	Each level has its own global numbering, which follows the Morton order.
+     *
+     *	The transfer operators between a level and the next finer level are
+     *	exposed as index maps stored in CSR format (see FlatVector2D::indices()
+     *	and FlatVector2D::data()): the restriction map of level k has a row for
+     *	each local octant of level k, containing the global indices of its
+     *	children on level k-1; the prolongation map of level k has a row for each
+     *	local octant of level k-1, containing the global index of its parent on
+     *	level k. Children of an octant may be owned by other processes, hence the
+     *	maps always store global indices.
+     */
+    class TreeHierarchy {
+
+    public:
+        TreeHierarchy(const ParaTree &tree, uint8_t minDepth = 0);
+
+        std::size_t getNofLevels() const;
+        uint8_t getDepth(std::size_t level) const;
+
+        uint32_t getNumOctants(std::size_t level) const;
+        uint64_t getGlobalNumOctants(std::size_t level) const;
+        const std::vector<Octant> & getOctants(std::size_t level) const;
+        const Octant * getOctant(std::size_t level, uint32_t idx) const;
+        uint64_t getGlobalIdx(std::size_t level, uint32_t idx) const;
+        const std::vector<uint64_t> & getPartitionRangeGlobalIdx(std::size_t level) const;
+
+        const FlatVector2D<uint64_t> & getRestriction(std::size_t level) const;
+        const FlatVector2D<uint64_t> & getProlongation(std::size_t level) const;
+
+    private:
+        /*!
+         * Level of the hierarchy
+         */
+        struct Level {
+            uint8_t depth;                                  /**<Depth at which the leaves are truncated*/
+            std::vector<Octant> octants;                    /**<Local octants of the level*/
+            uint64_t globalOffset;                          /**<Global index of the first local octant*/
+            std::vector<uint64_t> partitionRangeGlobalIdx;  /**<Global index of the last octant of each process*/
+            FlatVector2D<uint64_t> restriction;             /**<Global indices of the children of the local octants*/
+            FlatVector2D<uint64_t> prolongation;            /**<Global indices of the parents of the local octants of the finer level*/
+        };
+
+        std::vector<Level> m_levels;                        /**<Levels of the hierarchy, from the finest to the coarsest*/
+
+        void buildCoarseLevel(const ParaTree &tree, const Level &fine, Level *coarse);
+
+    };
+
+}
+
+#endif
@@ -26,16 +26,106 @@
 #define __BITPIT_PABLO_MORTON_HPP__
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <stdexcept>
 
+// BMI2 instructions (PDEP/PEXT) can be used only on x86-64 processors and
+// only with compilers that support function-level target attributes and the
+// detection of CPU features at runtime.
+#ifndef BITPIT_PABLO_ENABLE_BMI2
+#   if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#       define BITPIT_PABLO_ENABLE_BMI2 1
+#   else
+#       define BITPIT_PABLO_ENABLE_BMI2 0
+#   endif
+#endif
+
+// Scalar functions are not dispatched at runtime: a function compiled for the
+// BMI2 target can't be inlined across the target boundary, hence checking the
+// processor on every call costs more than what the instructions save. Scalar
+// functions use BMI2 instructions only when the code is compiled for a target
+// that supports them (e.g., -mbmi2 or -march=native), unless the target is an
+// AMD processor prior to Zen 3, on which PDEP/PEXT are microcoded.
+#ifndef BITPIT_PABLO_ENABLE_SCALAR_BMI2
+#   if BITPIT_PABLO_ENABLE_BMI2==1 && defined(__BMI2__) && !defined(__bdver4__) && !defined(__znver1__) && !defined(__znver2__)
+#       define BITPIT_PABLO_ENABLE_SCALAR_BMI2 1
+#   else
+#       define BITPIT_PABLO_ENABLE_SCALAR_BMI2 0
+#   endif
+#endif
+
+#if BITPIT_PABLO_ENABLE_BMI2==1
+#include <immintrin.h>
+#endif
+
 namespace bitpit {
 
 namespace PABLO {
 
 const uint64_t INVALID_MORTON = std::numeric_limits<uint64_t>::max();
 
+/**
+* Mask that selects the bits of the first coordinate of a 3D Morton number.
+*/
+const uint64_t MORTON_MASK_3D = 0x1249249249249249;
+
+/**
+* Mask that selects the bits of the first coordinate of a 2D Morton number.
+*/
+const uint64_t MORTON_MASK_2D = 0x5555555555555555;
+
+#if BITPIT_PABLO_ENABLE_BMI2==1
+/**
+* Check if Morton numbers can be evaluated using BMI2 instructions.
+*
+* BMI2 instructions are used only if the processor supports them and if they
+* are implemented in hardware: on AMD processors prior to Zen 3 PDEP/PEXT are
+* microcoded and are much slower than the "magic bits" algorithm.
+*
+* \result Returns true if Morton numbers can be evaluated using BMI2
+* instructions, false otherwise.
+*/
+inline bool detectBMI2Support()
+{
+    // The function may be called before any constructors is called
+    __builtin_cpu_init();
+
+    if (!__builtin_cpu_supports("bmi2")) {
+        return false;
+    }
+
+    if (__builtin_cpu_is("amdfam15h") || __builtin_cpu_is("znver1") || __builtin_cpu_is("znver2")) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+* Flag that defines if Morton numbers are evaluated using BMI2 instructions.
+*
+* The flag is evaluated once, when the library is loaded.
+*/
+inline const bool MORTON_USE_BMI2 = detectBMI2Support();
+#endif
+
+/**
+* Check if Morton numbers are evaluated using BMI2 instructions.
+*
+* \result Returns true if Morton numbers are evaluated using BMI2 instructions,
+* false otherwise.
+*/
+inline bool isMortonBMI2Enabled()
+{
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    return MORTON_USE_BMI2;
+#else
+    return false;
+#endif
+}
+
 /**
 * Compute the maximum allowed level.
 *
@@ -84,7 +174,7 @@ inline int8_t computeMaximumLevel(uint8_t dimension)
 * \param a is an integer position
 * \result Separated bits.
 */
-inline uint64_t splitBy3(uint32_t a)
+inline uint64_t splitBy3MagicBits(uint32_t a)
 {
     uint64_t x = a & 0x1fffff; // we only look at the first 21 bits
     x = (x | x << 32) & 0x001F00000000FFFF; // shift left 32 bits, OR with self, and 0000000000011111000000000000000000000000000000001111111111111111
@@ -104,7 +194,7 @@ inline uint64_t splitBy3(uint32_t a)
 * \param a is an integer position
 * \result Separated bits.
 */
-inline uint64_t splitBy2(uint32_t a)
+inline uint64_t splitBy2MagicBits(uint32_t a)
 {
     uint64_t x = a;
     x = (x | x << 32) & 0x00000000FFFFFFFF; // shift left 32 bits, OR with self, and 0000000000000000000000000000000011111111111111111111111111111111
@@ -125,7 +215,7 @@ inline uint64_t splitBy2(uint32_t a)
 * \param morton is the morton number
 * \result The third bit of the given Morton number.
 */
-inline uint32_t getThirdBits(uint64_t morton)
+inline uint32_t getThirdBitsMagicBits(uint64_t morton)
 {
     uint64_t x = morton & 0x1249249249249249;
     x = (x ^ (x >>  2)) & 0x10C30C30C30C30C3;
@@ -145,7 +235,7 @@ inline uint32_t getThirdBits(uint64_t morton)
 * \param morton is the morton number
 * \result The third bit of the given Morton number.
 */
-inline uint32_t getSecondBits(uint64_t morton)
+inline uint32_t getSecondBitsMagicBits(uint64_t morton)
 {
     uint64_t x = morton & 0x5555555555555555;
     x = (x ^ (x >>  1)) & 0x3333333333333333;
@@ -157,6 +247,252 @@ inline uint32_t getSecondBits(uint64_t morton)
     return static_cast<uint32_t>(x);
 }
 
+#if BITPIT_PABLO_ENABLE_BMI2==1
+/**
+* Seperate bits from a given integer 3 positions apart.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param a is an integer position
+* \result Separated bits.
+*/
+__attribute__((target("bmi2"))) inline uint64_t splitBy3BMI2(uint32_t a)
+{
+    return _pdep_u64(a, MORTON_MASK_3D);
+}
+
+/**
+* Seperate bits from a given integer 2 positions apart.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param a is an integer position
+* \result Separated bits.
+*/
+__attribute__((target("bmi2"))) inline uint64_t splitBy2BMI2(uint32_t a)
+{
+    return _pdep_u64(a, MORTON_MASK_2D);
+}
+
+/**
+* Get the third bits of the given Morton number.
+*
+* The function uses the PEXT instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param morton is the morton number
+* \result The third bit of the given Morton number.
+*/
+__attribute__((target("bmi2"))) inline uint32_t getThirdBitsBMI2(uint64_t morton)
+{
+    return static_cast<uint32_t>(_pext_u64(morton, MORTON_MASK_3D));
+}
+
+/**
+* Get the second bits of the given Morton number.
+*
+* The function uses the PEXT instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param morton is the morton number
+* \result The second bit of the given Morton number.
+*/
+__attribute__((target("bmi2"))) inline uint32_t getSecondBitsBMI2(uint64_t morton)
+{
+    return static_cast<uint32_t>(_pext_u64(morton, MORTON_MASK_2D));
+}
+
+/**
+* Compute the Morton number of the given set of coordinates.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param x is the integer x position
+* \param y is the integer y position
+* \param z is the integer z position
+* \result The Morton number.
+*/
+__attribute__((target("bmi2"))) inline uint64_t computeMorton3DBMI2(uint32_t x, uint32_t y, uint32_t z)
+{
+    return _pdep_u64(x, MORTON_MASK_3D) | _pdep_u64(y, MORTON_MASK_3D << 1) | _pdep_u64(z, MORTON_MASK_3D << 2);
+}
+
+/**
+* Compute the Morton number of the given set of coordinates.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param x is the integer x position
+* \param y is the integer y position
+* \result The Morton number.
+*/
+__attribute__((target("bmi2"))) inline uint64_t computeMorton2DBMI2(uint32_t x, uint32_t y)
+{
+    return _pdep_u64(x, MORTON_MASK_2D) | _pdep_u64(y, MORTON_MASK_2D << 1);
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param z are the integer z positions
+* \param[out] mortons on output will contain the Morton numbers
+*/
+__attribute__((target("bmi2"))) inline void computeMorton3DBMI2(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = _pdep_u64(x[i], MORTON_MASK_3D) | _pdep_u64(y[i], MORTON_MASK_3D << 1) | _pdep_u64(z[i], MORTON_MASK_3D << 2);
+    }
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* The function uses the PDEP instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param[out] mortons on output will contain the Morton numbers
+*/
+__attribute__((target("bmi2"))) inline void computeMorton2DBMI2(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = _pdep_u64(x[i], MORTON_MASK_2D) | _pdep_u64(y[i], MORTON_MASK_2D << 1);
+    }
+}
+
+/**
+* Compute the coordinates of the given Morton numbers.
+*
+* The function uses the PEXT instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+* \param[out] z on output will contain the integer z positions
+*/
+__attribute__((target("bmi2"))) inline void computeCoordinates3DBMI2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<uint32_t>(_pext_u64(mortons[i], MORTON_MASK_3D));
+        y[i] = static_cast<uint32_t>(_pext_u64(mortons[i], MORTON_MASK_3D << 1));
+        z[i] = static_cast<uint32_t>(_pext_u64(mortons[i], MORTON_MASK_3D << 2));
+    }
+}
+
+/**
+* Compute the coordinates of the given Morton numbers.
+*
+* The function uses the PEXT instruction of the BMI2 instruction set, it can
+* be called only if the processor supports BMI2 instructions.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+*/
+__attribute__((target("bmi2"))) inline void computeCoordinates2DBMI2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<uint32_t>(_pext_u64(mortons[i], MORTON_MASK_2D));
+        y[i] = static_cast<uint32_t>(_pext_u64(mortons[i], MORTON_MASK_2D << 1));
+    }
+}
+#endif
+
+/**
+* Seperate bits from a given integer 3 positions apart.
+*
+* BMI2 instructions are used if the code is compiled for a target that
+* supports them (see getSecondBits), otherwise the "magic bits" algorithm
+* is used.
+*
+* \param a is an integer position
+* \result Separated bits.
+*/
+inline uint64_t splitBy3(uint32_t a)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return splitBy3BMI2(a);
+#else
+    return splitBy3MagicBits(a);
+#endif
+}
+
+/**
+* Seperate bits from a given integer 2 positions apart.
+*
+* BMI2 instructions are used if the code is compiled for a target that
+* supports them (see getSecondBits), otherwise the "magic bits" algorithm
+* is used.
+*
+* \param a is an integer position
+* \result Separated bits.
+*/
+inline uint64_t splitBy2(uint32_t a)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return splitBy2BMI2(a);
+#else
+    return splitBy2MagicBits(a);
+#endif
+}
+
+/**
+* Get the third bits of the given Morton number.
+*
+* The function uses the "magic bits" algorithm of the libmorton library,
+* see getSecondBits for when BMI2 instructions are used.
+*
+* \param morton is the morton number
+* \result The third bit of the given Morton number.
+*/
+inline uint32_t getThirdBits(uint64_t morton)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return getThirdBitsBMI2(morton);
+#else
+    return getThirdBitsMagicBits(morton);
+#endif
+}
+
+/**
+* Get the second bits of the given Morton number.
+*
+* The function uses the "magic bits" algorithm of the libmorton library.
+* Scalar decoding is not dispatched at runtime to the BMI2 implementation:
+* the PEXT based function can't be inlined across the target boundary and,
+* on a per-call basis, it is slower than the "magic bits" algorithm. BMI2
+* instructions are used only if the code is compiled for a target that
+* supports them (see BITPIT_PABLO_ENABLE_SCALAR_BMI2) and by the batched
+* functions, where the cost of the runtime dispatch is amortized over the
+* whole array.
+*
+* \param morton is the morton number
+* \result The second bit of the given Morton number.
+*/
+inline uint32_t getSecondBits(uint64_t morton)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return getSecondBitsBMI2(morton);
+#else
+    return getSecondBitsMagicBits(morton);
+#endif
+}
+
 /**
 * Compute the Morton number of the given set of coordinates.
 *
@@ -168,9 +504,9 @@ inline uint32_t getSecondBits(uint64_t morton)
 * \param z is the integer z position
 * \result The Morton number.
 */
-inline uint64_t computeMorton3D(uint32_t x, uint32_t y, uint32_t z)
+inline uint64_t computeMorton3DMagicBits(uint32_t x, uint32_t y, uint32_t z)
 {
-    uint64_t morton = splitBy3(x) | (splitBy3(y) << 1) | (splitBy3(z) << 2);
+    uint64_t morton = splitBy3MagicBits(x) | (splitBy3MagicBits(y) << 1) | (splitBy3MagicBits(z) << 2);
 
     return morton;
 }
@@ -185,13 +521,111 @@ inline uint64_t computeMorton3D(uint32_t x, uint32_t y, uint32_t z)
 * \param y is the integer y position
 * \result The Morton number.
 */
-inline uint64_t computeMorton2D(uint32_t x, uint32_t y)
+inline uint64_t computeMorton2DMagicBits(uint32_t x, uint32_t y)
 {
-    uint64_t morton = splitBy2(x) | (splitBy2(y) << 1);
+    uint64_t morton = splitBy2MagicBits(x) | (splitBy2MagicBits(y) << 1);
 
     return morton;
 }
 
+/**
+* Compute the Morton number of the given set of coordinates.
+*
+* BMI2 instructions are used if the code is compiled for a target that
+* supports them (see getSecondBits), otherwise the "magic bits" algorithm
+* of the libmorton library is used.
+*
+* \param x is the integer x position
+* \param y is the integer y position
+* \param z is the integer z position
+* \result The Morton number.
+*/
+inline uint64_t computeMorton3D(uint32_t x, uint32_t y, uint32_t z)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return computeMorton3DBMI2(x, y, z);
+#else
+    return computeMorton3DMagicBits(x, y, z);
+#endif
+}
+
+/**
+* Compute the Morton number of the given set of coordinates.
+*
+* BMI2 instructions are used if the code is compiled for a target that
+* supports them (see getSecondBits), otherwise the "magic bits" algorithm
+* of the libmorton library is used.
+*
+* \param x is the integer x position
+* \param y is the integer y position
+* \result The Morton number.
+*/
+inline uint64_t computeMorton2D(uint32_t x, uint32_t y)
+{
+#if BITPIT_PABLO_ENABLE_SCALAR_BMI2==1
+    return computeMorton2DBMI2(x, y);
+#else
+    return computeMorton2DMagicBits(x, y);
+#endif
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* BMI2 instructions are used if available, otherwise the "magic bits"
+* algorithm of the libmorton library is used. The loop of the "magic bits"
+* implementation only contains shifts and masks, hence it can be vectorized
+* by the compiler.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param z are the integer z positions
+* \param[out] mortons on output will contain the Morton numbers, it's up to
+* the caller to allocate enough space for n Morton numbers
+*/
+inline void computeMorton3D(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (MORTON_USE_BMI2) {
+        computeMorton3DBMI2(n, x, y, z, mortons);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = computeMorton3DMagicBits(x[i], y[i], z[i]);
+    }
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* BMI2 instructions are used if available, otherwise the "magic bits"
+* algorithm of the libmorton library is used. The loop of the "magic bits"
+* implementation only contains shifts and masks, hence it can be vectorized
+* by the compiler.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param[out] mortons on output will contain the Morton numbers, it's up to
+* the caller to allocate enough space for n Morton numbers
+*/
+inline void computeMorton2D(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (MORTON_USE_BMI2) {
+        computeMorton2DBMI2(n, x, y, mortons);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = computeMorton2DMagicBits(x[i], y[i]);
+    }
+}
+
 /**
 * Compute the Morton number of the given set of coordinates.
 *
@@ -249,6 +683,64 @@ inline uint32_t computeCoordinate2D(uint64_t morton, int coord)
     }
 }
 
+/**
+* Compute the coordinates of the given Morton numbers.
+*
+* BMI2 instructions are used if available, otherwise the "magic bits"
+* algorithm of the libmorton library is used. The loop of the "magic bits"
+* implementation only contains shifts and masks, hence it can be vectorized
+* by the compiler.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+* \param[out] z on output will contain the integer z positions
+*/
+inline void computeCoordinates3D(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (MORTON_USE_BMI2) {
+        computeCoordinates3DBMI2(n, mortons, x, y, z);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = getThirdBitsMagicBits(mortons[i]);
+        y[i] = getThirdBitsMagicBits(mortons[i] >> 1);
+        z[i] = getThirdBitsMagicBits(mortons[i] >> 2);
+    }
+}
+
+/**
+* Compute the coordinates of the given Morton numbers.
+*
+* BMI2 instructions are used if available, otherwise the "magic bits"
+* algorithm of the libmorton library is used. The loop of the "magic bits"
+* implementation only contains shifts and masks, hence it can be vectorized
+* by the compiler.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+*/
+inline void computeCoordinates2D(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+#if BITPIT_PABLO_ENABLE_BMI2==1
+    if (MORTON_USE_BMI2) {
+        computeCoordinates2DBMI2(n, mortons, x, y);
+        return;
+    }
+#endif
+
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = getSecondBitsMagicBits(mortons[i]);
+        y[i] = getSecondBitsMagicBits(mortons[i] >> 1);
+    }
+}
+
 /**
 * Compute the specified coordinate value from the given Morton number.
 *
@@ -336,6 +828,79 @@ inline uint64_t computeXYZKey(uint8_t dimension, uint32_t x, uint32_t y, uint32_
     }
 }
 
+/**
+* Compute the Morton number of the given set of coordinates.
+*
+* The dimension of the space is given at compile time, this allows to avoid
+* the runtime dispatch on the dimension inside performance-critical loops.
+*
+* \tparam dim is the dimension of the space
+* \param x is the integer x position
+* \param y is the integer y position
+* \param z is the integer z position, it is ignored in two dimensions
+* \result The Morton number.
+*/
+template<int dim>
+inline uint64_t computeMorton(uint32_t x, uint32_t y, uint32_t z)
+{
+    static_assert(dim == 2 || dim == 3, "Requested dimension is not supported");
+
+    if constexpr (dim == 3) {
+        return computeMorton3D(x, y, z);
+    } else {
+        (void) z;
+        return computeMorton2D(x, y);
+    }
+}
+
+/**
+* Compute the specified coordinate value from the given Morton number.
+*
+* The dimension of the space is given at compile time, this allows to avoid
+* the runtime dispatch on the dimension inside performance-critical loops.
+*
+* \tparam dim is the dimension of the space
+* \param morton is the morton number
+* \param coord is the coordinate that will be computed
+* \result The coordinate value.
+*/
+template<int dim>
+inline uint32_t computeCoordinate(uint64_t morton, int coord)
+{
+    static_assert(dim == 2 || dim == 3, "Requested dimension is not supported");
+
+    if constexpr (dim == 3) {
+        return computeCoordinate3D(morton, coord);
+    } else {
+        return computeCoordinate2D(morton, coord);
+    }
+}
+
+/**
+* Compute the XYZ key of the given set of coordinates.
+*
+* The dimension of the space is given at compile time, this allows to avoid
+* the runtime dispatch on the dimension inside performance-critical loops.
+*
+* \tparam dim is the dimension of the space
+* \param x is the integer x position
+* \param y is the integer y position
+* \param z is the integer z position, it is ignored in two dimensions
+* \result The unique XYZ key of the coordinates.
+*/
+template<int dim>
+inline uint64_t computeXYZKey(uint32_t x, uint32_t y, uint32_t z)
+{
+    static_assert(dim == 2 || dim == 3, "Requested dimension is not supported");
+
+    if constexpr (dim == 3) {
+        return computeXYZKey3D(x, y, z);
+    } else {
+        (void) z;
+        return computeXYZKey2D(x, y);
+    }
+}
+
 }
 
 }
@@ -68,8 +68,8 @@ OBinaryStream & operator<<(OBinaryStream &stream, const std::array<T, SIZE> &dat
 * \param[in] data is the data to be streamed
 * \result Returns the updated input stream.
 */
-template<typename T>
-IBinaryStream & operator>>(IBinaryStream &stream, std::vector<T> &data)
+template<typename T, typename Allocator>
+IBinaryStream & operator>>(IBinaryStream &stream, std::vector<T, Allocator> &data)
 {
     std::size_t size;
     stream.read(reinterpret_cast<char *>(&size), sizeof(size));
@@ -92,8 +92,8 @@ IBinaryStream & operator>>(IBinaryStream &stream, std::vector<T> &data)
 * \param[in] data is the vector to be streamed
 * \result Returns the updated output stream.
 */
-template<typename T>
-OBinaryStream & operator<<(OBinaryStream &stream, const std::vector<T> &data)
+template<typename T, typename Allocator>
+OBinaryStream & operator<<(OBinaryStream &stream, const std::vector<T, Allocator> &data)
 {
     std::size_t size = data.size();
     stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
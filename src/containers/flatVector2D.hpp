@@ -34,14 +34,14 @@
 
 namespace bitpit{
 
-template<class T>
+template<class T, class Allocator = std::allocator<T>>
 class FlatVector2D;
 
-template<class T>
-OBinaryStream& operator<<(OBinaryStream &buffer, const FlatVector2D<T> &vector);
+template<class T, class Allocator>
+OBinaryStream& operator<<(OBinaryStream &buffer, const FlatVector2D<T, Allocator> &vector);
 
-template<class T>
-IBinaryStream& operator>>(IBinaryStream &buffer, FlatVector2D<T> &vector);
+template<class T, class Allocator>
+IBinaryStream& operator>>(IBinaryStream &buffer, FlatVector2D<T, Allocator> &vector);
 
 /*!
     @ingroup containers
@@ -53,19 +53,27 @@ IBinaryStream& operator>>(IBinaryStream &buffer, FlatVector2D<T> &vector);
     vectors.
 
     @tparam T The type of the objects stored in the vector
+    @tparam Allocator The allocator used to acquire and release the memory
+    of the vectors
 */
 
-template <class T>
+template <class T, class Allocator>
 class FlatVector2D
 {
 
-template<class U>
-friend OBinaryStream& (operator<<) (OBinaryStream &buffer, const FlatVector2D<U> &vector);
-template<class U>
-friend IBinaryStream& (operator>>) (IBinaryStream &buffer, FlatVector2D<U> &vector);
+template<class U, class OtherAllocator>
+friend class FlatVector2D;
+
+template<class U, class UAllocator>
+friend OBinaryStream& (operator<<) (OBinaryStream &buffer, const FlatVector2D<U, UAllocator> &vector);
+template<class U, class UAllocator>
+friend IBinaryStream& (operator>>) (IBinaryStream &buffer, FlatVector2D<U, UAllocator> &vector);
 
 public:
+    typedef Allocator allocator_type;
+
     FlatVector2D(bool initialize = true);
+    FlatVector2D(bool initialize, const Allocator &allocator);
     FlatVector2D(const std::vector<std::size_t> &sizes, const T &value = T());
     FlatVector2D(std::size_t nVectors, std::size_t size, const T &value = T());
     FlatVector2D(std::size_t nVectors, const std::size_t *sizes, const T &value);
@@ -97,7 +105,8 @@ public:
     void initialize(std::size_t nVectors, const std::size_t *sizes, const T &value);
     void initialize(std::size_t nVectors, const std::size_t *sizes, const T *values);
     void initialize(const std::vector<std::vector<T> > &vector2D);
-    void initialize(const FlatVector2D<T> &other);
+    template<class OtherAllocator>
+    void initialize(const FlatVector2D<T, OtherAllocator> &other);
 
     void destroy();
     void reserve(std::size_t nVectors, std::size_t nItems = 0);
@@ -115,7 +124,7 @@ public:
 
     T * data() noexcept;
     const T * data() const noexcept;
-    const std::vector<T> & vector() const;
+    const std::vector<T, Allocator> & vector() const;
 
     void pushBack();
     void pushBack(std::size_t subArraySize, const T &value = T());
@@ -159,9 +168,13 @@ public:
 
     std::size_t getBinarySize() const;
 
+    Allocator getAllocator() const;
+
 private:
-    std::vector<T> m_v;
-    std::vector<std::size_t> m_index;
+    typedef std::vector<std::size_t, typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>> IndexVector;
+
+    std::vector<T, Allocator> m_v;
+    IndexVector m_index;
 
     const T* operator[](std::size_t i) const;
     T* operator[](std::size_t i);
@@ -367,6 +367,7 @@ public:
     void dump() const;
     bool empty() const;
     bool isIteratorSlow();
+    bool isIdMapDense() const;
     std::size_t maxSize() const;
     std::size_t size() const;
     std::size_t capacity() const;
@@ -495,6 +496,62 @@ private:
         }
     };
 
+    /**
+    * Map that links the id of the elements and their position.
+    *
+    * As long as the ids are dense (i.e., the largest id is not much larger
+    * than the number of ids), positions are stored in a vector indexed by
+    * id. This avoids the hashing and the cache misses of a hash map lookup.
+    * When the ids become too sparse, the map automatically falls back to a
+    * hash map; it returns to the dense storage when it becomes empty or
+    * when the storage is updated (e.g., after the kernel is squeezed or
+    * sorted) and the ids are dense enough.
+    */
+    class PositionMap {
+
+    public:
+        static const std::size_t NULL_POS;
+
+        PositionMap();
+
+        void clear(bool release = false);
+        void reserve(std::size_t n);
+        void shrinkToFit();
+        void updateStorage();
+        void swap(PositionMap &other) noexcept;
+
+        bool isDense() const;
+        bool empty() const;
+        std::size_t size() const;
+
+        std::size_t count(id_t id) const;
+        std::size_t find(id_t id) const;
+        std::size_t at(id_t id) const;
+
+        void set(id_t id, std::size_t pos);
+        void erase(id_t id);
+        void swapPositions(id_t id_1, id_t id_2);
+
+        template<typename Function>
+        void forEach(Function function) const;
+
+    private:
+        static const std::size_t DENSE_MIN_SIZE;
+        static const std::size_t DENSE_MAX_SPARSITY;
+        static const std::size_t DENSE_RESTORE_SPARSITY;
+
+        bool m_dense;
+        std::size_t m_denseCount;
+        std::vector<std::size_t> m_densePos;
+        std::unordered_map<id_t, std::size_t, PiercedHasher> m_sparsePos;
+
+        void makeSparse();
+        void makeDense();
+
+        static bool isNegative(id_t id);
+
+    };
+
     /**
     * Compares the id of the elements in the specified position.
     *
@@ -544,7 +601,7 @@ private:
     * Map that links the id of the elements and their position inside the
     * internal vector.
     */
-    std::unordered_map<id_t, std::size_t, PiercedHasher> m_pos;
+    PositionMap m_pos;
 
     /**
     * Position of the first element in the internal vector.
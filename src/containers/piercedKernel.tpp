@@ -31,6 +31,18 @@ namespace bitpit {
 template<typename id_t>
 const std::size_t PiercedKernel<id_t>::MAX_PENDING_HOLES = 16384;
 
+template<typename id_t>
+const std::size_t PiercedKernel<id_t>::PositionMap::NULL_POS = std::numeric_limits<std::size_t>::max();
+
+template<typename id_t>
+const std::size_t PiercedKernel<id_t>::PositionMap::DENSE_MIN_SIZE = 1024;
+
+template<typename id_t>
+const std::size_t PiercedKernel<id_t>::PositionMap::DENSE_MAX_SPARSITY = 4;
+
+template<typename id_t>
+const std::size_t PiercedKernel<id_t>::PositionMap::DENSE_RESTORE_SPARSITY = 2;
+
 /**
 * Constructs an empty pierced kernel with no elements.
 */
@@ -115,10 +127,9 @@ typename PiercedKernel<id_t>::ClearAction PiercedKernel<id_t>::_clear(bool relea
 {
     // Clear positions
     m_ids.clear();
-    m_pos.clear();
+    m_pos.clear(release);
     if (release) {
         std::vector<id_t>().swap(m_ids);
-        std::unordered_map<id_t, std::size_t, PiercedHasher>().swap(m_pos);
     }
 
     // Reset begin and end
@@ -420,10 +431,15 @@ typename PiercedKernel<id_t>::SortAction PiercedKernel<id_t>::_sort(std::size_t
     utils::reorderVector<id_t>(sortPermutations, m_ids, updatedKernelRawSize);
 
     // Update the positions
+    //
+    // Positions are set in ascending id order, the map may fall back to the
+    // hash map storage before all the ids are set, hence its storage is
+    // updated once all the positions have been set.
     m_pos.clear();
     for (std::size_t i = 0; i < updatedKernelRawSize; ++i) {
-        m_pos[m_ids[i]] = i;
+        m_pos.set(m_ids[i], i);
     }
+    m_pos.updateStorage();
 
     // Return the permutations
     return syncAction;
@@ -574,6 +590,7 @@ typename PiercedKernel<id_t>::ShrinkToFitAction PiercedKernel<id_t>::_shrinkToFi
 {
     // Update the kernel
     m_ids.shrink_to_fit();
+    m_pos.shrinkToFit();
 
     // Generate the sync action
     ShrinkToFitAction syncAction;
@@ -602,7 +619,7 @@ void PiercedKernel<id_t>::swap(PiercedKernel &other) noexcept
     std::swap(other.m_end_pos, m_end_pos);
     std::swap(other.m_dirty_begin_pos, m_dirty_begin_pos);
     std::swap(other.m_ids, m_ids);
-    std::swap(other.m_pos, m_pos);
+    other.m_pos.swap(m_pos);
     std::swap(other.m_holes, m_holes);
     std::swap(other.m_holes_regular_begin, m_holes_regular_begin);
     std::swap(other.m_holes_regular_end, m_holes_regular_end);
@@ -667,9 +684,9 @@ void PiercedKernel<id_t>::dump() const
     std::cout << std::endl;
     std::cout << " Poistion map: " << std::endl;
     if (size() > 0) {
-        for (auto itr = m_pos.cbegin(); itr != m_pos.cend(); ++itr) {
-            std::cout << itr->first << " -> " << itr->second << std::endl;
-        }
+        m_pos.forEach([](id_t id, std::size_t pos) {
+            std::cout << id << " -> " << pos << std::endl;
+        });
     } else {
         std::cout << "None" << std::endl;
     }
@@ -684,15 +701,13 @@ template<typename id_t>
 void PiercedKernel<id_t>::checkIntegrity() const
 {
     // Check if the elements and their position match
-    for (const auto &entry : m_pos) {
-        id_t id = entry.first;
-        std::size_t pos = entry.second;
+    m_pos.forEach([this](id_t id, std::size_t pos) {
         if (m_ids[pos] != id) {
             std::cout << " Position " << pos << " should contain the element with id " << id << std::endl;
             std::cout << " but it contains the element with id " << m_ids[pos] << std::endl;
             throw std::runtime_error("Integrity check error");
         }
-    }
+    });
 
     for (std::size_t pos = m_begin_pos; pos < m_end_pos; ++pos) {
         id_t id = m_ids[pos];
@@ -797,6 +812,23 @@ bool PiercedKernel<id_t>::isIteratorSlow()
     return (m_dirty_begin_pos < m_end_pos);
 }
 
+/**
+* Checks if the map that links the ids of the elements and their positions
+* is using the dense storage (i.e., positions are stored in a vector indexed
+* by id).
+*
+* The dense storage is used as long as the ids are dense, when the ids
+* become too sparse the kernel automatically falls back to a hash map.
+*
+* \result Return true if the map that links the ids of the elements and
+* their positions is using the dense storage, false otherwise.
+*/
+template<typename id_t>
+bool PiercedKernel<id_t>::isIdMapDense() const
+{
+    return m_pos.isDense();
+}
+
 /**
 * Returns the maximum number of elements that the kernel can hold.
 *
@@ -1077,9 +1109,9 @@ id_t PiercedKernel<id_t>::getSizeMarker(std::size_t targetSize, const id_t &fall
 template<typename id_t>
 typename PiercedKernel<id_t>::const_iterator PiercedKernel<id_t>::find(const id_t &id) const noexcept
 {
-    auto iterator = m_pos.find(id);
-    if (iterator != m_pos.end()) {
-        return rawFind(iterator->second);
+    std::size_t pos = m_pos.find(id);
+    if (pos != PositionMap::NULL_POS) {
+        return rawFind(pos);
     } else {
         return end();
     }
@@ -1376,7 +1408,7 @@ typename PiercedKernel<id_t>::FillAction PiercedKernel<id_t>::fillAppend(id_t id
     setEndPos(rawSize());
 
     // Update the id map
-    m_pos[id] = m_end_pos - 1;
+    m_pos.set(id, m_end_pos - 1);
 
     // Update the storage
     FillAction fillAction(FillAction::TYPE_APPEND);
@@ -1509,10 +1541,10 @@ typename PiercedKernel<id_t>::FillAction PiercedKernel<id_t>::fillInsert(std::si
     for (std::size_t i = pos + 1; i < m_end_pos; ++i) {
         id_t id_i = m_ids[i];
         if (id_i >= 0) {
-            m_pos[id_i] = i;
+            m_pos.set(id_i, i);
         }
     }
-    m_pos[id] = pos;
+    m_pos.set(id, pos);
 
     // Update the regular holes
     if (m_holes_regular_begin != m_holes_regular_end) {
@@ -2261,7 +2293,7 @@ template<typename id_t>
 void PiercedKernel<id_t>::setPosId(std::size_t pos, id_t id)
 {
     m_ids[pos] = id;
-    m_pos[id]  = pos;
+    m_pos.set(id, pos);
 }
 
 /**
@@ -2326,7 +2358,7 @@ template<typename id_t>
 void PiercedKernel<id_t>::swapPosIds(std::size_t pos_1, id_t id_1, std::size_t pos_2, id_t id_2)
 {
     std::swap(m_ids[pos_1], m_ids[pos_2]);
-    std::swap(m_pos[id_1], m_pos[id_2]);
+    m_pos.swapPositions(id_1, id_2);
 }
 
 /**
@@ -2431,7 +2463,7 @@ void PiercedKernel<id_t>::restore(std::istream &stream)
         std::size_t pos;
         utils::binary::read(stream, pos);
 
-        m_pos.insert({id, pos});
+        m_pos.set(id, pos);
     }
 
     // Postions data
@@ -2482,10 +2514,10 @@ void PiercedKernel<id_t>::dump(std::ostream &stream) const
     // Ids data
     std::size_t nIds = m_pos.size();
     utils::binary::write(stream, nIds);
-    for (const auto &entry : m_pos) {
-        utils::binary::write(stream, entry.first);
-        utils::binary::write(stream, entry.second);
-    }
+    m_pos.forEach([&stream](id_t id, std::size_t pos) {
+        utils::binary::write(stream, id);
+        utils::binary::write(stream, pos);
+    });
 
     // Postions data
     std::size_t nPositions = m_ids.size();
@@ -2516,6 +2548,388 @@ void PiercedKernel<id_t>::dump(std::ostream &stream) const
     PiercedSyncMaster::dump(stream);
 }
 
+/**
+* Constructs an empty position map.
+*
+* The map initially uses the dense storage.
+*/
+template<typename id_t>
+PiercedKernel<id_t>::PositionMap::PositionMap()
+    : m_dense(true), m_denseCount(0)
+{
+}
+
+/**
+* Removes all the entries from the map.
+*
+* After being cleared, the map uses the dense storage.
+*
+* \param release if set to true, the memory used by the map is released
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::clear(bool release)
+{
+    m_densePos.clear();
+    m_sparsePos.clear();
+    if (release) {
+        std::vector<std::size_t>().swap(m_densePos);
+        std::unordered_map<id_t, std::size_t, PiercedHasher>().swap(m_sparsePos);
+    }
+
+    m_dense      = true;
+    m_denseCount = 0;
+}
+
+/**
+* Requests a change in capacity.
+*
+* \param n is the expected number of entries of the map
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::reserve(std::size_t n)
+{
+    if (m_dense) {
+        m_densePos.reserve(n);
+    } else {
+        m_sparsePos.reserve(n);
+    }
+}
+
+/**
+* Requests the map to reduce its capacity to fit its size.
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::shrinkToFit()
+{
+    updateStorage();
+
+    if (m_dense) {
+        m_densePos.shrink_to_fit();
+    } else {
+        m_sparsePos.rehash(0);
+    }
+}
+
+/**
+* Selects the storage that best fits the current ids.
+*
+* If the map is using the hash map storage and the ids have become dense
+* enough, the map switches back to the dense storage. The threshold used to
+* switch back is stricter than the one used to fall back to the hash map,
+* this avoids switching storage back and forth when ids are added and
+* removed near the threshold.
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::updateStorage()
+{
+    if (m_dense) {
+        return;
+    }
+
+    std::size_t denseSize = 0;
+    for (const auto &entry : m_sparsePos) {
+        denseSize = std::max(denseSize, static_cast<std::size_t>(entry.first) + 1);
+    }
+
+    std::size_t maxDenseSize = std::max(DENSE_MIN_SIZE, DENSE_RESTORE_SPARSITY * m_sparsePos.size());
+    if (denseSize > maxDenseSize) {
+        return;
+    }
+
+    makeDense();
+}
+
+/**
+* Exchanges the content of the map by the content of the specified map.
+*
+* \param other is another map whose content is swapped with that of this map
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::swap(PositionMap &other) noexcept
+{
+    std::swap(other.m_dense, m_dense);
+    std::swap(other.m_denseCount, m_denseCount);
+    std::swap(other.m_densePos, m_densePos);
+    std::swap(other.m_sparsePos, m_sparsePos);
+}
+
+/**
+* Checks if the map is using the dense storage.
+*
+* \result Returns true if the map is using the dense storage, false otherwise.
+*/
+template<typename id_t>
+bool PiercedKernel<id_t>::PositionMap::isDense() const
+{
+    return m_dense;
+}
+
+/**
+* Checks if the map is empty.
+*
+* \result Returns true if the map is empty, false otherwise.
+*/
+template<typename id_t>
+bool PiercedKernel<id_t>::PositionMap::empty() const
+{
+    return (size() == 0);
+}
+
+/**
+* Gets the number of entries of the map.
+*
+* \result The number of entries of the map.
+*/
+template<typename id_t>
+std::size_t PiercedKernel<id_t>::PositionMap::size() const
+{
+    if (m_dense) {
+        return m_denseCount;
+    } else {
+        return m_sparsePos.size();
+    }
+}
+
+/**
+* Counts the entries with the specified id.
+*
+* \param id is the id to search for
+* \result The number of entries with the specified id (either 0 or 1).
+*/
+template<typename id_t>
+std::size_t PiercedKernel<id_t>::PositionMap::count(id_t id) const
+{
+    return (find(id) != NULL_POS) ? 1 : 0;
+}
+
+/**
+* Gets the position associated with the specified id.
+*
+* \param id is the id to search for
+* \result The position associated with the specified id or NULL_POS if the
+* map doesn't contain the specified id.
+*/
+template<typename id_t>
+std::size_t PiercedKernel<id_t>::PositionMap::find(id_t id) const
+{
+    if (m_dense) {
+        if (isNegative(id) || static_cast<std::size_t>(id) >= m_densePos.size()) {
+            return NULL_POS;
+        }
+
+        return m_densePos[static_cast<std::size_t>(id)];
+    } else {
+        auto itr = m_sparsePos.find(id);
+        if (itr == m_sparsePos.end()) {
+            return NULL_POS;
+        }
+
+        return itr->second;
+    }
+}
+
+/**
+* Gets the position associated with the specified id.
+*
+* If the map doesn't contain the specified id, an exception is thrown.
+*
+* \param id is the id to search for
+* \result The position associated with the specified id.
+*/
+template<typename id_t>
+std::size_t PiercedKernel<id_t>::PositionMap::at(id_t id) const
+{
+    std::size_t pos = find(id);
+    if (pos == NULL_POS) {
+        throw std::out_of_range("Id not found");
+    }
+
+    return pos;
+}
+
+/**
+* Sets the position associated with the specified id.
+*
+* If adding the id to the dense storage would make the storage too sparse,
+* the map falls back to the hash map storage.
+*
+* \param id is the id, it should be a non-negative value
+* \param pos is the position associated with the id
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::set(id_t id, std::size_t pos)
+{
+    assert(!isNegative(id));
+
+    if (m_dense) {
+        std::size_t key = static_cast<std::size_t>(id);
+        if (key >= m_densePos.size()) {
+            std::size_t denseSize    = key + 1;
+            std::size_t maxDenseSize = std::max(DENSE_MIN_SIZE, DENSE_MAX_SPARSITY * (m_denseCount + 1));
+            if (denseSize > maxDenseSize) {
+                makeSparse();
+                m_sparsePos[id] = pos;
+                return;
+            }
+
+            m_densePos.resize(denseSize, NULL_POS);
+        }
+
+        std::size_t &densePos = m_densePos[key];
+        if (densePos == NULL_POS) {
+            ++m_denseCount;
+        }
+        densePos = pos;
+    } else {
+        m_sparsePos[id] = pos;
+    }
+}
+
+/**
+* Removes the entry with the specified id.
+*
+* \param id is the id of the entry to remove
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::erase(id_t id)
+{
+    if (m_dense) {
+        if (isNegative(id) || static_cast<std::size_t>(id) >= m_densePos.size()) {
+            return;
+        }
+
+        std::size_t &densePos = m_densePos[static_cast<std::size_t>(id)];
+        if (densePos == NULL_POS) {
+            return;
+        }
+
+        densePos = NULL_POS;
+        --m_denseCount;
+
+        // Drop the trailing empty entries
+        while (!m_densePos.empty() && m_densePos.back() == NULL_POS) {
+            m_densePos.pop_back();
+        }
+    } else {
+        m_sparsePos.erase(id);
+        if (m_sparsePos.empty()) {
+            clear(false);
+        }
+    }
+}
+
+/**
+* Exchanges the positions associated with the specified ids.
+*
+* Both ids should be contained in the map.
+*
+* \param id_1 is the first id
+* \param id_2 is the second id
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::swapPositions(id_t id_1, id_t id_2)
+{
+    if (m_dense) {
+        std::swap(m_densePos[static_cast<std::size_t>(id_1)], m_densePos[static_cast<std::size_t>(id_2)]);
+    } else {
+        std::swap(m_sparsePos.at(id_1), m_sparsePos.at(id_2));
+    }
+}
+
+/**
+* Calls the specified function for every entry of the map.
+*
+* \param function is the function to call, it will receive the id and the
+* position of the entry
+*/
+template<typename id_t>
+template<typename Function>
+void PiercedKernel<id_t>::PositionMap::forEach(Function function) const
+{
+    if (m_dense) {
+        std::size_t denseSize = m_densePos.size();
+        for (std::size_t key = 0; key < denseSize; ++key) {
+            std::size_t pos = m_densePos[key];
+            if (pos != NULL_POS) {
+                function(static_cast<id_t>(key), pos);
+            }
+        }
+    } else {
+        for (const auto &entry : m_sparsePos) {
+            function(entry.first, entry.second);
+        }
+    }
+}
+
+/**
+* Moves the entries of the map from the dense storage to the hash map
+* storage.
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::makeSparse()
+{
+    if (!m_dense) {
+        return;
+    }
+
+    m_sparsePos.reserve(m_denseCount + 1);
+    forEach([this](id_t id, std::size_t pos) {
+        m_sparsePos.insert({id, pos});
+    });
+
+    std::vector<std::size_t>().swap(m_densePos);
+    m_denseCount = 0;
+    m_dense      = false;
+}
+
+/**
+* Moves the entries of the map from the hash map storage to the dense
+* storage.
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::PositionMap::makeDense()
+{
+    if (m_dense) {
+        return;
+    }
+
+    std::size_t denseSize = 0;
+    for (const auto &entry : m_sparsePos) {
+        denseSize = std::max(denseSize, static_cast<std::size_t>(entry.first) + 1);
+    }
+
+    m_densePos.assign(denseSize, NULL_POS);
+    for (const auto &entry : m_sparsePos) {
+        m_densePos[static_cast<std::size_t>(entry.first)] = entry.second;
+    }
+
+    m_denseCount = m_sparsePos.size();
+    m_dense      = true;
+
+    std::unordered_map<id_t, std::size_t, PiercedHasher>().swap(m_sparsePos);
+}
+
+/**
+* Checks if the specified id is negative.
+*
+* Unsigned ids are never negative, the check is skipped for them to avoid
+* comparisons that are always false.
+*
+* \param id is the id to check
+* \result Returns true if the id is negative, false otherwise.
+*/
+template<typename id_t>
+bool PiercedKernel<id_t>::PositionMap::isNegative(id_t id)
+{
+    if constexpr (std::is_signed<id_t>::value) {
+        return (id < 0);
+    } else {
+        BITPIT_UNUSED(id);
+
+        return false;
+    }
+}
+
 }
 
 #endif
@@ -219,6 +219,43 @@ PiercedSyncMaster::PiercedSyncMaster()
     }
 }
 
+/**
+* Copy constructor.
+*
+* Slaves are not copied: a slave can be synchronized with a single master,
+* hence slaves registered with the other master are not registered with
+* this master.
+*
+* \param other is another master whose content is copied in this master
+*/
+PiercedSyncMaster::PiercedSyncMaster(const PiercedSyncMaster &other)
+    : PiercedSyncMaster()
+{
+    BITPIT_UNUSED(other);
+}
+
+/**
+* Copy assignment operator.
+*
+* Slaves are not copied: a slave can be synchronized with a single master,
+* hence slaves registered with the other master are not registered with
+* this master. A master with registered slaves cannot be assigned: after
+* the assignment the contents of the master would be replaced without
+* notifying the slaves, that would therefore be out-of-sync.
+*
+* \param other is another master whose content is copied in this master
+*/
+PiercedSyncMaster & PiercedSyncMaster::operator=(const PiercedSyncMaster &other)
+{
+    BITPIT_UNUSED(other);
+
+    if (!m_slaves.empty()) {
+        throw std::logic_error("Unable to assign a master with registered slaves");
+    }
+
+    return *this;
+}
+
 /**
 * Exchanges the content of the kernel by the content of x, which is another
 * kernel object of the same type. Sizes may differ.
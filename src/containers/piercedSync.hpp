@@ -164,6 +164,11 @@ protected:
     mutable std::unordered_map<PiercedSyncSlave *, SyncMode> m_slaves;
 
     PiercedSyncMaster();
+    PiercedSyncMaster(const PiercedSyncMaster &other);
+    PiercedSyncMaster(PiercedSyncMaster &&other) = default;
+
+    PiercedSyncMaster & operator=(const PiercedSyncMaster &other);
+    PiercedSyncMaster & operator=(PiercedSyncMaster &&other) = default;
 
     void registerSlave(PiercedSyncSlave *slave, PiercedSyncMaster::SyncMode syncMode) const;
     void unregisterSlave(const PiercedSyncSlave *slave) const;
@@ -218,7 +218,12 @@ void LineUnstructured::_restore(std::istream &stream)
  * If the point is not inside the patch, the function returns the id of the
  * null element.
  *
- * NOTE: this function is not implemented yet.
+ * A point is considered inside a cell if its distance from the cell is
+ * below the geometrical tolerance of the patch.
+ *
+ * The point is located using a LineSkdTree that is built the first time a
+ * point is located and that is kept until the cells of the patch are
+ * altered.
  *
  * \param[in] point is the point to be checked
  * \result Returns the linear id of the cell the contains the point. If the
@@ -227,11 +232,55 @@ void LineUnstructured::_restore(std::istream &stream)
  */
 long LineUnstructured::locatePoint(const std::array<double, 3> &point) const
 {
-    BITPIT_UNUSED(point);
+    return getLocationTree().locatePoint(point);
+}
+
+/*!
+ * Locates the cells that contain the specified points.
+ *
+ * \param[in] nPoints is the number of the points
+ * \param[in] points are the points coordinates
+ * \param[out] ids on output it will contain the ids of the cells that contain
+ * the points. If a point is not inside the patch, the related id will be set
+ * to the null id
+ */
+void LineUnstructured::locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const
+{
+    getLocationTree().locatePoint(nPoints, points, ids);
+}
 
-    throw std::runtime_error ("The function 'locatePoint' is not implemented yet");
+#if BITPIT_ENABLE_MPI==1
+/*!
+ * Given the specified points, considered distributed on the processes, locate
+ * the cells that contain them.
+ *
+ * Points are located among the interior cells of all the partitions. This is
+ * a collective function and it has to be called by all the processes of the
+ * patch.
+ *
+ * \param[in] nPoints is the number of the points
+ * \param[in] points are the points coordinates
+ * \param[out] ids on output it will contain the ids of the cells that contain
+ * the points. If a point is not inside the patch, the related id will be set
+ * to the null id
+ * \param[out] ranks on output it will contain the rank indices of the processes
+ * owner of the cells that contain the points. If a point is not inside the
+ * patch, the related rank will be set to -1
+ */
+void LineUnstructured::locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const
+{
+    getLocationTree().locateGlobalPoint(nPoints, points, ids, ranks);
+}
+#endif
 
-    return false;
+/*!
+ * Creates the tree used for locating points in the patch.
+ *
+ * \result The tree used for locating points in the patch.
+ */
+std::unique_ptr<PatchSkdTree> LineUnstructured::_createLocationTree() const
+{
+    return std::unique_ptr<PatchSkdTree>(new LineSkdTree(this));
 }
 
 /*!
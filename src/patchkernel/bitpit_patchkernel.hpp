@@ -40,10 +40,12 @@
 
 
 #include "line_kernel.hpp"
+#include "line_skd_tree.hpp"
 #include "patch_info.hpp"
 #include "patch_kernel.hpp"
 #include "patch_manager.hpp"
 #include "point_kernel.hpp"
+#include "point_skd_tree.hpp"
 #include "surface_kernel.hpp"
 #include "surface_skd_tree.hpp"
 #include "volume_kernel.hpp"
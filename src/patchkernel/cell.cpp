@@ -77,6 +77,58 @@ OBinaryStream& operator<<(OBinaryStream  &buffer, const Cell &cell)
 	return buffer;
 }
 
+/*!
+	\class CellNeighbourhoodPoolScope
+	\ingroup patchelements
+
+	\brief The CellNeighbourhoodPoolScope class selects the pool used by the
+	calling thread for storing the adjacencies and the interfaces of the
+	cells.
+
+	While a scope is alive, neighbourhood storage allocated by the calling
+	thread is taken from the pool of the scope. When the scope is destroyed,
+	the pool that was active before the scope was created is restored. If no
+	scope is alive, neighbourhood storage is allocated from the heap.
+*/
+
+namespace {
+
+thread_local std::pmr::memory_resource *cellNeighbourhoodActivePool = nullptr;
+
+}
+
+/*!
+	Creates a new scope.
+
+	\param pool is the pool that will be used inside the scope, if a null
+	pointer is specified, neighbourhood storage will be allocated from the
+	heap
+*/
+CellNeighbourhoodPoolScope::CellNeighbourhoodPoolScope(std::pmr::memory_resource *pool)
+	: m_previousPool(cellNeighbourhoodActivePool)
+{
+	cellNeighbourhoodActivePool = pool;
+}
+
+/*!
+	Destroys the scope, restoring the previously active pool.
+*/
+CellNeighbourhoodPoolScope::~CellNeighbourhoodPoolScope()
+{
+	cellNeighbourhoodActivePool = m_previousPool;
+}
+
+/*!
+	Gets the pool currently active for the calling thread.
+
+	\result The pool currently active for the calling thread, or a null
+	pointer if neighbourhood storage should be allocated from the heap.
+*/
+std::pmr::memory_resource * CellNeighbourhoodPoolScope::getActivePool() noexcept
+{
+	return cellNeighbourhoodActivePool;
+}
+
 /*!
 	\class Cell
 	\ingroup patchelements
@@ -96,19 +148,19 @@ OBinaryStream& operator<<(OBinaryStream  &buffer, const Cell &cell)
 	\param storeNeighbourhood defines if the cell should store neighbourhood
 	information
 */
-bitpit::FlatVector2D<long> Cell::createNeighbourhoodStorage(bool storeNeighbourhood)
+Cell::NeighbourhoodStorage Cell::createNeighbourhoodStorage(bool storeNeighbourhood)
 {
 	ElementType type = getType();
 	if (!storeNeighbourhood || type == ElementType::UNDEFINED) {
-		return bitpit::FlatVector2D<long>(false);
+		return NeighbourhoodStorage(false);
 	}
 
 	int nFaces = getFaceCount();
 	if (nFaces <= 0) {
-		return bitpit::FlatVector2D<long>(false);
+		return NeighbourhoodStorage(false);
 	}
 
-	return bitpit::FlatVector2D<long>(nFaces, 0);
+	return NeighbourhoodStorage(nFaces, 0);
 }
 
 /*!
@@ -387,6 +439,28 @@ void Cell::setInterior(bool interior)
 	m_interior = interior;
 }
 
+/*!
+	Reallocates the adjacencies and the interfaces of the cell.
+
+	The storage is reallocated using the neighbourhood pool that is active
+	for the calling thread (see CellNeighbourhoodPoolScope), the contents
+	of the storage are preserved.
+*/
+void Cell::relocateNeighbourhood()
+{
+	if (m_interfaces.isInitialized()) {
+		NeighbourhoodStorage interfaces(false);
+		interfaces.initialize(m_interfaces);
+		m_interfaces.swap(interfaces);
+	}
+
+	if (m_adjacencies.isInitialized()) {
+		NeighbourhoodStorage adjacencies(false);
+		adjacencies.initialize(m_adjacencies);
+		m_adjacencies.swap(adjacencies);
+	}
+}
+
 /*!
 	Gets if the cell belongs to the the interior domain.
 
@@ -463,7 +537,7 @@ void Cell::setInterfaces(const std::vector<std::vector<long>> &interfaces)
 
 	\param interfaces the list of all interfaces associated to the cell
 */
-void Cell::setInterfaces(FlatVector2D<long> &&interfaces)
+void Cell::setInterfaces(NeighbourhoodStorage &&interfaces)
 {
 	if (getType() == ElementType::UNDEFINED) {
 	    return;
@@ -474,6 +548,22 @@ void Cell::setInterfaces(FlatVector2D<long> &&interfaces)
 	m_interfaces.swap(interfaces);
 }
 
+/*!
+	Sets all the interfaces of the cell.
+
+	\param interfaces the list of all interfaces associated to the cell
+*/
+void Cell::setInterfaces(const FlatVector2D<long> &interfaces)
+{
+	if (getType() == ElementType::UNDEFINED) {
+	    return;
+	}
+
+	assert((int) m_interfaces.size() == getFaceCount());
+	assert((int) interfaces.size() == getFaceCount());
+	m_interfaces.initialize(interfaces);
+}
+
 /*!
 	Sets the i-th interface associated the the given face of the cell.
 
@@ -733,7 +823,7 @@ void Cell::setAdjacencies(const std::vector<std::vector<long>> &adjacencies)
 
 	\param adjacencies the list of all adjacencies associated to the cell
 */
-void Cell::setAdjacencies(FlatVector2D<long> &&adjacencies)
+void Cell::setAdjacencies(NeighbourhoodStorage &&adjacencies)
 {
 	if (getType() == ElementType::UNDEFINED) {
 	    return;
@@ -744,6 +834,22 @@ void Cell::setAdjacencies(FlatVector2D<long> &&adjacencies)
 	m_adjacencies.swap(adjacencies);
 }
 
+/*!
+	Sets all the adjacencies of the cell.
+
+	\param adjacencies the list of all adjacencies associated to the cell
+*/
+void Cell::setAdjacencies(const FlatVector2D<long> &adjacencies)
+{
+	if (getType() == ElementType::UNDEFINED) {
+	    return;
+	}
+
+	assert((int) m_adjacencies.size() == getFaceCount());
+	assert((int) adjacencies.size() == getFaceCount());
+	m_adjacencies.initialize(adjacencies);
+}
+
 /*!
 	Sets the i-th adjacency associated the the given face of the cell.
 
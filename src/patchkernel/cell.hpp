@@ -25,7 +25,9 @@
 #ifndef __BITPIT_CELL_HPP__
 #define __BITPIT_CELL_HPP__
 
+#include <algorithm>
 #include <memory>
+#include <memory_resource>
 
 #include "bitpit_containers.hpp"
 
@@ -39,6 +41,53 @@ class PatchKernel;
 IBinaryStream & operator>>(IBinaryStream &buf, Cell& cell);
 OBinaryStream & operator<<(OBinaryStream &buf, const Cell& cell);
 
+class CellNeighbourhoodPoolScope {
+
+public:
+	CellNeighbourhoodPoolScope(std::pmr::memory_resource *pool);
+	~CellNeighbourhoodPoolScope();
+
+	CellNeighbourhoodPoolScope(const CellNeighbourhoodPoolScope &other) = delete;
+	CellNeighbourhoodPoolScope & operator=(const CellNeighbourhoodPoolScope &other) = delete;
+
+	static std::pmr::memory_resource * getActivePool() noexcept;
+
+private:
+	std::pmr::memory_resource *m_previousPool;
+
+};
+
+template<typename T>
+class CellNeighbourhoodAllocator {
+
+public:
+	typedef T value_type;
+
+	typedef std::true_type is_always_equal;
+
+	template<typename U>
+	struct rebind {
+		typedef CellNeighbourhoodAllocator<U> other;
+	};
+
+	CellNeighbourhoodAllocator() noexcept = default;
+	template<typename U>
+	CellNeighbourhoodAllocator(const CellNeighbourhoodAllocator<U> &other) noexcept;
+
+	T * allocate(std::size_t n);
+	void deallocate(T *storage, std::size_t n);
+
+private:
+	static const std::size_t HEADER_SIZE;
+	static const std::size_t BLOCK_ALIGNMENT;
+
+};
+
+template<typename T, typename U>
+bool operator==(const CellNeighbourhoodAllocator<T> &lhs, const CellNeighbourhoodAllocator<U> &rhs) noexcept;
+template<typename T, typename U>
+bool operator!=(const CellNeighbourhoodAllocator<T> &lhs, const CellNeighbourhoodAllocator<U> &rhs) noexcept;
+
 class Cell : public Element {
 
 friend class PatchKernel;
@@ -47,6 +96,8 @@ friend OBinaryStream& (operator<<) (OBinaryStream& buf, const Cell& cell);
 friend IBinaryStream& (operator>>) (IBinaryStream& buf, Cell& cell);
 
 public:
+	typedef bitpit::FlatVector2D<long, CellNeighbourhoodAllocator<long>> NeighbourhoodStorage;
+
 	Cell();
 	BITPIT_DEPRECATED(Cell(long id, ElementType type, bool interior, bool storeNeighbourhood));
 	BITPIT_DEPRECATED(Cell(long id, ElementType type, int connectSize, bool interior, bool storeNeighbourhood));
@@ -69,7 +120,8 @@ public:
 	void deleteInterfaces();
 	void resetInterfaces(bool storeInterfaces = true);
 	void setInterfaces(const std::vector<std::vector<long>> &interfaces);
-	void setInterfaces(FlatVector2D<long> &&interfaces);
+	void setInterfaces(NeighbourhoodStorage &&interfaces);
+	void setInterfaces(const FlatVector2D<long> &interfaces);
 	void setInterface(int face, int index, long interface);
 	bool pushInterface(int face, long interface);
 	void deleteInterface(int face, int i);
@@ -86,7 +138,8 @@ public:
 	void deleteAdjacencies();
 	void resetAdjacencies(bool storeAdjacencies = true);
 	void setAdjacencies(const std::vector<std::vector<long>> &adjacencies);
-	void setAdjacencies(FlatVector2D<long> &&adjacencies);
+	void setAdjacencies(NeighbourhoodStorage &&adjacencies);
+	void setAdjacencies(const FlatVector2D<long> &adjacencies);
 	void setAdjacency(int face, int index, long adjacencies);
 	bool pushAdjacency(int face, long adjacency);
 	void deleteAdjacency(int face, int i);
@@ -108,14 +161,15 @@ public:
 
 protected:
 	void setInterior(bool interior);
+	void relocateNeighbourhood();
 
 private:
-	bitpit::FlatVector2D<long> m_interfaces;
-	bitpit::FlatVector2D<long> m_adjacencies;
+	NeighbourhoodStorage m_interfaces;
+	NeighbourhoodStorage m_adjacencies;
 
 	bool m_interior;
 
-	bitpit::FlatVector2D<long> createNeighbourhoodStorage(bool storeNeighbourhood);
+	NeighbourhoodStorage createNeighbourhoodStorage(bool storeNeighbourhood);
 
 	void _initialize(bool interior, bool initializeInterfaces, bool storeInterfaces, bool initializeAdjacency, bool storeAdjacencies);
 
@@ -140,6 +194,7 @@ public:
 	typedef typename ElementHalfFace<QualifiedCell>::Winding Winding;
 
 	QualifiedCellHalfFace(QualifiedCell &cell, int face, Winding winding = Winding::WINDING_NATURAL);
+	QualifiedCellHalfFace(QualifiedCell &cell, int face, ConstProxyVector<long> &&vertexIds, Winding winding = Winding::WINDING_NATURAL);
 
 	QualifiedCell & getCell() const;
 
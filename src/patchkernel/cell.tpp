@@ -27,6 +27,118 @@
 
 namespace bitpit {
 
+/*!
+	\class CellNeighbourhoodAllocator
+	\ingroup patchelements
+
+	\brief The CellNeighbourhoodAllocator class is the allocator used by the
+	cells for storing adjacencies and interfaces.
+
+	The allocator is stateless: storage is taken from the pool that is active
+	for the calling thread (see CellNeighbourhoodPoolScope) or, when no pool
+	is active, from the heap. Each block starts with a small header that
+	records where the block comes from, hence storage can be released
+	regardless of the pool active when the release takes place.
+*/
+
+/*!
+	Size of the header stored at the beginning of each block.
+*/
+template<typename T>
+const std::size_t CellNeighbourhoodAllocator<T>::HEADER_SIZE = std::max(sizeof(std::pmr::memory_resource *), alignof(T));
+
+/*!
+	Alignment of the blocks.
+*/
+template<typename T>
+const std::size_t CellNeighbourhoodAllocator<T>::BLOCK_ALIGNMENT = std::max(alignof(std::pmr::memory_resource *), alignof(T));
+
+/*!
+	Creates a new allocator.
+
+	\param other is another allocator
+*/
+template<typename T>
+template<typename U>
+CellNeighbourhoodAllocator<T>::CellNeighbourhoodAllocator(const CellNeighbourhoodAllocator<U> &other) noexcept
+{
+	BITPIT_UNUSED(other);
+}
+
+/*!
+	Allocates storage for the specified number of objects.
+
+	\param n is the number of objects
+	\result A pointer to the allocated storage.
+*/
+template<typename T>
+T * CellNeighbourhoodAllocator<T>::allocate(std::size_t n)
+{
+	std::size_t blockSize = HEADER_SIZE + n * sizeof(T);
+
+	std::pmr::memory_resource *pool = CellNeighbourhoodPoolScope::getActivePool();
+	void *block;
+	if (pool) {
+		block = pool->allocate(blockSize, BLOCK_ALIGNMENT);
+	} else {
+		block = ::operator new(blockSize);
+	}
+
+	*static_cast<std::pmr::memory_resource **>(block) = pool;
+
+	return reinterpret_cast<T *>(static_cast<char *>(block) + HEADER_SIZE);
+}
+
+/*!
+	Releases the specified storage.
+
+	\param storage is the storage to release
+	\param n is the number of objects the storage was allocated for
+*/
+template<typename T>
+void CellNeighbourhoodAllocator<T>::deallocate(T *storage, std::size_t n)
+{
+	void *block = reinterpret_cast<char *>(storage) - HEADER_SIZE;
+
+	std::pmr::memory_resource *pool = *static_cast<std::pmr::memory_resource **>(block);
+	if (pool) {
+		pool->deallocate(block, HEADER_SIZE + n * sizeof(T), BLOCK_ALIGNMENT);
+	} else {
+		::operator delete(block);
+	}
+}
+
+/*!
+	Checks if two allocators are equal.
+
+	Allocators are stateless, hence they are always equal.
+
+	\param lhs is the first allocator
+	\param rhs is the second allocator
+	\result Returns always true.
+*/
+template<typename T, typename U>
+bool operator==(const CellNeighbourhoodAllocator<T> &lhs, const CellNeighbourhoodAllocator<U> &rhs) noexcept
+{
+	BITPIT_UNUSED(lhs);
+	BITPIT_UNUSED(rhs);
+
+	return true;
+}
+
+/*!
+	Checks if two allocators are different.
+
+	\param lhs is the first allocator
+	\param rhs is the second allocator
+	\result Returns always false.
+*/
+template<typename T, typename U>
+bool operator!=(const CellNeighbourhoodAllocator<T> &lhs, const CellNeighbourhoodAllocator<U> &rhs) noexcept
+{
+	return !(lhs == rhs);
+}
+
 /*!
 	\class CellHalfEdge
 	\ingroup patchelements
@@ -85,6 +197,20 @@ QualifiedCellHalfFace<QualifiedCell>::QualifiedCellHalfFace(QualifiedCell &cell,
 {
 }
 
+/*!
+	Constructor.
+
+	\param cell is a reference to the cell the owns the face
+	\param face if the local face of the cell
+	\param vertexIds are the vertex ids of the face
+	\param winding is the winding order of the vertices
+*/
+template<class QualifiedCell>
+QualifiedCellHalfFace<QualifiedCell>::QualifiedCellHalfFace(QualifiedCell &cell, int face, ConstProxyVector<long> &&vertexIds, Winding winding)
+    : ElementHalfFace<QualifiedCell>(cell, face, std::move(vertexIds), winding)
+{
+}
+
 /*!
 	Get the element the half-item belongs to.
 
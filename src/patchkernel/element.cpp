@@ -23,6 +23,7 @@
 \*---------------------------------------------------------------------------*/
 
 #include <cassert>
+#include <cstdint>
 #include <limits>
 #include <set>
 
@@ -60,7 +61,7 @@ IBinaryStream& operator>>(IBinaryStream &buffer, Element &element)
 	}
 
 	// Set connectivity
-	buffer.read(reinterpret_cast<char *>(element.m_connect.get()), connectSize * sizeof(long));
+	buffer.read(reinterpret_cast<char *>(element.getConnect()), connectSize * sizeof(long));
 
 	// Set PID
 	int pid;
@@ -88,7 +89,7 @@ OBinaryStream& operator<<(OBinaryStream  &buffer, const Element &element)
 		buffer << connectSize;
 	}
 
-	buffer.write(reinterpret_cast<const char *>(element.m_connect.get()), connectSize * sizeof(long));
+	buffer.write(reinterpret_cast<const char *>(element.getConnect()), connectSize * sizeof(long));
 
 	buffer << element.getPID();
 
@@ -319,6 +320,56 @@ std::vector<std::array<double, 3>> Element::Tesselation::getTileVertexCoordinate
 
 const long Element::NULL_ID = std::numeric_limits<long>::min();
 
+/*!
+	Releases the specified connectivity storage, unless it is an external
+	storage.
+
+	\param connect is the connectivity storage
+*/
+void Element::ConnectDeleter::operator()(long *connect) const
+{
+	if (!isExternalConnect(connect)) {
+		delete[] connect;
+	}
+}
+
+/*!
+	Marks the specified connectivity storage as external.
+
+	\param connect is the connectivity storage
+	\result The tagged pointer to the connectivity storage.
+*/
+long * Element::tagExternalConnect(long *connect)
+{
+	static_assert(alignof(long) > 1, "Connectivity storage is not aligned");
+	assert((reinterpret_cast<std::uintptr_t>(connect) & 1) == 0);
+
+	return reinterpret_cast<long *>(reinterpret_cast<std::uintptr_t>(connect) | 1);
+}
+
+/*!
+	Removes the external mark from the specified connectivity storage.
+
+	\param connect is the (possibly tagged) connectivity storage
+	\result The pointer to the connectivity storage.
+*/
+long * Element::untagConnect(long *connect)
+{
+	return reinterpret_cast<long *>(reinterpret_cast<std::uintptr_t>(connect) & ~static_cast<std::uintptr_t>(1));
+}
+
+/*!
+	Checks if the specified connectivity storage is marked as external.
+
+	\param connect is the (possibly tagged) connectivity storage
+	\result Returns true if the storage is marked as external, false
+	otherwise.
+*/
+bool Element::isExternalConnect(const long *connect)
+{
+	return ((reinterpret_cast<std::uintptr_t>(connect) & 1) != 0);
+}
+
 /*!
 	Default constructor.
 */
@@ -372,7 +423,7 @@ Element::Element(const Element &other)
 	m_pid = other.m_pid;
 
 	if (other.m_connect) {
-		std::copy(other.m_connect.get(), other.m_connect.get() + connectSize, m_connect.get());
+		std::copy(other.getConnect(), other.getConnect() + connectSize, getConnect());
 	}
 }
 
@@ -453,15 +504,16 @@ void Element::_initialize(long id, ElementType type, int connectSize)
 		connectSize = ReferenceElementInfo::getInfo(type).nVertices;
 	}
 
-	std::unique_ptr<long[]> connectStorage;
+	//
+	// If the size of the connectivity doesn't change, the current storage is
+	// kept (it may be an external storage).
 	if (connectSize != previousConnectSize) {
-		connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+		_initialize(id, type, std::unique_ptr<long[]>(new long[connectSize]));
 	} else {
-		connectStorage = std::move(m_connect);
+		setId(id);
+		setType(type);
+		setPID(0);
 	}
-
-	// Initialize element
-	_initialize(id, type, std::move(connectStorage));
 }
 
 /*!
@@ -590,7 +642,28 @@ int Element::getPID() const
 */
 void Element::setConnect(std::unique_ptr<long[]> &&connect)
 {
-	m_connect = std::move(connect);
+	m_connect = std::unique_ptr<long[], ConnectDeleter>(connect.release());
+}
+
+/*!
+	Sets an external vertex connectivity for the element.
+
+	The element will not take the ownership of the storage, it's up to the
+	caller to guarantee that the storage outlives the element (or, at least,
+	that it outlives the time the element points to it) and to release it
+	when it is no longer needed. The size of the storage should be at least
+	equal to the connectivity size of the element.
+
+	\param connect a pointer to the external connectivity of the element
+*/
+void Element::setExternalConnect(long *connect)
+{
+	if (!connect) {
+		m_connect.reset(nullptr);
+		return;
+	}
+
+	m_connect = std::unique_ptr<long[], ConnectDeleter>(tagExternalConnect(connect));
 }
 
 /*!
@@ -601,6 +674,18 @@ void Element::unsetConnect()
 	m_connect.reset(nullptr);
 }
 
+/*!
+	Checks if the vertex connectivity of the element is stored in an external
+	storage (i.e., a storage not owned by the element).
+
+	\result Returns true if the vertex connectivity of the element is stored in
+	an external storage, false otherwise.
+*/
+bool Element::hasExternalConnect() const
+{
+	return isExternalConnect(m_connect.get());
+}
+
 /*!
 	Gets the vertex connectivity of the element.
 
@@ -608,7 +693,7 @@ void Element::unsetConnect()
 */
 const long * Element::getConnect() const
 {
-	return m_connect.get();
+	return untagConnect(m_connect.get());
 }
 
 /*!
@@ -618,7 +703,7 @@ const long * Element::getConnect() const
 */
 long * Element::getConnect()
 {
-	return m_connect.get();
+	return untagConnect(m_connect.get());
 }
 
 /*!
@@ -1331,6 +1416,58 @@ ConstProxyVector<long> Element::getFaceVertexIds(int face) const
 	return vertexIds;
 }
 
+/*!
+	Gets the list of vertex ids for the specified face of the element.
+
+	Vertex ids are read directly from the connectivity of the element, no
+	temporary storage is allocated. This allows to call the function from
+	multiple threads at the same time.
+
+	\param face is the face for which the vertex ids is reqested
+	\param[out] vertexIds on output will contain the vertex ids of the face,
+	the array should be large enough to contain getFaceVertexCount(face) ids
+*/
+void Element::getFaceVertexIds(int face, long *vertexIds) const
+{
+	const long *connectivity = getConnect();
+
+	switch (m_type) {
+
+	case (ElementType::POLYGON):
+	{
+		int nVertices = countPolygonVertices(connectivity);
+
+		vertexIds[0] = connectivity[1 + face];
+		vertexIds[1] = connectivity[1 + (face + 1) % nVertices];
+
+		break;
+	}
+
+	case (ElementType::POLYHEDRON):
+	{
+		int facePos       = getFaceStreamPosition(connectivity, face);
+		int nFaceVertices = static_cast<int>(connectivity[facePos]);
+		std::copy_n(connectivity + facePos + 1, nFaceVertices, vertexIds);
+
+		break;
+	}
+
+	default:
+	{
+		assert(m_type != ElementType::UNDEFINED);
+
+		int nFaceVertices = getFaceVertexCount(face);
+		const int *localFaceConnect = getInfo().faceConnectStorage[face].data();
+		for (int k = 0; k < nFaceVertices; ++k) {
+			vertexIds[k] = connectivity[localFaceConnect[k]];
+		}
+
+		break;
+	}
+
+	}
+}
+
 /*!
 	Gets the vertex id of the specified local vertex in the given face of
 	the element.
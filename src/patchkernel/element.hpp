@@ -117,7 +117,9 @@ public:
 	bool isThreeDimensional() const;
 	
 	void setConnect(std::unique_ptr<long[]> &&connect);
+	void setExternalConnect(long *connect);
 	void unsetConnect();
+	bool hasExternalConnect() const;
 	int getConnectSize() const;
 	const long * getConnect() const;
 	long * getConnect();
@@ -129,6 +131,7 @@ public:
 	ConstProxyVector<int> getFaceLocalConnect(int face) const;
 	ConstProxyVector<long> getFaceConnect(int face) const;
 	ConstProxyVector<long> getFaceVertexIds(int face) const;
+	void getFaceVertexIds(int face, long *vertexIds) const;
 	long getFaceVertexId(int face, int vertex) const;
 	ConstProxyVector<int> getFaceLocalVertexIds(int face) const;
 
@@ -201,13 +204,30 @@ private:
 	static int countPolygonFaces(const long *connectivity);
 	static int countPolyhedronFaces(const long *connectivity);
 
+	/*!
+		Deleter for the connectivity storage.
+
+		The connectivity storage may be owned by the element or it may
+		be provided by an external entity (e.g., the connectivity arena
+		of a patch). External storage is marked setting the lowest bit
+		of the stored pointer, which is always zero for a properly
+		aligned storage, and it is not released by the element.
+	*/
+	struct ConnectDeleter {
+		void operator()(long *connect) const;
+	};
+
+	static long * tagExternalConnect(long *connect);
+	static long * untagConnect(long *connect);
+	static bool isExternalConnect(const long *connect);
+
 	long m_id; //!< Is the id that identifies the element
 
 	ElementType m_type;
 
 	int m_pid; //!< Is the part id associated with the element
 
-	std::unique_ptr<long[]> m_connect;
+	std::unique_ptr<long[], ConnectDeleter> m_connect;
 
 	void _initialize(long id, ElementType type = ElementType::UNDEFINED, int connectSize = 0);
 	void _initialize(long id, ElementType type, std::unique_ptr<long[]> &&connectStorage);
@@ -280,6 +300,7 @@ protected:
 	int m_face;
 
 	ElementHalfFace(DerivedElement &element, int face, Winding winding);
+	ElementHalfFace(DerivedElement &element, int face, ConstProxyVector<long> &&vertexIds, Winding winding);
 
 };
 
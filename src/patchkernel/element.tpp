@@ -260,6 +260,21 @@ ElementHalfFace<DerivedElement>::ElementHalfFace(DerivedElement &element, int fa
 {
 }
 
+/*!
+	Constructor.
+
+	\param element is a reference to the element the owns the face
+	\param face if the local face of the element
+	\param vertexIds are the vertex ids of the face
+	\param winding is the winding order of the vertexIds
+*/
+template<class DerivedElement>
+ElementHalfFace<DerivedElement>::ElementHalfFace(DerivedElement &element, int face, ConstProxyVector<long> &&vertexIds, Winding winding)
+    : ElementHalfItem<DerivedElement>(element, std::move(vertexIds), winding),
+      m_face(face)
+{
+}
+
 /*!
 	Get the local face index.
 
@@ -0,0 +1,42 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+# ifndef __BITPIT_LINE_SKD_TREE_HPP__
+# define __BITPIT_LINE_SKD_TREE_HPP__
+
+#include "patch_skd_tree.hpp"
+#include "line_kernel.hpp"
+
+namespace bitpit {
+
+class LineSkdTree : public PatchSkdTree {
+
+public:
+    LineSkdTree(const LineKernel *patch, bool interiorCellsOnly = false);
+
+};
+
+}
+
+#endif
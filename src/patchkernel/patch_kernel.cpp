@@ -29,6 +29,9 @@
 #if BITPIT_ENABLE_MPI==1
 #	include <mpi.h>
 #endif
+#if BITPIT_ENABLE_OPENMP==1
+#	include <omp.h>
+#endif
 
 #include "bitpit_CG.hpp"
 #include "bitpit_common.hpp"
@@ -36,6 +39,7 @@
 #include "patch_info.hpp"
 #include "patch_kernel.hpp"
 #include "patch_manager.hpp"
+#include "patch_skd_tree.hpp"
 
 namespace bitpit {
 
@@ -216,6 +220,7 @@ PatchKernel::PatchKernel(const PatchKernel &other)
       m_interfaces(other.m_interfaces),
       m_alteredCells(other.m_alteredCells),
       m_alteredInterfaces(other.m_alteredInterfaces),
+      m_movedVertices(other.m_movedVertices),
       m_nInternalVertices(other.m_nInternalVertices),
 #if BITPIT_ENABLE_MPI==1
       m_nGhostVertices(other.m_nGhostVertices),
@@ -280,6 +285,15 @@ PatchKernel::PatchKernel(const PatchKernel &other)
 	importInterfaceIndexGenerator(other);
 	importCellIndexGenerator(other);
 
+	// Create the connectivity arena
+	//
+	// Copied cells own their connectivity, if the connectivity arena of
+	// the source patch was enabled, the connectivity of the cells is moved
+	// into the arena of this patch.
+	if (other.isCellConnectArenaEnabled()) {
+		setCellConnectArena(true);
+	}
+
 	// Register the patch
 	patch::manager().registerPatch(this);
 
@@ -294,14 +308,17 @@ PatchKernel::PatchKernel(const PatchKernel &other)
 */
 PatchKernel::PatchKernel(PatchKernel &&other)
     : VTKBaseStreamer(std::move(other)),
+      m_cellNeighbourhoodPool(std::move(other.m_cellNeighbourhoodPool)),
       m_vertices(std::move(other.m_vertices)),
       m_cells(std::move(other.m_cells)),
       m_interfaces(std::move(other.m_interfaces)),
       m_alteredCells(std::move(other.m_alteredCells)),
       m_alteredInterfaces(std::move(other.m_alteredInterfaces)),
+      m_movedVertices(std::move(other.m_movedVertices)),
       m_vertexIdGenerator(std::move(other.m_vertexIdGenerator)),
       m_interfaceIdGenerator(std::move(other.m_interfaceIdGenerator)),
       m_cellIdGenerator(std::move(other.m_cellIdGenerator)),
+      m_cellConnectArena(std::move(other.m_cellConnectArena)),
       m_nInternalVertices(std::move(other.m_nInternalVertices)),
 #if BITPIT_ENABLE_MPI==1
       m_nGhostVertices(std::move(other.m_nGhostVertices)),
@@ -382,15 +399,23 @@ PatchKernel::PatchKernel(PatchKernel &&other)
 */
 PatchKernel & PatchKernel::operator=(PatchKernel &&other)
 {
+	// The previous neighbourhood pool should be kept alive until the previous
+	// cells have been destroyed.
+	std::unique_ptr<std::pmr::synchronized_pool_resource> previousCellNeighbourhoodPool = std::move(m_cellNeighbourhoodPool);
+
 	VTKBaseStreamer::operator=(std::move(other));
+	m_cellNeighbourhoodPool = std::move(other.m_cellNeighbourhoodPool);
 	m_vertices = std::move(other.m_vertices);
 	m_cells = std::move(other.m_cells);
 	m_interfaces = std::move(other.m_interfaces);
 	m_alteredCells = std::move(other.m_alteredCells);
 	m_alteredInterfaces = std::move(other.m_alteredInterfaces);
+	m_movedVertices = std::move(other.m_movedVertices);
 	m_vertexIdGenerator = std::move(other.m_vertexIdGenerator);
 	m_interfaceIdGenerator = std::move(other.m_interfaceIdGenerator);
 	m_cellIdGenerator = std::move(other.m_cellIdGenerator);
+	m_cellConnectArena = std::move(other.m_cellConnectArena);
+	m_locationTree.reset();
 	m_nInternalVertices = std::move(other.m_nInternalVertices);
 #if BITPIT_ENABLE_MPI==1
 	m_nGhostVertices = std::move(other.m_nGhostVertices);
@@ -859,6 +884,12 @@ void PatchKernel::finalizeAlterations(bool squeezeStorage)
 	// Flush interfaces data structures
 	m_interfaces.flush();
 
+	// Update geometric cache
+	if (_isGeometricCacheEnabled()) {
+		flagMovedVerticesGeometry();
+		_updateGeometricCache(false);
+	}
+
 #if BITPIT_ENABLE_MPI==1
 	// Update partitioning information
 	bool partitioningInfoDirty = arePartitioningInfoDirty();
@@ -982,6 +1013,7 @@ void PatchKernel::resetVertices()
 #if BITPIT_ENABLE_MPI==1
 	m_firstGhostVertexId = Vertex::NULL_ID;
 #endif
+	m_movedVertices.clear();
 
 	for (auto &cell : m_cells) {
 		cell.unsetConnect();
@@ -994,9 +1026,16 @@ void PatchKernel::resetVertices()
 void PatchKernel::resetCells()
 {
 	m_cells.clear();
+	resetLocationTree();
 	if (m_cellIdGenerator) {
 		m_cellIdGenerator->reset();
 	}
+	if (m_cellConnectArena) {
+		m_cellConnectArena->clear();
+	}
+	if (m_cellNeighbourhoodPool) {
+		m_cellNeighbourhoodPool->release();
+	}
 	m_nInternalCells = 0;
 #if BITPIT_ENABLE_MPI==1
 	m_nGhostCells = 0;
@@ -1055,6 +1094,7 @@ void PatchKernel::resetInterfaces()
 */
 void PatchKernel::_resetInterfaces(bool release)
 {
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
 	for (auto &cell : m_cells) {
 		cell.resetInterfaces(!release);
 	}
@@ -1384,7 +1424,14 @@ bool PatchKernel::isDirty(bool global) const
 
 	if (!isDirty) {
 		isDirty |= areInterfacesDirty(false);
-		assert(isDirty || m_alteredInterfaces.empty());
+	}
+
+	if (!isDirty) {
+		isDirty |= !m_alteredInterfaces.empty();
+	}
+
+	if (!isDirty) {
+		isDirty |= !m_movedVertices.empty();
 	}
 
 	if (!isDirty) {
@@ -2366,6 +2413,28 @@ void PatchKernel::getVertexCoords(std::size_t nVertices, const long *ids, std::a
 	}
 }
 
+/*!
+	Sets the coordinates of the specified vertex.
+
+	The bounding box of the patch is updated and the geometry of the patch
+	is marked as altered: cached geometric quantities of the cells and of
+	the interfaces that share the vertex will be re-evaluated when the patch
+	is updated.
+
+	\param id is the id of the vertex
+	\param coords are the new coordinates of the vertex
+*/
+void PatchKernel::setVertexCoords(long id, const std::array<double, 3> &coords)
+{
+	Vertex &vertex = getVertex(id);
+
+	removePointFromBoundingBox(vertex.getCoords());
+	vertex.setCoords(coords);
+	addPointToBoundingBox(coords);
+
+	setGeometryAltered(id);
+}
+
 /*!
 	Return true if the patch is empty.
 
@@ -2445,6 +2514,300 @@ void PatchKernel::setCellAutoIndexing(bool enabled)
 	}
 }
 
+/*!
+	Checks if the connectivity arena for cells is enabled.
+
+	\return Returns true if the connectivity arena for cells is enabled,
+	otherwise it returns false.
+*/
+bool PatchKernel::isCellConnectArenaEnabled() const
+{
+	return static_cast<bool>(m_cellConnectArena);
+}
+
+/*!
+	Enables or disables the connectivity arena for cells.
+
+	When the arena is enabled, the connectivity of the cells is stored in
+	large contiguous blocks owned by the patch, rather than in a separate
+	heap allocation for each cell. This reduces the number of allocations
+	performed when the patch is built and the fragmentation of the memory.
+	The blocks are compacted, following the order of the cells in the
+	storage, when the cells are sorted or squeezed, hence loops over the
+	connectivity of the cells access contiguous memory.
+
+	Together with the arena, a memory pool owned by the patch is used for
+	storing the adjacencies and the interfaces of the cells. Storage that
+	is released when the neighbourhood of a cell is updated or when a cell
+	is deleted is recycled by the pool, instead of being returned to the
+	heap.
+
+	Cells of a patch with an enabled arena don't own their connectivity
+	and their neighbourhood storage: a cell moved out of the patch should
+	not outlive the patch (copies of the cells own their storage and are
+	not subject to this limit). Memory of the arena is not reused when
+	cells are deleted, it is only reclaimed when the arena is compacted.
+
+	\param enabled if set to true the connectivity arena will be enabled
+*/
+void PatchKernel::setCellConnectArena(bool enabled)
+{
+	if (isCellConnectArenaEnabled() == enabled) {
+		return;
+	}
+
+	if (enabled) {
+		m_cellConnectArena = std::unique_ptr<CellConnectArena>(new CellConnectArena());
+		compactCellConnectArena();
+
+		m_cellNeighbourhoodPool = std::unique_ptr<std::pmr::synchronized_pool_resource>(new std::pmr::synchronized_pool_resource());
+		for (Cell &cell : m_cells) {
+			storeCellNeighbourhood(cell);
+		}
+	} else {
+		std::unique_ptr<CellConnectArena> arena = std::move(m_cellConnectArena);
+		for (Cell &cell : m_cells) {
+			storeCellConnect(cell);
+		}
+
+		// Also the positions of deleted cells may hold storage allocated by
+		// the pool, all the positions of the storage should be processed.
+		std::unique_ptr<std::pmr::synchronized_pool_resource> pool = std::move(m_cellNeighbourhoodPool);
+		for (auto itr = m_cells.rawBegin(); itr != m_cells.rawEnd(); ++itr) {
+			storeCellNeighbourhood(*itr);
+		}
+	}
+}
+
+/*!
+	Stores the connectivity of the specified cell.
+
+	If the connectivity arena is enabled, the connectivity is moved into the
+	arena, otherwise, if the connectivity of the cell is stored in an external
+	storage, the cell will take the ownership of a copy of its connectivity.
+
+	\param cell is the cell whose connectivity will be stored
+*/
+void PatchKernel::storeCellConnect(Cell &cell)
+{
+	const long *connect = cell.getConnect();
+	if (!connect) {
+		return;
+	}
+
+	if (m_cellConnectArena) {
+		int connectSize = cell.getConnectSize();
+		long *arenaConnect = m_cellConnectArena->allocate(connectSize);
+		std::copy(connect, connect + connectSize, arenaConnect);
+		cell.setExternalConnect(arenaConnect);
+	} else if (cell.hasExternalConnect()) {
+		int connectSize = cell.getConnectSize();
+		std::unique_ptr<long[]> ownedConnect = std::unique_ptr<long[]>(new long[connectSize]);
+		std::copy(connect, connect + connectSize, ownedConnect.get());
+		cell.setConnect(std::move(ownedConnect));
+	}
+}
+
+/*!
+	Assigns to the specified cell a connectivity already stored in the arena.
+
+	The cell should have been created without a connectivity, once the
+	connectivity is assigned, the storage for the adjacencies and the
+	interfaces of the cell is initialized.
+
+	\param cell is the cell whose connectivity will be assigned
+	\param arenaConnect is the connectivity, it should have been allocated
+	by the arena
+*/
+void PatchKernel::storeCellArenaConnect(Cell &cell, long *arenaConnect)
+{
+	assert(m_cellConnectArena);
+
+	cell.setExternalConnect(arenaConnect);
+
+	bool storeInterfaces  = (getInterfacesBuildStrategy() != INTERFACES_NONE);
+	bool storeAdjacencies = storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
+
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+	cell.resetInterfaces(storeInterfaces);
+	cell.resetAdjacencies(storeAdjacencies);
+}
+
+/*!
+	Stores the adjacencies and the interfaces of the specified cell.
+
+	If the connectivity arena is enabled, adjacencies and interfaces are
+	copied into the neighbourhood pool, otherwise they are copied into
+	storage allocated from the heap.
+
+	\param cell is the cell whose adjacencies and interfaces will be stored
+*/
+void PatchKernel::storeCellNeighbourhood(Cell &cell)
+{
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+	cell.relocateNeighbourhood();
+}
+
+/*!
+	Stores the connectivity and the neighbourhood of a newly created cell.
+
+	When the connectivity arena is enabled, cells are created without the
+	storage for adjacencies and interfaces: that storage is initialized,
+	using the neighbourhood pool, only after the connectivity of the cell
+	has been moved into the arena. If the cell has no connectivity yet, the
+	storage will be initialized when the connectivity will be assigned.
+
+	\param cell is the newly created cell
+*/
+void PatchKernel::storeNewCell(Cell &cell)
+{
+	storeCellConnect(cell);
+	if (!m_cellConnectArena) {
+		return;
+	}
+
+	if (cell.getConnect()) {
+		storeCellArenaConnect(cell, cell.getConnect());
+	}
+}
+
+/*!
+	Compacts the connectivity arena.
+
+	The connectivity of all the cells is copied into a single block of a new
+	arena, following the order of the cells in the storage. Memory used by
+	the connectivity of deleted cells is released.
+*/
+void PatchKernel::compactCellConnectArena()
+{
+	if (!m_cellConnectArena) {
+		return;
+	}
+
+	std::size_t arenaSize = 0;
+	for (const Cell &cell : m_cells) {
+		if (cell.getConnect()) {
+			arenaSize += cell.getConnectSize();
+		}
+	}
+
+	// The previous arena should be kept alive until the connectivity of all
+	// the cells has been copied into the new arena.
+	std::unique_ptr<CellConnectArena> previousArena = std::move(m_cellConnectArena);
+
+	m_cellConnectArena = std::unique_ptr<CellConnectArena>(new CellConnectArena());
+	m_cellConnectArena->reserve(arenaSize);
+	for (Cell &cell : m_cells) {
+		storeCellConnect(cell);
+	}
+}
+
+/*!
+	\class PatchKernel::CellConnectArena
+
+	\brief Stores the connectivity of the cells in large contiguous blocks.
+
+	Storage is allocated from the last block, new blocks are created when the
+	last block is full. Blocks are never relocated, hence pointers to the
+	allocated storage remain valid until the arena is cleared or destroyed.
+	Allocated storage cannot be released individually.
+*/
+
+/*!
+	Default size (expressed in number of connectivity entries) of the blocks.
+*/
+const std::size_t PatchKernel::CellConnectArena::DEFAULT_BLOCK_SIZE = 65536;
+
+/*!
+	Constructor.
+
+	\param blockSize is the size, expressed in number of connectivity entries,
+	of the blocks allocated by the arena
+*/
+PatchKernel::CellConnectArena::CellConnectArena(std::size_t blockSize)
+	: m_blockSize(blockSize),
+	  m_lastBlockSize(0), m_lastBlockCapacity(0),
+	  m_size(0), m_capacity(0)
+{
+}
+
+/*!
+	Allocates storage for the specified number of connectivity entries.
+
+	\param size is the number of connectivity entries
+	\result A pointer to the allocated storage.
+*/
+long * PatchKernel::CellConnectArena::allocate(std::size_t size)
+{
+	reserve(size);
+
+	long *storage = m_blocks.back().get() + m_lastBlockSize;
+	m_lastBlockSize += size;
+	m_size          += size;
+
+	return storage;
+}
+
+/*!
+	Guarantees that the last block of the arena can hold at least the
+	specified number of connectivity entries.
+
+	If the last block is not large enough, a new block is allocated. The
+	storage left at the end of the previous block is not used anymore.
+
+	\param size is the number of connectivity entries
+*/
+void PatchKernel::CellConnectArena::reserve(std::size_t size)
+{
+	if (!m_blocks.empty() && (m_lastBlockCapacity - m_lastBlockSize) >= size) {
+		return;
+	}
+
+	std::size_t blockCapacity = std::max(m_blockSize, size);
+	m_blocks.emplace_back(new long[blockCapacity]);
+	m_lastBlockSize     = 0;
+	m_lastBlockCapacity = blockCapacity;
+	m_capacity         += blockCapacity;
+}
+
+/*!
+	Releases all the blocks of the arena.
+
+	Storage previously allocated by the arena is not valid anymore.
+*/
+void PatchKernel::CellConnectArena::clear()
+{
+	m_blocks.clear();
+	m_blocks.shrink_to_fit();
+
+	m_lastBlockSize     = 0;
+	m_lastBlockCapacity = 0;
+	m_size              = 0;
+	m_capacity          = 0;
+}
+
+/*!
+	Gets the number of connectivity entries allocated by the arena.
+
+	\result The number of connectivity entries allocated by the arena.
+*/
+std::size_t PatchKernel::CellConnectArena::size() const
+{
+	return m_size;
+}
+
+/*!
+	Gets the number of connectivity entries the arena can hold without
+	allocating new blocks.
+
+	\result The number of connectivity entries the arena can hold without
+	allocating new blocks.
+*/
+std::size_t PatchKernel::CellConnectArena::capacity() const
+{
+	return m_capacity;
+}
+
 /*!
 	Dump cell auto indexing.
 
@@ -2824,6 +3187,10 @@ PatchKernel::CellIterator PatchKernel::addCell(Cell &&source, long id)
 	Cell &cell = (*iterator);
 	cell = std::move(source);
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeCellConnect(cell);
+	storeCellNeighbourhood(cell);
+
 	return iterator;
 }
 
@@ -2875,10 +3242,25 @@ PatchKernel::CellIterator PatchKernel::addCell(ElementType type, const std::vect
 											   long id)
 {
 	int connectSize = connectivity.size();
-	std::unique_ptr<long[]> connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
-	std::copy(connectivity.data(), connectivity.data() + connectSize, connectStorage.get());
 
-	return addCell(type, std::move(connectStorage), id);
+	// Add the cell
+	//
+	// When the connectivity arena is enabled, the connectivity is copied
+	// directly into the arena once the cell has been created.
+	std::unique_ptr<long[]> connectStorage;
+	if (!m_cellConnectArena) {
+		connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+		std::copy(connectivity.data(), connectivity.data() + connectSize, connectStorage.get());
+	}
+
+	CellIterator iterator = addCell(type, std::move(connectStorage), id);
+	if (m_cellConnectArena && iterator != cellEnd()) {
+		long *arenaConnect = m_cellConnectArena->allocate(connectSize);
+		std::copy(connectivity.data(), connectivity.data() + connectSize, arenaConnect);
+		storeCellArenaConnect(*iterator, arenaConnect);
+	}
+
+	return iterator;
 }
 
 /*!
@@ -2958,8 +3340,11 @@ PatchKernel::CellIterator PatchKernel::_addInternalCell(ElementType type, std::u
 #endif
 
 	// Create the cell
-	bool storeInterfaces  = (getInterfacesBuildStrategy() != INTERFACES_NONE);
-	bool storeAdjacencies = storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
+	//
+	// When the connectivity arena is enabled, the neighbourhood storage is
+	// initialized after the connectivity has been stored.
+	bool storeInterfaces  = !m_cellConnectArena && (getInterfacesBuildStrategy() != INTERFACES_NONE);
+	bool storeAdjacencies = !m_cellConnectArena && (storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE));
 
 	CellIterator iterator;
 	if (referenceId == Cell::NULL_ID) {
@@ -2969,6 +3354,9 @@ PatchKernel::CellIterator PatchKernel::_addInternalCell(ElementType type, std::u
 	}
 	m_nInternalCells++;
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeNewCell(*iterator);
+
 	// Update the id of the last internal cell
 	if (m_lastInternalCellId < 0) {
 		m_lastInternalCellId = id;
@@ -3004,8 +3392,14 @@ void PatchKernel::setAddedCellAlterationFlags(long id)
 	if (getInterfacesBuildStrategy() != INTERFACES_NONE) {
 		flags |= FLAG_INTERFACES_DIRTY;
 	}
+	if (_isGeometricCacheEnabled()) {
+		flags |= FLAG_GEOMETRY_DIRTY;
+	}
 
 	setCellAlterationFlags(id, flags);
+
+	// Reset the location tree
+	resetLocationTree();
 }
 
 #if BITPIT_ENABLE_MPI==0
@@ -3057,15 +3451,20 @@ void PatchKernel::_restoreInternalCell(const CellIterator &iterator, ElementType
 	// Restore the cell
 	//
 	// There is no need to set the id of the cell as assigned, because
-	// also the index generator will be restored.
-	bool storeInterfaces  = (getInterfacesBuildStrategy() != INTERFACES_NONE);
-	bool storeAdjacencies = storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
+	// also the index generator will be restored. When the connectivity
+	// arena is enabled, the neighbourhood storage is initialized after
+	// the connectivity has been stored.
+	bool storeInterfaces  = !m_cellConnectArena && (getInterfacesBuildStrategy() != INTERFACES_NONE);
+	bool storeAdjacencies = !m_cellConnectArena && (storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE));
 
 	long cellId = iterator.getId();
 	Cell &cell = *iterator;
 	cell.initialize(cellId, type, std::move(connectStorage), true, storeInterfaces, storeAdjacencies);
 	m_nInternalCells++;
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeNewCell(cell);
+
 	// Set the alteration flags of the cell
 	setRestoredCellAlterationFlags(cellId);
 }
@@ -3084,8 +3483,14 @@ void PatchKernel::setRestoredCellAlterationFlags(long id)
 	if (getInterfacesBuildStrategy() != INTERFACES_NONE) {
 		flags |= FLAG_INTERFACES_DIRTY;
 	}
+	if (_isGeometricCacheEnabled()) {
+		flags |= FLAG_GEOMETRY_DIRTY;
+	}
 
 	setCellAlterationFlags(id, flags);
+
+	// Reset the location tree
+	resetLocationTree();
 }
 
 /*!
@@ -3179,6 +3584,9 @@ void PatchKernel::setDeletedCellAlterationFlags(long id)
 			setInterfaceAlterationFlags(interfaceId, FLAG_DANGLING);
 		}
 	}
+
+	// Reset the location tree
+	resetLocationTree();
 }
 
 /*!
@@ -4577,7 +4985,9 @@ PatchKernel::InterfaceIterator PatchKernel::_addInterface(ElementType type,
 */
 void PatchKernel::setAddedInterfaceAlterationFlags(long id)
 {
-	BITPIT_UNUSED(id);
+	if (_isGeometricCacheEnabled()) {
+		setInterfaceAlterationFlags(id, FLAG_GEOMETRY_DIRTY);
+	}
 }
 
 /*!
@@ -4647,7 +5057,9 @@ void PatchKernel::_restoreInterface(const InterfaceIterator &iterator, ElementTy
 */
 void PatchKernel::setRestoredInterfaceAlterationFlags(long id)
 {
-	BITPIT_UNUSED(id);
+	if (_isGeometricCacheEnabled()) {
+		setInterfaceAlterationFlags(id, FLAG_GEOMETRY_DIRTY);
+	}
 }
 
 /*!
@@ -5019,6 +5431,7 @@ void PatchKernel::restoreCells(std::istream &stream)
 {
 	// Restore kernel
 	m_cells.restoreKernel(stream);
+	resetLocationTree();
 
 	// Enable manual adaption
 	AdaptionMode previousAdaptionMode = getAdaptionMode();
@@ -5053,9 +5466,21 @@ void PatchKernel::restoreCells(std::istream &stream)
 		int cellConnectSize;
 		utils::binary::read(stream, cellConnectSize);
 
-		std::unique_ptr<long[]> cellConnect = std::unique_ptr<long[]>(new long[cellConnectSize]);
+		// When the connectivity arena is enabled, the connectivity is read
+		// directly into the arena and assigned once the cell is restored.
+		std::unique_ptr<long[]> cellConnect;
+		long *arenaConnect = nullptr;
+		long *cellConnectData;
+		if (m_cellConnectArena) {
+			arenaConnect    = m_cellConnectArena->allocate(cellConnectSize);
+			cellConnectData = arenaConnect;
+		} else {
+			cellConnect     = std::unique_ptr<long[]>(new long[cellConnectSize]);
+			cellConnectData = cellConnect.get();
+		}
+
 		for (int k = 0; k < cellConnectSize; ++k) {
-			utils::binary::read(stream, cellConnect[k]);
+			utils::binary::read(stream, cellConnectData[k]);
 		}
 
 		CellIterator iterator;
@@ -5064,6 +5489,9 @@ void PatchKernel::restoreCells(std::istream &stream)
 #else
 		iterator = restoreCell(type, std::move(cellConnect), id);
 #endif
+		if (arenaConnect) {
+			storeCellArenaConnect(*iterator, arenaConnect);
+		}
 		iterator->setPID(PID);
 	}
 
@@ -5172,7 +5600,7 @@ void PatchKernel::restoreInterfaces(std::istream &stream)
 
 	// Interfaces are now updated
 	unsetCellAlterationFlags(FLAG_INTERFACES_DIRTY);
-	m_alteredInterfaces.clear();
+	unsetInterfaceAlterationFlags(FLAG_DELETED | FLAG_DANGLING);
 
 	// Restore previous adaption mode
 	setAdaptionMode(previousAdaptionMode);
@@ -5356,9 +5784,15 @@ bool PatchKernel::sortCells()
 	}
 #endif
 
+	// Reset the location tree
+	resetLocationTree();
+
 	// Synchronize storage
 	m_cells.sync();
 
+	// Compact the connectivity arena
+	compactCellConnectArena();
+
 	return true;
 }
 
@@ -5428,6 +5862,10 @@ bool PatchKernel::squeezeCells()
 
 	m_cells.sync();
 
+	resetLocationTree();
+
+	compactCellConnectArena();
+
 	return true;
 }
 
@@ -6002,6 +6440,9 @@ void PatchKernel::updateAdjacencies(bool forcedUpdated)
 		return;
 	}
 
+	// Neighbourhood storage is allocated from the pool of the patch
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+
 	// Update adjacencies
 	if (adjacenciesDirty) {
 		// Prune stale adjacencies
@@ -6071,6 +6512,7 @@ void PatchKernel::resetAdjacencies()
 */
 void PatchKernel::_resetAdjacencies(bool release)
 {
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
 	for (Cell &cell : m_cells) {
 		cell.resetAdjacencies(!release);
 	}
@@ -6262,6 +6704,18 @@ void PatchKernel::_updateAdjacencies()
 		}
 	}
 
+#if BITPIT_ENABLE_OPENMP==1
+	// Create the adjacencies using the threaded sort-based matching
+	//
+	// When the adjacencies of all the cells are dirty the whole patch is being
+	// processed, half-faces can then be matched in bulk sorting their keys.
+	if (nDirtyAdjacenciesCells == getCellCount() && nDirtyAdjacenciesCells >= THREADED_ADJACENCIES_MIN_CELLS && omp_get_max_threads() > 1) {
+		if (matchHalfFacesThreaded(processList, matchingWindings)) {
+			return;
+		}
+	}
+#endif
+
 	// Create the adjacencies
 	std::unordered_set<CellHalfFace, CellHalfFace::Hasher> halfFaces;
 	halfFaces.reserve(static_cast<std::size_t>(0.5 * nMaxHalfFaces));
@@ -6368,64 +6822,391 @@ void PatchKernel::_updateAdjacencies()
 	}
 }
 
+#if BITPIT_ENABLE_OPENMP==1
 /*!
-	Returns the current interfaces build strategy.
-
-	\return The current interfaces build strategy.
+	Minimum number of cells for which adjacencies are built using multiple
+	threads.
 */
-PatchKernel::InterfacesBuildStrategy PatchKernel::getInterfacesBuildStrategy() const
-{
-	return m_interfacesBuildStrategy;
-}
+const long PatchKernel::THREADED_ADJACENCIES_MIN_CELLS = 8192;
 
 /*!
-	Set the current interfaces build strategy.
+	Internal function to create, using multiple threads, the adjacencies of
+	the cells in the specified list.
 
-	\param status is the interfaces build strategy that will be set
+	Each thread evaluates the keys of the half-faces of a chunk of cells. The
+	key of an half-face is evaluated from its sorted vertex ids, therefore it
+	doesn't depend on the winding of the face. Keys are gathered in a flat
+	array which is then sorted in parallel, this will place half-faces that
+	may match in contiguous runs of equal keys. Each run is then processed
+	replicating the matching performed by the serial algorithm: the case in
+	which multiple adjacencies are allowed is handled and the adjacencies
+	created will be the same created by the serial algorithm.
+
+	Matching is only possible if the cells in the list don't have any
+	adjacency.
+
+	\param processList is the list of cells to process, the adjacencies of
+	all the cells in the list should be dirty
+	\param matchingWindings are the windings that will be used to look for
+	matching half-faces
+	\result Returns true if the adjacencies have been created, false if the
+	cells already have adjacencies and no matching has been performed.
 */
-void PatchKernel::setInterfacesBuildStrategy(InterfacesBuildStrategy status)
+bool PatchKernel::matchHalfFacesThreaded(const std::vector<Cell *> &processList, const std::vector<CellHalfFace::Winding> &matchingWindings)
 {
-	if (status == INTERFACES_AUTOMATIC) {
-		if (!isInterfaceAutoIndexingEnabled()) {
-			throw std::runtime_error("Automatic build strategy requires auto-indexing.");
+	bool multipleMatchesAllowed = (matchingWindings.size() > 1);
+
+	std::size_t nCells = processList.size();
+
+	// Check if the cells already have adjacencies
+	bool adjacenciesFound = false;
+
+#pragma omp parallel for schedule(static) reduction(||:adjacenciesFound)
+	for (std::size_t n = 0; n < nCells; ++n) {
+		if (processList[n]->getAdjacencyCount() > 0) {
+			adjacenciesFound = true;
 		}
 	}
 
-	m_interfacesBuildStrategy = status;
-}
+	if (adjacenciesFound) {
+		return false;
+	}
 
-/*!
-	Checks if the interfaces are dirty.
+	// Split cells in chunks
+	int nChunks = omp_get_max_threads();
 
-	\param global if set to true, the dirty status will be evaluated globally
-	across all the partitions
-	\result Returns true if the interfaces are dirty, false otherwise.
-*/
-bool PatchKernel::areInterfacesDirty(bool global) const
-{
-	if (getInterfacesBuildStrategy() == INTERFACES_NONE) {
-		return false;
+	std::vector<std::size_t> chunkBegins(nChunks + 1);
+	for (int chunk = 0; chunk <= nChunks; ++chunk) {
+		chunkBegins[chunk] = (nCells * chunk) / nChunks;
 	}
 
-	bool areDirty = !m_alteredInterfaces.empty();
-	if (!areDirty) {
-		for (const auto &entry : m_alteredCells) {
-			AlterationFlags cellAlterationFlags = entry.second;
-			if (testAlterationFlags(cellAlterationFlags, FLAG_INTERFACES_DIRTY)) {
-				areDirty = true;
-				break;
-			}
-		}
+	// Evaluate the offsets of the half-faces of each cell
+	std::vector<std::size_t> halfFaceOffsets(nCells + 1);
+	halfFaceOffsets[0] = 0;
+
+#pragma omp parallel for schedule(static)
+	for (std::size_t n = 0; n < nCells; ++n) {
+		halfFaceOffsets[n + 1] = processList[n]->getFaceCount();
 	}
 
-#if BITPIT_ENABLE_MPI==1
-	if (global && isPartitioned()) {
-		const auto &communicator = getCommunicator();
-		MPI_Allreduce(MPI_IN_PLACE, &areDirty, 1, MPI_C_BOOL, MPI_LOR, communicator);
+	for (std::size_t n = 0; n < nCells; ++n) {
+		halfFaceOffsets[n + 1] += halfFaceOffsets[n];
 	}
-#else
-	BITPIT_UNUSED(global);
-#endif
+
+	std::size_t nHalfFaces = halfFaceOffsets[nCells];
+
+	// Gather and sort the keys of the half-faces
+	//
+	// Each entry contains the key of the half-face, the position of its cell
+	// in the process list and the face. Half-faces with the same key are
+	// sorted in the order in which the serial algorithm would process them.
+	typedef std::tuple<std::size_t, std::size_t, int> HalfFaceKey;
+
+	std::vector<HalfFaceKey> halfFaceKeys(nHalfFaces);
+
+#pragma omp parallel for schedule(static)
+	for (int chunk = 0; chunk < nChunks; ++chunk) {
+		std::vector<long> sortedVertexIds;
+		for (std::size_t n = chunkBegins[chunk]; n < chunkBegins[chunk + 1]; ++n) {
+			const Cell &cell = *(processList[n]);
+			const int nCellFaces = cell.getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				sortedVertexIds.resize(cell.getFaceVertexCount(face));
+				cell.getFaceVertexIds(face, sortedVertexIds.data());
+				std::sort(sortedVertexIds.begin(), sortedVertexIds.end());
+
+				std::size_t key = sortedVertexIds.size();
+				for (long vertexId : sortedVertexIds) {
+					utils::hashing::hash_combine(key, vertexId);
+				}
+
+				halfFaceKeys[halfFaceOffsets[n] + face] = HalfFaceKey(key, n, face);
+			}
+		}
+
+		std::sort(halfFaceKeys.begin() + halfFaceOffsets[chunkBegins[chunk]], halfFaceKeys.begin() + halfFaceOffsets[chunkBegins[chunk + 1]]);
+	}
+
+	for (int width = 1; width < nChunks; width *= 2) {
+#pragma omp parallel for schedule(static)
+		for (int chunk = 0; chunk < nChunks - width; chunk += 2 * width) {
+			auto chunkBegin = halfFaceKeys.begin() + halfFaceOffsets[chunkBegins[chunk]];
+			auto chunkMid   = halfFaceKeys.begin() + halfFaceOffsets[chunkBegins[chunk + width]];
+			auto chunkEnd   = halfFaceKeys.begin() + halfFaceOffsets[chunkBegins[std::min(chunk + 2 * width, nChunks)]];
+			std::inplace_merge(chunkBegin, chunkMid, chunkEnd);
+		}
+	}
+
+	// Split the keys in chunks
+	//
+	// A run of equal keys should not be split among different chunks.
+	std::vector<std::size_t> keyChunkBegins(nChunks + 1);
+	keyChunkBegins[0] = 0;
+	for (int chunk = 1; chunk < nChunks; ++chunk) {
+		std::size_t k = std::max(keyChunkBegins[chunk - 1], (nHalfFaces * chunk) / nChunks);
+		while (k > 0 && k < nHalfFaces && std::get<0>(halfFaceKeys[k]) == std::get<0>(halfFaceKeys[k - 1])) {
+			++k;
+		}
+
+		keyChunkBegins[chunk] = k;
+	}
+	keyChunkBegins[nChunks] = nHalfFaces;
+
+	// Match the half-faces
+	//
+	// Half-faces in a run of equal keys are matched replicating the serial
+	// algorithm. Two half-faces match if they have the same hash and if they
+	// are equal, exactly as it happens in the set used by serial algorithm.
+	//
+	// Adjacencies are not created immediately, they are stored in a list of
+	// entries (position of the cell in the process list, face and id of the
+	// adjacent cell) grouped by the chunk the cell belongs to. The entries
+	// associated with a face all come from the same run, hence from the same
+	// chunk, and they are stored in the order the serial algorithm would
+	// create them.
+	typedef std::tuple<std::size_t, int, long> AdjacencyEntry;
+
+	std::vector<std::vector<std::vector<AdjacencyEntry>>> adjacencyEntries(nChunks, std::vector<std::vector<AdjacencyEntry>>(nChunks));
+
+#pragma omp parallel for schedule(static)
+	for (int chunk = 0; chunk < nChunks; ++chunk) {
+		std::vector<std::vector<AdjacencyEntry>> &chunkAdjacencyEntries = adjacencyEntries[chunk];
+
+		auto addAdjacencyEntry = [&chunkBegins, &chunkAdjacencyEntries](std::size_t n, int face, long adjacencyId) {
+			int cellChunk = static_cast<int>(std::upper_bound(chunkBegins.begin(), chunkBegins.end(), n) - chunkBegins.begin()) - 1;
+			chunkAdjacencyEntries[cellChunk].emplace_back(n, face, adjacencyId);
+		};
+
+		CellHalfFace::Hasher halfFaceHasher;
+		std::vector<std::size_t> runVertexOffsets;
+		std::vector<long> runVertexIds;
+		std::vector<CellHalfFace> runHalfFaces;
+		std::vector<std::size_t> runHashes;
+		std::vector<std::size_t> runCandidates;
+		std::vector<std::vector<std::size_t>> runAdjacencies;
+		std::vector<std::size_t> matchingAdjacencies;
+
+		std::size_t runBegin = keyChunkBegins[chunk];
+		while (runBegin < keyChunkBegins[chunk + 1]) {
+			// Identify the run
+			std::size_t runKey = std::get<0>(halfFaceKeys[runBegin]);
+			std::size_t runEnd = runBegin + 1;
+			while (runEnd < keyChunkBegins[chunk + 1] && std::get<0>(halfFaceKeys[runEnd]) == runKey) {
+				++runEnd;
+			}
+
+			std::size_t runSize = runEnd - runBegin;
+			if (runSize == 1) {
+				runBegin = runEnd;
+				continue;
+			}
+
+			// Gather the vertices of the half-faces of the run
+			//
+			// Half-faces will be views over the gathered vertices. Proxy
+			// vectors with internal storage share a memory pool, hence they
+			// cannot be created concurrently by multiple threads.
+			runVertexOffsets.resize(runSize + 1);
+			runVertexOffsets[0] = 0;
+			for (std::size_t i = 0; i < runSize; ++i) {
+				const HalfFaceKey &halfFaceKey = halfFaceKeys[runBegin + i];
+				const Cell &cell = *(processList[std::get<1>(halfFaceKey)]);
+				runVertexOffsets[i + 1] = runVertexOffsets[i] + cell.getFaceVertexCount(std::get<2>(halfFaceKey));
+			}
+
+			runVertexIds.resize(runVertexOffsets[runSize]);
+			for (std::size_t i = 0; i < runSize; ++i) {
+				const HalfFaceKey &halfFaceKey = halfFaceKeys[runBegin + i];
+				const Cell &cell = *(processList[std::get<1>(halfFaceKey)]);
+				cell.getFaceVertexIds(std::get<2>(halfFaceKey), runVertexIds.data() + runVertexOffsets[i]);
+			}
+
+			// Match the half-faces of the run
+			runHalfFaces.clear();
+			runHalfFaces.reserve(runSize);
+			runHashes.resize(runSize);
+			runCandidates.clear();
+			if (runAdjacencies.size() < runSize) {
+				runAdjacencies.resize(runSize);
+			}
+
+			for (std::size_t i = 0; i < runSize; ++i) {
+				const HalfFaceKey &halfFaceKey = halfFaceKeys[runBegin + i];
+				std::size_t n = std::get<1>(halfFaceKey);
+				int face = std::get<2>(halfFaceKey);
+				Cell &cell = *(processList[n]);
+
+				runAdjacencies[i].clear();
+
+				// Generate the half-face
+				ConstProxyVector<long> faceVertexIds(runVertexIds.data() + runVertexOffsets[i], runVertexOffsets[i + 1] - runVertexOffsets[i]);
+				runHalfFaces.emplace_back(cell, face, std::move(faceVertexIds));
+				CellHalfFace &halfFace = runHalfFaces.back();
+
+				// Find matching half-face
+				std::size_t matchingIndex = runSize;
+				for (CellHalfFace::Winding winding : matchingWindings) {
+					halfFace.setWinding(winding);
+					std::size_t halfFaceHash = halfFaceHasher(halfFace);
+					for (std::size_t candidate : runCandidates) {
+						if (runHashes[candidate] == halfFaceHash && runHalfFaces[candidate] == halfFace) {
+							matchingIndex = candidate;
+							break;
+						}
+					}
+
+					if (matchingIndex != runSize) {
+						break;
+					}
+				}
+
+				halfFace.setWinding(CellHalfFace::WINDING_NATURAL);
+				runHashes[i] = halfFaceHasher(halfFace);
+
+				// Add unmatched half-faces to the candidates
+				//
+				// Candidates mimic the set used by the serial algorithm,
+				// they can't contain duplicate half-faces.
+				if (matchingIndex == runSize) {
+					bool isDuplicate = false;
+					for (std::size_t candidate : runCandidates) {
+						if (runHashes[candidate] == runHashes[i] && runHalfFaces[candidate] == halfFace) {
+							isDuplicate = true;
+							break;
+						}
+					}
+
+					if (!isDuplicate) {
+						runCandidates.push_back(i);
+					}
+
+					continue;
+				}
+
+				// Identifty matching adjacencies
+				matchingAdjacencies.clear();
+				matchingAdjacencies.push_back(matchingIndex);
+				if (multipleMatchesAllowed) {
+					for (std::size_t neigh : runAdjacencies[matchingIndex]) {
+						if (&(runHalfFaces[neigh].getCell()) == &cell) {
+							continue;
+						}
+
+						matchingAdjacencies.push_back(neigh);
+					}
+				}
+
+				// Create adjacency entries
+				long cellId = cell.getId();
+				for (std::size_t adjacent : matchingAdjacencies) {
+					const HalfFaceKey &adjacentKey = halfFaceKeys[runBegin + adjacent];
+					long adjacentCellId = runHalfFaces[adjacent].getCell().getId();
+
+					addAdjacencyEntry(n, face, adjacentCellId);
+					addAdjacencyEntry(std::get<1>(adjacentKey), std::get<2>(adjacentKey), cellId);
+
+					runAdjacencies[i].push_back(adjacent);
+					runAdjacencies[adjacent].push_back(i);
+				}
+
+				// Remove the matching half-face from the candidates
+				if (!multipleMatchesAllowed) {
+					runCandidates.erase(std::find(runCandidates.begin(), runCandidates.end(), matchingIndex));
+				}
+			}
+
+			runBegin = runEnd;
+		}
+	}
+
+	// Create the adjacencies
+	//
+	// The neighbourhood pool is selected per thread, hence each thread has
+	// to enable the pool of the patch.
+#pragma omp parallel
+	{
+		CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+
+#pragma omp for schedule(static)
+		for (int chunk = 0; chunk < nChunks; ++chunk) {
+			for (int sourceChunk = 0; sourceChunk < nChunks; ++sourceChunk) {
+				for (const AdjacencyEntry &entry : adjacencyEntries[sourceChunk][chunk]) {
+					processList[std::get<0>(entry)]->pushAdjacency(std::get<1>(entry), std::get<2>(entry));
+				}
+			}
+		}
+	}
+
+	return true;
+}
+#endif
+
+/*!
+	Returns the current interfaces build strategy.
+
+	\return The current interfaces build strategy.
+*/
+PatchKernel::InterfacesBuildStrategy PatchKernel::getInterfacesBuildStrategy() const
+{
+	return m_interfacesBuildStrategy;
+}
+
+/*!
+	Set the current interfaces build strategy.
+
+	\param status is the interfaces build strategy that will be set
+*/
+void PatchKernel::setInterfacesBuildStrategy(InterfacesBuildStrategy status)
+{
+	if (status == INTERFACES_AUTOMATIC) {
+		if (!isInterfaceAutoIndexingEnabled()) {
+			throw std::runtime_error("Automatic build strategy requires auto-indexing.");
+		}
+	}
+
+	m_interfacesBuildStrategy = status;
+}
+
+/*!
+	Checks if the interfaces are dirty.
+
+	\param global if set to true, the dirty status will be evaluated globally
+	across all the partitions
+	\result Returns true if the interfaces are dirty, false otherwise.
+*/
+bool PatchKernel::areInterfacesDirty(bool global) const
+{
+	if (getInterfacesBuildStrategy() == INTERFACES_NONE) {
+		return false;
+	}
+
+	bool areDirty = false;
+	for (const auto &entry : m_alteredInterfaces) {
+		AlterationFlags interfaceAlterationFlags = entry.second;
+		if (interfaceAlterationFlags != FLAG_GEOMETRY_DIRTY) {
+			areDirty = true;
+			break;
+		}
+	}
+
+	if (!areDirty) {
+		for (const auto &entry : m_alteredCells) {
+			AlterationFlags cellAlterationFlags = entry.second;
+			if (testAlterationFlags(cellAlterationFlags, FLAG_INTERFACES_DIRTY)) {
+				areDirty = true;
+				break;
+			}
+		}
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	if (global && isPartitioned()) {
+		const auto &communicator = getCommunicator();
+		MPI_Allreduce(MPI_IN_PLACE, &areDirty, 1, MPI_C_BOOL, MPI_LOR, communicator);
+	}
+#else
+	BITPIT_UNUSED(global);
+#endif
 
 	return areDirty;
 }
@@ -6507,6 +7288,9 @@ void PatchKernel::updateInterfaces(bool forcedUpdated)
 	assert(getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
 	updateAdjacencies();
 
+	// Neighbourhood storage is allocated from the pool of the patch
+	CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+
 	// Update interfaces
 	if (interfacesDirty) {
 		// Enable manual adaption
@@ -6520,8 +7304,11 @@ void PatchKernel::updateInterfaces(bool forcedUpdated)
 		_updateInterfaces();
 
 		// Interfaces are now updated
+		//
+		// Geometry flags are preserved, they will be processed when the
+		// geometric cache is updated.
 		unsetCellAlterationFlags(FLAG_INTERFACES_DIRTY);
-		m_alteredInterfaces.clear();
+		unsetInterfaceAlterationFlags(FLAG_DELETED | FLAG_DANGLING);
 
 		// Restore previous adaption mode
 		setAdaptionMode(previousAdaptionMode);
@@ -6621,6 +7408,29 @@ void PatchKernel::pruneStaleInterfaces()
 */
 void PatchKernel::_updateInterfaces()
 {
+#if BITPIT_ENABLE_OPENMP==1
+	// Build all the interfaces at once
+	//
+	// When the patch has no interfaces and the interfaces of all the cells
+	// are dirty, interfaces can be built in bulk using multiple threads.
+	if (m_interfaces.empty() && m_interfaceIdGenerator && getCellCount() >= THREADED_INTERFACES_MIN_CELLS && omp_get_max_threads() > 1) {
+		long nDirtyInterfacesCells = 0;
+		for (const auto &entry : m_alteredCells) {
+			AlterationFlags cellAlterationFlags = entry.second;
+			if (!testAlterationFlags(cellAlterationFlags, FLAG_INTERFACES_DIRTY)) {
+				continue;
+			}
+
+			++nDirtyInterfacesCells;
+		}
+
+		if (nDirtyInterfacesCells == getCellCount()) {
+			buildInterfacesThreaded();
+			return;
+		}
+	}
+#endif
+
 	// Update interfaces
 	//
 	// Adjacencies and interfaces of a face are paired: the i-th face adjacency
@@ -6671,6 +7481,323 @@ void PatchKernel::_updateInterfaces()
 	}
 }
 
+#if BITPIT_ENABLE_OPENMP==1
+/*!
+	Minimum number of cells for which interfaces are built using multiple
+	threads.
+*/
+const long PatchKernel::THREADED_INTERFACES_MIN_CELLS = 8192;
+
+/*!
+	Internal function to build, using multiple threads, all the interfaces
+	of the patch.
+
+	The interfaces are built in bulk. First, the number of interfaces that
+	each cell will create is evaluated in parallel: an interface between two
+	cells is created by the cell with the lowest id, an interface on a border
+	face is created by the cell the face belongs to. Then all the interfaces
+	are added at once, using consecutive ids. Finally, the connectivity of the
+	interfaces and the interfaces of the cells are filled concurrently.
+
+	Owner and neighbour of the interfaces are chosen using the same criteria
+	used by buildCellInterface. The interface associated with the i-th face
+	adjacency is stored as the i-th face interface, therefore there is no need
+	to sort the adjacencies of the cells.
+
+	The function can only be called when the patch has no interfaces.
+*/
+void PatchKernel::buildInterfacesThreaded()
+{
+	assert(m_interfaces.empty());
+	assert(m_interfaceIdGenerator);
+
+	// List the cells
+	//
+	// Cells are listed using their raw index, this allows to easily find the
+	// position of a neighbour in the list.
+	std::vector<Cell *> cells;
+	cells.reserve(getCellCount());
+	for (auto itr = m_cells.begin(); itr != m_cells.end(); ++itr) {
+		std::size_t rawIndex = itr.getRawIndex();
+		if (rawIndex >= cells.size()) {
+			cells.resize(rawIndex + 1, nullptr);
+		}
+
+		cells[rawIndex] = &(*itr);
+	}
+
+	std::size_t nRawCells = cells.size();
+
+	// Proxy vectors with internal storage share a memory pool, hence they
+	// cannot be created concurrently by multiple threads. Functions that
+	// may need them are called inside a critical section.
+	auto findNeighFace = [this](const Cell &cell, int face, const Cell &neigh) -> int {
+		// Cells are usually neighbours through a single face, if this is
+		// the case there is no need to call the function that identifies
+		// the adjoining face.
+		long cellId = cell.getId();
+
+		int neighFace   = -1;
+		int nCandidates = 0;
+		const int nNeighFaces = neigh.getFaceCount();
+		for (int candidateFace = 0; candidateFace < nNeighFaces; ++candidateFace) {
+			const long *candidateAdjacencies = neigh.getAdjacencies(candidateFace);
+			const int nCandidateAdjacencies = neigh.getAdjacencyCount(candidateFace);
+			if (std::find(candidateAdjacencies, candidateAdjacencies + nCandidateAdjacencies, cellId) != candidateAdjacencies + nCandidateAdjacencies) {
+				neighFace = candidateFace;
+				++nCandidates;
+			}
+		}
+
+		if (nCandidates > 1) {
+#pragma omp critical (PatchKernel_buildInterfacesThreaded)
+			neighFace = findAdjoinNeighFace(cell, face, neigh);
+		}
+
+		return neighFace;
+	};
+
+	auto isInterfaceCreator = [&findNeighFace](const Cell &cell, int face, const Cell &neigh) -> bool {
+		long cellId  = cell.getId();
+		long neighId = neigh.getId();
+		if (cellId != neighId) {
+			return (cellId < neighId);
+		}
+
+		return (face < findNeighFace(cell, face, neigh));
+	};
+
+	// Count interface slots and interfaces created by each cell
+	//
+	// Each face has a slot for every adjacency, border faces have a single
+	// slot. Every slot will contain an interface.
+	std::vector<std::size_t> slotOffsets(nRawCells + 1);
+	std::vector<std::size_t> interfaceOffsets(nRawCells + 1);
+	slotOffsets[0]      = 0;
+	interfaceOffsets[0] = 0;
+
+#pragma omp parallel for schedule(static)
+	for (std::size_t n = 0; n < nRawCells; ++n) {
+		std::size_t nCellSlots      = 0;
+		std::size_t nCellInterfaces = 0;
+
+		const Cell *cell = cells[n];
+		if (cell) {
+			const int nCellFaces = cell->getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				const int nFaceAdjacencies = cell->getAdjacencyCount(face);
+				if (nFaceAdjacencies == 0) {
+					++nCellSlots;
+					++nCellInterfaces;
+					continue;
+				}
+
+				nCellSlots += nFaceAdjacencies;
+
+				const long *faceAdjacencies = cell->getAdjacencies(face);
+				for (int k = 0; k < nFaceAdjacencies; ++k) {
+					const Cell &neigh = m_cells[faceAdjacencies[k]];
+					if (isInterfaceCreator(*cell, face, neigh)) {
+						++nCellInterfaces;
+					}
+				}
+			}
+		}
+
+		slotOffsets[n + 1]      = nCellSlots;
+		interfaceOffsets[n + 1] = nCellInterfaces;
+	}
+
+	for (std::size_t n = 0; n < nRawCells; ++n) {
+		slotOffsets[n + 1]      += slotOffsets[n];
+		interfaceOffsets[n + 1] += interfaceOffsets[n];
+	}
+
+	std::size_t nSlots      = slotOffsets[nRawCells];
+	std::size_t nInterfaces = interfaceOffsets[nRawCells];
+
+	// Identify owner and neighbour of the interfaces
+	//
+	// Each interface also stores the slots it will be associated with.
+	struct InterfaceInfo {
+		Cell *owner;
+		int ownerFace;
+		Cell *neigh;
+		int neighFace;
+		std::size_t ownerSlot;
+		std::size_t neighSlot;
+	};
+
+	std::vector<InterfaceInfo> interfaceInfos(nInterfaces);
+
+#pragma omp parallel for schedule(static)
+	for (std::size_t n = 0; n < nRawCells; ++n) {
+		Cell *cell = cells[n];
+		if (!cell) {
+			continue;
+		}
+
+		long cellId = cell->getId();
+
+		std::size_t slot = slotOffsets[n];
+		std::size_t interfaceIndex = interfaceOffsets[n];
+		const int nCellFaces = cell->getFaceCount();
+		for (int face = 0; face < nCellFaces; ++face) {
+			// Border faces
+			const int nFaceAdjacencies = cell->getAdjacencyCount(face);
+			if (nFaceAdjacencies == 0) {
+				InterfaceInfo &info = interfaceInfos[interfaceIndex++];
+				info.owner     = cell;
+				info.ownerFace = face;
+				info.neigh     = nullptr;
+				info.neighFace = -1;
+				info.ownerSlot = slot;
+				info.neighSlot = slot;
+
+				++slot;
+				continue;
+			}
+
+			// Internal faces
+			const long *faceAdjacencies = cell->getAdjacencies(face);
+			for (int k = 0; k < nFaceAdjacencies; ++k, ++slot) {
+				long neighId = faceAdjacencies[k];
+				std::size_t neighRawIndex = m_cells.rawIndex(neighId);
+				Cell *neigh = cells[neighRawIndex];
+				if (!isInterfaceCreator(*cell, face, *neigh)) {
+					continue;
+				}
+
+				// Slot of the neighbour
+				int neighFace = findNeighFace(*cell, face, *neigh);
+				assert(neighFace >= 0);
+
+				std::size_t neighSlot = slotOffsets[neighRawIndex];
+				for (int i = 0; i < neighFace; ++i) {
+					neighSlot += std::max(neigh->getAdjacencyCount(i), 1);
+				}
+				neighSlot += neigh->findAdjacency(neighFace, cellId);
+
+				// Owner and neighbour
+				//
+				// See buildCellInterface for the criteria used to choose
+				// the owner of the interface.
+				bool cellOwnsInterface;
+				if (nFaceAdjacencies > 1) {
+					cellOwnsInterface = false;
+				} else if (neigh->getAdjacencyCount(neighFace) == 1) {
+					if (cell->getType() != ElementType::POLYHEDRON && neigh->getType() != ElementType::POLYHEDRON) {
+						cellOwnsInterface = CellFuzzyPositionLess(*this)(cellId, neighId);
+					} else {
+#pragma omp critical (PatchKernel_buildInterfacesThreaded)
+						cellOwnsInterface = CellFuzzyPositionLess(*this)(cellId, neighId);
+					}
+				} else {
+					cellOwnsInterface = true;
+				}
+
+				InterfaceInfo &info = interfaceInfos[interfaceIndex++];
+				if (cellOwnsInterface) {
+					info.owner     = cell;
+					info.ownerFace = face;
+					info.neigh     = neigh;
+					info.neighFace = neighFace;
+					info.ownerSlot = slot;
+					info.neighSlot = neighSlot;
+				} else {
+					info.owner     = neigh;
+					info.ownerFace = neighFace;
+					info.neigh     = cell;
+					info.neighFace = face;
+					info.ownerSlot = neighSlot;
+					info.neighSlot = slot;
+				}
+			}
+		}
+	}
+
+	// Add the interfaces
+	//
+	// Interfaces are added without a connectivity, the connectivity will be
+	// filled later.
+	std::vector<long> interfaceIds(nInterfaces);
+
+	m_interfaces.reserve(nInterfaces);
+	for (std::size_t i = 0; i < nInterfaces; ++i) {
+		const InterfaceInfo &info = interfaceInfos[i];
+		ElementType interfaceType = info.owner->getFaceType(info.ownerFace);
+
+		long interfaceId = m_interfaceIdGenerator->generate();
+		m_interfaces.emreclaimBack(interfaceId, interfaceId, interfaceType, std::unique_ptr<long[]>());
+		setAddedInterfaceAlterationFlags(interfaceId);
+
+		interfaceIds[i] = interfaceId;
+	}
+
+	// Fill the interfaces
+	std::vector<long> slotInterfaces(nSlots);
+
+#pragma omp parallel for schedule(static)
+	for (std::size_t i = 0; i < nInterfaces; ++i) {
+		const InterfaceInfo &info = interfaceInfos[i];
+		long interfaceId = interfaceIds[i];
+		Interface &interface = m_interfaces.at(interfaceId);
+
+		// Connectivity
+		//
+		// The connectivity of polygonal interfaces starts with the number of
+		// vertices of the interface.
+		int nInterfaceVertices = info.owner->getFaceVertexCount(info.ownerFace);
+		bool isPolygon = !ReferenceElementInfo::hasInfo(interface.getType());
+
+		std::unique_ptr<long[]> interfaceConnect = std::unique_ptr<long[]>(new long[nInterfaceVertices + (isPolygon ? 1 : 0)]);
+		if (isPolygon) {
+			interfaceConnect[0] = nInterfaceVertices;
+			info.owner->getFaceVertexIds(info.ownerFace, interfaceConnect.get() + 1);
+		} else {
+			info.owner->getFaceVertexIds(info.ownerFace, interfaceConnect.get());
+		}
+		interface.setConnect(std::move(interfaceConnect));
+
+		// Owner and neighbour
+		interface.setOwner(info.owner->getId(), info.ownerFace);
+		if (info.neigh) {
+			interface.setNeigh(info.neigh->getId(), info.neighFace);
+		}
+
+		// Slots
+		slotInterfaces[info.ownerSlot] = interfaceId;
+		slotInterfaces[info.neighSlot] = interfaceId;
+	}
+
+	// Set cell interfaces
+	//
+	// The neighbourhood pool is selected per thread, hence each thread has
+	// to enable the pool of the patch.
+#pragma omp parallel
+	{
+		CellNeighbourhoodPoolScope neighbourhoodPoolScope(m_cellNeighbourhoodPool.get());
+
+#pragma omp for schedule(static)
+		for (std::size_t n = 0; n < nRawCells; ++n) {
+			Cell *cell = cells[n];
+			if (!cell) {
+				continue;
+			}
+
+			std::size_t slot = slotOffsets[n];
+			const int nCellFaces = cell->getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				int nFaceSlots = std::max(cell->getAdjacencyCount(face), 1);
+				for (int k = 0; k < nFaceSlots; ++k) {
+					cell->pushInterface(face, slotInterfaces[slot++]);
+				}
+			}
+		}
+	}
+}
+#endif
+
 /*!
 	Given two cells, build the interface between them.
 
@@ -7510,6 +8637,9 @@ void PatchKernel::translate(const std::array<double, 3> &translation)
 		m_boxMinPoint += translation;
 		m_boxMaxPoint += translation;
 	}
+
+	// The geometry of the whole patch has been altered
+	setGeometryAltered();
 }
 
 /*!
@@ -7565,6 +8695,9 @@ void PatchKernel::rotate(const std::array<double, 3> &n0, const std::array<doubl
 			}
 		}
 	}
+
+	// The geometry of the whole patch has been altered
+	setGeometryAltered();
 }
 
 /*!
@@ -7617,6 +8750,9 @@ void PatchKernel::scale(const std::array<double, 3> &scaling, const std::array<d
 			m_boxMaxPoint[k] = center[k] + scaling[k] * (m_boxMaxPoint[k] - center[k]);
 		}
 	}
+
+	// The geometry of the whole patch has been altered
+	setGeometryAltered();
 }
 
 /*!
@@ -7680,6 +8816,9 @@ void PatchKernel::setTol(double tolerance)
 	_setTol(tolerance);
 
 	m_toleranceCustom = true;
+
+	// Reset the location tree
+	resetLocationTree();
 }
 
 /*!
@@ -7711,6 +8850,9 @@ void PatchKernel::resetTol()
 	_resetTol();
 
 	m_toleranceCustom = false;
+
+	// Reset the location tree
+	resetLocationTree();
 }
 
 /*!
@@ -7740,6 +8882,165 @@ bool PatchKernel::isTolCustomized() const
 	return m_toleranceCustom;
 }
 
+/*!
+	Checks if the geometric quantities of the cells and of the interfaces are
+	cached by the patch.
+
+	The base implementation doesn't provide any cache, patches that cache
+	their geometric quantities should re-implement this function.
+
+	\result Returns true if the geometric cache is enabled, false otherwise.
+*/
+bool PatchKernel::_isGeometricCacheEnabled() const
+{
+	return false;
+}
+
+/*!
+	Internal function to update the geometric cache of the patch.
+
+	Only the cells and the interfaces flagged with FLAG_GEOMETRY_DIRTY are
+	updated, unless a forced update is requested. The function is called
+	when the alterations of the patch are finalized, hence the cache should
+	not rely on the alteration flags of other kind.
+
+	\param forcedUpdated if set to true, the geometric quantities of all the
+	cells and interfaces will be evaluated, regardless of their alteration
+	flags
+*/
+void PatchKernel::_updateGeometricCache(bool forcedUpdated)
+{
+	BITPIT_UNUSED(forcedUpdated);
+}
+
+/*!
+	Marks the geometry of the patch as altered after the coordinates of its
+	vertices have been changed.
+
+	When the coordinates of a single vertex are changed, the vertex is
+	tracked: the cells and the interfaces that share it are flagged with
+	FLAG_GEOMETRY_DIRTY when the alterations of the patch are finalized,
+	hence their cached geometric quantities are re-evaluated when the patch
+	is updated. When the coordinates of all the vertices are changed (e.g.,
+	when the patch is transformed), the whole geometric cache is evaluated
+	immediately.
+
+	In both cases the tree used for locating points is reset.
+
+	\param vertexId is the id of the vertex whose coordinates have been
+	changed, if a null id is specified, the coordinates of all the vertices
+	are considered changed
+*/
+void PatchKernel::setGeometryAltered(long vertexId)
+{
+	resetLocationTree();
+
+	if (!_isGeometricCacheEnabled()) {
+		return;
+	}
+
+	if (vertexId == Vertex::NULL_ID) {
+		m_movedVertices.clear();
+		_updateGeometricCache(true);
+	} else {
+		m_movedVertices.insert(vertexId);
+	}
+}
+
+/*!
+	Flags with FLAG_GEOMETRY_DIRTY the cells and the interfaces that share
+	a vertex whose coordinates have been changed.
+*/
+void PatchKernel::flagMovedVerticesGeometry()
+{
+	if (m_movedVertices.empty()) {
+		return;
+	}
+
+	auto hasMovedVertex = [this](const Element &element) {
+		for (long vertexId : element.getVertexIds()) {
+			if (m_movedVertices.count(vertexId) > 0) {
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	for (const Cell &cell : m_cells) {
+		if (hasMovedVertex(cell)) {
+			setCellAlterationFlags(cell.getId(), FLAG_GEOMETRY_DIRTY);
+		}
+	}
+
+	for (const Interface &interface : m_interfaces) {
+		if (hasMovedVertex(interface)) {
+			setInterfaceAlterationFlags(interface.getId(), FLAG_GEOMETRY_DIRTY);
+		}
+	}
+
+	m_movedVertices.clear();
+}
+
+/*!
+	Gets the tree used for locating points in the patch.
+
+	The tree is built the first time it is requested and it is kept until
+	the cells of the patch are altered, the coordinates of the vertices are
+	changed (see setVertexCoords) or the tolerance is changed. The tree
+	contains all the cells of the patch (ghost cells included) and doesn't
+	evaluate partition information, hence building it never requires
+	communications among the processes. Building the tree is not thread
+	safe, the first request should not be issued concurrently.
+
+	Changes of vertex coordinates made directly through the vertices are not
+	tracked by the patch.
+
+	\result The tree used for locating points in the patch.
+*/
+const PatchSkdTree & PatchKernel::getLocationTree() const
+{
+	if (!m_locationTree) {
+		std::unique_ptr<PatchSkdTree> locationTree = _createLocationTree();
+		if (!locationTree) {
+			throw std::runtime_error("The patch doesn't provide a tree for locating points.");
+		}
+
+#if BITPIT_ENABLE_MPI==1
+		locationTree->enablePartitionInfo(false);
+#endif
+		locationTree->build();
+
+		m_locationTree = std::move(locationTree);
+	}
+
+	return *m_locationTree;
+}
+
+/*!
+	Resets the tree used for locating points in the patch.
+
+	The tree will be re-built the next time it is requested.
+*/
+void PatchKernel::resetLocationTree()
+{
+	m_locationTree.reset();
+}
+
+/*!
+	Internal function to create the tree used for locating points in the
+	patch.
+
+	The base implementation doesn't provide any tree, patches that locate
+	points using a tree should re-implement this function.
+
+	\result The tree used for locating points in the patch.
+*/
+std::unique_ptr<PatchSkdTree> PatchKernel::_createLocationTree() const
+{
+	return nullptr;
+}
+
 /*!
 	Extracts the external envelope and appends it to the given patch.
 
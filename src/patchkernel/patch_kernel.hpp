@@ -29,6 +29,7 @@
 #include <deque>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #if BITPIT_ENABLE_MPI==1
 #	include <mpi.h>
 #endif
@@ -36,6 +37,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "bitpit_IO.hpp"
 #if BITPIT_ENABLE_MPI==1
@@ -51,6 +53,8 @@
 
 namespace bitpit {
 
+class PatchSkdTree;
+
 class PatchKernel : public VTKBaseStreamer {
 
 friend class PatchInfo;
@@ -444,6 +448,7 @@ public:
 	const Vertex &getFirstGhostVertex() const;
 #endif
 	const std::array<double, 3> & getVertexCoords(long id) const;
+	void setVertexCoords(long id, const std::array<double, 3> &coords);
 	void getVertexCoords(std::size_t nVertices, const long *ids, std::unique_ptr<std::array<double, 3>[]> *coordinates) const;
 	void getVertexCoords(std::size_t nVertices, const long *ids, std::array<double, 3> *coordinates) const;
 	VertexIterator addVertex(const Vertex &source, long id = Vertex::NULL_ID);
@@ -480,6 +485,9 @@ public:
 	bool isCellAutoIndexingEnabled() const;
 	void setCellAutoIndexing(bool enabled);
 
+	bool isCellConnectArenaEnabled() const;
+	void setCellConnectArena(bool enabled);
+
 	virtual long getCellCount() const;
 	long getInternalCellCount() const;
 	BITPIT_DEPRECATED(long getInternalCount() const);
@@ -802,7 +810,14 @@ protected:
 	const static AlterationFlags FLAG_ADJACENCIES_DIRTY = (1u << 1);
 	const static AlterationFlags FLAG_INTERFACES_DIRTY  = (1u << 2);
 	const static AlterationFlags FLAG_DANGLING          = (1u << 3);
+	const static AlterationFlags FLAG_GEOMETRY_DIRTY    = (1u << 4);
+
+private:
+	// The pool should be declared before the cells: cells release their
+	// neighbourhood storage into the pool when they are destroyed.
+	std::unique_ptr<std::pmr::synchronized_pool_resource> m_cellNeighbourhoodPool;
 
+protected:
 	PiercedVector<Vertex> m_vertices;
 	PiercedVector<Cell> m_cells;
 	PiercedVector<Interface> m_interfaces;
@@ -810,6 +825,8 @@ protected:
 	AlterationFlagsStorage m_alteredCells;
 	AlterationFlagsStorage m_alteredInterfaces;
 
+	std::unordered_set<long> m_movedVertices;
+
 #if BITPIT_ENABLE_MPI==1
 	PatchKernel(MPI_Comm communicator, std::size_t haloSize, AdaptionMode adaptionMode, PartitioningMode partitioningMode);
 	PatchKernel(int dimension, MPI_Comm communicator, std::size_t haloSize, AdaptionMode adaptionMode, PartitioningMode partitioningMode);
@@ -920,6 +937,14 @@ protected:
 	virtual void _setTol(double tolerance);
 	virtual void _resetTol();
 
+	virtual bool _isGeometricCacheEnabled() const;
+	virtual void _updateGeometricCache(bool forcedUpdated);
+	void setGeometryAltered(long vertexId = Vertex::NULL_ID);
+
+	const PatchSkdTree & getLocationTree() const;
+	void resetLocationTree();
+	virtual std::unique_ptr<PatchSkdTree> _createLocationTree() const;
+
 	virtual int _getDumpVersion() const = 0;
 	virtual void _dump(std::ostream &stream) const = 0;
 	virtual void _restore(std::istream &stream) = 0;
@@ -965,6 +990,35 @@ protected:
 	virtual bool isSameFace(const Cell &cell_A, int face_A, const Cell &cell_B, int face_B) const;
 
 private:
+#if BITPIT_ENABLE_OPENMP==1
+	static const long THREADED_ADJACENCIES_MIN_CELLS;
+	static const long THREADED_INTERFACES_MIN_CELLS;
+#endif
+
+	class CellConnectArena {
+
+	public:
+		CellConnectArena(std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+		long * allocate(std::size_t size);
+		void reserve(std::size_t size);
+		void clear();
+
+		std::size_t size() const;
+		std::size_t capacity() const;
+
+	private:
+		static const std::size_t DEFAULT_BLOCK_SIZE;
+
+		std::size_t m_blockSize;
+		std::vector<std::unique_ptr<long[]>> m_blocks;
+		std::size_t m_lastBlockSize;
+		std::size_t m_lastBlockCapacity;
+		std::size_t m_size;
+		std::size_t m_capacity;
+
+	};
+
 	struct GhostVertexInfo {
 		int owner;
 	};
@@ -978,6 +1032,10 @@ private:
 	std::unique_ptr<IndexGenerator<long>> m_interfaceIdGenerator;
 	std::unique_ptr<IndexGenerator<long>> m_cellIdGenerator;
 
+	std::unique_ptr<CellConnectArena> m_cellConnectArena;
+
+	mutable std::unique_ptr<PatchSkdTree> m_locationTree;
+
 	long m_nInternalVertices;
 #if BITPIT_ENABLE_MPI==1
 	long m_nGhostVertices;
@@ -1129,6 +1187,19 @@ private:
 	void createCellIndexGenerator(bool populate);
 	void importCellIndexGenerator(const PatchKernel &source);
 
+	void storeCellConnect(Cell &cell);
+	void storeCellArenaConnect(Cell &cell, long *arenaConnect);
+	void storeCellNeighbourhood(Cell &cell);
+	void storeNewCell(Cell &cell);
+	void compactCellConnectArena();
+
+	void flagMovedVerticesGeometry();
+
+#if BITPIT_ENABLE_OPENMP==1
+	bool matchHalfFacesThreaded(const std::vector<Cell *> &processList, const std::vector<CellHalfFace::Winding> &matchingWindings);
+	void buildInterfacesThreaded();
+#endif
+
 	void dumpInterfaceAutoIndexing(std::ostream &stream) const;
 	void restoreInterfaceAutoIndexing(std::istream &stream);
 	void createInterfaceIndexGenerator(bool populate);
@@ -625,6 +625,9 @@ PatchKernel::CellIterator PatchKernel::internalCell2GhostCell(long id, int owner
 		m_cells.swap(id, m_lastInternalCellId);
 	}
 
+	// Reset the location tree
+	resetLocationTree();
+
 	// Get the iterator pointing to the updated position of the element
 	CellIterator iterator = m_cells.find(id);
 
@@ -666,6 +669,9 @@ PatchKernel::CellIterator PatchKernel::ghostCell2InternalCell(long id)
 		m_cells.swap(id, m_firstGhostCellId);
 	}
 
+	// Reset the location tree
+	resetLocationTree();
+
 	// Get the iterator pointing to the updated position of the element
 	CellIterator iterator = m_cells.find(id);
 
@@ -911,10 +917,19 @@ PatchKernel::CellIterator PatchKernel::addCell(Cell &&source, int owner, int hal
 		id = source.getId();
 	}
 
-	int connectSize = source.getConnectSize();
-	std::unique_ptr<long[]> connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
-	if (!source.hasInfo()){
-		std::copy(source.getConnect(), source.getConnect() + connectSize, connectStorage.get());
+	// Add a cell of the same type
+	//
+	// The newly created cell will be replaced with the source, when the
+	// connectivity arena is enabled there is no need to create a temporary
+	// connectivity (the neighbourhood of the cell is not initialized until
+	// a connectivity is assigned).
+	std::unique_ptr<long[]> connectStorage;
+	if (!m_cellConnectArena) {
+		int connectSize = source.getConnectSize();
+		connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+		if (!source.hasInfo()){
+			std::copy(source.getConnect(), source.getConnect() + connectSize, connectStorage.get());
+		}
 	}
 
 	CellIterator iterator = addCell(source.getType(), std::move(connectStorage), owner, haloLayer, id);
@@ -924,6 +939,10 @@ PatchKernel::CellIterator PatchKernel::addCell(Cell &&source, int owner, int hal
 	cell = std::move(source);
 	cell.setId(id);
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeCellConnect(cell);
+	storeCellNeighbourhood(cell);
+
 	return iterator;
 }
 
@@ -981,10 +1000,25 @@ PatchKernel::CellIterator PatchKernel::addCell(ElementType type, const std::vect
 											   int owner, int haloLayer, long id)
 {
 	int connectSize = connectivity.size();
-	std::unique_ptr<long[]> connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
-	std::copy(connectivity.data(), connectivity.data() + connectSize, connectStorage.get());
 
-	return addCell(type, std::move(connectStorage), owner, haloLayer, id);
+	// Add the cell
+	//
+	// When the connectivity arena is enabled, the connectivity is copied
+	// directly into the arena once the cell has been created.
+	std::unique_ptr<long[]> connectStorage;
+	if (!m_cellConnectArena) {
+		connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+		std::copy(connectivity.data(), connectivity.data() + connectSize, connectStorage.get());
+	}
+
+	CellIterator iterator = addCell(type, std::move(connectStorage), owner, haloLayer, id);
+	if (m_cellConnectArena && iterator != cellEnd()) {
+		long *arenaConnect = m_cellConnectArena->allocate(connectSize);
+		std::copy(connectivity.data(), connectivity.data() + connectSize, arenaConnect);
+		storeCellArenaConnect(*iterator, arenaConnect);
+	}
+
+	return iterator;
 }
 
 /*!
@@ -1064,8 +1098,11 @@ PatchKernel::CellIterator PatchKernel::_addGhostCell(ElementType type, std::uniq
 	//
 	// If there are internal cells, the ghost cell should be inserted
 	// after the last internal cell.
-	bool storeInterfaces  = (getInterfacesBuildStrategy() != INTERFACES_NONE);
-	bool storeAdjacencies = storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
+	//
+	// When the connectivity arena is enabled, the neighbourhood storage is
+	// initialized after the connectivity has been stored.
+	bool storeInterfaces  = !m_cellConnectArena && (getInterfacesBuildStrategy() != INTERFACES_NONE);
+	bool storeAdjacencies = !m_cellConnectArena && (storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE));
 
 	CellIterator iterator;
 	if (m_lastInternalCellId < 0) {
@@ -1075,6 +1112,9 @@ PatchKernel::CellIterator PatchKernel::_addGhostCell(ElementType type, std::uniq
 	}
 	m_nGhostCells++;
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeNewCell(*iterator);
+
 	// Update the id of the first ghost cell
 	if (m_firstGhostCellId < 0) {
 		m_firstGhostCellId = id;
@@ -1154,15 +1194,20 @@ void PatchKernel::_restoreGhostCell(const CellIterator &iterator, ElementType ty
 	// Restore the cell
 	//
 	// There is no need to set the id of the cell as assigned, because
-	// also the index generator will be restored.
-	bool storeInterfaces  = (getInterfacesBuildStrategy() != INTERFACES_NONE);
-	bool storeAdjacencies = storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE);
+	// also the index generator will be restored. When the connectivity
+	// arena is enabled, the neighbourhood storage is initialized after
+	// the connectivity has been stored.
+	bool storeInterfaces  = !m_cellConnectArena && (getInterfacesBuildStrategy() != INTERFACES_NONE);
+	bool storeAdjacencies = !m_cellConnectArena && (storeInterfaces || (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE));
 
 	long cellId = iterator.getId();
 	Cell &cell = *iterator;
 	cell.initialize(iterator.getId(), type, std::move(connectStorage), false, storeInterfaces, storeAdjacencies);
 	m_nGhostCells++;
 
+	// Store the connectivity and the neighbourhood of the cell
+	storeNewCell(cell);
+
 	// Set ghost information
 	setGhostCellInfo(cellId, owner, haloLayer);
 
@@ -1027,7 +1027,8 @@ PatchSkdTree::PatchSkdTree(const PatchKernel *patch, bool interiorCellsOnly)
       m_interiorCellsOnly(interiorCellsOnly),
       m_threadSafeLookups(false)
 #if BITPIT_ENABLE_MPI
-    , m_rank(0), m_nProcessors(1), m_communicator(MPI_COMM_NULL)
+    , m_partitionInfoEnabled(true),
+      m_rank(0), m_nProcessors(1), m_communicator(MPI_COMM_NULL)
 #endif
 {
 
@@ -1147,12 +1148,15 @@ void PatchSkdTree::build(std::size_t leafThreshold, bool squeezeStorage)
 
 #if BITPIT_ENABLE_MPI
     // Set partition information
-    if (patch.isPartitioned()){
+    if (patch.isPartitioned() && m_partitionInfoEnabled){
         // Set communicator
         setCommunicator(patch.getCommunicator());
 
         // Build partition info with partition boxes if the patch is partitioned
         buildPartitionBoxes();
+    } else if (patch.isPartitioned()) {
+        m_rank        = patch.getRank();
+        m_nProcessors = patch.getProcessorCount();
     } else {
         m_rank        = 0;
         m_nProcessors = 1;
@@ -1411,6 +1415,262 @@ bool PatchSkdTree::areLookupsThreadSafe() const
     return m_threadSafeLookups;
 }
 
+/*!
+* Locates the cell that contains the specified point.
+*
+* The tree is traversed visiting only the nodes whose bounding box contains
+* the point, the containment test is then evaluated only for the cells of
+* the leaf nodes reached by the traversal.
+*
+* \param[in] point is the point
+* \result The id of the cell that contains the point. If the point is not
+* contained in any cell of the tree, the id of the null element is returned.
+*/
+long PatchSkdTree::locatePoint(const std::array<double, 3> &point) const
+{
+    return locatePoint(point, false);
+}
+
+/*!
+* Locates the cell that contains the specified point.
+*
+* The tree is traversed visiting only the nodes whose bounding box contains
+* the point, the containment test is then evaluated only for the cells of
+* the leaf nodes reached by the traversal.
+*
+* \param[in] point is the point
+* \param[in] interiorCellsOnly if set to true, only interior cells will be considered,
+* it will be possible to consider non-interior cells only if the tree has been
+* instantiated with non-interior cells support enabled
+* \result The id of the cell that contains the point. If the point is not
+* contained in any cell of the tree, the id of the null element is returned.
+*/
+long PatchSkdTree::locatePoint(const std::array<double, 3> &point, bool interiorCellsOnly) const
+{
+    // Get patch information
+    const PatchKernel &patch = getPatch();
+    double tolerance = patch.getTol();
+
+    // Early return if the tree is empty
+    std::size_t rootId = 0;
+    if (m_nodes.empty() || m_nodes[rootId].isEmpty()) {
+        return Cell::NULL_ID;
+    }
+
+    // Traverse the nodes whose bounding box contains the point
+    std::vector<std::size_t> nodeStack;
+    nodeStack.push_back(rootId);
+    while (!nodeStack.empty()) {
+        std::size_t nodeId = nodeStack.back();
+        const SkdNode &node = m_nodes[nodeId];
+        nodeStack.pop_back();
+
+        if (!node.getBoundingBox().boxContainsPoint(point, tolerance)) {
+            continue;
+        }
+
+        // Add the children to the stack
+        bool isLeaf = true;
+        for (int i = SkdNode::CHILD_BEGIN; i != SkdNode::CHILD_END; ++i) {
+            SkdNode::ChildLocation childLocation = static_cast<SkdNode::ChildLocation>(i);
+            if (node.hasChild(childLocation)) {
+                isLeaf = false;
+                nodeStack.push_back(node.getChildId(childLocation));
+            }
+        }
+
+        if (!isLeaf) {
+            continue;
+        }
+
+        // Check if the point is inside one of the cells of the leaf
+        std::size_t nNodeCells = node.getCellCount();
+        for (std::size_t n = 0; n < nNodeCells; ++n) {
+            long cellId = node.getCell(n);
+            if (interiorCellsOnly && !patch.getCell(cellId).isInterior()) {
+                continue;
+            }
+
+            if (cellContainsPoint(cellId, point)) {
+                return cellId;
+            }
+        }
+    }
+
+    return Cell::NULL_ID;
+}
+
+/*!
+* Locates the cells that contain the specified points.
+*
+* \param[in] nPoints is the number of the points
+* \param[in] points are the points coordinates
+* \param[out] ids on output it will contain the ids of the cells that contain
+* the points. If a point is not contained in any cell of the tree, the related
+* id will be set to the null id
+*/
+void PatchSkdTree::locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const
+{
+    locatePoint(nPoints, points, false, ids);
+}
+
+/*!
+* Locates the cells that contain the specified points.
+*
+* \param[in] nPoints is the number of the points
+* \param[in] points are the points coordinates
+* \param[in] interiorCellsOnly if set to true, only interior cells will be considered,
+* it will be possible to consider non-interior cells only if the tree has been
+* instantiated with non-interior cells support enabled
+* \param[out] ids on output it will contain the ids of the cells that contain
+* the points. If a point is not contained in any cell of the tree, the related
+* id will be set to the null id
+*/
+void PatchSkdTree::locatePoint(int nPoints, const std::array<double, 3> *points, bool interiorCellsOnly, long *ids) const
+{
+    for (int i = 0; i < nPoints; ++i) {
+        ids[i] = locatePoint(points[i], interiorCellsOnly);
+    }
+}
+
+#if BITPIT_ENABLE_MPI
+/*!
+* Given the specified points, considered distributed on the processes, locate
+* the cells that contain them.
+*
+* Points are located among the interior cells of all the partitions, for each
+* point the id of the cell that contains it and the rank of the process that
+* owns the cell are returned. The function uses the communicator of the patch
+* and doesn't need the partition information of the tree, however, it is a
+* collective function and it has to be called by all the processes of the
+* patch.
+*
+* \param[in] nPoints is the number of the points
+* \param[in] points are the points coordinates
+* \param[out] ids on output it will contain the ids of the cells that contain
+* the points. If a point is not contained in any cell of the patch, the related
+* id will be set to the null id
+* \param[out] ranks on output it will contain the rank indices of the processes
+* owner of the cells that contain the points. If a point is not contained in
+* any cell of the patch, the related rank will be set to -1
+*/
+void PatchSkdTree::locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const
+{
+    // Early return is the patch is not partitioned
+    const PatchKernel &patch = getPatch();
+    if (!patch.isPartitioned()) {
+        for (int i = 0; i < nPoints; ++i) {
+            ids[i] = locatePoint(points[i]);
+            if (ids[i] != Cell::NULL_ID) {
+                ranks[i] = patch.getRank();
+            } else {
+                ranks[i] = -1;
+            }
+        }
+
+        return;
+    }
+
+    // Get MPI information
+    MPI_Comm communicator = patch.getCommunicator();
+    int rank = patch.getRank();
+    int nProcessors = patch.getProcessorCount();
+
+    // Gather the number of points associated to each process
+    std::vector<int> pointsCount(nProcessors);
+    MPI_Allgather(&nPoints, 1, MPI_INT, pointsCount.data(), 1, MPI_INT, communicator);
+
+    // Evaluate information for data communications
+    std::vector<int> globalPointsDispls(nProcessors, 0);
+    std::vector<int> globalPointsOffsets(nProcessors, 0);
+    std::vector<int> globalPointsDataCount(nProcessors, 0);
+
+    globalPointsDataCount[0] = 3 * pointsCount[0];
+    for (int i = 1; i < nProcessors; ++i) {
+        globalPointsDispls[i]     = globalPointsDispls[i - 1] + 3 * pointsCount[i - 1];
+        globalPointsOffsets[i]    = globalPointsOffsets[i - 1] + pointsCount[i - 1];
+        globalPointsDataCount[i]  = 3 * pointsCount[i];
+    }
+
+    int nGlobalPoints = globalPointsOffsets.back() + pointsCount.back();
+
+    // Gather point coordinates
+    std::vector<std::array<double,3>> globalPoints(nGlobalPoints);
+    int pointsDataCount = 3 * nPoints;
+    MPI_Allgatherv(points, pointsDataCount, MPI_DOUBLE, globalPoints.data(),
+                   globalPointsDataCount.data(), globalPointsDispls.data(), MPI_DOUBLE, communicator);
+
+    // Locate the points among the local interior cells
+    //
+    // Located points are given a null distance, this allows to use the
+    // global cell distance reduction to identify the owner of the cell.
+    std::vector<SkdGlobalCellDistance> globalCellDistances(nGlobalPoints);
+    for (int i = 0; i < nGlobalPoints; ++i) {
+        const std::array<double, 3> &point = globalPoints[i];
+
+        SkdGlobalCellDistance &globalCellDistance = globalCellDistances[i];
+        int &cellRank = globalCellDistance.getRank();
+        long &cellId = globalCellDistance.getId();
+        double &cellDistance = globalCellDistance.getDistance();
+
+        bool interiorCellsOnly = true;
+        cellId = locatePoint(point, interiorCellsOnly);
+        if (cellId != Cell::NULL_ID) {
+            cellRank     = rank;
+            cellDistance = 0.;
+        } else {
+            cellRank     = -1;
+            cellDistance = std::numeric_limits<double>::max();
+        }
+    }
+
+    // Exchange location information
+    MPI_Datatype globalCellDistanceDatatype = SkdGlobalCellDistance::getMPIDatatype();
+    MPI_Op globalCellDistanceMinOp = SkdGlobalCellDistance::getMPIMinOperation();
+    for (int targetRank = 0; targetRank < nProcessors; ++targetRank) {
+        SkdGlobalCellDistance *globalCellDistance = globalCellDistances.data() + globalPointsOffsets[targetRank];
+        if (rank == targetRank) {
+            MPI_Reduce(MPI_IN_PLACE, globalCellDistance, pointsCount[targetRank], globalCellDistanceDatatype, globalCellDistanceMinOp, targetRank, communicator);
+        } else {
+            MPI_Reduce(globalCellDistance, globalCellDistance, pointsCount[targetRank], globalCellDistanceDatatype, globalCellDistanceMinOp, targetRank, communicator);
+        }
+    }
+
+    // Update output arguments
+    for (int i = 0; i < nPoints; ++i) {
+        int globalIndex = i + globalPointsOffsets[rank];
+        const SkdGlobalCellDistance &globalCellDistance = globalCellDistances[globalIndex];
+
+        double cellDistance;
+        globalCellDistance.exportData(ranks + i, ids + i, &cellDistance);
+    }
+}
+#endif
+
+/*!
+* Checks if the specified cell contains the given point.
+*
+* The base implementation considers the point contained in the cell if its
+* distance from the cell is below the geometrical tolerance of the patch,
+* trees built on volume patches should re-implement this function using a
+* proper containment test.
+*
+* \param[in] id is the id of the cell
+* \param[in] point is the point
+* \result Returns true if the cell contains the point, false otherwise.
+*/
+bool PatchSkdTree::cellContainsPoint(long id, const std::array<double, 3> &point) const
+{
+    const PatchKernel &patch = getPatch();
+    const Cell &cell = patch.getCell(id);
+
+    int nCellVertices = cell.getVertexCount();
+    BITPIT_CREATE_WORKSPACE(cellVertexCoordinates, std::array<double BITPIT_COMMA 3>, nCellVertices, ReferenceElementInfo::MAX_ELEM_VERTICES);
+    patch.getElementVertexCoordinates(cell, cellVertexCoordinates);
+
+    return (cell.evalPointDistance(point, cellVertexCoordinates) <= patch.getTol());
+}
+
 #if BITPIT_ENABLE_MPI
 /*!
 * Sets the MPI communicator to be used for parallel communications.
@@ -1518,6 +1778,35 @@ void PatchSkdTree::buildPartitionBoxes()
 }
 
 
+/*!
+* Set if partition information should be evaluated when the tree is built.
+*
+* Partition information (i.e., the communicator and the bounding boxes of
+* the partitions) is needed by the functions that look for the closest cells
+* among all the partitions. When partition information is enabled, building
+* the tree of a partitioned patch is a collective operation. Point location,
+* both local and global, doesn't need partition information.
+*
+* The setting will be applied the next time the tree is built.
+*
+* \param enable if set to true partition information will be evaluated
+*/
+void PatchSkdTree::enablePartitionInfo(bool enable)
+{
+    m_partitionInfoEnabled = enable;
+}
+
+/*!
+* Check if partition information is evaluated when the tree is built.
+*
+* \result Returns true if partition information is evaluated when the tree
+* is built, false otherwise.
+*/
+bool PatchSkdTree::isPartitionInfoEnabled() const
+{
+    return m_partitionInfoEnabled;
+}
+
 /*!
 * Get the bounding box associated to a partition.
 *
@@ -194,7 +194,18 @@ public:
     void enableThreadSafeLookups(bool enable);
     bool areLookupsThreadSafe() const;
 
+    long locatePoint(const std::array<double, 3> &point) const;
+    long locatePoint(const std::array<double, 3> &point, bool interiorCellsOnly) const;
+    void locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const;
+    void locatePoint(int nPoints, const std::array<double, 3> *points, bool interiorCellsOnly, long *ids) const;
 #if BITPIT_ENABLE_MPI
+    void locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const;
+#endif
+
+#if BITPIT_ENABLE_MPI
+    void enablePartitionInfo(bool enable);
+    bool isPartitionInfoEnabled() const;
+
     const SkdBox & getPartitionBox(int rank) const;
 #endif
 
@@ -213,6 +224,8 @@ protected:
     bool m_threadSafeLookups;                                       /*! Controls if the tree lookups should be thread safe */
 
 #if BITPIT_ENABLE_MPI
+    bool m_partitionInfoEnabled;                                    /*! Controls if partition information is evaluated when the tree is built */
+
     int m_rank;
     int m_nProcessors;
     MPI_Comm m_communicator;
@@ -223,6 +236,8 @@ protected:
 
     SkdNode & _getNode(std::size_t nodeId);
 
+    virtual bool cellContainsPoint(long id, const std::array<double, 3> &point) const;
+
 #if BITPIT_ENABLE_MPI
     bool isCommunicatorSet() const;
     const MPI_Comm & getCommunicator() const;
@@ -0,0 +1,47 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include "point_skd_tree.hpp"
+
+namespace bitpit {
+
+/*!
+* \class PointSkdTree
+*
+* \brief The PointSkdTree implements a Bounding Volume Hierarchy tree for
+* point patches.
+*/
+
+/*!
+* Constructor.
+*
+* \param patch is the point patch that will be use to build the tree
+* \param interiorCellsOnly if set to true, only interior cells will be considered
+*/
+PointSkdTree::PointSkdTree(const PointKernel *patch, bool interiorCellsOnly)
+    : PatchSkdTree(patch, interiorCellsOnly)
+{
+}
+
+}
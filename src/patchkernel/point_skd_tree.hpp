@@ -0,0 +1,42 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+# ifndef __BITPIT_POINT_SKD_TREE_HPP__
+# define __BITPIT_POINT_SKD_TREE_HPP__
+
+#include "patch_skd_tree.hpp"
+#include "point_kernel.hpp"
+
+namespace bitpit {
+
+class PointSkdTree : public PatchSkdTree {
+
+public:
+    PointSkdTree(const PointKernel *patch, bool interiorCellsOnly = false);
+
+};
+
+}
+
+#endif
@@ -162,6 +162,24 @@ SurfaceKernel::SurfaceKernel(int id, int dimension, AdaptionMode adaptionMode)
 {
 }
 
+/*!
+	Copy constructor.
+
+	If the geometric cache of the source patch is enabled, the cached values
+	are copied and the cache is synchronized with the cells of the new patch.
+
+	\param other is another patch whose content is copied into this patch
+*/
+SurfaceKernel::SurfaceKernel(const SurfaceKernel &other)
+	: PatchKernel(other)
+{
+	if (other.m_cellAreaCache) {
+		m_cellAreaCache     = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(*(other.m_cellAreaCache), &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_cellCentroidCache = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(*(other.m_cellCentroidCache), &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_facetNormalCache  = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(*(other.m_facetNormalCache), &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+	}
+}
+
 /*!
 	Initialize the patch
 */
@@ -2161,4 +2179,185 @@ int SurfaceKernel::getFacetOrderedLocalEdge(const Cell &facet, std::size_t n) co
     }
 }
 
+/*!
+ * Checks if the geometric cache is enabled.
+ *
+ * \result Returns true if the geometric cache is enabled, false otherwise.
+*/
+bool SurfaceKernel::isGeometricCacheEnabled() const
+{
+    return _isGeometricCacheEnabled();
+}
+
+/*!
+ * Enables or disables the geometric cache.
+ *
+ * When the cache is enabled, area, centroid and normal of the cells are
+ * stored in contiguous storages synchronized with the cells of the patch.
+ * Cached values are evaluated when the cache is enabled and they are
+ * re-evaluated, only for the altered cells, when the patch is updated.
+ * Transformations of the patch (e.g., translation, rotation, scaling)
+ * re-evaluate the whole cache. Cached normals are evaluated using the
+ * default orientation of evalFacetNormal.
+ *
+ * Vertices moved through PatchKernel::setVertexCoords are tracked, cells
+ * that share them are re-evaluated when the patch is updated. Changes to
+ * the vertex coordinates performed directly through the vertices are not
+ * tracked, after such changes the cache has to be explicitly refreshed
+ * disabling and re-enabling it.
+ *
+ * \param enabled if set to true the cache will be enabled, otherwise it
+ * will be disabled and its memory released
+*/
+void SurfaceKernel::setGeometricCacheEnabled(bool enabled)
+{
+    if (enabled == isGeometricCacheEnabled()) {
+        return;
+    }
+
+    if (enabled) {
+        m_cellAreaCache     = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(1, &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+        m_cellCentroidCache = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(1, &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+        m_facetNormalCache  = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(1, &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+
+        _updateGeometricCache(true);
+    } else {
+        m_cellAreaCache.reset();
+        m_cellCentroidCache.reset();
+        m_facetNormalCache.reset();
+
+        unsetCellAlterationFlags(FLAG_GEOMETRY_DIRTY);
+    }
+}
+
+/*!
+ * Gets the area of the specified cell.
+ *
+ * If the geometric cache is enabled, the cached value is returned,
+ * otherwise the area is evaluated.
+ *
+ * \param[in] id is the id of the cell
+ * \result The area of the specified cell.
+*/
+double SurfaceKernel::getCellArea(long id) const
+{
+    if (!m_cellAreaCache) {
+        return evalCellArea(id);
+    }
+
+    return m_cellAreaCache->at(id);
+}
+
+/*!
+ * Gets the centroid of the specified cell.
+ *
+ * If the geometric cache is enabled, the cached value is returned,
+ * otherwise the centroid is evaluated.
+ *
+ * \param[in] id is the id of the cell
+ * \result The centroid of the specified cell.
+*/
+std::array<double, 3> SurfaceKernel::getCellCentroid(long id) const
+{
+    if (!m_cellCentroidCache) {
+        return evalCellCentroid(id);
+    }
+
+    return m_cellCentroidCache->at(id);
+}
+
+/*!
+ * Gets the normal of the specified cell.
+ *
+ * If the geometric cache is enabled, the cached value is returned,
+ * otherwise the normal is evaluated. In both cases the default orientation
+ * of evalFacetNormal is used.
+ *
+ * \param[in] id is the id of the cell
+ * \result The normal of the specified cell.
+*/
+std::array<double, 3> SurfaceKernel::getFacetNormal(long id) const
+{
+    if (!m_facetNormalCache) {
+        return evalFacetNormal(id);
+    }
+
+    return m_facetNormalCache->at(id);
+}
+
+/*!
+ * Checks if the geometric cache is enabled.
+ *
+ * \result Returns true if the geometric cache is enabled, false otherwise.
+*/
+bool SurfaceKernel::_isGeometricCacheEnabled() const
+{
+    return static_cast<bool>(m_cellAreaCache);
+}
+
+/*!
+ * Internal function to update the geometric cache.
+ *
+ * Geometric quantities are evaluated in bulk. When OpenMP support is
+ * enabled, the evaluation is distributed among the threads; generic
+ * polygons are evaluated one at a time, because their evaluation relies
+ * on temporary storages that are not thread-safe.
+ *
+ * \param[in] forcedUpdated if set to true, the geometric quantities of all
+ * the cells will be evaluated, regardless of their alteration flags
+*/
+void SurfaceKernel::_updateGeometricCache(bool forcedUpdated)
+{
+    // Identify the cells to update
+    std::vector<std::size_t> cellRawIds;
+    if (forcedUpdated) {
+        cellRawIds.reserve(m_cells.size());
+        CellConstIterator endItr = cellConstEnd();
+        for (CellConstIterator itr = cellConstBegin(); itr != endItr; ++itr) {
+            cellRawIds.push_back(itr.getRawIndex());
+        }
+    } else {
+        for (const auto &entry : m_alteredCells) {
+            if (!testAlterationFlags(entry.second, FLAG_GEOMETRY_DIRTY)) {
+                continue;
+            }
+
+            long cellId = entry.first;
+            if (!m_cells.exists(cellId)) {
+                continue;
+            }
+
+            cellRawIds.push_back(m_cells.rawIndex(cellId));
+        }
+    }
+
+    // Evaluate cell quantities
+    auto evalCellGeometry = [this](std::size_t rawId) {
+        long cellId = m_cells.rawAt(rawId).getId();
+
+        m_cellAreaCache->rawAt(rawId)     = evalCellArea(cellId);
+        m_cellCentroidCache->rawAt(rawId) = evalCellCentroid(cellId);
+        m_facetNormalCache->rawAt(rawId)  = evalFacetNormal(cellId);
+    };
+
+    long nUpdatedCells = cellRawIds.size();
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(dynamic, 256)
+#endif
+    for (long n = 0; n < nUpdatedCells; ++n) {
+        std::size_t rawId = cellRawIds[n];
+        if (m_cells.rawAt(rawId).getType() == ElementType::POLYGON) {
+#if BITPIT_ENABLE_OPENMP==1
+            #pragma omp critical (SurfaceKernel_updateGeometricCache)
+#endif
+            evalCellGeometry(rawId);
+        } else {
+            evalCellGeometry(rawId);
+        }
+    }
+
+    // Geometric quantities are now updated
+    unsetCellAlterationFlags(FLAG_GEOMETRY_DIRTY);
+}
+
 }
@@ -87,6 +87,13 @@ public:
     bool areFacetEdgesOrdered(const Cell &facet) const;
     int getFacetOrderedLocalEdge(const Cell &facet, std::size_t n) const;
 
+    bool isGeometricCacheEnabled() const;
+    void setGeometricCacheEnabled(bool enabled);
+
+    double getCellArea(long id) const;
+    std::array<double, 3> getCellCentroid(long id) const;
+    std::array<double, 3> getFacetNormal(long id) const;
+
     void displayQualityStats(std::ostream&, unsigned int padding = 0) const;
     std::vector<double> computeHistogram(eval_f_ funct_, std::vector<double> &bins, long &count, int n_intervals = 8, unsigned short mask = SELECT_ALL) const;
 
@@ -100,6 +107,10 @@ private:
 
     bool haveSameOrientation(const Cell &cell_A, int face_A, const Cell &cell_B, int face_B) const;
 
+    std::unique_ptr<PiercedStorage<double, long>> m_cellAreaCache;
+    std::unique_ptr<PiercedStorage<std::array<double, 3>, long>> m_cellCentroidCache;
+    std::unique_ptr<PiercedStorage<std::array<double, 3>, long>> m_facetNormalCache;
+
 protected:
 #if BITPIT_ENABLE_MPI==1
     SurfaceKernel(MPI_Comm communicator, std::size_t haloSize, AdaptionMode adaptionMode, PartitioningMode partitioningMode);
@@ -110,6 +121,10 @@ protected:
     SurfaceKernel(int dimension, AdaptionMode adaptionMode);
     SurfaceKernel(int id, int dimension, AdaptionMode adaptionMode);
 #endif
+    SurfaceKernel(const SurfaceKernel &other);
+
+    bool _isGeometricCacheEnabled() const override;
+    void _updateGeometricCache(bool forcedUpdated) override;
 
 };
 
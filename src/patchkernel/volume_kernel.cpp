@@ -138,6 +138,26 @@ VolumeKernel::VolumeKernel(int id, int dimension, AdaptionMode adaptionMode)
 {
 }
 
+/*!
+	Copy constructor.
+
+	If the geometric cache of the source patch is enabled, the cached values
+	are copied and the cache is synchronized with the cells and interfaces
+	of the new patch.
+
+	\param other is another patch whose content is copied into this patch
+*/
+VolumeKernel::VolumeKernel(const VolumeKernel &other)
+	: PatchKernel(other)
+{
+	if (other.m_cellVolumeCache) {
+		m_cellVolumeCache      = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(*(other.m_cellVolumeCache), &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_cellCentroidCache    = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(*(other.m_cellCentroidCache), &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_interfaceAreaCache   = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(*(other.m_interfaceAreaCache), &m_interfaces, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_interfaceNormalCache = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(*(other.m_interfaceNormalCache), &m_interfaces, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+	}
+}
+
 /*!
 	Get the codimension of the patch in the volume space.
 
@@ -313,4 +333,254 @@ int VolumeKernel::getFaceOrderedLocalVertex(const Cell &cell, int face, std::siz
     }
 }
 
+/*!
+	Checks if the geometric cache is enabled.
+
+	\result Returns true if the geometric cache is enabled, false otherwise.
+*/
+bool VolumeKernel::isGeometricCacheEnabled() const
+{
+	return _isGeometricCacheEnabled();
+}
+
+/*!
+	Enables or disables the geometric cache.
+
+	When the cache is enabled, volume and centroid of the cells and area and
+	normal of the interfaces are stored in contiguous storages synchronized
+	with the cells and the interfaces of the patch. Cached values are
+	evaluated when the cache is enabled and they are re-evaluated, only for
+	the altered entities, when the patch is updated. Transformations of the
+	patch (e.g., translation, rotation, scaling) re-evaluate the whole cache.
+
+	Vertices moved through PatchKernel::setVertexCoords are tracked, cells
+	and interfaces that share them are re-evaluated when the patch is
+	updated. Changes to the vertex coordinates performed directly through
+	the vertices are not tracked, after such changes the cache has to be
+	explicitly refreshed disabling and re-enabling it.
+
+	\param enabled if set to true the cache will be enabled, otherwise it
+	will be disabled and its memory released
+*/
+void VolumeKernel::setGeometricCacheEnabled(bool enabled)
+{
+	if (enabled == isGeometricCacheEnabled()) {
+		return;
+	}
+
+	if (enabled) {
+		m_cellVolumeCache      = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(1, &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_cellCentroidCache    = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(1, &m_cells, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_interfaceAreaCache   = std::unique_ptr<PiercedStorage<double, long>>(new PiercedStorage<double, long>(1, &m_interfaces, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+		m_interfaceNormalCache = std::unique_ptr<PiercedStorage<std::array<double, 3>, long>>(new PiercedStorage<std::array<double, 3>, long>(1, &m_interfaces, PiercedSyncMaster::SYNC_MODE_CONCURRENT));
+
+		_updateGeometricCache(true);
+	} else {
+		m_cellVolumeCache.reset();
+		m_cellCentroidCache.reset();
+		m_interfaceAreaCache.reset();
+		m_interfaceNormalCache.reset();
+
+		unsetCellAlterationFlags(FLAG_GEOMETRY_DIRTY);
+		unsetInterfaceAlterationFlags(FLAG_GEOMETRY_DIRTY);
+	}
+}
+
+/*!
+	Gets the volume of the specified cell.
+
+	If the geometric cache is enabled, the cached value is returned,
+	otherwise the volume is evaluated.
+
+	\param id is the id of the cell
+	\result The volume of the specified cell.
+*/
+double VolumeKernel::getCellVolume(long id) const
+{
+	if (!m_cellVolumeCache) {
+		return evalCellVolume(id);
+	}
+
+	return m_cellVolumeCache->at(id);
+}
+
+/*!
+	Gets the centroid of the specified cell.
+
+	If the geometric cache is enabled, the cached value is returned,
+	otherwise the centroid is evaluated.
+
+	\param id is the id of the cell
+	\result The centroid of the specified cell.
+*/
+std::array<double, 3> VolumeKernel::getCellCentroid(long id) const
+{
+	if (!m_cellCentroidCache) {
+		return evalCellCentroid(id);
+	}
+
+	return m_cellCentroidCache->at(id);
+}
+
+/*!
+	Gets the area of the specified interface.
+
+	If the geometric cache is enabled, the cached value is returned,
+	otherwise the area is evaluated.
+
+	\param id is the id of the interface
+	\result The area of the specified interface.
+*/
+double VolumeKernel::getInterfaceArea(long id) const
+{
+	if (!m_interfaceAreaCache) {
+		return evalInterfaceArea(id);
+	}
+
+	return m_interfaceAreaCache->at(id);
+}
+
+/*!
+	Gets the normal of the specified interface.
+
+	If the geometric cache is enabled, the cached value is returned,
+	otherwise the normal is evaluated.
+
+	\param id is the id of the interface
+	\result The normal of the specified interface.
+*/
+std::array<double, 3> VolumeKernel::getInterfaceNormal(long id) const
+{
+	if (!m_interfaceNormalCache) {
+		return evalInterfaceNormal(id);
+	}
+
+	return m_interfaceNormalCache->at(id);
+}
+
+/*!
+	Checks if the geometric cache is enabled.
+
+	\result Returns true if the geometric cache is enabled, false otherwise.
+*/
+bool VolumeKernel::_isGeometricCacheEnabled() const
+{
+	return static_cast<bool>(m_cellVolumeCache);
+}
+
+/*!
+	Internal function to update the geometric cache.
+
+	Geometric quantities are evaluated in bulk. When OpenMP support is
+	enabled, the evaluation is distributed among the threads; generic
+	polygons and polyhedra are evaluated one at a time, because their
+	evaluation relies on temporary storages that are not thread-safe.
+
+	\param forcedUpdated if set to true, the geometric quantities of all the
+	cells and interfaces will be evaluated, regardless of their alteration
+	flags
+*/
+void VolumeKernel::_updateGeometricCache(bool forcedUpdated)
+{
+	// Identify the cells to update
+	std::vector<std::size_t> cellRawIds;
+	if (forcedUpdated) {
+		cellRawIds.reserve(m_cells.size());
+		CellConstIterator endItr = cellConstEnd();
+		for (CellConstIterator itr = cellConstBegin(); itr != endItr; ++itr) {
+			cellRawIds.push_back(itr.getRawIndex());
+		}
+	} else {
+		for (const auto &entry : m_alteredCells) {
+			if (!testAlterationFlags(entry.second, FLAG_GEOMETRY_DIRTY)) {
+				continue;
+			}
+
+			long cellId = entry.first;
+			if (!m_cells.exists(cellId)) {
+				continue;
+			}
+
+			cellRawIds.push_back(m_cells.rawIndex(cellId));
+		}
+	}
+
+	// Identify the interfaces to update
+	std::vector<std::size_t> interfaceRawIds;
+	if (forcedUpdated) {
+		interfaceRawIds.reserve(m_interfaces.size());
+		InterfaceConstIterator endItr = interfaceConstEnd();
+		for (InterfaceConstIterator itr = interfaceConstBegin(); itr != endItr; ++itr) {
+			interfaceRawIds.push_back(itr.getRawIndex());
+		}
+	} else {
+		for (const auto &entry : m_alteredInterfaces) {
+			if (!testAlterationFlags(entry.second, FLAG_GEOMETRY_DIRTY)) {
+				continue;
+			}
+
+			long interfaceId = entry.first;
+			if (!m_interfaces.exists(interfaceId)) {
+				continue;
+			}
+
+			interfaceRawIds.push_back(m_interfaces.rawIndex(interfaceId));
+		}
+	}
+
+	// Evaluate cell quantities
+	auto evalCellGeometry = [this](std::size_t rawId) {
+		long cellId = m_cells.rawAt(rawId).getId();
+
+		m_cellVolumeCache->rawAt(rawId)   = evalCellVolume(cellId);
+		m_cellCentroidCache->rawAt(rawId) = evalCellCentroid(cellId);
+	};
+
+	long nUpdatedCells = cellRawIds.size();
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (long n = 0; n < nUpdatedCells; ++n) {
+		std::size_t rawId = cellRawIds[n];
+		ElementType cellType = m_cells.rawAt(rawId).getType();
+		if (cellType == ElementType::POLYGON || cellType == ElementType::POLYHEDRON) {
+#if BITPIT_ENABLE_OPENMP==1
+			#pragma omp critical (VolumeKernel_updateGeometricCache)
+#endif
+			evalCellGeometry(rawId);
+		} else {
+			evalCellGeometry(rawId);
+		}
+	}
+
+	// Evaluate interface quantities
+	auto evalInterfaceGeometry = [this](std::size_t rawId) {
+		long interfaceId = m_interfaces.rawAt(rawId).getId();
+
+		m_interfaceAreaCache->rawAt(rawId)   = evalInterfaceArea(interfaceId);
+		m_interfaceNormalCache->rawAt(rawId) = evalInterfaceNormal(interfaceId);
+	};
+
+	long nUpdatedInterfaces = interfaceRawIds.size();
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel for schedule(dynamic, 256)
+#endif
+	for (long n = 0; n < nUpdatedInterfaces; ++n) {
+		std::size_t rawId = interfaceRawIds[n];
+		ElementType interfaceType = m_interfaces.rawAt(rawId).getType();
+		if (interfaceType == ElementType::POLYGON) {
+#if BITPIT_ENABLE_OPENMP==1
+			#pragma omp critical (VolumeKernel_updateGeometricCache)
+#endif
+			evalInterfaceGeometry(rawId);
+		} else {
+			evalInterfaceGeometry(rawId);
+		}
+	}
+
+	// Geometric quantities are now updated
+	unsetCellAlterationFlags(FLAG_GEOMETRY_DIRTY);
+	unsetInterfaceAlterationFlags(FLAG_GEOMETRY_DIRTY);
+}
+
 }
@@ -54,6 +54,14 @@ public:
 	bool areFaceVerticesOrdered(const Cell &cell, int face) const;
 	int getFaceOrderedLocalVertex(const Cell &cell, int face, std::size_t n) const;
 
+	bool isGeometricCacheEnabled() const;
+	void setGeometricCacheEnabled(bool enabled);
+
+	double getCellVolume(long id) const;
+	std::array<double, 3> getCellCentroid(long id) const;
+	double getInterfaceArea(long id) const;
+	std::array<double, 3> getInterfaceNormal(long id) const;
+
 protected:
 #if BITPIT_ENABLE_MPI==1
 	VolumeKernel(MPI_Comm communicator, std::size_t haloSize, AdaptionMode adaptionMode, PartitioningMode partitioningMode);
@@ -64,6 +72,16 @@ protected:
 	VolumeKernel(int dimension, AdaptionMode adaptionMode);
 	VolumeKernel(int id, int dimension, AdaptionMode adaptionMode);
 #endif
+	VolumeKernel(const VolumeKernel &other);
+
+	bool _isGeometricCacheEnabled() const override;
+	void _updateGeometricCache(bool forcedUpdated) override;
+
+private:
+	std::unique_ptr<PiercedStorage<double, long>> m_cellVolumeCache;
+	std::unique_ptr<PiercedStorage<std::array<double, 3>, long>> m_cellCentroidCache;
+	std::unique_ptr<PiercedStorage<double, long>> m_interfaceAreaCache;
+	std::unique_ptr<PiercedStorage<std::array<double, 3>, long>> m_interfaceNormalCache;
 
 };
 
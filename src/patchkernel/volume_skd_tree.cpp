@@ -44,4 +44,20 @@ VolumeSkdTree::VolumeSkdTree(const VolumeKernel *patch, bool interiorCellsOnly)
 {
 }
 
+/*!
+* Checks if the specified cell contains the given point.
+*
+* The containment test of the volume patch is used.
+*
+* \param[in] id is the id of the cell
+* \param[in] point is the point
+* \result Returns true if the cell contains the point, false otherwise.
+*/
+bool VolumeSkdTree::cellContainsPoint(long id, const std::array<double, 3> &point) const
+{
+    const VolumeKernel &patch = static_cast<const VolumeKernel &>(getPatch());
+
+    return patch.isPointInside(id, point);
+}
+
 }
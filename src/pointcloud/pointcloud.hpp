@@ -57,6 +57,10 @@ public:
 
     // Search algorithms
     long locatePoint(const std::array<double, 3> &point) const override;
+    void locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const;
+#if BITPIT_ENABLE_MPI==1
+    void locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const;
+#endif
 
 protected:
     PointCloud(const PointCloud &other) = default;
@@ -65,6 +69,8 @@ protected:
     void _dump(std::ostream &stream) const override;
     void _restore(std::istream &stream) override;
 
+    std::unique_ptr<PatchSkdTree> _createLocationTree() const override;
+
 };
 
 }
@@ -342,7 +342,7 @@ void VolCartesian::_updateInterfaces()
 
 		// Initialize interfaces
 		for (Cell &cell : getCells()) {
-			cell.setInterfaces(FlatVector2D<long>(nCellFaces, 1, Interface::NULL_ID));
+			cell.setInterfaces(Cell::NeighbourhoodStorage(nCellFaces, 1, Interface::NULL_ID));
 		}
 
 		// Build interfaces
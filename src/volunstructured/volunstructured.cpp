@@ -22,6 +22,7 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include "bitpit_CG.hpp"
 #include "bitpit_common.hpp"
 
 #include "volunstructured.hpp"
@@ -279,33 +280,66 @@ void VolUnstructured::_restore(std::istream &stream)
 /*!
  * Checks if the specified point is inside the patch.
  *
+ * The point is located using locatePoint(const std::array<double, 3> &),
+ * hence cells of standard types are assumed to be convex.
+ *
  * \param[in] point is the point to be checked
  * \result Returns true if the point is inside the patch, false otherwise.
  */
 bool VolUnstructured::isPointInside(const std::array<double, 3> &point) const
 {
-	BITPIT_UNUSED(point);
-
-	throw std::runtime_error ("The function 'isPointInside' is not implemented yet");
-
-	return false;
+	return (locatePoint(point) != Cell::NULL_ID);
 }
 
 /*!
 	Checks if the specified point is inside a cell.
 
+	Polygons and polyhedra are checked using a crossing-number test, hence
+	the check is exact also for non-convex cells. All other elements are
+	assumed to be convex: the point is considered inside the cell if it lies
+	on the inner side of all the faces of the cell. Points whose distance
+	from the boundary of the cell is below the geometrical tolerance of the
+	patch are considered inside the cell.
+
 	\param[in] id is the idof the cell
 	\param[in] point is the point to be checked
 	\result Returns true if the point is inside the cell, false otherwise.
  */
 bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point) const
 {
-	BITPIT_UNUSED(id);
-	BITPIT_UNUSED(point);
+	const double tolerance = getTol();
+
+	// Discard points outside the bounding box of the cell
+	std::array<double, 3> boxMinPoint;
+	std::array<double, 3> boxMaxPoint;
+	evalCellBoundingBox(id, &boxMinPoint, &boxMaxPoint);
+	for (int d = 0; d < 3; ++d) {
+		if (point[d] < boxMinPoint[d] - tolerance || point[d] > boxMaxPoint[d] + tolerance) {
+			return false;
+		}
+	}
+
+	// Get cell information
+	const Cell &cell = getCell(id);
+
+	ConstProxyVector<long> cellVertexIds = cell.getVertexIds();
+	std::size_t nCellVertices = cellVertexIds.size();
+	BITPIT_CREATE_WORKSPACE(cellVertexCoordinates, std::array<double BITPIT_COMMA 3>, nCellVertices, ReferenceElementInfo::MAX_ELEM_VERTICES);
+	getVertexCoords(nCellVertices, cellVertexIds.data(), cellVertexCoordinates);
 
-	throw std::runtime_error ("The function 'isPointInside' is not implemented yet");
+	// Check if the point is inside the cell
+	switch (cell.getType()) {
 
-	return false;
+	case ElementType::POLYGON:
+		return isPointInsidePolygon(cell, cellVertexCoordinates, point);
+
+	case ElementType::POLYHEDRON:
+		return isPointInsidePolyhedron(cell, cellVertexCoordinates, point);
+
+	default:
+		return isPointInsideConvexCell(cell, cellVertexCoordinates, point);
+
+	}
 }
 
 /*!
@@ -314,6 +348,17 @@ bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point)
  * If the point is not inside the patch, the function returns the id of the
  * null element.
  *
+ * The point is located using a VolumeSkdTree that is built the first time
+ * a point is located and that is kept until the cells of the patch are
+ * altered, the coordinates of the vertices are changed or the tolerance is
+ * changed.
+ *
+ * Only polygons and polyhedra are checked with a test that is exact also
+ * for non-convex cells, all other cells are assumed to be convex (see
+ * isPointInside(long, const std::array<double, 3> &)). Points that lie in
+ * the concave region of a non-convex cell of a standard type (e.g., a
+ * distorted hexahedron) may not be located correctly.
+ *
  * \param[in] point is the point to be checked
  * \result Returns the linear id of the cell the contains the point. If the
  * point is not inside the patch, the function returns the id of the null
@@ -321,11 +366,315 @@ bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point)
  */
 long VolUnstructured::locatePoint(const std::array<double, 3> &point) const
 {
-	BITPIT_UNUSED(point);
+	return getLocationTree().locatePoint(point);
+}
+
+/*!
+ * Locates the cells that contain the specified points.
+ *
+ * Points are located as in locatePoint(const std::array<double, 3> &), hence
+ * cells of standard types are assumed to be convex.
+ *
+ * \param[in] nPoints is the number of the points
+ * \param[in] points are the points coordinates
+ * \param[out] ids on output it will contain the ids of the cells that contain
+ * the points. If a point is not inside the patch, the related id will be set
+ * to the null id
+ */
+void VolUnstructured::locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const
+{
+	getLocationTree().locatePoint(nPoints, points, ids);
+}
+
+#if BITPIT_ENABLE_MPI==1
+/*!
+ * Given the specified points, considered distributed on the processes, locate
+ * the cells that contain them.
+ *
+ * Points are located among the interior cells of all the partitions. This is
+ * a collective function and it has to be called by all the processes of the
+ * patch.
+ *
+ * \param[in] nPoints is the number of the points
+ * \param[in] points are the points coordinates
+ * \param[out] ids on output it will contain the ids of the cells that contain
+ * the points. If a point is not inside the patch, the related id will be set
+ * to the null id
+ * \param[out] ranks on output it will contain the rank indices of the processes
+ * owner of the cells that contain the points. If a point is not inside the
+ * patch, the related rank will be set to -1
+ */
+void VolUnstructured::locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const
+{
+	getLocationTree().locateGlobalPoint(nPoints, points, ids, ranks);
+}
+#endif
+
+/*!
+	Creates the tree used for locating points in the patch.
+
+	\result The tree used for locating points in the patch.
+*/
+std::unique_ptr<PatchSkdTree> VolUnstructured::_createLocationTree() const
+{
+	return std::unique_ptr<PatchSkdTree>(new VolumeSkdTree(this));
+}
 
-	throw std::runtime_error ("The function 'locatePoint' is not implemented yet");
+/*!
+	Checks if the specified point is inside a convex cell.
+
+	The point is considered inside the cell if it lies on the inner side of
+	all the faces of the cell.
+
+	\param[in] cell is the cell
+	\param[in] vertexCoords are the coordinates of the vertices of the cell
+	\param[in] point is the point to be checked
+	\result Returns true if the point is inside the cell, false otherwise.
+*/
+bool VolUnstructured::isPointInsideConvexCell(const Cell &cell, const std::array<double, 3> *vertexCoords,
+                                              const std::array<double, 3> &point) const
+{
+	const double tolerance = getTol();
+
+	std::array<double, 3> cellCentroid = cell.evalCentroid(vertexCoords);
+
+	// Check if the point lies on the inner side of all the faces
+	bool isThreeDimensionalCell = isThreeDimensional();
+
+	int nCellFaces = cell.getFaceCount();
+	for (int face = 0; face < nCellFaces; ++face) {
+		ConstProxyVector<int> faceLocalVertexIds = cell.getFaceLocalVertexIds(face);
+		std::size_t nFaceVertices = faceLocalVertexIds.size();
+
+		// Face centroid
+		std::array<double, 3> faceCentroid = {{0., 0., 0.}};
+		for (std::size_t k = 0; k < nFaceVertices; ++k) {
+			faceCentroid += vertexCoords[faceLocalVertexIds[k]];
+		}
+		faceCentroid /= static_cast<double>(nFaceVertices);
+
+		// Face normal
+		//
+		// On two-dimensional patches faces are segments and the normal is the
+		// component of the face-to-cell-centroid vector orthogonal to the
+		// segment. On three-dimensional patches the normal is evaluated using
+		// a fan triangulation of the face (vertices of pixel faces are not
+		// ordered counter-clockwise, hence only the first triangle is used).
+		const std::array<double, 3> &V_A = vertexCoords[faceLocalVertexIds[0]];
+		const std::array<double, 3> &V_B = vertexCoords[faceLocalVertexIds[1]];
+
+		std::array<double, 3> faceNormal;
+		if (!isThreeDimensionalCell) {
+			std::array<double, 3> faceTangent = V_B - V_A;
+			std::array<double, 3> centroidOffset = cellCentroid - V_A;
+			faceNormal = dotProduct(centroidOffset, faceTangent) / dotProduct(faceTangent, faceTangent) * faceTangent - centroidOffset;
+		} else if (cell.getFaceType(face) == ElementType::PIXEL) {
+			const std::array<double, 3> &V_C = vertexCoords[faceLocalVertexIds[2]];
+			faceNormal = crossProduct(V_B - V_A, V_C - V_A);
+		} else {
+			faceNormal = {{0., 0., 0.}};
+			for (std::size_t k = 1; k < nFaceVertices - 1; ++k) {
+				const std::array<double, 3> &V_k   = vertexCoords[faceLocalVertexIds[k]];
+				const std::array<double, 3> &V_kp1 = vertexCoords[faceLocalVertexIds[k + 1]];
+				faceNormal += crossProduct(V_k - V_A, V_kp1 - V_A);
+			}
+		}
+
+		double faceNormalMagnitude = norm2(faceNormal);
+		if (faceNormalMagnitude <= 0.) {
+			continue;
+		}
+		faceNormal /= faceNormalMagnitude;
+
+		// Orient the normal outwards
+		if (dotProduct(faceNormal, faceCentroid - cellCentroid) < 0.) {
+			faceNormal = -1. * faceNormal;
+		}
+
+		// Check on which side of the face the point lies
+		if (dotProduct(point - faceCentroid, faceNormal) > tolerance) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+	Checks if the specified point is inside a polygonal cell.
+
+	The polygon is projected on the coordinate plane on which its projection
+	is largest, then a ray parallel to one of the axes of that plane is cast
+	from the point: the point is inside the polygon if the ray crosses the
+	boundary of the polygon an odd number of times. Crossings are counted
+	using half-open intervals, hence rays passing through a vertex are not
+	counted twice.
+
+	\param[in] cell is the cell
+	\param[in] vertexCoords are the coordinates of the vertices of the cell
+	\param[in] point is the point to be checked
+	\result Returns true if the point is inside the cell, false otherwise.
+*/
+bool VolUnstructured::isPointInsidePolygon(const Cell &cell, const std::array<double, 3> *vertexCoords,
+                                           const std::array<double, 3> &point) const
+{
+	const double tolerance = getTol();
+
+	int nCellVertices = cell.getVertexCount();
+
+	// Points on the boundary are inside the polygon
+	for (int k = 0; k < nCellVertices; ++k) {
+		const std::array<double, 3> &V_k   = vertexCoords[k];
+		const std::array<double, 3> &V_kp1 = vertexCoords[(k + 1) % nCellVertices];
+		if (CGElem::distancePointSegment(point, V_k, V_kp1) <= tolerance) {
+			return true;
+		}
+	}
+
+	// Identify the projection plane
+	std::array<double, 3> normal = {{0., 0., 0.}};
+	for (int k = 0; k < nCellVertices; ++k) {
+		normal += crossProduct(vertexCoords[k], vertexCoords[(k + 1) % nCellVertices]);
+	}
+
+	int normalDirection = 0;
+	for (int d = 1; d < 3; ++d) {
+		if (std::abs(normal[d]) > std::abs(normal[normalDirection])) {
+			normalDirection = d;
+		}
+	}
+
+	int u = (normalDirection + 1) % 3;
+	int v = (normalDirection + 2) % 3;
+
+	// Count the crossings
+	bool isInside = false;
+	for (int k = 0; k < nCellVertices; ++k) {
+		const std::array<double, 3> &V_k   = vertexCoords[k];
+		const std::array<double, 3> &V_kp1 = vertexCoords[(k + 1) % nCellVertices];
+		if ((V_k[v] > point[v]) == (V_kp1[v] > point[v])) {
+			continue;
+		}
+
+		double crossing = V_k[u] + (point[v] - V_k[v]) / (V_kp1[v] - V_k[v]) * (V_kp1[u] - V_k[u]);
+		if (point[u] < crossing) {
+			isInside = !isInside;
+		}
+	}
+
+	return isInside;
+}
+
+/*!
+	Checks if the specified point is inside a polyhedral cell.
+
+	The faces of the polyhedron are split in triangles and a ray is cast from
+	the point: the point is inside the polyhedron if the ray crosses the
+	triangles an odd number of times. Faces are split using a fan, on
+	non-convex faces the triangles of the fan overlap, but the parity of the
+	number of crossings is not affected. If the ray passes too close to an
+	edge or a vertex of the triangles, the crossing cannot be reliably counted
+	and the test is repeated along a different direction.
+
+	\param[in] cell is the cell
+	\param[in] vertexCoords are the coordinates of the vertices of the cell
+	\param[in] point is the point to be checked
+	\result Returns true if the point is inside the cell, false otherwise.
+*/
+bool VolUnstructured::isPointInsidePolyhedron(const Cell &cell, const std::array<double, 3> *vertexCoords,
+                                              const std::array<double, 3> &point) const
+{
+	const double tolerance = getTol();
+
+	const double BARYCENTRIC_TOLERANCE = 1e-10;
+
+	const std::array<std::array<double, 3>, 4> RAY_DIRECTIONS = {{
+		{{ 0.34202014,  0.61237244,  0.71274108}},
+		{{-0.70710678,  0.25881905,  0.65797986}},
+		{{ 0.44721360, -0.81649658,  0.36514837}},
+		{{-0.26726124, -0.53452248, -0.80178373}}
+	}};
+
+	// Split the faces in triangles
+	std::vector<std::array<int, 3>> triangles;
+
+	int nCellFaces = cell.getFaceCount();
+	for (int face = 0; face < nCellFaces; ++face) {
+		ConstProxyVector<int> faceLocalVertexIds = cell.getFaceLocalVertexIds(face);
+		std::size_t nFaceVertices = faceLocalVertexIds.size();
+		for (std::size_t k = 1; k < nFaceVertices - 1; ++k) {
+			triangles.push_back({{faceLocalVertexIds[0], faceLocalVertexIds[k], faceLocalVertexIds[k + 1]}});
+		}
+	}
+
+	// Points on the boundary are inside the polyhedron
+	for (const std::array<int, 3> &triangle : triangles) {
+		const std::array<double, 3> &V_A = vertexCoords[triangle[0]];
+		const std::array<double, 3> &V_B = vertexCoords[triangle[1]];
+		const std::array<double, 3> &V_C = vertexCoords[triangle[2]];
+		if (CGElem::distancePointTriangle(point, V_A, V_B, V_C) <= tolerance) {
+			return true;
+		}
+	}
+
+	// Count the crossings
+	int nCrossings = 0;
+	for (const std::array<double, 3> &direction : RAY_DIRECTIONS) {
+		nCrossings = 0;
+		bool isAmbiguous = false;
+		for (const std::array<int, 3> &triangle : triangles) {
+			const std::array<double, 3> &V_A = vertexCoords[triangle[0]];
+			const std::array<double, 3> &V_B = vertexCoords[triangle[1]];
+			const std::array<double, 3> &V_C = vertexCoords[triangle[2]];
+
+			std::array<double, 3> edge_AB = V_B - V_A;
+			std::array<double, 3> edge_AC = V_C - V_A;
+
+			// Rays parallel to the triangle don't cross it, unless they lie
+			// on the plane of the triangle.
+			std::array<double, 3> directionCrossAC = crossProduct(direction, edge_AC);
+			double determinant = dotProduct(edge_AB, directionCrossAC);
+			if (std::abs(determinant) <= BARYCENTRIC_TOLERANCE * norm2(edge_AB) * norm2(edge_AC)) {
+				std::array<double, 3> triangleNormal = crossProduct(edge_AB, edge_AC);
+				double triangleNormalMagnitude = norm2(triangleNormal);
+				if (triangleNormalMagnitude > 0. && std::abs(dotProduct(point - V_A, triangleNormal)) <= tolerance * triangleNormalMagnitude) {
+					isAmbiguous = true;
+					break;
+				}
+
+				continue;
+			}
+
+			// Evaluate the intersection between the ray and the triangle
+			std::array<double, 3> offset = point - V_A;
+			std::array<double, 3> offsetCrossAB = crossProduct(offset, edge_AB);
+
+			double distance = dotProduct(edge_AC, offsetCrossAB) / determinant;
+			if (distance <= 0.) {
+				continue;
+			}
+
+			double lambda_B = dotProduct(offset, directionCrossAC) / determinant;
+			double lambda_C = dotProduct(direction, offsetCrossAB) / determinant;
+			double lambda_A = 1. - lambda_B - lambda_C;
+			if (lambda_A < -BARYCENTRIC_TOLERANCE || lambda_B < -BARYCENTRIC_TOLERANCE || lambda_C < -BARYCENTRIC_TOLERANCE) {
+				continue;
+			}
+
+			if (lambda_A <= BARYCENTRIC_TOLERANCE || lambda_B <= BARYCENTRIC_TOLERANCE || lambda_C <= BARYCENTRIC_TOLERANCE) {
+				isAmbiguous = true;
+				break;
+			}
+
+			++nCrossings;
+		}
+
+		if (!isAmbiguous) {
+			break;
+		}
+	}
 
-	return Cell::NULL_ID;
+	return (nCrossings % 2 == 1);
 }
 
 #if BITPIT_ENABLE_MPI==1
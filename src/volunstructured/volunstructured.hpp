@@ -61,17 +61,26 @@ public:
 	bool isPointInside(const std::array<double, 3> &point) const override;
 	bool isPointInside(long id, const std::array<double, 3> &point) const override;
 	long locatePoint(const std::array<double, 3> &point) const override;
+	void locatePoint(int nPoints, const std::array<double, 3> *points, long *ids) const;
+#if BITPIT_ENABLE_MPI==1
+	void locateGlobalPoint(int nPoints, const std::array<double, 3> *points, long *ids, int *ranks) const;
+#endif
 
 protected:
 	int _getDumpVersion() const override;
 	void _dump(std::ostream &stream) const override;
 	void _restore(std::istream &stream) override;
 
+	std::unique_ptr<PatchSkdTree> _createLocationTree() const override;
+
 #if BITPIT_ENABLE_MPI==1
 	std::size_t _getMaxHaloSize() override;
 #endif
 
 private:
+	bool isPointInsideConvexCell(const Cell &cell, const std::array<double, 3> *vertexCoords, const std::array<double, 3> &point) const;
+	bool isPointInsidePolygon(const Cell &cell, const std::array<double, 3> *vertexCoords, const std::array<double, 3> &point) const;
+	bool isPointInsidePolyhedron(const Cell &cell, const std::array<double, 3> *vertexCoords, const std::array<double, 3> &point) const;
 
 };
 
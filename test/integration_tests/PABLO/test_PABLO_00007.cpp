@@ -0,0 +1,227 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Set the number of threads used by the shared-memory parallel kernels.
+*
+* \param nThreads is the number of threads
+*/
+void setThreadCount(int nThreads)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nThreads);
+#else
+    BITPIT_UNUSED(nThreads);
+#endif
+}
+
+/*!
+* Mark the octants of the tree for adaption.
+*
+* Markers are chosen using a deterministic pseudo-random sequence, this way
+* two identical trees will receive identical markers.
+*
+* \param tree is the tree
+* \param refinementMarker is the marker that will be used for refinement
+*/
+void setMarkers(ParaTree *tree, int8_t refinementMarker)
+{
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < tree->getNumOctants(); ++i) {
+        seed = 1664525 * seed + 1013904223;
+        uint32_t value = (seed >> 16) % 10;
+        if (value < 1) {
+            tree->setMarker(i, refinementMarker);
+        } else if (value < 6) {
+            tree->setMarker(i, -1);
+        }
+    }
+}
+
+/*!
+* Compare two trees and their adaption mappings.
+*
+* \param reference is the reference tree
+* \param tree is the tree that will be compared with the reference
+* \result Returns zero if the trees are equal, a non-zero value otherwise.
+*/
+int compareTrees(const ParaTree &reference, const ParaTree &tree)
+{
+    uint32_t nOctants = reference.getNumOctants();
+    if (tree.getNumOctants() != nOctants) {
+        log::cout() << "  Number of octants differs: " << tree.getNumOctants() << " vs " << nOctants << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> referenceMapper;
+    std::vector<bool> referenceIsGhost;
+    std::vector<uint32_t> mapper;
+    std::vector<bool> isGhost;
+    for (uint32_t i = 0; i < nOctants; ++i) {
+        const Octant *referenceOctant = reference.getOctant(i);
+        const Octant *octant = tree.getOctant(i);
+
+        bool equal = (referenceOctant->getMorton() == octant->getMorton());
+        equal &= (referenceOctant->getLevel() == octant->getLevel());
+        equal &= (referenceOctant->getMarker() == octant->getMarker());
+        equal &= (referenceOctant->getIsNewR() == octant->getIsNewR());
+        equal &= (referenceOctant->getIsNewC() == octant->getIsNewC());
+        equal &= (referenceOctant->getBalance() == octant->getBalance());
+        for (uint8_t face = 0; face < reference.getNfaces(); ++face) {
+            equal &= (referenceOctant->getBound(face) == octant->getBound(face));
+        }
+
+        reference.getMapping(i, referenceMapper, referenceIsGhost);
+        tree.getMapping(i, mapper, isGhost);
+        equal &= (referenceMapper == mapper);
+        equal &= (referenceIsGhost == isGhost);
+
+        if (!equal) {
+            log::cout() << "  Octant " << i << " differs from the reference" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 001
+*
+* Testing threaded adaption of a tree.
+*
+* \param dimension is the dimension of the tree
+* \param nThreads is the number of threads used for the threaded adaption
+*/
+int subtest_001(uint8_t dimension, int nThreads)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", threads " << nThreads << std::endl;
+
+    // Create the trees
+    ParaTree serialTree(dimension);
+    ParaTree threadedTree(dimension);
+
+    int nInitialRefinements = (dimension == 2) ? 7 : 5;
+    for (int i = 0; i < nInitialRefinements; ++i) {
+        serialTree.adaptGlobalRefine();
+        threadedTree.adaptGlobalRefine();
+    }
+
+    // Adapt the trees
+    int8_t refinementMarkers[] = {1, -1, 2};
+    for (int8_t refinementMarker : refinementMarkers) {
+        setMarkers(&serialTree, refinementMarker);
+        setThreadCount(1);
+        serialTree.adapt(true);
+
+        setMarkers(&threadedTree, refinementMarker);
+        setThreadCount(nThreads);
+        threadedTree.adapt(true);
+
+        log::cout() << "     Number of octants after adaption: " << threadedTree.getNumOctants() << std::endl;
+        if (compareTrees(serialTree, threadedTree) != 0) {
+            return 1;
+        }
+    }
+
+    // Coarse the trees globally
+    setThreadCount(1);
+    serialTree.adaptGlobalCoarse(true);
+
+    setThreadCount(nThreads);
+    threadedTree.adaptGlobalCoarse(true);
+
+    log::cout() << "     Number of octants after global coarsening: " << threadedTree.getNumOctants() << std::endl;
+    if (compareTrees(serialTree, threadedTree) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing threaded adaption" << std::endl;
+
+    int status = 0;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3 && status == 0; ++dimension) {
+            for (int nThreads : {2, 3, 4}) {
+                status = subtest_001(dimension, nThreads);
+                if (status != 0) {
+                    log::cout() << "Threaded adaption differs from serial adaption" << std::endl;
+                    break;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        status = 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
@@ -0,0 +1,197 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <random>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Subtest 001
+*
+* Testing evaluation of Morton numbers.
+*
+* \param dimension is the dimension of the space
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+    log::cout() << "     BMI2 instructions enabled: " << PABLO::isMortonBMI2Enabled() << std::endl;
+
+    // Generate random coordinates
+    const std::size_t N_POINTS = 100000;
+
+    int maxLevel = PABLO::computeMaximumLevel(dimension);
+    uint32_t maxCoordinate = (uint32_t(1) << maxLevel) - 1;
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<uint32_t> distribution(0, maxCoordinate);
+
+    std::vector<uint32_t> x(N_POINTS);
+    std::vector<uint32_t> y(N_POINTS);
+    std::vector<uint32_t> z(N_POINTS, 0);
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        x[i] = distribution(generator);
+        y[i] = distribution(generator);
+        if (dimension == 3) {
+            z[i] = distribution(generator);
+        }
+    }
+
+    // Evaluate Morton numbers
+    std::vector<uint64_t> batchMortons(N_POINTS);
+    if (dimension == 3) {
+        PABLO::computeMorton3D(N_POINTS, x.data(), y.data(), z.data(), batchMortons.data());
+    } else {
+        PABLO::computeMorton2D(N_POINTS, x.data(), y.data(), batchMortons.data());
+    }
+
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        uint64_t referenceMorton;
+        if (dimension == 3) {
+            referenceMorton = PABLO::computeMorton3DMagicBits(x[i], y[i], z[i]);
+        } else {
+            referenceMorton = PABLO::computeMorton2DMagicBits(x[i], y[i]);
+        }
+
+        uint64_t morton = PABLO::computeMorton(dimension, x[i], y[i], z[i]);
+        if (morton != referenceMorton) {
+            log::cout() << "     Morton number of point " << i << " is not correct" << std::endl;
+            return 1;
+        }
+
+        if (batchMortons[i] != referenceMorton) {
+            log::cout() << "     Batch Morton number of point " << i << " is not correct" << std::endl;
+            return 1;
+        }
+
+#if BITPIT_PABLO_ENABLE_BMI2==1
+        if (PABLO::isMortonBMI2Enabled()) {
+            uint64_t bmi2Morton;
+            if (dimension == 3) {
+                bmi2Morton = PABLO::computeMorton3DBMI2(x[i], y[i], z[i]);
+            } else {
+                bmi2Morton = PABLO::computeMorton2DBMI2(x[i], y[i]);
+            }
+
+            if (bmi2Morton != referenceMorton) {
+                log::cout() << "     BMI2 Morton number of point " << i << " is not correct" << std::endl;
+                return 1;
+            }
+        }
+#endif
+    }
+
+    // Evaluate coordinates
+    std::vector<uint32_t> batchX(N_POINTS);
+    std::vector<uint32_t> batchY(N_POINTS);
+    std::vector<uint32_t> batchZ(N_POINTS, 0);
+    if (dimension == 3) {
+        PABLO::computeCoordinates3D(N_POINTS, batchMortons.data(), batchX.data(), batchY.data(), batchZ.data());
+    } else {
+        PABLO::computeCoordinates2D(N_POINTS, batchMortons.data(), batchX.data(), batchY.data());
+    }
+
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        for (int d = 0; d < 3; ++d) {
+            uint32_t expectedCoordinate;
+            uint32_t batchCoordinate;
+            if (d == 0) {
+                expectedCoordinate = x[i];
+                batchCoordinate    = batchX[i];
+            } else if (d == 1) {
+                expectedCoordinate = y[i];
+                batchCoordinate    = batchY[i];
+            } else {
+                expectedCoordinate = z[i];
+                batchCoordinate    = batchZ[i];
+            }
+
+            if (PABLO::computeCoordinate(dimension, batchMortons[i], d) != expectedCoordinate) {
+                log::cout() << "     Coordinate " << d << " of point " << i << " is not correct" << std::endl;
+                return 1;
+            }
+
+            if (batchCoordinate != expectedCoordinate) {
+                log::cout() << "     Batch coordinate " << d << " of point " << i << " is not correct" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing Morton numbers" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,225 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Set the number of threads used by the shared-memory parallel kernels.
+*
+* \param nThreads is the number of threads
+*/
+void setThreadCount(int nThreads)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nThreads);
+#else
+    BITPIT_UNUSED(nThreads);
+#endif
+}
+
+/*!
+* Check the connectivity of a tree.
+*
+* Every vertex of every octant should point to a node with the same logical
+* coordinates of the vertex, nodes should be unique and sorted by their
+* persistent key.
+*
+* \param tree is the tree
+* \result Returns zero if the connectivity is valid, a non-zero value otherwise.
+*/
+int checkConnectivity(const ParaTree &tree)
+{
+    uint8_t dimension = tree.getDim();
+    uint32_t nNodes = tree.getNumNodes();
+    for (uint32_t n = 1; n < nNodes; ++n) {
+        const u32array3 &previousNode = tree.getNodeLogicalCoordinates(n - 1);
+        const u32array3 &node = tree.getNodeLogicalCoordinates(n);
+        uint64_t previousKey = PABLO::computeXYZKey(dimension, previousNode[0], previousNode[1], previousNode[2]);
+        uint64_t key = PABLO::computeXYZKey(dimension, node[0], node[1], node[2]);
+        if (key <= previousKey) {
+            log::cout() << "  Nodes " << (n - 1) << " and " << n << " are not sorted" << std::endl;
+            return 1;
+        }
+    }
+
+    const FlatVector2D<uint32_t> &connectivity = tree.getConnectivityFlat();
+    if (connectivity.size() != tree.getNumOctants()) {
+        log::cout() << "  Connectivity size differs from the number of octants" << std::endl;
+        return 1;
+    }
+
+    std::vector<bool> usedNodes(nNodes, false);
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        const Octant *octant = tree.getOctant(i);
+        ConstProxyVector<uint32_t> octantConnect = tree.getConnectivity(i);
+        if (octantConnect.size() != tree.getNnodes()) {
+            log::cout() << "  Octant " << i << " has a wrong number of nodes" << std::endl;
+            return 1;
+        }
+
+        for (uint8_t j = 0; j < tree.getNnodes(); ++j) {
+            uint32_t nodeId = octantConnect[j];
+            if (nodeId != connectivity.getItem(i, j) || nodeId >= nNodes) {
+                log::cout() << "  Octant " << i << " has an invalid node " << (int) j << std::endl;
+                return 1;
+            }
+
+            if (tree.getNodeLogicalCoordinates(nodeId) != octant->getLogicalNode(j)) {
+                log::cout() << "  Node " << (int) j << " of octant " << i << " has wrong coordinates" << std::endl;
+                return 1;
+            }
+
+            usedNodes[nodeId] = true;
+        }
+    }
+
+    for (uint32_t n = 0; n < nNodes; ++n) {
+        if (!usedNodes[n]) {
+            log::cout() << "  Node " << n << " is not used by any octant" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 001
+*
+* Testing connectivity of an adapted tree.
+*
+* \param dimension is the dimension of the tree
+* \param nThreads is the number of threads used for building the connectivity
+*/
+int subtest_001(uint8_t dimension, int nThreads)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", threads " << nThreads << std::endl;
+
+    setThreadCount(nThreads);
+
+    // Create the tree
+    ParaTree tree(dimension);
+
+    int nInitialRefinements = (dimension == 2) ? 7 : 5;
+    for (int i = 0; i < nInitialRefinements; ++i) {
+        tree.adaptGlobalRefine();
+    }
+
+    // Refine the tree around a corner of the domain
+    for (int k = 0; k < 2; ++k) {
+        for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+            darray3 center = tree.getCenter(i);
+            if (center[0] < 0.3 && center[1] < 0.3) {
+                tree.setMarker(i, 1);
+            }
+        }
+        tree.adapt();
+    }
+
+    // Compute the connectivity
+    tree.computeConnectivity();
+    log::cout() << "     Number of octants: " << tree.getNumOctants() << std::endl;
+    log::cout() << "     Number of nodes: " << tree.getNumNodes() << std::endl;
+    if (checkConnectivity(tree) != 0) {
+        return 1;
+    }
+
+    // Update the connectivity after a further refinement
+    tree.adaptGlobalRefine();
+    tree.updateConnectivity();
+    log::cout() << "     Number of nodes after global refinement: " << tree.getNumNodes() << std::endl;
+    if (checkConnectivity(tree) != 0) {
+        return 1;
+    }
+
+    // Release the connectivity
+    tree.clearConnectivity();
+    if (tree.getNumNodes() != 0 || tree.getConnectivityFlat().size() != 0 || tree.getConnectivity().size() != 0) {
+        log::cout() << "  Connectivity has not been cleared" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing flat connectivity" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            for (int nThreads : {1, 3}) {
+                status = subtest_001(dimension, nThreads);
+                if (status != 0) {
+                    log::cout() << "Connectivity is not valid" << std::endl;
+                    return status;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,180 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <sstream>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check if the restored tree matches the original tree.
+*
+* \param tree is the original tree
+* \param restored is the restored tree
+* \result Returns true if the trees are equal, false otherwise.
+*/
+bool compareTrees(const ParaTree &tree, const ParaTree &restored)
+{
+    if (tree.getNumOctants() != restored.getNumOctants()) {
+        log::cout() << "  Number of octants doesn't match" << std::endl;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        const Octant *octant = tree.getOctant(i);
+        const Octant *restoredOctant = restored.getOctant(i);
+        if (octant->getMorton() != restoredOctant->getMorton() || octant->getLevel() != restoredOctant->getLevel()) {
+            log::cout() << "  Octant " << i << " doesn't match" << std::endl;
+            return false;
+        }
+
+        for (int face = 0; face < 2 * tree.getDim(); ++face) {
+            if (octant->getBound(face) != restoredOctant->getBound(face)) {
+                log::cout() << "  Boundary information of octant " << i << " doesn't match" << std::endl;
+                return false;
+            }
+        }
+
+        if (octant->getMarker() != restoredOctant->getMarker() || octant->getBalance() != restoredOctant->getBalance() ||
+                octant->getIsNewR() != restoredOctant->getIsNewR() || octant->getIsNewC() != restoredOctant->getIsNewC()) {
+            log::cout() << "  Information of octant " << i << " doesn't match" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing compressed dump and restore.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create the tree
+    ParaTree octree(dimension);
+    for (int i = 0; i < 4; ++i) {
+        octree.adaptGlobalRefine();
+    }
+
+    for (uint32_t i = 0; i < octree.getNumOctants(); ++i) {
+        if (i % 7 == 0) {
+            octree.setMarker(i, 2);
+        } else if (i % 11 == 0) {
+            octree.setBalance(i, false);
+        }
+    }
+    octree.adapt();
+
+    for (uint32_t i = 0; i < octree.getNumOctants(); i += 3) {
+        octree.setMarker(i, -1);
+    }
+
+    // Dump the tree with and without compression
+    std::size_t dumpSizes[2];
+    for (bool compression : {false, true}) {
+        octree.setOctantCompression(compression);
+
+        std::stringstream stream;
+        octree.dump(stream);
+        dumpSizes[compression] = stream.str().size();
+
+        ParaTree restored;
+        restored.restore(stream);
+        if (!compareTrees(octree, restored)) {
+            log::cout() << "  Restored tree doesn't match (compression " << compression << ")" << std::endl;
+            return 1;
+        }
+    }
+
+    log::cout() << "     Uncompressed dump size: " << dumpSizes[0] << std::endl;
+    log::cout() << "     Compressed dump size  : " << dumpSizes[1] << std::endl;
+
+    if (3 * dumpSizes[1] > dumpSizes[0]) {
+        log::cout() << "  Compressed dump is too large" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing compressed dump and restore" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Compressed dump is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,216 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Mark the octants of the tree for adaption.
+*
+* Markers are chosen using a deterministic pseudo-random sequence.
+*
+* \param tree is the tree
+* \param seed is the seed of the sequence
+*/
+void setMarkers(ParaTree *tree, uint32_t seed)
+{
+    for (uint32_t i = 0; i < tree->getNumOctants(); ++i) {
+        seed = 1664525 * seed + 1013904223;
+        uint32_t value = (seed >> 16) % 10;
+        if (value < 2) {
+            tree->setMarker(i, 1);
+        } else if (value < 6) {
+            tree->setMarker(i, -1);
+        }
+    }
+}
+
+/*!
+* Compare the neighbour graph of the tree with the neighbours evaluated by
+* findNeighbours.
+*
+* \param tree is the tree
+* \result Returns zero if the graph is valid, a non-zero value otherwise.
+*/
+int checkNeighbourGraph(const ParaTree &tree)
+{
+    uint8_t maxCodim = tree.getNeighbourGraphCodimension();
+    if (maxCodim != tree.getDim()) {
+        log::cout() << "  Neighbour graph has not been computed" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> neighs;
+    std::vector<bool> isGhost;
+    std::vector<uint32_t> graphNeighs;
+    std::vector<bool> graphIsGhost;
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        for (uint8_t codim = 1; codim <= maxCodim; ++codim) {
+            uint8_t nEntities;
+            if (codim == 1) {
+                nEntities = tree.getNfaces();
+            } else if (codim == 2 && tree.getDim() == 3) {
+                nEntities = tree.getNedges();
+            } else {
+                nEntities = tree.getNnodes();
+            }
+
+            for (uint8_t k = 0; k < nEntities; ++k) {
+                tree.findNeighbours(i, k, codim, neighs, isGhost);
+                tree.getGraphNeighbours(i, k, codim, graphNeighs, graphIsGhost);
+                ConstProxyVector<uint32_t> graphNeighsProxy = tree.getGraphNeighbours(i, k, codim);
+
+                bool equal = (neighs == graphNeighs);
+                equal &= (isGhost == graphIsGhost);
+                equal &= (graphNeighsProxy.size() == neighs.size());
+                equal &= std::equal(neighs.begin(), neighs.end(), graphNeighsProxy.begin());
+                if (!equal) {
+                    log::cout() << "  Neighbours of entity " << (int) k << " with codimension " << (int) codim
+                                << " of octant " << i << " differ from the graph" << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 001
+*
+* Testing the neighbour graph and its update after the modifications of
+* the tree.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create the tree
+    ParaTree tree(dimension);
+    tree.setPeriodic(0);
+
+    int nInitialRefinements = (dimension == 2) ? 5 : 3;
+    for (int i = 0; i < nInitialRefinements; ++i) {
+        tree.adaptGlobalRefine();
+    }
+
+    // Compute the graph on the serial tree
+    tree.computeNeighbourGraph(dimension);
+    if (checkNeighbourGraph(tree) != 0) {
+        return 1;
+    }
+
+    // Partition the tree
+    tree.loadBalance();
+    log::cout() << "     Number of octants after partitioning: " << tree.getNumOctants() << std::endl;
+    if (checkNeighbourGraph(tree) != 0) {
+        return 1;
+    }
+
+    // Adapt the tree tracking the changes (incremental update)
+    for (uint32_t seed : {1u, 2u, 3u}) {
+        setMarkers(&tree, seed);
+        tree.adapt(true);
+        log::cout() << "     Number of octants after mapped adaption: " << tree.getNumOctants() << std::endl;
+        if (checkNeighbourGraph(tree) != 0) {
+            return 1;
+        }
+    }
+
+    // Coarse the tree tracking the changes (incremental update)
+    tree.adaptGlobalCoarse(true);
+    log::cout() << "     Number of octants after mapped global coarsening: " << tree.getNumOctants() << std::endl;
+    if (checkNeighbourGraph(tree) != 0) {
+        return 1;
+    }
+
+    // Adapt the tree without tracking the changes
+    setMarkers(&tree, 4);
+    tree.adapt(false);
+    log::cout() << "     Number of octants after unmapped adaption: " << tree.getNumOctants() << std::endl;
+    if (checkNeighbourGraph(tree) != 0) {
+        return 1;
+    }
+
+    // Global refinement and load balance
+    tree.adaptGlobalRefine(true);
+    tree.loadBalance();
+    log::cout() << "     Number of octants after refinement and balancing: " << tree.getNumOctants() << std::endl;
+    if (checkNeighbourGraph(tree) != 0) {
+        return 1;
+    }
+
+    // Clear the graph
+    tree.clearNeighbourGraph();
+    if (tree.getNeighbourGraphCodimension() != 0) {
+        log::cout() << "  Neighbour graph has not been cleared" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing neighbour graph" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Neighbour graph is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
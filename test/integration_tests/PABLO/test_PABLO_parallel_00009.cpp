@@ -0,0 +1,283 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* User data communicator that exchanges the global indices of the octants.
+*
+* If the variable size flag is set, the number of values exchanged for each
+* octant depends on the global index of the octant.
+*/
+class GlobalIndexComm : public DataCommInterface<GlobalIndexComm> {
+
+public:
+    GlobalIndexComm(const ParaTree &tree, bool variableSize)
+        : m_tree(tree), m_variableSize(variableSize), m_ghostData(tree.getNumGhosts())
+    {
+    }
+
+    size_t fixedSize() const
+    {
+        if (m_variableSize) {
+            return 0;
+        }
+
+        return sizeof(uint64_t);
+    }
+
+    size_t size(const uint32_t e) const
+    {
+        return sizeof(int) + getValueCount(m_tree.getGlobalIdx(e)) * sizeof(uint64_t);
+    }
+
+    template<class Buffer>
+    void gather(Buffer &buff, const uint32_t e)
+    {
+        uint64_t globalIdx = m_tree.getGlobalIdx(e);
+        if (!m_variableSize) {
+            buff << globalIdx;
+            return;
+        }
+
+        int nValues = getValueCount(globalIdx);
+        buff << nValues;
+        for (int k = 0; k < nValues; ++k) {
+            buff << globalIdx;
+        }
+    }
+
+    template<class Buffer>
+    void scatter(Buffer &buff, const uint32_t e)
+    {
+        if (!m_variableSize) {
+            buff >> m_ghostData[e];
+            return;
+        }
+
+        int nValues;
+        buff >> nValues;
+        for (int k = 0; k < nValues; ++k) {
+            buff >> m_ghostData[e];
+        }
+    }
+
+    const std::vector<uint64_t> & getGhostData() const
+    {
+        return m_ghostData;
+    }
+
+private:
+    const ParaTree &m_tree;
+    bool m_variableSize;
+    std::vector<uint64_t> m_ghostData;
+
+    static int getValueCount(uint64_t globalIdx)
+    {
+        return static_cast<int>(globalIdx % 3) + 1;
+    }
+
+};
+
+/*!
+* Check the ghost data exchanged using the user data communicator.
+*
+* \param tree is the tree
+* \param variableSize controls if variable size data will be exchanged
+* \result Returns zero if the data are valid, a non-zero value otherwise.
+*/
+int checkUserDataCommunication(ParaTree &tree, bool variableSize)
+{
+    GlobalIndexComm userData(tree, variableSize);
+    tree.communicateBegin(userData);
+    tree.communicateEnd(userData);
+
+    const std::vector<uint64_t> &ghostData = userData.getGhostData();
+    for (uint32_t i = 0; i < tree.getNumGhosts(); ++i) {
+        if (ghostData[i] != tree.getGhostGlobalIdx(i)) {
+            log::cout() << "  Invalid data received for ghost " << i << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Check the ghost data exchanged using contiguous arrays.
+*
+* \param tree is the tree
+* \result Returns zero if the data are valid, a non-zero value otherwise.
+*/
+int checkArrayCommunication(ParaTree &tree)
+{
+    const std::size_t N_COMPONENTS = 2;
+
+    std::vector<double> data(N_COMPONENTS * tree.getNumOctants());
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        data[N_COMPONENTS * i]     = tree.getGlobalIdx(i);
+        data[N_COMPONENTS * i + 1] = tree.getLevel(i);
+    }
+
+    std::vector<double> ghostData(N_COMPONENTS * tree.getNumGhosts(), -1.);
+    tree.communicateBegin(data.data(), N_COMPONENTS);
+
+    // Internal octants can be processed while the communication is in progress
+    double sum = 0.;
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        sum += data[N_COMPONENTS * i + 1];
+    }
+    log::cout() << "     Sum of the levels of the internal octants: " << sum << std::endl;
+
+    tree.communicateEnd(ghostData.data(), N_COMPONENTS);
+
+    for (uint32_t i = 0; i < tree.getNumGhosts(); ++i) {
+        const Octant *ghost = tree.getGhostOctant(i);
+        if (ghostData[N_COMPONENTS * i] != tree.getGhostGlobalIdx(i)) {
+            log::cout() << "  Invalid global index received for ghost " << i << std::endl;
+            return 1;
+        } else if (ghostData[N_COMPONENTS * i + 1] != tree.getLevel(ghost)) {
+            log::cout() << "  Invalid level received for ghost " << i << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Check all the communications.
+*
+* \param tree is the tree
+* \result Returns zero if the communications are valid, a non-zero value
+* otherwise.
+*/
+int checkCommunications(ParaTree &tree)
+{
+    // Communications are repeated to check the reuse of the buffers
+    for (int i = 0; i < 2; ++i) {
+        if (checkArrayCommunication(tree) != 0) {
+            return 1;
+        }
+
+        if (checkUserDataCommunication(tree, false) != 0) {
+            return 1;
+        }
+
+        if (checkUserDataCommunication(tree, true) != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 001
+*
+* Testing split-phase communication of ghost data.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  Dimension: " << int(dimension) << std::endl;
+
+    // Create the tree
+    ParaTree tree(dimension);
+    tree.setNofGhostLayers(2);
+
+    for (int i = 0; i < 3; ++i) {
+        tree.adaptGlobalRefine();
+    }
+
+    tree.loadBalance();
+    log::cout() << "     Number of octants after load balance: " << tree.getNumOctants() << std::endl;
+    if (checkCommunications(tree) != 0) {
+        return 1;
+    }
+
+    // Adaption and load balance
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        if (tree.getGlobalIdx(i) % 5 == 0) {
+            tree.setMarker(i, 1);
+        }
+    }
+
+    tree.adapt();
+    log::cout() << "     Number of octants after adaption: " << tree.getNumOctants() << std::endl;
+    if (checkCommunications(tree) != 0) {
+        return 1;
+    }
+
+    tree.loadBalance();
+    log::cout() << "     Number of octants after load balance: " << tree.getNumOctants() << std::endl;
+    if (checkCommunications(tree) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing split-phase ghost communication" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Ghost communication is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,211 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Build the tree used by the test.
+*
+* \param dimension is the dimension of the tree
+* \param tolerance is the partition tolerance
+* \param weights are the weights that will be used for partitioning
+*/
+std::unique_ptr<ParaTree> buildTree(uint8_t dimension, double tolerance, bool weighted)
+{
+    std::unique_ptr<ParaTree> tree(new ParaTree(dimension));
+    tree->setPartitionTolerance(tolerance);
+
+    int nRefinements = (dimension == 2) ? 5 : 3;
+    for (int i = 0; i < nRefinements; ++i) {
+        tree->adaptGlobalRefine();
+    }
+
+    // Refine the octants near the origin
+    for (uint32_t i = 0; i < tree->getNumOctants(); ++i) {
+        std::array<double, 3> center = tree->getCenter(i);
+        if (center[0] + center[1] < 0.5) {
+            tree->setMarker(i, 1);
+        }
+    }
+    tree->adapt();
+
+    // Partition the tree
+    if (weighted) {
+        std::vector<double> weights(tree->getNumOctants());
+        for (uint32_t i = 0; i < tree->getNumOctants(); ++i) {
+            weights[i] = 1. + tree->getLevel(i);
+        }
+        tree->loadBalance(&weights);
+    } else {
+        tree->loadBalance();
+    }
+
+    return tree;
+}
+
+/*!
+* Evaluate the global number of ghosts of the tree.
+*
+* \param tree is the tree
+* \result The global number of ghosts.
+*/
+uint64_t evalGlobalNumGhosts(const ParaTree &tree)
+{
+    uint64_t nGhosts = tree.getNumGhosts();
+    MPI_Allreduce(MPI_IN_PLACE, &nGhosts, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+
+    return nGhosts;
+}
+
+/*!
+* Subtest 001
+*
+* Testing compact partitioning.
+*
+* \param dimension is the dimension of the tree
+* \param weighted controls if weighted partitioning will be tested
+*/
+int subtest_001(uint8_t dimension, bool weighted)
+{
+    const double TOLERANCE = 0.1;
+
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    log::cout() << "  Dimension: " << int(dimension) << ", weighted: " << weighted << std::endl;
+
+    // Build reference and compact trees
+    std::unique_ptr<ParaTree> referenceTree = buildTree(dimension, 0., weighted);
+    std::unique_ptr<ParaTree> compactTree   = buildTree(dimension, TOLERANCE, weighted);
+
+    if (compactTree->getGlobalNumOctants() != referenceTree->getGlobalNumOctants()) {
+        log::cout() << "  Global number of octants doesn't match" << std::endl;
+        return 1;
+    }
+
+    // Check the size of the partitions
+    std::vector<double> weights(compactTree->getNumOctants(), 1.);
+    if (weighted) {
+        for (uint32_t i = 0; i < compactTree->getNumOctants(); ++i) {
+            weights[i] = 1. + compactTree->getLevel(i);
+        }
+    }
+
+    double localWeight = 0.;
+    for (double weight : weights) {
+        localWeight += weight;
+    }
+
+    double globalWeight = localWeight;
+    MPI_Allreduce(MPI_IN_PLACE, &globalWeight, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+    double averageWeight = globalWeight / nProcs;
+    double maxWeight = averageWeight * (1. + 2. * TOLERANCE) + 2 * (1. + compactTree->getMaxDepth());
+    log::cout() << "     Weight of the partition: " << localWeight << " (average " << averageWeight << ")" << std::endl;
+    if (localWeight > maxWeight) {
+        log::cout() << "  Partition weight exceeds the tolerance" << std::endl;
+        return 1;
+    }
+
+    // Check the number of ghosts
+    uint64_t nReferenceGhosts = evalGlobalNumGhosts(*referenceTree);
+    uint64_t nCompactGhosts   = evalGlobalNumGhosts(*compactTree);
+    log::cout() << "     Global number of ghosts: " << nCompactGhosts << " (reference " << nReferenceGhosts << ")" << std::endl;
+    if (nCompactGhosts > nReferenceGhosts) {
+        log::cout() << "  Compact partitioning increased the number of ghosts" << std::endl;
+        return 1;
+    }
+
+    // Check load balance ranges
+    //
+    // The tree is already partitioned, hence no octants should be exchanged.
+    ParaTree::LoadBalanceRanges ranges = compactTree->evalLoadBalanceRanges(weighted ? &weights : nullptr);
+    if (!ranges.sendRanges.empty() || !ranges.recvRanges.empty()) {
+        log::cout() << "  Partitioning is not stable" << std::endl;
+        return 1;
+    }
+
+    // Compact the partition of the distributed reference tree
+    //
+    // The result should match the partition evaluated on the serial tree.
+    std::vector<double> referenceWeights(referenceTree->getNumOctants(), 1.);
+    if (weighted) {
+        for (uint32_t i = 0; i < referenceTree->getNumOctants(); ++i) {
+            referenceWeights[i] = 1. + referenceTree->getLevel(i);
+        }
+    }
+
+    referenceTree->setPartitionTolerance(TOLERANCE);
+    referenceTree->loadBalance(weighted ? &referenceWeights : nullptr);
+    if (referenceTree->getPartitionRangeGlobalIdx() != compactTree->getPartitionRangeGlobalIdx()) {
+        log::cout() << "  Distributed and serial compact partitions don't match" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing compact partitioning" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            for (int weighted = 0; weighted <= 1; ++weighted) {
+                status = subtest_001(dimension, weighted);
+                if (status != 0) {
+                    log::cout() << "Compact partitioning is not valid" << std::endl;
+                    return status;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
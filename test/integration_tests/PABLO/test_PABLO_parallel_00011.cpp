@@ -0,0 +1,223 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Set the number of threads used by the shared-memory parallel kernels.
+*
+* \param nThreads is the number of threads
+*/
+void setThreadCount(int nThreads)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nThreads);
+#else
+    BITPIT_UNUSED(nThreads);
+#endif
+}
+
+/*!
+* Generate the points to be located.
+*
+* Points are generated using a deterministic pseudo-random sequence, some of
+* the points are outside the domain of the tree.
+*
+* \param origin is the origin of the domain
+* \param length is the length of the domain
+* \param nPoints is the number of points
+* \param seed is the seed of the sequence
+* \result The generated points.
+*/
+std::vector<darray3> generatePoints(const darray3 &origin, double length, std::size_t nPoints, uint32_t seed)
+{
+    std::vector<darray3> points(nPoints);
+    for (darray3 &point : points) {
+        for (int d = 0; d < 3; ++d) {
+            seed = 1664525 * seed + 1013904223;
+            double value = ((seed >> 8) % 100000) / 100000.;
+            point[d] = origin[d] + length * (1.1 * value - 0.05);
+        }
+    }
+
+    return points;
+}
+
+/*!
+* Build the tree used by the test.
+*
+* \param tree is the tree
+*/
+void buildTree(PabloUniform *tree)
+{
+    int nRefinements = (tree->getDim() == 2) ? 6 : 4;
+    for (int i = 0; i < nRefinements; ++i) {
+        tree->adaptGlobalRefine();
+    }
+
+    for (uint32_t i = 0; i < tree->getNumOctants(); ++i) {
+        darray3 center = tree->getCenter(i);
+        if (center[0] < 0.5 && center[1] < 0.5) {
+            tree->setMarker(i, 1);
+        }
+    }
+    tree->adapt();
+}
+
+/*!
+* Subtest 001
+*
+* Testing batched and distributed point location.
+*
+* \param dimension is the dimension of the tree
+* \param nThreads is the number of threads
+*/
+int subtest_001(uint8_t dimension, int nThreads)
+{
+    const std::size_t N_POINTS = 20000;
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::cout() << "  >> Dimension " << (int) dimension << ", threads " << nThreads << std::endl;
+
+    setThreadCount(nThreads);
+
+    // Build the trees
+    //
+    // The reference tree is not partitioned.
+    darray3 origin = {{-1., 2., 0.5}};
+    double length = 2.;
+
+    PabloUniform referenceTree(origin[0], origin[1], origin[2], length, dimension);
+    buildTree(&referenceTree);
+
+    PabloUniform tree(origin[0], origin[1], origin[2], length, dimension);
+    buildTree(&tree);
+    tree.loadBalance();
+
+    // Generate the points
+    std::vector<darray3> points = generatePoints(origin, length, N_POINTS, 17 + rank);
+
+    // Locate points in the local partition
+    std::vector<uint32_t> ownerIdx = tree.getPointsOwnerIdx(points);
+    std::vector<int> ownerRanks(N_POINTS);
+    tree.getPointsOwnerRank(N_POINTS, points.data(), ownerRanks.data());
+    for (std::size_t n = 0; n < N_POINTS; ++n) {
+        if (ownerIdx[n] != tree.getPointOwnerIdx(points[n])) {
+            log::cout() << "  Wrong local owner for point " << n << std::endl;
+            return 1;
+        } else if (ownerRanks[n] != tree.getPointOwnerRank(points[n])) {
+            log::cout() << "  Wrong owner rank for point " << n << std::endl;
+            return 1;
+        }
+    }
+
+    // Locate points in the whole tree
+    std::vector<uint32_t> distributedOwnerIdx(N_POINTS);
+    tree.locatePoints(N_POINTS, points.data(), ownerRanks.data(), distributedOwnerIdx.data());
+
+    const std::vector<uint64_t> &partitionRanges = tree.getPartitionRangeGlobalIdx();
+    std::size_t nLocalPoints = 0;
+    for (std::size_t n = 0; n < N_POINTS; ++n) {
+        uint32_t referenceOwnerIdx = referenceTree.getPointOwnerIdx(points[n]);
+        if (referenceOwnerIdx == std::numeric_limits<uint32_t>::max()) {
+            if (ownerRanks[n] >= 0 || distributedOwnerIdx[n] != std::numeric_limits<uint32_t>::max()) {
+                log::cout() << "  Point " << n << " should be outside the domain" << std::endl;
+                return 1;
+            }
+            continue;
+        }
+
+        if (ownerRanks[n] != tree.getPointOwnerRank(points[n])) {
+            log::cout() << "  Wrong distributed owner rank for point " << n << std::endl;
+            return 1;
+        }
+
+        uint64_t globalIdx = distributedOwnerIdx[n];
+        if (ownerRanks[n] > 0) {
+            globalIdx += partitionRanges[ownerRanks[n] - 1] + 1;
+        }
+
+        if (globalIdx != referenceOwnerIdx) {
+            log::cout() << "  Wrong distributed owner for point " << n << std::endl;
+            return 1;
+        }
+
+        if (ownerRanks[n] == rank) {
+            ++nLocalPoints;
+        }
+    }
+
+    log::cout() << "     Number of points located in the local partition: " << nLocalPoints << std::endl;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing point location" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            for (int nThreads : {1, 3}) {
+                status = subtest_001(dimension, nThreads);
+                if (status != 0) {
+                    log::cout() << "Point location is not valid" << std::endl;
+                    return status;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
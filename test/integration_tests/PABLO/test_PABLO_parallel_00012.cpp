@@ -0,0 +1,333 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Compare two trees.
+*
+* \param tree is the tree to check
+* \param reference is the reference tree
+* \result Returns true if the trees are equal, false otherwise.
+*/
+bool compareTrees(ParaTree &tree, ParaTree &reference)
+{
+    if (tree.getGlobalNumOctants() != reference.getGlobalNumOctants()) {
+        log::cout() << "  Global number of octants doesn't match" << std::endl;
+        return false;
+    } else if (tree.getMaxDepth() != reference.getMaxDepth()) {
+        log::cout() << "  Maximum depth doesn't match" << std::endl;
+        return false;
+    } else if (tree.getSerial() != reference.getSerial()) {
+        log::cout() << "  Serial flag doesn't match" << std::endl;
+        return false;
+    } else if (tree.getPartitionRangeGlobalIdx() != reference.getPartitionRangeGlobalIdx()) {
+        log::cout() << "  Partition ranges don't match" << std::endl;
+        return false;
+    } else if (tree.getPartitionFirstDesc() != reference.getPartitionFirstDesc()) {
+        log::cout() << "  Partition first descendants don't match" << std::endl;
+        return false;
+    } else if (tree.getPartitionLastDesc() != reference.getPartitionLastDesc()) {
+        log::cout() << "  Partition last descendants don't match" << std::endl;
+        return false;
+    } else if (tree.getNumOctants() != reference.getNumOctants()) {
+        log::cout() << "  Number of octants doesn't match" << std::endl;
+        return false;
+    } else if (tree.getNumGhosts() != reference.getNumGhosts()) {
+        log::cout() << "  Number of ghosts doesn't match" << std::endl;
+        return false;
+    }
+
+    int nFaces = 2 * tree.getDim();
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        if (tree.getMorton(i) != reference.getMorton(i) || tree.getLevel(i) != reference.getLevel(i)) {
+            log::cout() << "  Octant " << i << " doesn't match" << std::endl;
+            return false;
+        }
+
+        for (int face = 0; face < nFaces; ++face) {
+            if (tree.getBound(i, face) != reference.getBound(i, face) || tree.getPbound(i, face) != reference.getPbound(i, face)) {
+                log::cout() << "  Boundary information of octant " << i << " doesn't match" << std::endl;
+                return false;
+            }
+        }
+
+        std::vector<uint32_t> neighs;
+        std::vector<bool> isGhost;
+        tree.findAllCodimensionNeighbours(i, neighs, isGhost);
+
+        std::vector<uint32_t> referenceNeighs;
+        std::vector<bool> referenceIsGhost;
+        reference.findAllCodimensionNeighbours(i, referenceNeighs, referenceIsGhost);
+        if (neighs != referenceNeighs || isGhost != referenceIsGhost) {
+            log::cout() << "  Neighbours of octant " << i << " don't match" << std::endl;
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < tree.getNumGhosts(); ++i) {
+        const Octant *ghost = tree.getGhostOctant(i);
+        const Octant *referenceGhost = reference.getGhostOctant(i);
+        if (tree.getMorton(ghost) != reference.getMorton(referenceGhost) || tree.getLevel(ghost) != reference.getLevel(referenceGhost)) {
+            log::cout() << "  Ghost " << i << " doesn't match" << std::endl;
+            return false;
+        } else if (tree.getGhostGlobalIdx(i) != reference.getGhostGlobalIdx(i)) {
+            log::cout() << "  Global index of ghost " << i << " doesn't match" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Compare the connectivity of two trees.
+*
+* Nodes are compared by their logical coordinates, hence the trees don't
+* need to number the nodes in the same order.
+*
+* \param tree is the tree to check
+* \param reference is the reference tree
+* \result Returns true if the connectivities are equal, false otherwise.
+*/
+bool compareConnectivity(const ParaTree &tree, const ParaTree &reference)
+{
+    if (tree.getNumNodes() != reference.getNumNodes()) {
+        log::cout() << "  Number of nodes doesn't match" << std::endl;
+        return false;
+    }
+
+    const u32arr3vector &nodes = tree.getNodes();
+    const u32arr3vector &referenceNodes = reference.getNodes();
+
+    const FlatVector2D<uint32_t> &connectivity = tree.getConnectivityFlat();
+    const FlatVector2D<uint32_t> &referenceConnectivity = reference.getConnectivityFlat();
+    if (connectivity.size() != tree.getNumOctants() || referenceConnectivity.size() != reference.getNumOctants()) {
+        log::cout() << "  Connectivity has not been built" << std::endl;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        for (std::size_t k = 0; k < connectivity.getItemCount(i); ++k) {
+            if (nodes[connectivity.getItem(i, k)] != referenceNodes[referenceConnectivity.getItem(i, k)]) {
+                log::cout() << "  Connectivity of octant " << i << " doesn't match" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    const FlatVector2D<uint32_t> &ghostConnectivity = tree.getGhostConnectivityFlat();
+    const FlatVector2D<uint32_t> &referenceGhostConnectivity = reference.getGhostConnectivityFlat();
+    if (ghostConnectivity.size() != tree.getNumGhosts()) {
+        log::cout() << "  Ghost connectivity has not been built" << std::endl;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < tree.getNumGhosts(); ++i) {
+        for (std::size_t k = 0; k < ghostConnectivity.getItemCount(i); ++k) {
+            if (nodes[ghostConnectivity.getItem(i, k)] != referenceNodes[referenceGhostConnectivity.getItem(i, k)]) {
+                log::cout() << "  Connectivity of ghost " << i << " doesn't match" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing direct construction of uniform trees.
+*
+* \param dimension is the dimension of the tree
+* \param level is the refinement level of the tree
+* \param periodic controls if the tree is periodic
+*/
+int subtest_001(uint8_t dimension, uint8_t level, bool periodic)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", level " << (int) level << ", periodic " << periodic << std::endl;
+
+    // Reference tree
+    ParaTree reference(dimension);
+    if (periodic) {
+        reference.setPeriodic(0);
+    }
+
+    for (int i = 0; i < level; ++i) {
+        reference.adaptGlobalRefine();
+    }
+    reference.loadBalance();
+
+    // Uniform tree
+    ParaTree tree(dimension);
+    if (periodic) {
+        tree.setPeriodic(0);
+    }
+
+    tree.buildUniform(level);
+
+    // Compare the trees
+    if (!compareTrees(tree, reference)) {
+        return 1;
+    }
+
+    reference.computeConnectivity();
+    if (!compareConnectivity(tree, reference)) {
+        return 1;
+    }
+
+    // Check if the tree can be adapted
+    for (ParaTree *adaptTree : {&tree, &reference}) {
+        for (uint32_t i = 0; i < adaptTree->getNumOctants(); ++i) {
+            if (adaptTree->getGlobalIdx(i) % 7 == 0) {
+                adaptTree->setMarker(i, 1);
+            }
+        }
+        adaptTree->adapt();
+        adaptTree->loadBalance();
+    }
+
+    if (!compareTrees(tree, reference)) {
+        return 1;
+    }
+
+    log::cout() << "     Number of octants: " << tree.getGlobalNumOctants() << std::endl;
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing direct construction of uniform trees with less octants than
+* processes.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_002(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", empty processes" << std::endl;
+
+    int rank;
+    int nProcs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    // Build a tree with a single octant
+    //
+    // All the processes but the first one get no octants.
+    ParaTree tree(dimension);
+    tree.buildUniform(0);
+
+    uint32_t nExpectedOctants = (rank == 0) ? 1 : 0;
+    uint32_t nExpectedNodes   = (rank == 0) ? tree.getNnodes() : 0;
+    if (tree.getGlobalNumOctants() != 1 || tree.getNumOctants() != nExpectedOctants) {
+        log::cout() << "  Octants have not been assigned to the first process" << std::endl;
+        return 1;
+    } else if (tree.getNumGhosts() != 0) {
+        log::cout() << "  Ghosts have been created" << std::endl;
+        return 1;
+    } else if (tree.getNumNodes() != nExpectedNodes || tree.getConnectivityFlat().size() != nExpectedOctants) {
+        log::cout() << "  Connectivity is not valid" << std::endl;
+        return 1;
+    }
+
+    // Refine the tree until every process gets some octants
+    tree.adaptGlobalRefine();
+    tree.loadBalance();
+
+    ParaTree reference(dimension);
+    reference.adaptGlobalRefine();
+    reference.loadBalance();
+
+    if (tree.getNumOctants() == 0) {
+        log::cout() << "  Octants have not been distributed" << std::endl;
+        return 1;
+    } else if (!compareTrees(tree, reference)) {
+        return 1;
+    }
+
+    tree.updateConnectivity();
+    reference.computeConnectivity();
+    if (!compareConnectivity(tree, reference)) {
+        return 1;
+    }
+
+    log::cout() << "     Number of local octants: " << tree.getNumOctants() << std::endl;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing direct construction of uniform trees" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            for (uint8_t level : {0, 1, 4}) {
+                for (bool periodic : {false, true}) {
+                    status = subtest_001(dimension, level, periodic);
+                    if (status != 0) {
+                        log::cout() << "Uniform tree is not valid" << std::endl;
+                        return status;
+                    }
+                }
+            }
+
+            status = subtest_002(dimension);
+            if (status != 0) {
+                log::cout() << "Uniform tree with empty processes is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
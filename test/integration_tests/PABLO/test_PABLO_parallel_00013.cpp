@@ -0,0 +1,192 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Evaluate an order-dependent checksum of the global sequence of octants.
+*
+* \param tree is the tree
+* \result The checksum of the tree.
+*/
+uint64_t evalChecksum(const ParaTree &tree)
+{
+    uint64_t checksum = 0;
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        const Octant *octant = tree.getOctant(i);
+        uint64_t octantHash = tree.getMorton(i) * 31 + tree.getLevel(i) + 7 * octant->getMarker();
+        for (int face = 0; face < 2 * tree.getDim(); ++face) {
+            octantHash = 2 * octantHash + tree.getBound(i, face);
+        }
+
+        checksum += octantHash * (tree.getGlobalIdx(i) + 1);
+    }
+
+    if (!tree.getSerial()) {
+        MPI_Allreduce(MPI_IN_PLACE, &checksum, 1, MPI_UINT64_T, MPI_SUM, tree.getComm());
+    }
+
+    return checksum;
+}
+
+/*!
+* Subtest 001
+*
+* Testing collective checkpoint and restart with a different number of
+* processes.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    const std::string FILENAME = "test_PABLO_parallel_00013.ckp";
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create the tree
+    ParaTree tree(dimension);
+    tree.setPeriodic(0);
+
+    for (int i = 0; i < 3; ++i) {
+        tree.adaptGlobalRefine();
+    }
+    tree.loadBalance();
+
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        darray3 center = tree.getCenter(i);
+        if (center[0] < 0.4 && center[1] > 0.3) {
+            tree.setMarker(i, 1);
+        }
+    }
+    tree.adapt();
+
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        if (tree.getGlobalIdx(i) % 5 == 0) {
+            tree.setMarker(i, 1);
+        }
+    }
+
+    uint64_t nGlobalOctants = tree.getGlobalNumOctants();
+    uint64_t checksum = evalChecksum(tree);
+
+    log::cout() << "     Global number of octants: " << nGlobalOctants << std::endl;
+
+    // Write the checkpoint
+    tree.checkpoint(FILENAME);
+
+    // Restart with the same number of processes
+    ParaTree restartedTree;
+    restartedTree.restart(FILENAME);
+
+    if (restartedTree.getDim() != dimension || restartedTree.getGlobalNumOctants() != nGlobalOctants) {
+        log::cout() << "  Restarted tree doesn't match the original tree" << std::endl;
+        return 1;
+    } else if (!restartedTree.getPeriodic(0) || !restartedTree.getPeriodic(1) || restartedTree.getPeriodic(2)) {
+        log::cout() << "  Periodic conditions of the restarted tree don't match" << std::endl;
+        return 1;
+    } else if (evalChecksum(restartedTree) != checksum) {
+        log::cout() << "  Octants of the restarted tree don't match" << std::endl;
+        return 1;
+    }
+
+    // Restart with a different number of processes
+    MPI_Comm subComm;
+    MPI_Comm_split(MPI_COMM_WORLD, (rank < 2) ? 0 : 1, rank, &subComm);
+
+    {
+        ParaTree subTree(ParaTree::DEFAULT_LOG_FILE, subComm);
+        subTree.restart(FILENAME);
+
+        int nSubProcs;
+        MPI_Comm_size(subComm, &nSubProcs);
+        log::cout() << "     Restarted with " << nSubProcs << " processes, local octants " << subTree.getNumOctants() << ", ghosts " << subTree.getNumGhosts() << std::endl;
+
+        if (subTree.getGlobalNumOctants() != nGlobalOctants) {
+            log::cout() << "  Number of octants of the restarted tree doesn't match" << std::endl;
+            return 1;
+        } else if (evalChecksum(subTree) != checksum) {
+            log::cout() << "  Octants of the tree restarted with a different number of processes don't match" << std::endl;
+            return 1;
+        } else if (nSubProcs > 1 && subTree.getNumGhosts() == 0) {
+            log::cout() << "  Ghost halo of the restarted tree is empty" << std::endl;
+            return 1;
+        }
+
+        // The restarted tree can be adapted
+        subTree.adapt();
+        if (subTree.getGlobalNumOctants() <= nGlobalOctants) {
+            log::cout() << "  Restarted tree has not been adapted" << std::endl;
+            return 1;
+        }
+    }
+
+    MPI_Comm_free(&subComm);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing collective checkpoint and restart" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Checkpoint and restart are not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,183 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check if two intersections are equal.
+*
+* \param tree is the tree
+* \param intersection is the intersection to check
+* \param reference is the reference intersection
+* \result Returns true if the intersections are equal, false otherwise.
+*/
+bool compareIntersections(const ParaTree &tree, const Intersection *intersection, const Intersection *reference)
+{
+    if (tree.getOwners(intersection) != tree.getOwners(reference)) {
+        return false;
+    } else if (tree.getFace(intersection) != tree.getFace(reference)) {
+        return false;
+    } else if (tree.getFiner(intersection) != tree.getFiner(reference)) {
+        return false;
+    } else if (tree.getBound(intersection) != tree.getBound(reference)) {
+        return false;
+    } else if (tree.getPbound(intersection) != tree.getPbound(reference)) {
+        return false;
+    } else if (tree.getIsGhost(intersection) != tree.getIsGhost(reference)) {
+        return false;
+    } else if (tree.getOutIsGhost(intersection) != tree.getOutIsGhost(reference)) {
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing on-the-fly evaluation of the intersections.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create the tree
+    PabloUniform tree(dimension);
+    tree.setPeriodic(0);
+
+    for (int i = 0; i < 3; ++i) {
+        tree.adaptGlobalRefine();
+    }
+    tree.loadBalance();
+
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        darray3 center = tree.getCenter(i);
+        if (center[0] > 0.6 && center[1] < 0.5) {
+            tree.setMarker(i, 1);
+        }
+    }
+    tree.adapt();
+    tree.loadBalance();
+
+    // Stored intersections
+    tree.computeIntersections();
+    uint32_t nIntersections = tree.getNumIntersections();
+
+    log::cout() << "     Number of intersections: " << nIntersections << std::endl;
+
+    // Iterate over all intersections
+    uint32_t n = 0;
+    IntersectionIterator end = tree.getIntersectionsEnd();
+    for (IntersectionIterator itr = tree.getIntersectionsBegin(); itr != end; ++itr) {
+        if (n >= nIntersections || !compareIntersections(tree, &(*itr), tree.getIntersection(n))) {
+            log::cout() << "  Intersection " << n << " doesn't match" << std::endl;
+            return 1;
+        }
+        ++n;
+    }
+
+    if (n != nIntersections) {
+        log::cout() << "  Number of iterated intersections doesn't match" << std::endl;
+        return 1;
+    }
+
+    // Iterate over the intersections in chunks
+    int nChunks = 4;
+    std::vector<std::vector<Intersection>> chunkIntersections(nChunks);
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for
+#endif
+    for (int chunk = 0; chunk < nChunks; ++chunk) {
+        IntersectionIterator chunkEnd = tree.getIntersectionsEnd(chunk, nChunks);
+        for (IntersectionIterator itr = tree.getIntersectionsBegin(chunk, nChunks); itr != chunkEnd; ++itr) {
+            chunkIntersections[chunk].push_back(*itr);
+        }
+    }
+
+    n = 0;
+    for (int chunk = 0; chunk < nChunks; ++chunk) {
+        for (const Intersection &intersection : chunkIntersections[chunk]) {
+            if (n >= nIntersections || !compareIntersections(tree, &intersection, tree.getIntersection(n))) {
+                log::cout() << "  Intersection " << n << " of chunk " << chunk << " doesn't match" << std::endl;
+                return 1;
+            }
+            ++n;
+        }
+    }
+
+    if (n != nIntersections) {
+        log::cout() << "  Number of intersections iterated in chunks doesn't match" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing on-the-fly evaluation of the intersections" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Intersection iterators are not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,234 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check a brick tree.
+*
+* The octants should cover the whole brick, the boundary faces should be
+* the ones on the boundary of the brick, all the other faces should have
+* neighbours and the tree should be 2:1 balanced across the faces.
+*
+* \param tree is the tree to check
+* \result Returns true if the tree is valid, false otherwise.
+*/
+bool checkBrick(ParaTree &tree)
+{
+    const double TOLERANCE = 1e-12;
+
+    int dimension = tree.getDim();
+    const u32array3 &brickSize = tree.getBrickSize();
+    double rootSize = 1. / (1 << tree.getBrickLevel());
+
+    darray3 brickLimit;
+    double brickVolume = 1.;
+    for (int d = 0; d < 3; ++d) {
+        brickLimit[d] = brickSize[d] * rootSize;
+        if (d < dimension) {
+            brickVolume *= brickLimit[d];
+        }
+    }
+
+    double volume = 0.;
+    int nFaces = 2 * dimension;
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        volume += tree.getVolume(i);
+
+        darray3 center = tree.getCenter(i);
+        double size = tree.getSize(i);
+        for (int face = 0; face < nFaces; ++face) {
+            int d = face / 2;
+            double faceCoordinate = center[d] + ((face % 2 == 0) ? -0.5 : 0.5) * size;
+            bool isBrickBoundary = (std::abs(faceCoordinate) < TOLERANCE) || (std::abs(faceCoordinate - brickLimit[d]) < TOLERANCE);
+            if (tree.getBound(i, face) != isBrickBoundary) {
+                log::cout() << "  Boundary information of octant " << tree.getGlobalIdx(i) << " is not valid" << std::endl;
+                return false;
+            }
+
+            std::vector<uint32_t> neighs;
+            std::vector<bool> isGhost;
+            tree.findNeighbours(i, face, 1, neighs, isGhost);
+            if (neighs.empty() != isBrickBoundary) {
+                log::cout() << "  Neighbours of octant " << tree.getGlobalIdx(i) << " are not valid" << std::endl;
+                return false;
+            }
+
+            for (std::size_t n = 0; n < neighs.size(); ++n) {
+                const Octant *neigh = isGhost[n] ? tree.getGhostOctant(neighs[n]) : tree.getOctant(neighs[n]);
+                if (std::abs(tree.getLevel(neigh) - tree.getLevel(i)) > 1) {
+                    log::cout() << "  Octant " << tree.getGlobalIdx(i) << " is not balanced" << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        if (tree.getPointOwnerIdx(center) != i) {
+            log::cout() << "  Unable to locate the center of octant " << tree.getGlobalIdx(i) << std::endl;
+            return false;
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &volume, 1, MPI_DOUBLE, MPI_SUM, tree.getComm());
+    if (std::abs(volume - brickVolume) > TOLERANCE) {
+        log::cout() << "  Octants don't cover the brick" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing construction and adaption of brick trees.
+*
+* \param dimension is the dimension of the tree
+* \param brickSize is the number of root octants along each direction
+* \param level is the refinement level of the root octants
+*/
+int subtest_001(uint8_t dimension, const u32array3 &brickSize, uint8_t level)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", brick " << brickSize[0] << "x" << brickSize[1] << "x" << brickSize[2] << ", level " << (int) level << std::endl;
+
+    // Build the brick
+    ParaTree tree(dimension);
+    tree.buildBrick(brickSize, level);
+
+    uint64_t nExpectedOctants = uint64_t(brickSize[0]) * brickSize[1] * brickSize[2] << (dimension * level);
+    if (tree.getGlobalNumOctants() != nExpectedOctants) {
+        log::cout() << "  Number of octants doesn't match the size of the brick" << std::endl;
+        return 1;
+    }
+
+    if (!checkBrick(tree)) {
+        return 1;
+    }
+
+    // Points outside the brick are not located
+    darray3 outsidePoint = {{0.5 * tree.getBrickSize()[0] / (1 << tree.getBrickLevel()), 0.99, 0.}};
+    if (dimension == 3) {
+        outsidePoint[2] = 0.99;
+    }
+
+    if (brickSize[1] < (uint32_t(1) << tree.getBrickLevel()) && tree.getPointOwnerIdx(outsidePoint) != std::numeric_limits<uint32_t>::max()) {
+        log::cout() << "  Point outside the brick has been located" << std::endl;
+        return 1;
+    }
+
+    // Refine the octants near the faces shared by the roots and balance
+    double rootSize = 1. / (1 << tree.getBrickLevel());
+    for (int iter = 0; iter < 2; ++iter) {
+        for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+            darray3 center = tree.getCenter(i);
+            double relativeCoordinate = center[0] / rootSize - std::floor(center[0] / rootSize);
+            if (relativeCoordinate > 0.7 && tree.getGlobalIdx(i) % 3 == 0) {
+                tree.setMarker(i, 1);
+            }
+        }
+        tree.adapt();
+        tree.loadBalance();
+
+        if (!checkBrick(tree)) {
+            return 1;
+        }
+    }
+
+    // Coarsen the tree
+    tree.adaptGlobalCoarse();
+    tree.loadBalance();
+    if (!checkBrick(tree)) {
+        return 1;
+    }
+
+    // Dump and restore the tree
+    std::stringstream dumpStream;
+    tree.dump(dumpStream);
+
+    ParaTree restoredTree(dumpStream);
+    if (restoredTree.getBrickSize() != tree.getBrickSize() || restoredTree.getBrickLevel() != tree.getBrickLevel()) {
+        log::cout() << "  Brick information has not been restored" << std::endl;
+        return 1;
+    }
+
+    if (!checkBrick(restoredTree)) {
+        return 1;
+    }
+
+    log::cout() << "     Number of octants: " << tree.getGlobalNumOctants() << std::endl;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing brick trees" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(2, {{1, 1, 1}}, 3);
+        if (status == 0) {
+            status = subtest_001(2, {{10, 1, 1}}, 2);
+        }
+        if (status == 0) {
+            status = subtest_001(2, {{5, 3, 1}}, 1);
+        }
+        if (status == 0) {
+            status = subtest_001(3, {{6, 1, 2}}, 1);
+        }
+        if (status == 0) {
+            status = subtest_001(3, {{3, 3, 3}}, 0);
+        }
+
+        if (status != 0) {
+            log::cout() << "Brick tree is not valid" << std::endl;
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,347 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Gather the specified values from all the processes.
+*
+* \param values are the local values
+* \param comm is the communicator
+* \result The values of all the processes, ordered by rank.
+*/
+std::vector<uint64_t> gatherValues(const std::vector<uint64_t> &values, MPI_Comm comm)
+{
+    int nProcs;
+    MPI_Comm_size(comm, &nProcs);
+
+    int nValues = values.size();
+    std::vector<int> counts(nProcs);
+    MPI_Allgather(&nValues, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+
+    std::vector<int> displs(nProcs, 0);
+    for (int p = 1; p < nProcs; ++p) {
+        displs[p] = displs[p - 1] + counts[p - 1];
+    }
+
+    std::vector<uint64_t> globalValues(displs.back() + counts.back());
+    MPI_Allgatherv(values.data(), nValues, MPI_UINT64_T, globalValues.data(), counts.data(), displs.data(), MPI_UINT64_T, comm);
+
+    return globalValues;
+}
+
+/*!
+* Check the hierarchy of the specified tree.
+*
+* \param tree is the tree
+* \param hierarchy is the hierarchy
+* \result Returns true if the hierarchy is valid, false otherwise.
+*/
+bool checkHierarchy(ParaTree &tree, const TreeHierarchy &hierarchy)
+{
+    MPI_Comm comm = tree.getComm();
+    int rank = tree.getRank();
+    int dimension = tree.getDim();
+    int maxLevel = tree.getMaxLevel();
+
+    // Finest level
+    if (hierarchy.getGlobalNumOctants(0) != tree.getGlobalNumOctants() || hierarchy.getNumOctants(0) != tree.getNumOctants()) {
+        log::cout() << "  Finest level doesn't match the tree" << std::endl;
+        return false;
+    }
+
+    for (std::size_t level = 1; level < hierarchy.getNofLevels(); ++level) {
+        uint8_t depth = hierarchy.getDepth(level);
+        uint32_t nOctants = hierarchy.getNumOctants(level);
+        uint32_t nFineOctants = hierarchy.getNumOctants(level - 1);
+
+        // Partitioning
+        const std::vector<uint64_t> &ranges = hierarchy.getPartitionRangeGlobalIdx(level);
+        uint64_t offset = (rank > 0) ? ranges[rank - 1] + 1 : 0;
+        if (ranges[rank] + 1 - offset != nOctants || (nOctants > 0 && hierarchy.getGlobalIdx(level, 0) != offset)) {
+            log::cout() << "  Partitioning of level " << level << " is not valid" << std::endl;
+            return false;
+        }
+
+        // Octants of the level should be sorted and should not be deeper than
+        // the level depth.
+        std::vector<uint64_t> mortons;
+        std::vector<uint64_t> levels;
+        double volume = 0.;
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            const Octant *octant = hierarchy.getOctant(level, i);
+            if (octant->getLevel() > depth || (i > 0 && octant->getMorton() <= mortons.back())) {
+                log::cout() << "  Octants of level " << level << " are not valid" << std::endl;
+                return false;
+            }
+
+            mortons.push_back(octant->getMorton());
+            levels.push_back(octant->getLevel());
+            volume += tree.getVolume(octant);
+        }
+
+        MPI_Allreduce(MPI_IN_PLACE, &volume, 1, MPI_DOUBLE, MPI_SUM, comm);
+        if (std::abs(volume - 1.) > 1e-12) {
+            log::cout() << "  Octants of level " << level << " don't cover the domain" << std::endl;
+            return false;
+        }
+
+        std::vector<uint64_t> globalMortons = gatherValues(mortons, comm);
+        std::vector<uint64_t> globalLevels = gatherValues(levels, comm);
+        if (globalMortons.size() != hierarchy.getGlobalNumOctants(level)) {
+            log::cout() << "  Global number of octants of level " << level << " is not valid" << std::endl;
+            return false;
+        }
+
+        // Restriction and prolongation should describe the same relations
+        std::vector<uint64_t> restrictionPairs;
+        const FlatVector2D<uint64_t> &restriction = hierarchy.getRestriction(level);
+        if (restriction.size() != nOctants) {
+            log::cout() << "  Restriction of level " << level << " has a wrong number of rows" << std::endl;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            for (std::size_t k = restriction.indices()[i]; k < restriction.indices()[i + 1]; ++k) {
+                restrictionPairs.push_back(hierarchy.getGlobalIdx(level, i));
+                restrictionPairs.push_back(restriction.data()[k]);
+            }
+        }
+
+        std::vector<uint64_t> prolongationPairs;
+        const FlatVector2D<uint64_t> &prolongation = hierarchy.getProlongation(level);
+        if (prolongation.size() != nFineOctants || prolongation.getItemCount() != nFineOctants) {
+            log::cout() << "  Prolongation of level " << level << " has a wrong size" << std::endl;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < nFineOctants; ++i) {
+            prolongationPairs.push_back(prolongation.getItem(i, 0));
+            prolongationPairs.push_back(hierarchy.getGlobalIdx(level - 1, i));
+        }
+
+        std::vector<uint64_t> globalRestrictionPairs = gatherValues(restrictionPairs, comm);
+        std::vector<uint64_t> globalProlongationPairs = gatherValues(prolongationPairs, comm);
+        if (globalRestrictionPairs != globalProlongationPairs) {
+            log::cout() << "  Restriction and prolongation of level " << level << " don't match" << std::endl;
+            return false;
+        }
+
+        if (globalProlongationPairs.size() != 2 * hierarchy.getGlobalNumOctants(level - 1)) {
+            log::cout() << "  Prolongation of level " << level << " doesn't cover the finer level" << std::endl;
+            return false;
+        }
+
+        // Children should be contained in their parent
+        std::vector<uint64_t> fineMortons;
+        std::vector<uint64_t> fineLevels;
+        for (uint32_t i = 0; i < nFineOctants; ++i) {
+            fineMortons.push_back(hierarchy.getOctant(level - 1, i)->getMorton());
+            fineLevels.push_back(hierarchy.getOctant(level - 1, i)->getLevel());
+        }
+
+        std::vector<uint64_t> globalFineMortons = gatherValues(fineMortons, comm);
+        std::vector<uint64_t> globalFineLevels = gatherValues(fineLevels, comm);
+        for (std::size_t n = 0; n < globalProlongationPairs.size(); n += 2) {
+            uint64_t parent = globalProlongationPairs[n];
+            uint64_t child  = globalProlongationPairs[n + 1];
+
+            uint64_t parentLevel = globalLevels[parent];
+            uint64_t childLevel  = globalFineLevels[child];
+            uint64_t mask = ~((uint64_t(1) << (dimension * (maxLevel - parentLevel))) - 1);
+            if ((globalFineMortons[child] & mask) != globalMortons[parent]) {
+                log::cout() << "  Octant " << child << " of level " << (level - 1) << " is not inside its parent" << std::endl;
+                return false;
+            } else if (childLevel != parentLevel && childLevel != parentLevel + 1) {
+                log::cout() << "  Octant " << child << " of level " << (level - 1) << " has a wrong level" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing the hierarchy of an adapted tree.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create an adapted tree
+    ParaTree tree(dimension);
+    tree.buildUniform(2);
+    for (int iter = 0; iter < 3; ++iter) {
+        for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+            darray3 center = tree.getCenter(i);
+            if (center[0] + center[1] < 0.6 || tree.getGlobalIdx(i) % 11 == 0) {
+                tree.setMarker(i, 1);
+            }
+        }
+        tree.adapt();
+        tree.loadBalance();
+    }
+
+    // Build the hierarchy
+    TreeHierarchy hierarchy(tree);
+    if (hierarchy.getNofLevels() != (std::size_t) tree.getMaxDepth() + 1) {
+        log::cout() << "  Number of levels is not valid" << std::endl;
+        return 1;
+    }
+
+    if (!checkHierarchy(tree, hierarchy)) {
+        return 1;
+    }
+
+    std::size_t coarsestLevel = hierarchy.getNofLevels() - 1;
+    if (hierarchy.getGlobalNumOctants(coarsestLevel) != 1) {
+        log::cout() << "  Coarsest level should contain only the root octant" << std::endl;
+        return 1;
+    }
+
+    for (std::size_t level = 0; level < hierarchy.getNofLevels(); ++level) {
+        log::cout() << "     Level " << level << ", depth " << (int) hierarchy.getDepth(level) << ", number of octants: " << hierarchy.getGlobalNumOctants(level) << std::endl;
+    }
+
+    // Build a partial hierarchy
+    TreeHierarchy partialHierarchy(tree, 2);
+    if (partialHierarchy.getDepth(partialHierarchy.getNofLevels() - 1) != 2) {
+        log::cout() << "  Depth of the coarsest level is not valid" << std::endl;
+        return 1;
+    }
+
+    if (partialHierarchy.getGlobalNumOctants(partialHierarchy.getNofLevels() - 1) != (uint64_t(1) << (2 * dimension))) {
+        log::cout() << "  Coarsest level of the partial hierarchy is not valid" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing the hierarchy of a brick tree.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_002(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Create an adapted brick
+    ParaTree tree(dimension);
+    tree.buildBrick({{3, 1, 1}}, 2);
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        if (tree.getGlobalIdx(i) % 5 == 0) {
+            tree.setMarker(i, 1);
+        }
+    }
+    tree.adapt();
+    tree.loadBalance();
+
+    // The coarsest level should contain the root octants of the brick
+    TreeHierarchy hierarchy(tree);
+
+    std::size_t coarsestLevel = hierarchy.getNofLevels() - 1;
+    if (hierarchy.getDepth(coarsestLevel) != tree.getBrickLevel() || hierarchy.getGlobalNumOctants(coarsestLevel) != 3) {
+        log::cout() << "  Coarsest level should contain the root octants of the brick" << std::endl;
+        return 1;
+    }
+
+    int nBoundaryFaces = 0;
+    for (uint32_t i = 0; i < hierarchy.getNumOctants(coarsestLevel); ++i) {
+        const Octant *octant = hierarchy.getOctant(coarsestLevel, i);
+        if (!tree.getBound(octant, 2) || !tree.getBound(octant, 3)) {
+            log::cout() << "  Boundary information of the root octants is not valid" << std::endl;
+            return 1;
+        }
+
+        nBoundaryFaces += tree.getBound(octant, 0) + tree.getBound(octant, 1);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &nBoundaryFaces, 1, MPI_INT, MPI_SUM, tree.getComm());
+    if (nBoundaryFaces != 2) {
+        log::cout() << "  Boundary information of the root octants is not valid" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing multigrid hierarchy of the tree levels" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Hierarchy is not valid" << std::endl;
+                return status;
+            }
+        }
+
+        log::cout() << "Testing multigrid hierarchy of brick trees" << std::endl;
+
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_002(dimension);
+            if (status != 0) {
+                log::cout() << "Brick hierarchy is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,212 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Adapt, load balance and communicate data on the specified tree.
+*
+* \param tree is the tree
+*/
+void runOperations(ParaTree &tree)
+{
+    // Refine a corner of the domain and coarsen the opposite one
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        darray3 center = tree.getCenter(i);
+        if (center[0] + center[1] < 0.5) {
+            tree.setMarker(i, 1);
+        } else if (center[0] + center[1] > 1.5) {
+            tree.setMarker(i, -1);
+        }
+    }
+    tree.adapt();
+
+    // Redistribute the octants
+    tree.loadBalance();
+
+    // Connectivity
+    tree.computeConnectivity();
+
+    // Communicate the global index of the octants
+    std::vector<uint64_t> data(tree.getNumOctants());
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        data[i] = tree.getGlobalIdx(i);
+    }
+
+    std::vector<uint64_t> ghostData(tree.getNumGhosts());
+    tree.communicate(data.data(), ghostData.data());
+}
+
+/*!
+* Subtest 001
+*
+* Testing per-phase performance counters.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    // Counters are disabled by default
+    ParaTree referenceTree(dimension);
+    referenceTree.buildUniform(3);
+    referenceTree.loadBalance();
+    runOperations(referenceTree);
+    for (int phase = 0; phase < ParaTree::PHASE_COUNT; ++phase) {
+        const ParaTree::PerformanceCounters &counters = referenceTree.getPerformanceCounters(static_cast<ParaTree::PerformancePhase>(phase));
+        if (counters.nCalls != 0 || counters.time != 0.) {
+            log::cout() << "  Counters should be disabled by default" << std::endl;
+            return 1;
+        }
+    }
+
+    // Collect the counters
+    ParaTree tree(dimension);
+    tree.enablePerformanceCounters();
+    if (!tree.arePerformanceCountersEnabled()) {
+        log::cout() << "  Counters are not enabled" << std::endl;
+        return 1;
+    }
+
+    tree.buildUniform(3);
+    tree.loadBalance();
+    runOperations(tree);
+
+    const char *phaseNames[] = {"refine", "coarsen", "balance", "ghost halo", "connectivity", "load balance", "communicate"};
+    for (int phase = 0; phase < ParaTree::PHASE_COUNT; ++phase) {
+        ParaTree::PerformancePhase performancePhase = static_cast<ParaTree::PerformancePhase>(phase);
+        const ParaTree::PerformanceCounters &counters = tree.getPerformanceCounters(performancePhase);
+        if (counters.nCalls == 0 || counters.time < 0.) {
+            log::cout() << "  Counters of phase \"" << phaseNames[phase] << "\" have not been updated" << std::endl;
+            return 1;
+        }
+
+        ParaTree::PerformanceCounters minCounters;
+        ParaTree::PerformanceCounters maxCounters;
+        ParaTree::PerformanceCounters avgCounters;
+        tree.reducePerformanceCounters(performancePhase, &minCounters, &maxCounters, &avgCounters);
+
+        log::cout() << "     Phase \"" << phaseNames[phase] << "\"" << std::endl;
+        log::cout() << "       calls         : " << counters.nCalls << std::endl;
+        log::cout() << "       octants       : " << counters.nOctants << std::endl;
+        log::cout() << "       time (min/avg/max) : " << minCounters.time << " / " << avgCounters.time << " / " << maxCounters.time << std::endl;
+        log::cout() << "       sent bytes (min/avg/max) : " << minCounters.nSentBytes << " / " << avgCounters.nSentBytes << " / " << maxCounters.nSentBytes << std::endl;
+        log::cout() << "       received bytes (min/avg/max) : " << minCounters.nReceivedBytes << " / " << avgCounters.nReceivedBytes << " / " << maxCounters.nReceivedBytes << std::endl;
+        log::cout() << "       rounds (min/avg/max) : " << minCounters.nRounds << " / " << avgCounters.nRounds << " / " << maxCounters.nRounds << std::endl;
+
+        if (minCounters.time > counters.time || maxCounters.time < counters.time ||
+                minCounters.time > avgCounters.time || maxCounters.time < avgCounters.time ||
+                minCounters.nOctants > avgCounters.nOctants || maxCounters.nOctants < avgCounters.nOctants ||
+                minCounters.nSentBytes > avgCounters.nSentBytes || maxCounters.nSentBytes < avgCounters.nSentBytes) {
+            log::cout() << "  Reduced counters of phase \"" << phaseNames[phase] << "\" are not valid" << std::endl;
+            return 1;
+        }
+
+        // All the processes execute the same phases
+        if (minCounters.nCalls != counters.nCalls || maxCounters.nCalls != counters.nCalls) {
+            log::cout() << "  Number of calls of phase \"" << phaseNames[phase] << "\" differs among the processes" << std::endl;
+            return 1;
+        }
+    }
+
+    // A single communication is a single round with every neighbour process
+    const ParaTree::PerformanceCounters &communicateCounters = tree.getPerformanceCounters(ParaTree::PHASE_COMMUNICATE);
+    if (communicateCounters.nCalls != 1 || communicateCounters.nRounds != 1 ||
+            communicateCounters.nSentBytes == 0 || communicateCounters.nReceivedBytes == 0) {
+        log::cout() << "  Counters of the communication are not valid" << std::endl;
+        return 1;
+    }
+
+    // The octants have been moved among the processes
+    ParaTree::PerformanceCounters maxLoadBalanceCounters;
+    tree.reducePerformanceCounters(ParaTree::PHASE_LOAD_BALANCE, nullptr, &maxLoadBalanceCounters, nullptr);
+    if (maxLoadBalanceCounters.nSentBytes == 0 || maxLoadBalanceCounters.nReceivedBytes == 0) {
+        log::cout() << "  Traffic of the load balance has not been counted" << std::endl;
+        return 1;
+    }
+
+    // Disabled counters are not updated
+    tree.enablePerformanceCounters(false);
+    runOperations(tree);
+    if (tree.getPerformanceCounters(ParaTree::PHASE_COMMUNICATE).nCalls != 1) {
+        log::cout() << "  Disabled counters should not be updated" << std::endl;
+        return 1;
+    }
+
+    // Reset
+    tree.resetPerformanceCounters();
+    for (int phase = 0; phase < ParaTree::PHASE_COUNT; ++phase) {
+        const ParaTree::PerformanceCounters &counters = tree.getPerformanceCounters(static_cast<ParaTree::PerformancePhase>(phase));
+        if (counters.nCalls != 0 || counters.nOctants != 0 || counters.time != 0. ||
+                counters.nSentBytes != 0 || counters.nReceivedBytes != 0 || counters.nRounds != 0) {
+            log::cout() << "  Counters have not been reset" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing per-phase performance counters" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Performance counters are not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
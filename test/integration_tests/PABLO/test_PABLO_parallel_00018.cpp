@@ -0,0 +1,247 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Fill the fields with the center and the Morton number of the octants.
+*
+* \param tree is the tree
+* \param centers on output will contain the centers of the octants
+* \param mortons on output will contain the Morton numbers of the octants
+*/
+void fillFields(const ParaTree &tree, std::vector<double> *centers, std::vector<uint64_t> *mortons)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    centers->resize(3 * nOctants);
+    mortons->resize(nOctants);
+    for (uint32_t i = 0; i < nOctants; ++i) {
+        darray3 center = tree.getCenter(i);
+        for (int d = 0; d < 3; ++d) {
+            (*centers)[3 * i + d] = center[d];
+        }
+        (*mortons)[i] = tree.getMorton(i);
+    }
+}
+
+/*!
+* Check if the fields match the octants of the tree.
+*
+* \param tree is the tree
+* \param centers are the centers of the octants
+* \param mortons are the Morton numbers of the octants
+* \result Returns true if the fields match the octants, false otherwise.
+*/
+bool checkFields(const ParaTree &tree, const std::vector<double> &centers, const std::vector<uint64_t> &mortons)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    if (centers.size() != 3 * nOctants || mortons.size() != nOctants) {
+        log::cout() << "  Size of the fields doesn't match the number of octants" << std::endl;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < nOctants; ++i) {
+        darray3 center = tree.getCenter(i);
+        for (int d = 0; d < 3; ++d) {
+            if (centers[3 * i + d] != center[d]) {
+                log::cout() << "  Center of octant " << i << " doesn't match" << std::endl;
+                return false;
+            }
+        }
+
+        if (mortons[i] != tree.getMorton(i)) {
+            log::cout() << "  Morton number of octant " << i << " doesn't match" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing load balance of fixed-size fields.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    ParaTree tree(dimension);
+    tree.buildUniform(3);
+
+    std::vector<double> centers;
+    std::vector<uint64_t> mortons;
+    fillFields(tree, &centers, &mortons);
+
+    DataLBFields fields;
+    fields.addField(&centers, 3);
+    fields.addField(&mortons);
+    if (fields.getFieldCount() != 2 || fields.getEntrySize() != 3 * sizeof(double) + sizeof(uint64_t)) {
+        log::cout() << "  Fields have not been registered" << std::endl;
+        return 1;
+    }
+
+    // Distribute the serial tree
+    tree.loadBalance(fields);
+    if (!checkFields(tree, centers, mortons)) {
+        return 1;
+    }
+
+    // Refine a corner of the domain and redistribute the octants with
+    // and without compression.
+    for (int iter = 0; iter < 2; ++iter) {
+        for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+            darray3 center = tree.getCenter(i);
+            if (center[0] + center[1] < 0.5 + 0.25 * iter) {
+                tree.setMarker(i, 1);
+            }
+        }
+        tree.adapt();
+        fillFields(tree, &centers, &mortons);
+
+        tree.setOctantCompression(iter == 0);
+        tree.loadBalance(fields);
+        if (!checkFields(tree, centers, mortons)) {
+            return 1;
+        }
+
+        log::cout() << "     Number of octants after load balance " << iter << " : " << tree.getNumOctants() << std::endl;
+    }
+
+    // Redistribute the octants with weights
+    dvector weights(tree.getNumOctants());
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        weights[i] = 1. + tree.getLevel(i);
+    }
+
+    tree.loadBalance(fields, &weights);
+    if (!checkFields(tree, centers, mortons)) {
+        return 1;
+    }
+
+    // Redistribute the octants keeping families compact
+    uint8_t level = 1;
+    tree.loadBalance(fields, level);
+    if (!checkFields(tree, centers, mortons)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing that fields with a wrong size are rejected by the load balance.
+*
+* \param rank is the rank of the process
+*/
+int subtest_002(int rank)
+{
+    log::cout() << "  >> Fields with a wrong size" << std::endl;
+
+    ParaTree tree(2);
+    tree.buildUniform(3);
+
+    std::vector<double> centers;
+    std::vector<uint64_t> mortons;
+    fillFields(tree, &centers, &mortons);
+
+    // Only the fields of the last process have a wrong size, all processes
+    // should detect the error.
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    if (rank == nProcs - 1) {
+        mortons.pop_back();
+    }
+
+    DataLBFields fields;
+    fields.addField(&centers, 3);
+    fields.addField(&mortons);
+
+    bool exceptionThrown = false;
+    try {
+        tree.loadBalance(fields);
+    } catch (const std::runtime_error &exception) {
+        log::cout() << "     Expected exception: " << exception.what() << std::endl;
+        exceptionThrown = true;
+    }
+
+    if (!exceptionThrown) {
+        log::cout() << "  Fields with a wrong size have not been detected" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing load balance of fixed-size fields" << std::endl;
+
+    int status = 0;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3 && status == 0; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Fields have not been load balanced correctly" << std::endl;
+            }
+        }
+
+        if (status == 0) {
+            status = subtest_002(rank);
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        status = 1;
+    }
+
+    MPI_Finalize();
+
+    return status;
+}
@@ -0,0 +1,265 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check if the load balance exchanged octants only among the processes
+* of the same node.
+*
+* \param tree is the tree
+* \param nodeOffsets are the ranks of the first process of each node
+* \result Returns true if octants were exchanged only among the processes
+* of the same node, false otherwise.
+*/
+bool checkIntraNodeExchanges(const ParaTree &tree, const std::vector<int> &nodeOffsets)
+{
+    auto getNode = [&nodeOffsets](int rank) {
+        return static_cast<int>(std::upper_bound(nodeOffsets.begin(), nodeOffsets.end(), rank) - nodeOffsets.begin()) - 1;
+    };
+
+    int node = getNode(tree.getRank());
+
+    const ParaTree::LoadBalanceRanges &ranges = tree.getLoadBalanceRanges();
+    int isValid = 1;
+    for (const auto &entry : ranges.sendRanges) {
+        if (getNode(entry.first) != node && entry.second[1] > entry.second[0]) {
+            isValid = 0;
+        }
+    }
+    for (const auto &entry : ranges.recvRanges) {
+        if (getNode(entry.first) != node && entry.second[1] > entry.second[0]) {
+            isValid = 0;
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &isValid, 1, MPI_INT, MPI_LAND, tree.getComm());
+
+    return (isValid == 1);
+}
+
+/*!
+* Subtest 001
+*
+* Testing node-aware partitioning.
+*
+* \param dimension is the dimension of the tree
+*/
+int subtest_001(uint8_t dimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << std::endl;
+
+    int rank;
+    int nProcs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    // Emulate two nodes: the first one with all the processes but the last
+    // one, the second one with the last process.
+    std::vector<int> nodeOffsets = {0, nProcs - 1, nProcs};
+    int color = (rank < nProcs - 1) ? 0 : 1;
+
+    MPI_Comm nodeComm;
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &nodeComm);
+
+    ParaTree tree(dimension);
+    tree.enableNodeAwarePartitioning(true, nodeComm);
+    tree.setNodePartitionTolerance(0.5);
+    MPI_Comm_free(&nodeComm);
+
+    if (!tree.isNodeAwarePartitioningEnabled() || tree.getPartitionNodeCount() != 2) {
+        log::cout() << "  Nodes have not been detected" << std::endl;
+        return 1;
+    }
+
+    // Distribute the serial tree
+    tree.buildUniform(3);
+    tree.loadBalance();
+
+    uint64_t nGlobalOctants = tree.getGlobalNumOctants();
+    const std::vector<uint64_t> &ranges = tree.getPartitionRangeGlobalIdx();
+    uint64_t nNodeOctants = ranges[nProcs - 2] + 1;
+    uint64_t targetNodeOctants = nGlobalOctants * (nProcs - 1) / nProcs;
+    if (std::max(nNodeOctants, targetNodeOctants) - std::min(nNodeOctants, targetNodeOctants) > 1) {
+        log::cout() << "  Octants have not been partitioned among the nodes" << std::endl;
+        return 1;
+    }
+
+    // Refine some octants of the first process, the imbalance among the
+    // nodes is within the tolerance, hence the boundary between the nodes
+    // should not be moved.
+    uint64_t nodeBoundaryMorton = tree.getPartitionFirstDesc()[nProcs - 1];
+    if (rank == 0) {
+        for (uint32_t i = 0; i < tree.getNumOctants(); i += 4) {
+            tree.setMarker(i, 1);
+        }
+    }
+    tree.adapt();
+    tree.loadBalance();
+
+    if (tree.getPartitionFirstDesc()[nProcs - 1] != nodeBoundaryMorton) {
+        log::cout() << "  Boundary between the nodes has been moved" << std::endl;
+        return 1;
+    }
+
+    if (!checkIntraNodeExchanges(tree, nodeOffsets)) {
+        log::cout() << "  Octants have been exchanged among different nodes" << std::endl;
+        return 1;
+    }
+
+    uint32_t nOctants = tree.getNumOctants();
+    uint32_t minNodeOctants = nOctants;
+    uint32_t maxNodeOctants = nOctants;
+    MPI_Comm firstNodeComm;
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &firstNodeComm);
+    MPI_Allreduce(MPI_IN_PLACE, &minNodeOctants, 1, MPI_UINT32_T, MPI_MIN, firstNodeComm);
+    MPI_Allreduce(MPI_IN_PLACE, &maxNodeOctants, 1, MPI_UINT32_T, MPI_MAX, firstNodeComm);
+    MPI_Comm_free(&firstNodeComm);
+    if (maxNodeOctants - minNodeOctants > 1) {
+        log::cout() << "  Octants have not been balanced among the processes of the node" << std::endl;
+        return 1;
+    }
+
+    log::cout() << "     Local octants after intra-node load balance : " << nOctants << std::endl;
+
+    // Without tolerance the boundary between the nodes is moved
+    tree.setNodePartitionTolerance(0.);
+    tree.loadBalance();
+
+    nGlobalOctants = tree.getGlobalNumOctants();
+    nNodeOctants = tree.getPartitionRangeGlobalIdx()[nProcs - 2] + 1;
+    targetNodeOctants = nGlobalOctants * (nProcs - 1) / nProcs;
+    if (std::max(nNodeOctants, targetNodeOctants) - std::min(nNodeOctants, targetNodeOctants) > 1) {
+        log::cout() << "  Octants have not been repartitioned among the nodes" << std::endl;
+        return 1;
+    }
+
+    log::cout() << "     Local octants after node load balance : " << tree.getNumOctants() << std::endl;
+
+    // Unit weights should give the same partition as uniform partitioning
+    std::vector<uint64_t> uniformRanges = tree.getPartitionRangeGlobalIdx();
+
+    dvector unitWeights(tree.getNumOctants(), 1.);
+    tree.loadBalance(&unitWeights);
+
+    if (tree.getPartitionRangeGlobalIdx() != uniformRanges) {
+        log::cout() << "  Uniform and unit-weight partitions don't match" << std::endl;
+        return 1;
+    }
+
+    // Weighted partitioning
+    dvector weights(tree.getNumOctants());
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        weights[i] = 1. + tree.getLevel(i);
+    }
+    tree.loadBalance(&weights);
+
+    // Every boundary is placed at the position closest to its target weight,
+    // hence the weights of nodes and processes can't differ from their
+    // target by more than the weight of an octant.
+    double maxWeight = 1. + tree.getMaxDepth();
+
+    double localWeight = 0.;
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        localWeight += 1. + tree.getLevel(i);
+    }
+
+    std::vector<double> processWeights(nProcs);
+    MPI_Allgather(&localWeight, 1, MPI_DOUBLE, processWeights.data(), 1, MPI_DOUBLE, MPI_COMM_WORLD);
+
+    double totalWeight = 0.;
+    double firstNodeWeight = 0.;
+    for (int i = 0; i < nProcs; ++i) {
+        totalWeight += processWeights[i];
+        if (i < nProcs - 1) {
+            firstNodeWeight += processWeights[i];
+        }
+    }
+
+    double targetNodeWeight = totalWeight * (nProcs - 1) / nProcs;
+    if (std::abs(firstNodeWeight - targetNodeWeight) > maxWeight) {
+        log::cout() << "  Weights have not been balanced among the nodes" << std::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < nProcs - 1; ++i) {
+        if (std::abs(processWeights[i] - firstNodeWeight / (nProcs - 1)) > maxWeight) {
+            log::cout() << "  Weights have not been balanced among the processes of the node" << std::endl;
+            return 1;
+        }
+    }
+
+    log::cout() << "     Local weight after weighted load balance : " << localWeight << std::endl;
+
+    // Disable node-aware partitioning
+    tree.enableNodeAwarePartitioning(false);
+    if (tree.isNodeAwarePartitioningEnabled() || tree.getPartitionNodeCount() != 0) {
+        log::cout() << "  Node-aware partitioning has not been disabled" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing node-aware partitioning" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            status = subtest_001(dimension);
+            if (status != 0) {
+                log::cout() << "Node-aware partitioning is not valid" << std::endl;
+                return status;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,187 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+
+#include <mpi.h>
+
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Mark the octants whose center lies near the specified point.
+*
+* \param tree is the tree whose octants will be marked
+* \param point is the point around which the octants will be marked
+* \param radius is the radius of the marked region
+* \param marker is the marker that will be set
+*/
+void markRegion(ParaTree &tree, const darray3 &point, double radius, int8_t marker)
+{
+    for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+        darray3 center = tree.getCenter(i);
+
+        double distance = 0.;
+        for (int d = 0; d < tree.getDim(); ++d) {
+            distance += (center[d] - point[d]) * (center[d] - point[d]);
+        }
+
+        if (distance <= radius * radius) {
+            tree.setMarker(i, marker);
+        }
+    }
+}
+
+/*!
+* Compare a partitioned tree with a serial reference tree.
+*
+* \param tree is the partitioned tree to check
+* \param reference is the serial reference tree
+* \result Returns true if the trees contain the same octants, false otherwise.
+*/
+bool compareTrees(ParaTree &tree, ParaTree &reference)
+{
+    int failed = 0;
+    if (tree.getGlobalNumOctants() != reference.getGlobalNumOctants()) {
+        log::cout() << "  Global number of octants doesn't match" << std::endl;
+        failed = 1;
+    } else {
+        for (uint32_t i = 0; i < tree.getNumOctants(); ++i) {
+            uint32_t referenceIdx = static_cast<uint32_t>(tree.getGlobalIdx(i));
+            if (tree.getMorton(i) != reference.getMorton(referenceIdx) || tree.getLevel(i) != reference.getLevel(referenceIdx)) {
+                log::cout() << "  Octant " << tree.getGlobalIdx(i) << " doesn't match" << std::endl;
+                failed = 1;
+                break;
+            }
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    return (failed == 0);
+}
+
+/*!
+* Subtest 001
+*
+* Testing 2:1 balance of trees refined unevenly across the processes.
+*
+* \param dimension is the dimension of the tree
+* \param codimension is the balance codimension
+*/
+int subtest_001(uint8_t dimension, uint8_t codimension)
+{
+    log::cout() << "  >> Dimension " << (int) dimension << ", balance codimension " << (int) codimension << std::endl;
+
+    // Partitioned tree
+    ParaTree tree(dimension);
+    tree.setBalanceCodimension(codimension);
+    for (int i = 0; i < 3; ++i) {
+        tree.adaptGlobalRefine();
+    }
+    tree.loadBalance();
+
+    // Serial reference tree
+    ParaTree reference(dimension, ParaTree::DEFAULT_LOG_FILE, MPI_COMM_SELF);
+    reference.setBalanceCodimension(codimension);
+    for (int i = 0; i < 3; ++i) {
+        reference.adaptGlobalRefine();
+    }
+
+    // Adapt both trees with the same markers
+    //
+    // The regions are chosen so that the refinement is concentrated on some
+    // of the processes, while the octants created by the 2:1 balance spill
+    // over the partition boundaries.
+    const darray3 refinePoint = {{0.45, 0.55, 0.45}};
+    const darray3 coarsenPoint = {{0.85, 0.15, 0.85}};
+    for (int step = 0; step < 3; ++step) {
+        for (ParaTree *adaptTree : {&tree, &reference}) {
+            markRegion(*adaptTree, refinePoint, 0.1, static_cast<int8_t>(step + 1));
+            if (step > 0) {
+                markRegion(*adaptTree, coarsenPoint, 0.25, -1);
+            }
+            adaptTree->adapt();
+        }
+
+        if (!compareTrees(tree, reference)) {
+            log::cout() << "  Trees don't match after adaption step " << step << std::endl;
+            return 1;
+        }
+
+        // Only balance the partitioned tree every other step, this leaves
+        // the refined region unevenly distributed among the processes.
+        if (step % 2 == 1) {
+            tree.loadBalance();
+            if (!compareTrees(tree, reference)) {
+                log::cout() << "  Trees don't match after load balance " << step << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    log::cout() << "     Number of octants: " << tree.getGlobalNumOctants() << std::endl;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    log::cout() << "Testing 2:1 balance of unevenly refined trees" << std::endl;
+
+    int status;
+    try {
+        for (uint8_t dimension = 2; dimension <= 3; ++dimension) {
+            for (uint8_t codimension = 1; codimension <= dimension; ++codimension) {
+                status = subtest_001(dimension, codimension);
+                if (status != 0) {
+                    log::cout() << "Balanced tree doesn't match the serial reference" << std::endl;
+                    return status;
+                }
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
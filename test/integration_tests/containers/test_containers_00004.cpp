@@ -0,0 +1,200 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "bitpit_containers.hpp"
+
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include <stdexcept>
+
+using namespace bitpit;
+
+/*!
+* Check if the elements of the container match the expected values.
+*
+* \param container is the container to check
+* \param expected is the map with the expected values
+*/
+void checkContents(const PiercedVector<double> &container, const std::unordered_map<long, double> &expected)
+{
+    container.checkIntegrity();
+
+    if (container.size() != expected.size()) {
+        throw std::runtime_error("Size of the container doesn't match the expected value");
+    }
+
+    for (const auto &entry : expected) {
+        auto itr = container.find(entry.first);
+        if (itr == container.end()) {
+            throw std::runtime_error("Unable to find an element of the container");
+        }
+
+        if (*itr != entry.second || container.at(entry.first) != entry.second) {
+            throw std::runtime_error("Contents of the container don't match expected values");
+        }
+    }
+
+    if (container.contains(-1) || container.find(-1) != container.end()) {
+        throw std::runtime_error("Container contains a negative id");
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing the dense id map of the kernel.
+*/
+int subtest_001()
+{
+    std::cout << std::endl;
+    std::cout << "Testing dense id map" << std::endl;
+
+    PiercedVector<double> container;
+    std::unordered_map<long, double> expected;
+
+    // Dense ids
+    std::cout << "Inserting dense ids..." << std::endl;
+
+    const long N_DENSE_IDS = 10000;
+    for (long id = 0; id < N_DENSE_IDS; ++id) {
+        container.insert(id, 0.5 * id);
+        expected[id] = 0.5 * id;
+    }
+
+    if (!container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be dense");
+    }
+
+    checkContents(container, expected);
+
+    // Erase and sort
+    std::cout << "Erasing and sorting..." << std::endl;
+
+    for (long id = 0; id < N_DENSE_IDS; id += 3) {
+        container.erase(id);
+        expected.erase(id);
+    }
+
+    container.emplace(N_DENSE_IDS + 1, -1.);
+    expected[N_DENSE_IDS + 1] = -1.;
+
+    container.sort();
+    container.squeeze();
+
+    if (!container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be dense");
+    }
+
+    checkContents(container, expected);
+
+    // Sparse ids
+    std::cout << "Inserting sparse ids..." << std::endl;
+
+    const long SPARSE_ID = 1000000000;
+    container.insert(SPARSE_ID, 1.);
+    expected[SPARSE_ID] = 1.;
+
+    if (container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be sparse");
+    }
+
+    checkContents(container, expected);
+
+    container.erase(SPARSE_ID);
+    expected.erase(SPARSE_ID);
+
+    container.sort();
+
+    if (!container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be dense after sorting dense ids");
+    }
+
+    checkContents(container, expected);
+
+    container.insert(SPARSE_ID, 1.);
+    container.erase(SPARSE_ID);
+
+    if (container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be sparse");
+    }
+
+    container.squeeze();
+
+    if (!container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be dense after squeezing dense ids");
+    }
+
+    checkContents(container, expected);
+
+    // Clear
+    std::cout << "Clearing the container..." << std::endl;
+
+    container.clear();
+    expected.clear();
+
+    if (!container.isIdMapDense()) {
+        throw std::runtime_error("Id map should be dense");
+    }
+
+    container.insert(3, 3.);
+    expected[3] = 3.;
+
+    checkContents(container, expected);
+
+    std::cout << "Test completed." << std::endl;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Run the subtests
+    std::cout << "Testing PiercedVector id map" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        std::cout << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,190 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include "bitpit_containers.hpp"
+
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include <stdexcept>
+
+using namespace bitpit;
+
+/*!
+* Master that exposes the registration of the slaves.
+*/
+class TestMaster : public PiercedSyncMaster {
+
+public:
+    using PiercedSyncMaster::registerSlave;
+    using PiercedSyncMaster::unregisterSlave;
+    using PiercedSyncMaster::isSlaveRegistered;
+    using PiercedSyncMaster::processSyncAction;
+
+    TestMaster() = default;
+    TestMaster(const TestMaster &other) = default;
+
+    TestMaster & operator=(const TestMaster &other) = default;
+
+};
+
+/*!
+* Slave that counts the synchronization actions it receives.
+*/
+class TestSlave : public PiercedSyncSlave {
+
+public:
+    std::size_t nActions = 0;
+
+protected:
+    void commitSyncAction(const PiercedSyncAction &action) override
+    {
+        BITPIT_UNUSED(action);
+
+        ++nActions;
+    }
+
+};
+
+/*!
+* Subtest 001
+*
+* Testing that copies of a master don't take over its slaves.
+*/
+int subtest_001()
+{
+    std::cout << std::endl;
+    std::cout << "Testing slaves of copied masters" << std::endl;
+
+    const PiercedSyncAction action(PiercedSyncAction::TYPE_CLEAR);
+
+    TestMaster master;
+    TestSlave slave;
+    master.registerSlave(&slave, PiercedSyncMaster::SYNC_MODE_CONCURRENT);
+
+    master.processSyncAction(action);
+    if (slave.nActions != 1) {
+        throw std::runtime_error("Slave has not been synchronized with the master");
+    }
+
+    // Copy construction
+    std::cout << "Copy constructing the master..." << std::endl;
+    {
+        TestMaster copiedMaster(master);
+        if (copiedMaster.isSlaveRegistered(&slave)) {
+            throw std::runtime_error("Slave is registered with the copied master");
+        }
+
+        copiedMaster.processSyncAction(action);
+        if (slave.nActions != 1) {
+            throw std::runtime_error("Slave has been synchronized with the copied master");
+        }
+    }
+
+    // Copy assignment
+    std::cout << "Copy assigning the master..." << std::endl;
+    {
+        TestMaster assignedMaster;
+        assignedMaster = master;
+        if (assignedMaster.isSlaveRegistered(&slave)) {
+            throw std::runtime_error("Slave is registered with the assigned master");
+        }
+
+        assignedMaster.processSyncAction(action);
+        if (slave.nActions != 1) {
+            throw std::runtime_error("Slave has been synchronized with the assigned master");
+        }
+    }
+
+    // Copy assignment of a master with registered slaves
+    std::cout << "Copy assigning a master with registered slaves..." << std::endl;
+    {
+        TestMaster assignedMaster;
+        TestSlave assignedSlave;
+        assignedMaster.registerSlave(&assignedSlave, PiercedSyncMaster::SYNC_MODE_CONCURRENT);
+
+        bool assignmentRejected = false;
+        try {
+            assignedMaster = master;
+        } catch (const std::logic_error &exception) {
+            BITPIT_UNUSED(exception);
+
+            assignmentRejected = true;
+        }
+
+        if (!assignmentRejected) {
+            throw std::runtime_error("Master with registered slaves has been assigned");
+        }
+
+        if (!assignedMaster.isSlaveRegistered(&assignedSlave)) {
+            throw std::runtime_error("Slave of the assigned master is no longer registered");
+        }
+
+        assignedMaster.unregisterSlave(&assignedSlave);
+    }
+
+    // The slave is still synchronized with the original master
+    if (!master.isSlaveRegistered(&slave)) {
+        throw std::runtime_error("Slave is no longer registered with the master");
+    }
+
+    master.processSyncAction(action);
+    if (slave.nActions != 2) {
+        throw std::runtime_error("Slave has not been synchronized with the master");
+    }
+
+    master.unregisterSlave(&slave);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Run the subtests
+    std::cout << "Testing PiercedSyncMaster copies" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+    } catch (const std::exception &exception) {
+        std::cout << exception.what() << std::endl;
+        status = 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
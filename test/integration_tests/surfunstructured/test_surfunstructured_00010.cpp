@@ -0,0 +1,240 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// ========================================================================== //
+//           ** BitPit mesh ** Test 010 for class SurfUnstructured **         //
+//                                                                            //
+// Test threaded adjacencies build on non-manifold surfaces                   //
+// ========================================================================== //
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+// Standard Template Library
+# include <array>
+# include <vector>
+# include <unordered_map>
+# include <iostream>
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+#if BITPIT_ENABLE_OPENMP==1
+# include <omp.h>
+#endif
+
+// BitPit
+# include "bitpit_common.hpp"
+# include "bitpit_surfunstructured.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace std;
+using namespace bitpit;
+
+// ========================================================================== //
+// AUXILIARY FUNCTIONS                                                        //
+// ========================================================================== //
+unordered_map<long, vector<vector<long>>> gatherAdjacencies(
+    const SurfUnstructured &mesh
+) {
+    unordered_map<long, vector<vector<long>>> adjacencies;
+    for (const Cell &cell : mesh.getCells()) {
+        int nCellFaces = cell.getFaceCount();
+        vector<vector<long>> &cellAdjacencies = adjacencies[cell.getId()];
+        cellAdjacencies.resize(nCellFaces);
+        for (int face = 0; face < nCellFaces; ++face) {
+            const long *faceAdjacencies = cell.getAdjacencies(face);
+            int nFaceAdjacencies = cell.getAdjacencyCount(face);
+            cellAdjacencies[face].assign(faceAdjacencies, faceAdjacencies + nFaceAdjacencies);
+        }
+    }
+
+    return adjacencies;
+}
+
+// ========================================================================== //
+// SUBTEST #001 Test threaded adjacencies build                               //
+// ========================================================================== //
+int subtest_001(
+    void
+) {
+
+    // Create the mesh
+    //
+    // The mesh is a triangulated square. Fins are attached to the horizontal
+    // edges of the square, some edges carry one fin, some edges carry two
+    // fins and fins may have different windings. This creates non-manifold
+    // edges shared among three or four triangles.
+    log::cout() << "  >> Creating the mesh" << std::endl;
+
+#if BITPIT_ENABLE_MPI
+    SurfUnstructured mesh(2, MPI_COMM_NULL);
+#else
+    SurfUnstructured mesh(2);
+#endif
+
+    const int N = 70;
+
+    for (int j = 0; j <= N; ++j) {
+        for (int i = 0; i <= N; ++i) {
+            mesh.addVertex({{double(i), double(j), 0.}});
+        }
+    }
+
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            long v0 = j * (N + 1) + i;
+            long v1 = v0 + 1;
+            long v2 = v1 + (N + 1);
+            long v3 = v0 + (N + 1);
+
+            mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v0, v1, v2});
+            mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v0, v2, v3});
+        }
+    }
+
+    for (int j = 1; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            long v0 = j * (N + 1) + i;
+            long v1 = v0 + 1;
+
+            long apex = mesh.addVertex({{i + 0.5, double(j), 1.}})->getId();
+            if ((i + j) % 2 == 0) {
+                mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v0, v1, apex});
+            } else {
+                mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v1, v0, apex});
+            }
+
+            if (i % 3 == 0) {
+                long bottomApex = mesh.addVertex({{i + 0.5, double(j), -1.}})->getId();
+                mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v1, v0, bottomApex});
+            }
+        }
+    }
+
+    log::cout() << "  >> Number of cells: " << mesh.getCellCount() << std::endl;
+
+    // Build adjacencies using a single thread
+    log::cout() << "  >> Building adjacencies using a single thread" << std::endl;
+
+#if BITPIT_ENABLE_OPENMP==1
+    int nMaxThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+
+    mesh.destroyAdjacencies();
+    mesh.initializeAdjacencies();
+    unordered_map<long, vector<vector<long>>> serialAdjacencies = gatherAdjacencies(mesh);
+
+    // Build adjacencies using multiple threads
+    log::cout() << "  >> Building adjacencies using multiple threads" << std::endl;
+
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(std::max(nMaxThreads, 4));
+#endif
+
+    mesh.destroyAdjacencies();
+    mesh.initializeAdjacencies();
+    unordered_map<long, vector<vector<long>>> threadedAdjacencies = gatherAdjacencies(mesh);
+
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nMaxThreads);
+#endif
+
+    // Compare adjacencies
+    log::cout() << "  >> Comparing adjacencies" << std::endl;
+
+    long nNonManifoldFaces = 0;
+    for (const Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+        const vector<vector<long>> &cellSerialAdjacencies   = serialAdjacencies.at(cellId);
+        const vector<vector<long>> &cellThreadedAdjacencies = threadedAdjacencies.at(cellId);
+        if (cellSerialAdjacencies != cellThreadedAdjacencies) {
+            log::cout() << "  Adjacencies of cell " << cellId << " don't match." << std::endl;
+            return 1;
+        }
+
+        for (const vector<long> &faceAdjacencies : cellSerialAdjacencies) {
+            if (faceAdjacencies.size() > 1) {
+                ++nNonManifoldFaces;
+            }
+        }
+    }
+
+    if (nNonManifoldFaces == 0) {
+        log::cout() << "  No non-manifold faces found." << std::endl;
+        return 1;
+    }
+
+    log::cout() << "  >> Number of non-manifold faces: " << nNonManifoldFaces << std::endl;
+
+    return 0;
+}
+
+// ========================================================================== //
+// MAIN                                                                       //
+// ========================================================================== //
+int main(int argc, char *argv[])
+{
+    // ====================================================================== //
+    // INITIALIZE MPI                                                         //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Local variabels
+    int                             status = 0;
+
+    // ====================================================================== //
+    // RUN SUB-TESTS                                                          //
+    // ====================================================================== //
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return (10 + status);
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    // ====================================================================== //
+    // FINALIZE MPI                                                           //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
@@ -0,0 +1,318 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// ========================================================================== //
+//           ** BitPit mesh ** Test 011 for class SurfUnstructured **         //
+//                                                                            //
+// Test the geometric cache of surface patches                                //
+// ========================================================================== //
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+// Standard Template Library
+# include <array>
+# include <cmath>
+# include <vector>
+# include <iostream>
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// BitPit
+# include "bitpit_common.hpp"
+# include "bitpit_surfunstructured.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace std;
+using namespace bitpit;
+
+// ========================================================================== //
+// AUXILIARY FUNCTIONS                                                        //
+// ========================================================================== //
+
+/*!
+* Fill the specified patch with a wavy surface made of triangles, quadrangles
+* and hexagonal polygons.
+*
+* Each row of the grid uses a different element type: quadrangles, pairs of
+* triangles, or polygons obtained merging two neighbouring quadrangles.
+*
+* \param N is the number of grid intervals along each direction
+* \param mesh is the patch that will be filled
+*/
+void fillMesh(
+    int                 N,
+    SurfUnstructured    &mesh
+) {
+    for (int j = 0; j <= N; ++j) {
+        for (int i = 0; i <= N; ++i) {
+            double x = double(i);
+            double y = double(j);
+            double z = 0.2 * std::sin(0.7 * x) * std::cos(0.4 * y);
+            mesh.addVertex({{x, y, z}}, j * (N + 1) + i);
+        }
+    }
+
+    for (int j = 0; j < N; ++j) {
+        for (int i = 0; i < N; ++i) {
+            long v0 = j * (N + 1) + i;
+            long v1 = v0 + 1;
+            long v2 = v1 + (N + 1);
+            long v3 = v0 + (N + 1);
+
+            switch (j % 3) {
+
+            case 0:
+                mesh.addCell(ElementType::QUAD, std::vector<long>{v0, v1, v2, v3});
+                break;
+
+            case 1:
+                mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v0, v1, v2});
+                mesh.addCell(ElementType::TRIANGLE, std::vector<long>{v0, v2, v3});
+                break;
+
+            default:
+                if (i % 2 == 0 && i + 1 < N) {
+                    long v4 = v1 + 1;
+                    long v5 = v2 + 1;
+                    mesh.addCell(ElementType::POLYGON, std::vector<long>{6, v0, v1, v4, v5, v2, v3});
+                } else if (i % 2 == 0) {
+                    mesh.addCell(ElementType::QUAD, std::vector<long>{v0, v1, v2, v3});
+                }
+                break;
+
+            }
+        }
+    }
+}
+
+/*!
+* Check that the cached geometric quantities match the evaluated ones.
+*
+* \param mesh is the patch
+* \result Returns true if the cached quantities match the evaluated ones,
+* false otherwise.
+*/
+bool checkGeometricCache(
+    const SurfUnstructured      &mesh
+) {
+    const double TOLERANCE = 1e-12;
+
+    for (const Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+        if (std::abs(mesh.getCellArea(cellId) - mesh.evalCellArea(cellId)) > TOLERANCE) {
+            log::cout() << "  Cached area of cell " << cellId << " doesn't match the evaluated one." << std::endl;
+            return false;
+        }
+
+        if (norm2(mesh.getCellCentroid(cellId) - mesh.evalCellCentroid(cellId)) > TOLERANCE) {
+            log::cout() << "  Cached centroid of cell " << cellId << " doesn't match the evaluated one." << std::endl;
+            return false;
+        }
+
+        if (norm2(mesh.getFacetNormal(cellId) - mesh.evalFacetNormal(cellId)) > TOLERANCE) {
+            log::cout() << "  Cached normal of cell " << cellId << " doesn't match the evaluated one." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ========================================================================== //
+// SUBTEST #001 Test the geometric cache                                      //
+// ========================================================================== //
+int subtest_001(
+    void
+) {
+
+    // Create the mesh
+    log::cout() << "  >> Creating the mesh" << std::endl;
+
+#if BITPIT_ENABLE_MPI
+    SurfUnstructured mesh(0, 2, MPI_COMM_NULL);
+#else
+    SurfUnstructured mesh(0, 2);
+#endif
+
+    const int N = 24;
+    fillMesh(N, mesh);
+
+    log::cout() << "  >> Number of cells: " << mesh.getCellCount() << std::endl;
+
+    // Enable the cache
+    log::cout() << "  >> Enabling the cache" << std::endl;
+
+    mesh.setGeometricCacheEnabled(true);
+    if (!mesh.isGeometricCacheEnabled() || !checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    // Add cells
+    //
+    // A triangle and a polygon are added above the surface.
+    log::cout() << "  >> Adding cells" << std::endl;
+
+    std::vector<long> triangleConnect;
+    triangleConnect.push_back(mesh.addVertex({{0.0, 0.0, 2.0}})->getId());
+    triangleConnect.push_back(mesh.addVertex({{3.0, 0.0, 2.5}})->getId());
+    triangleConnect.push_back(mesh.addVertex({{0.0, 4.0, 2.0}})->getId());
+    long triangleId = mesh.addCell(ElementType::TRIANGLE, triangleConnect).getId();
+
+    std::vector<long> polygonConnect = {5};
+    for (int k = 0; k < 5; ++k) {
+        double angle = 2. * BITPIT_PI * k / 5.;
+        polygonConnect.push_back(mesh.addVertex({{std::cos(angle), std::sin(angle), 3.0}})->getId());
+    }
+    long polygonId = mesh.addCell(ElementType::POLYGON, polygonConnect).getId();
+
+    mesh.update();
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    if (std::abs(mesh.getCellArea(triangleId) - 0.5 * std::sqrt(148.)) > 1e-12) {
+        log::cout() << "  Cached area of the added triangle doesn't match the expected value." << std::endl;
+        return 1;
+    }
+
+    // Delete cells
+    log::cout() << "  >> Deleting cells" << std::endl;
+
+    mesh.deleteCell(0);
+    mesh.deleteCell(triangleId);
+    mesh.deleteCell(mesh.getCellCount() / 2);
+
+    mesh.update();
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    // Update cells
+    //
+    // Cells are replaced by cells with the same id but a different shape,
+    // cached values of the old cells should not be reused.
+    log::cout() << "  >> Updating cells" << std::endl;
+
+    std::vector<long> updatedIds = {1, polygonId};
+    for (long cellId : updatedIds) {
+        Cell &cell = mesh.getCell(cellId);
+        std::vector<long> connect(cell.getVertexIds().begin(), cell.getVertexIds().end());
+        connect.pop_back();
+
+        mesh.deleteCell(cellId);
+        if (connect.size() == 3) {
+            mesh.addCell(ElementType::TRIANGLE, connect, cellId);
+        } else {
+            connect.insert(connect.begin(), static_cast<long>(connect.size()));
+            mesh.addCell(ElementType::POLYGON, connect, cellId);
+        }
+    }
+
+    mesh.update();
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    // Transform the mesh
+    log::cout() << "  >> Translating the mesh" << std::endl;
+
+    mesh.translate({{1.0, -2.0, 0.5}});
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    log::cout() << "  >> Rotating the mesh" << std::endl;
+
+    mesh.rotate({{0.0, 0.0, 0.0}}, {{1.0, 1.0, 0.0}}, 0.7);
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    log::cout() << "  >> Scaling the mesh" << std::endl;
+
+    mesh.scale({{2.0, 0.5, 1.5}}, {{1.0, 1.0, 1.0}});
+    if (!checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    // Disable the cache
+    log::cout() << "  >> Disabling the cache" << std::endl;
+
+    mesh.setGeometricCacheEnabled(false);
+    if (mesh.isGeometricCacheEnabled() || !checkGeometricCache(mesh)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// ========================================================================== //
+// MAIN                                                                       //
+// ========================================================================== //
+int main(int argc, char *argv[])
+{
+    // ====================================================================== //
+    // INITIALIZE MPI                                                         //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Local variabels
+    int                             status = 0;
+
+    // ====================================================================== //
+    // RUN SUB-TESTS                                                          //
+    // ====================================================================== //
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            status = 10 + status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        status = 1;
+    }
+
+    // ====================================================================== //
+    // FINALIZE MPI                                                           //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
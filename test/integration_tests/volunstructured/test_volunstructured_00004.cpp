@@ -0,0 +1,326 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2023 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <algorithm>
+#include <sstream>
+
+#include "bitpit_common.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+/*!
+* Fill the specified 2D patch.
+*
+* \param patch is the patch that will be filled
+*/
+void fillPatch(VolUnstructured *patch)
+{
+    patch->setVertexAutoIndexing(false);
+
+    patch->addVertex({{0.00000000, 0.00000000, 0.00000000}},  1);
+    patch->addVertex({{0.00000000, 1.00000000, 0.00000000}},  2);
+    patch->addVertex({{1.00000000, 1.00000000, 0.00000000}},  3);
+    patch->addVertex({{1.00000000, 0.00000000, 0.00000000}},  4);
+    patch->addVertex({{1.00000000, 0.50000000, 0.00000000}},  5);
+    patch->addVertex({{0.25992107, 1.00000000, 0.00000000}},  6);
+    patch->addVertex({{0.58740113, 1.00000000, 0.00000000}},  7);
+    patch->addVertex({{0.00000000, 0.75000000, 0.00000000}},  8);
+    patch->addVertex({{0.00000000, 0.50000000, 0.00000000}},  9);
+    patch->addVertex({{0.00000000, 0.25000000, 0.00000000}}, 10);
+    patch->addVertex({{0.25992107, 0.00000000, 0.00000000}}, 11);
+    patch->addVertex({{0.58740113, 0.00000000, 0.00000000}}, 12);
+    patch->addVertex({{0.42807699, 0.41426491, 0.00000000}}, 13);
+    patch->addVertex({{0.30507278, 0.69963441, 0.00000000}}, 14);
+    patch->addVertex({{0.64032722, 0.68239464, 0.00000000}}, 15);
+    patch->addVertex({{0.24229808, 0.24179558, 0.00000000}}, 16);
+    patch->addVertex({{0.67991107, 0.28835559, 0.00000000}}, 17);
+    patch->addVertex({{0.22034760, 0.48841527, 0.00000000}}, 18);
+    patch->addVertex({{0.43952167, 0.18888322, 0.00000000}}, 19);
+
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3,  7, 15}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{ 1, 11, 16, 10}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8,  9, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8, 18, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3, 15,  5}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 9, 10, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{10, 16, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4, 17, 12}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4,  5, 17}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{13, 17, 15, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 12, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 19, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{12, 17, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 14, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 5, 15, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 19, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 16, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 18, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{14, 15,  7}}));
+    patch->addCell(ElementType::POLYGON,  std::vector<long>({{ 5,  2,  8, 14, 7, 6}}));
+}
+
+/*!
+* Check if the cells of the specified patches have the same connectivity.
+*
+* \param patch is the patch to check
+* \param reference is the reference patch
+* \param expectExternal controls if the connectivity of the cells of the
+* patch is expected to be stored in an external storage
+* \result Returns true if the check is successful, false otherwise.
+*/
+bool checkConnectivity(const PatchKernel &patch, const PatchKernel &reference, bool expectExternal)
+{
+    if (patch.getCellCount() != reference.getCellCount()) {
+        log::cout() << "   Number of cells doesn't match the expected value!" << std::endl;
+        return false;
+    }
+
+    for (const Cell &cell : patch.getCells()) {
+        const Cell &referenceCell = reference.getCell(cell.getId());
+        if (!cell.hasSameConnect(referenceCell)) {
+            log::cout() << "   Connectivity of cell " << cell.getId() << " doesn't match the expected value!" << std::endl;
+            return false;
+        }
+
+        if (cell.hasExternalConnect() != expectExternal) {
+            log::cout() << "   Storage of the connectivity of cell " << cell.getId() << " doesn't match the expected one!" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Check if the cells of the specified patches have the same neighbourhood.
+*
+* \param patch is the patch to check
+* \param reference is the reference patch
+* \result Returns true if the check is successful, false otherwise.
+*/
+bool checkNeighbourhood(const PatchKernel &patch, const PatchKernel &reference)
+{
+    for (const Cell &cell : patch.getCells()) {
+        const Cell &referenceCell = reference.getCell(cell.getId());
+
+        std::vector<long> adjacencies(cell.getAdjacencies(), cell.getAdjacencies() + cell.getAdjacencyCount());
+        std::vector<long> referenceAdjacencies(referenceCell.getAdjacencies(), referenceCell.getAdjacencies() + referenceCell.getAdjacencyCount());
+        std::sort(adjacencies.begin(), adjacencies.end());
+        std::sort(referenceAdjacencies.begin(), referenceAdjacencies.end());
+        if (adjacencies != referenceAdjacencies) {
+            log::cout() << "   Adjacencies of cell " << cell.getId() << " don't match the expected value!" << std::endl;
+            return false;
+        }
+
+        if (cell.getInterfaceCount() != referenceCell.getInterfaceCount()) {
+            log::cout() << "   Interfaces of cell " << cell.getId() << " dont match " << cell.getInterfaceCount() << " " << referenceCell.getInterfaceCount() << " " << patch.getCellCount() << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing the connectivity arena of the cells.
+*/
+int subtest_001()
+{
+    log::cout() << "Testing the connectivity arena of the cells" << std::endl;
+
+    // Create the patches
+#if BITPIT_ENABLE_MPI
+    std::unique_ptr<VolUnstructured> reference(new VolUnstructured(0, 2, MPI_COMM_NULL));
+    std::unique_ptr<VolUnstructured> patch(new VolUnstructured(1, 2, MPI_COMM_NULL));
+#else
+    std::unique_ptr<VolUnstructured> reference(new VolUnstructured(0, 2));
+    std::unique_ptr<VolUnstructured> patch(new VolUnstructured(1, 2));
+#endif
+
+    fillPatch(reference.get());
+
+    patch->setCellConnectArena(true);
+    fillPatch(patch.get());
+
+    log::cout() << " Checking the connectivity of the cells..." << std::endl;
+    if (!checkConnectivity(*patch, *reference, true)) {
+        return 1;
+    }
+
+    // Check adjacencies and interfaces
+    log::cout() << " Checking the adjacencies and the interfaces of the cells..." << std::endl;
+
+    reference->initializeAdjacencies();
+    patch->initializeAdjacencies();
+
+    reference->initializeInterfaces();
+    patch->initializeInterfaces();
+
+    if (!checkNeighbourhood(*patch, *reference)) {
+        return 1;
+    }
+
+    // Delete some cells and compact the arena
+    log::cout() << " Checking the connectivity after deleting some cells..." << std::endl;
+
+    for (long cellId : std::vector<long>({{1, 5, 19}})) {
+        reference->deleteCell(cellId);
+        patch->deleteCell(cellId);
+    }
+
+    patch->squeezeCells();
+    reference->squeezeCells();
+
+    if (!checkConnectivity(*patch, *reference, true)) {
+        return 1;
+    }
+
+    // Add back the polygon
+    //
+    // Neighbourhood storage of the new cell is initialized only after its
+    // connectivity has been stored in the arena.
+    log::cout() << " Checking the neighbourhood after adding a polygon..." << std::endl;
+
+    reference->addCell(ElementType::POLYGON, std::vector<long>({{5, 2, 8, 14, 7, 6}}), 19L);
+    patch->addCell(ElementType::POLYGON, std::vector<long>({{5, 2, 8, 14, 7, 6}}), 19L);
+
+    reference->updateInterfaces();
+    patch->updateInterfaces();
+
+    if (!checkConnectivity(*patch, *reference, true)) {
+        return 1;
+    }
+
+    if (!checkNeighbourhood(*patch, *reference)) {
+        return 1;
+    }
+
+    // Restore the patch
+    log::cout() << " Checking the connectivity of a restored patch..." << std::endl;
+
+    // Dumping the patch updates it, the reference is updated as well to
+    // keep the two patches in the same state.
+    std::stringstream archive;
+    patch->dump(archive);
+    reference->update();
+
+#if BITPIT_ENABLE_MPI
+    std::unique_ptr<VolUnstructured> restored(new VolUnstructured(MPI_COMM_NULL));
+#else
+    std::unique_ptr<VolUnstructured> restored(new VolUnstructured());
+#endif
+    restored->setCellConnectArena(true);
+    restored->restore(archive);
+
+    if (!checkConnectivity(*restored, *reference, true)) {
+        return 1;
+    }
+
+    if (!checkNeighbourhood(*restored, *reference)) {
+        return 1;
+    }
+
+    // Clone the patch
+    log::cout() << " Checking the connectivity of a clone of the patch..." << std::endl;
+
+    std::unique_ptr<PatchKernel> clone = patch->clone();
+    if (!clone->isCellConnectArenaEnabled()) {
+        log::cout() << "   Connectivity arena of the clone is not enabled!" << std::endl;
+        return 1;
+    }
+
+    if (!checkConnectivity(*clone, *reference, true)) {
+        return 1;
+    }
+
+    // Disable the arena
+    log::cout() << " Checking the connectivity after disabling the arena..." << std::endl;
+
+    patch->setCellConnectArena(false);
+    if (!checkConnectivity(*patch, *reference, false)) {
+        return 1;
+    }
+
+    if (!checkNeighbourhood(*patch, *reference)) {
+        return 1;
+    }
+
+    // Update the neighbourhood of a patch that used the pool
+    //
+    // Storage of the deleted cells was allocated by the pool, it should
+    // have been moved out of the pool when the arena has been disabled.
+    log::cout() << " Checking the neighbourhood after disabling the arena..." << std::endl;
+
+    reference->deleteCell(3);
+    patch->deleteCell(3);
+
+    reference->addCell(ElementType::TRIANGLE, std::vector<long>({{8, 18, 14}}), 3L);
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{8, 18, 14}}), 3L);
+
+    reference->updateInterfaces();
+    patch->updateInterfaces();
+
+    if (!checkNeighbourhood(*patch, *reference)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_COMBINE);
+
+    // Run the subtests
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,667 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2023 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <tuple>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+typedef std::tuple<long, int, long> InterfaceKey;
+typedef std::tuple<long, int, long, int, std::vector<long>> InterfaceData;
+
+/*!
+* Add to the specified patch the vertices of a lattice.
+*
+* The coordinates of a vertex are the indices of the vertex in the lattice,
+* two-dimensional lattices lie on the plane z = 0.
+*
+* \param dimension is the dimension of the lattice
+* \param nIntervals is the number of intervals along each direction
+* \param patch is the patch that will be filled
+*/
+void addLatticeVertices(int dimension, int nIntervals, VolUnstructured *patch)
+{
+    int nVerticesZ = (dimension == 3) ? nIntervals + 1 : 1;
+    for (int k = 0; k < nVerticesZ; ++k) {
+        for (int j = 0; j <= nIntervals; ++j) {
+            for (int i = 0; i <= nIntervals; ++i) {
+                long id = (static_cast<long>(k) * (nIntervals + 1) + j) * (nIntervals + 1) + i;
+                patch->addVertex({{double(i), double(j), double(k)}}, id);
+            }
+        }
+    }
+}
+
+/*!
+* Get the vertices of a cube of the lattice.
+*
+* Vertices are ordered as the vertices of the reference hexahedron.
+*
+* \param nIntervals is the number of intervals of the lattice along each direction
+* \param origin are the indices of the lower vertex of the cube
+* \param size is the size of the cube, expressed in lattice intervals
+* \result The vertices of the cube.
+*/
+std::array<long, 8> getCubeVertices(int nIntervals, const std::array<int, 3> &origin, int size)
+{
+    auto vertexId = [nIntervals](int i, int j, int k) -> long {
+        return (static_cast<long>(k) * (nIntervals + 1) + j) * (nIntervals + 1) + i;
+    };
+
+    int i = origin[0];
+    int j = origin[1];
+    int k = origin[2];
+
+    return {{
+        vertexId(i, j, k), vertexId(i + size, j, k), vertexId(i + size, j + size, k), vertexId(i, j + size, k),
+        vertexId(i, j, k + size), vertexId(i + size, j, k + size), vertexId(i + size, j + size, k + size), vertexId(i, j + size, k + size)
+    }};
+}
+
+/*!
+* Add to the specified patch a polyhedron obtained merging unit cubes.
+*
+* The faces shared by two cubes are removed, all other faces of the cubes
+* become faces of the polyhedron.
+*
+* \param cubes are the vertices of the cubes
+* \param patch is the patch that will be filled
+* \result The id of the polyhedron.
+*/
+long addMergedPolyhedron(const std::vector<std::array<long, 8>> &cubes, VolUnstructured *patch)
+{
+    const ReferenceElementInfo &hexahedronInfo = ReferenceElementInfo::getInfo(ElementType::HEXAHEDRON);
+
+    std::vector<std::array<long, 4>> faces;
+    std::vector<std::array<long, 4>> sortedFaces;
+    for (const std::array<long, 8> &cube : cubes) {
+        for (int face = 0; face < hexahedronInfo.nFaces; ++face) {
+            std::array<long, 4> faceVertices;
+            for (int n = 0; n < 4; ++n) {
+                faceVertices[n] = cube[hexahedronInfo.faceConnectStorage[face][n]];
+            }
+
+            std::array<long, 4> sortedFaceVertices = faceVertices;
+            std::sort(sortedFaceVertices.begin(), sortedFaceVertices.end());
+
+            faces.push_back(faceVertices);
+            sortedFaces.push_back(sortedFaceVertices);
+        }
+    }
+
+    std::vector<long> connect = {0};
+    for (std::size_t n = 0; n < faces.size(); ++n) {
+        if (std::count(sortedFaces.begin(), sortedFaces.end(), sortedFaces[n]) > 1) {
+            continue;
+        }
+
+        ++connect[0];
+        connect.push_back(4);
+        connect.insert(connect.end(), faces[n].begin(), faces[n].end());
+    }
+
+    return patch->addCell(ElementType::POLYHEDRON, connect).getId();
+}
+
+/*!
+* Fill the specified 3D patch with a grid of hexahedra and polyhedra.
+*
+* The grid is split in blocks of 2x2 unit cubes along x and y, blocks are
+* filled with hexahedra, with polyhedra made of a single cube or with an
+* L-shaped polyhedron that wraps a hexahedron. The hexahedron is adjacent
+* to the L-shaped polyhedron through two faces.
+*
+* \param nCells is the number of unit cubes along each direction (should be
+* an even number)
+* \param polyhedra controls if polyhedra will be created, if polyhedra are
+* not created, all the blocks will be filled with hexahedra
+* \param patch is the patch that will be filled
+*/
+void fillPolyhedralPatch(int nCells, bool polyhedra, VolUnstructured *patch)
+{
+    addLatticeVertices(3, nCells, patch);
+
+    for (int k = 0; k < nCells; ++k) {
+        for (int J = 0; J < nCells; J += 2) {
+            for (int I = 0; I < nCells; I += 2) {
+                std::array<std::array<long, 8>, 4> cubes;
+                for (int n = 0; n < 4; ++n) {
+                    cubes[n] = getCubeVertices(nCells, {{I + n % 2, J + n / 2, k}}, 1);
+                }
+
+                int blockType = polyhedra ? (I / 2 + J / 2 + k) % 3 : 0;
+                switch (blockType) {
+
+                case 0:
+                    for (const std::array<long, 8> &cube : cubes) {
+                        patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(cube.begin(), cube.end()));
+                    }
+                    break;
+
+                case 1:
+                    for (const std::array<long, 8> &cube : cubes) {
+                        addMergedPolyhedron({cube}, patch);
+                    }
+                    break;
+
+                default:
+                    addMergedPolyhedron({cubes[0], cubes[1], cubes[2]}, patch);
+                    patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(cubes[3].begin(), cubes[3].end()));
+                    break;
+
+                }
+            }
+        }
+    }
+}
+
+/*!
+* Fill the specified 2D patch with a grid of quadrangles and polygons.
+*
+* The grid is split in blocks of 2x2 unit squares, blocks are filled with
+* quadrangles, with polygons made of a single square or with an L-shaped
+* polygon that wraps a quadrangle. The quadrangle is adjacent to the
+* L-shaped polygon through two faces.
+*
+* \param nCells is the number of unit squares along each direction (should
+* be an even number)
+* \param patch is the patch that will be filled
+*/
+void fillPolygonalPatch(int nCells, VolUnstructured *patch)
+{
+    addLatticeVertices(2, nCells, patch);
+
+    auto vertexId = [nCells](int i, int j) -> long {
+        return static_cast<long>(j) * (nCells + 1) + i;
+    };
+
+    for (int J = 0; J < nCells; J += 2) {
+        for (int I = 0; I < nCells; I += 2) {
+            int blockType = (I / 2 + 2 * (J / 2)) % 3;
+            switch (blockType) {
+
+            case 0:
+            case 1:
+                for (int n = 0; n < 4; ++n) {
+                    int i = I + n % 2;
+                    int j = J + n / 2;
+                    std::vector<long> connect = {vertexId(i, j), vertexId(i + 1, j), vertexId(i + 1, j + 1), vertexId(i, j + 1)};
+                    if (blockType == 0) {
+                        patch->addCell(ElementType::QUAD, connect);
+                    } else {
+                        connect.insert(connect.begin(), 4);
+                        patch->addCell(ElementType::POLYGON, connect);
+                    }
+                }
+                break;
+
+            default:
+                patch->addCell(ElementType::POLYGON, std::vector<long>{
+                    8, vertexId(I, J), vertexId(I + 1, J), vertexId(I + 2, J), vertexId(I + 2, J + 1),
+                    vertexId(I + 1, J + 1), vertexId(I + 1, J + 2), vertexId(I, J + 2), vertexId(I, J + 1)
+                });
+
+                patch->addCell(ElementType::QUAD, std::vector<long>{
+                    vertexId(I + 1, J + 1), vertexId(I + 2, J + 1), vertexId(I + 2, J + 2), vertexId(I + 1, J + 2)
+                });
+                break;
+
+            }
+        }
+    }
+}
+
+/*!
+* Fill the specified 3D patch with a non-conforming grid of hexahedra.
+*
+* The grid is made of coarse cubes, the cubes in the first half of the
+* domain along x are split in eight fine cubes. Adjacencies are built and
+* the coarse cells on the refinement boundary are linked to the four fine
+* cells they touch: their faces on the refinement boundary have four
+* adjacencies.
+*
+* \param nCells is the number of coarse cubes along each direction (should
+* be an even number)
+* \param patch is the patch that will be filled
+*/
+void fillNonConformingPatch(int nCells, VolUnstructured *patch)
+{
+    // Faces of the reference hexahedron on the planes x = xmin and x = xmax
+    const int FACE_XMIN = 2;
+    const int FACE_XMAX = 3;
+
+    int nIntervals = 2 * nCells;
+    addLatticeVertices(3, nIntervals, patch);
+
+    int nFineCellsX = nCells;
+    std::map<std::array<int, 2>, long> coarseBoundaryCells;
+    std::map<std::array<int, 2>, long> fineBoundaryCells;
+    for (int K = 0; K < nCells; ++K) {
+        for (int J = 0; J < nCells; ++J) {
+            for (int I = 0; I < nCells; ++I) {
+                if (I >= nCells / 2) {
+                    std::array<long, 8> cube = getCubeVertices(nIntervals, {{2 * I, 2 * J, 2 * K}}, 2);
+                    long cellId = patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(cube.begin(), cube.end())).getId();
+                    if (I == nCells / 2) {
+                        coarseBoundaryCells[{{J, K}}] = cellId;
+                    }
+
+                    continue;
+                }
+
+                for (int n = 0; n < 8; ++n) {
+                    int i = 2 * I + n % 2;
+                    int j = 2 * J + (n / 2) % 2;
+                    int k = 2 * K + n / 4;
+
+                    std::array<long, 8> cube = getCubeVertices(nIntervals, {{i, j, k}}, 1);
+                    long cellId = patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(cube.begin(), cube.end())).getId();
+                    if (i == nFineCellsX - 1) {
+                        fineBoundaryCells[{{j, k}}] = cellId;
+                    }
+                }
+            }
+        }
+    }
+
+    patch->initializeAdjacencies();
+
+    for (const auto &entry : fineBoundaryCells) {
+        int j = entry.first[0];
+        int k = entry.first[1];
+        long fineId = entry.second;
+        long coarseId = coarseBoundaryCells.at({{j / 2, k / 2}});
+
+        patch->getCell(fineId).pushAdjacency(FACE_XMAX, coarseId);
+        patch->getCell(coarseId).pushAdjacency(FACE_XMIN, fineId);
+    }
+}
+
+/*!
+* Gather the interfaces of the specified patch.
+*
+* Interfaces are identified by the cell, the face and the adjacency they
+* are associated with. The function also checks that the i-th interface of
+* each face is associated with the i-th adjacency of the face.
+*
+* \param patch is the patch
+* \param[out] interfaces on output will contain the interfaces of the patch
+* \result Returns true if the interfaces are paired with the adjacencies,
+* false otherwise.
+*/
+bool gatherInterfaces(const PatchKernel &patch, std::map<InterfaceKey, InterfaceData> *interfaces)
+{
+    interfaces->clear();
+    for (const Cell &cell : patch.getCells()) {
+        long cellId = cell.getId();
+        int nCellFaces = cell.getFaceCount();
+        for (int face = 0; face < nCellFaces; ++face) {
+            int nFaceAdjacencies = cell.getAdjacencyCount(face);
+            int nFaceInterfaces = cell.getInterfaceCount(face);
+            if (nFaceInterfaces != std::max(nFaceAdjacencies, 1)) {
+                log::cout() << "   Number of interfaces of cell " << cellId << " doesn't match the expected value!" << std::endl;
+                return false;
+            }
+
+            for (int k = 0; k < nFaceInterfaces; ++k) {
+                const Interface &interface = patch.getInterface(cell.getInterface(face, k));
+                long ownerId = interface.getOwner();
+                long neighId = interface.getNeigh();
+
+                long adjacencyId = Cell::NULL_ID;
+                if (nFaceAdjacencies > 0) {
+                    adjacencyId = cell.getAdjacency(face, k);
+                }
+
+                long otherId = (ownerId == cellId) ? neighId : ownerId;
+                if (otherId != adjacencyId) {
+                    log::cout() << "   Interfaces of cell " << cellId << " are not paired with its adjacencies!" << std::endl;
+                    return false;
+                }
+
+                ConstProxyVector<long> interfaceConnect = interface.getVertexIds();
+                std::vector<long> connect(interfaceConnect.begin(), interfaceConnect.end());
+
+                (*interfaces)[InterfaceKey(cellId, face, adjacencyId)] = InterfaceData(ownerId, interface.getOwnerFace(), neighId, interface.getNeighFace(), connect);
+            }
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Build from scratch the interfaces of the specified patch and gather them.
+*
+* \param patch is the patch
+* \param threaded controls if the interfaces will be built using multiple
+* threads
+* \param[out] interfaces on output will contain the interfaces of the patch
+* \result Returns true if the interfaces are valid, false otherwise.
+*/
+bool buildInterfaces(VolUnstructured *patch, bool threaded, std::map<InterfaceKey, InterfaceData> *interfaces)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    int nMaxThreads = omp_get_max_threads();
+    omp_set_num_threads(threaded ? std::max(nMaxThreads, 4) : 1);
+#else
+    BITPIT_UNUSED(threaded);
+#endif
+
+    patch->destroyInterfaces();
+    patch->initializeInterfaces();
+
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nMaxThreads);
+#endif
+
+    if (!gatherInterfaces(*patch, interfaces)) {
+        return false;
+    }
+
+    if (static_cast<long>(interfaces->size()) > 2 * patch->getInterfaceCount()) {
+        log::cout() << "   Number of interfaces doesn't match the expected value!" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+* Check that the interfaces built using multiple threads match the ones
+* built using a single thread.
+*
+* \param patch is the patch
+* \param[out] serialInterfaces if a valid pointer is provided, on output will
+* contain the interfaces built using a single thread
+* \result Returns true if the interfaces match, false otherwise.
+*/
+bool checkThreadedInterfaces(VolUnstructured *patch, std::map<InterfaceKey, InterfaceData> *serialInterfaces = nullptr)
+{
+    log::cout() << " Building the interfaces using a single thread..." << std::endl;
+
+    std::map<InterfaceKey, InterfaceData> localSerialInterfaces;
+    if (!serialInterfaces) {
+        serialInterfaces = &localSerialInterfaces;
+    }
+
+    if (!buildInterfaces(patch, false, serialInterfaces)) {
+        return false;
+    }
+
+    long nSerialInterfaces = patch->getInterfaceCount();
+
+    log::cout() << " Building the interfaces using multiple threads..." << std::endl;
+
+    std::map<InterfaceKey, InterfaceData> threadedInterfaces;
+    if (!buildInterfaces(patch, true, &threadedInterfaces)) {
+        return false;
+    }
+
+    long nThreadedInterfaces = patch->getInterfaceCount();
+
+    log::cout() << " Comparing the interfaces..." << std::endl;
+
+    if (nThreadedInterfaces != nSerialInterfaces) {
+        log::cout() << "   Number of interfaces doesn't match the expected value!" << std::endl;
+        return false;
+    }
+
+    if (threadedInterfaces != *serialInterfaces) {
+        log::cout() << "   Interfaces don't match the expected ones!" << std::endl;
+        return false;
+    }
+
+    log::cout() << " Number of interfaces: " << nThreadedInterfaces << std::endl;
+
+    return true;
+}
+
+/*!
+* Create a patch.
+*
+* \param dimension is the dimension of the patch
+* \result The newly created patch.
+*/
+std::unique_ptr<VolUnstructured> createPatch(int dimension)
+{
+#if BITPIT_ENABLE_MPI
+    return std::unique_ptr<VolUnstructured>(new VolUnstructured(dimension, MPI_COMM_NULL));
+#else
+    return std::unique_ptr<VolUnstructured>(new VolUnstructured(dimension));
+#endif
+}
+
+/*!
+* Subtest 001
+*
+* Testing the threaded build of the interfaces on a conforming grid of
+* hexahedra.
+*/
+int subtest_001()
+{
+    log::cout() << "Testing the threaded build of the interfaces on hexahedra" << std::endl;
+
+    std::unique_ptr<VolUnstructured> patch = createPatch(3);
+    fillPolyhedralPatch(24, false, patch.get());
+    patch->initializeAdjacencies();
+
+    if (!checkThreadedInterfaces(patch.get())) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing the threaded build of the interfaces on a non-conforming grid.
+*
+* Faces with more than one adjacency are owned by their neighbours.
+*/
+int subtest_002()
+{
+    log::cout() << "Testing the threaded build of the interfaces on non-conforming faces" << std::endl;
+
+    std::unique_ptr<VolUnstructured> patch = createPatch(3);
+    fillNonConformingPatch(16, patch.get());
+
+    std::map<InterfaceKey, InterfaceData> serialInterfaces;
+    if (!checkThreadedInterfaces(patch.get(), &serialInterfaces)) {
+        return 2;
+    }
+
+    long nNonConformingInterfaces = 0;
+    for (const Cell &cell : patch->getCells()) {
+        long cellId = cell.getId();
+        int nCellFaces = cell.getFaceCount();
+        for (int face = 0; face < nCellFaces; ++face) {
+            int nFaceAdjacencies = cell.getAdjacencyCount(face);
+            if (nFaceAdjacencies <= 1) {
+                continue;
+            }
+
+            for (int k = 0; k < nFaceAdjacencies; ++k) {
+                const InterfaceData &data = serialInterfaces.at(InterfaceKey(cellId, face, cell.getAdjacency(face, k)));
+                if (std::get<0>(data) == cellId) {
+                    log::cout() << "   Non-conforming face of cell " << cellId << " owns its interfaces!" << std::endl;
+                    return 2;
+                }
+
+                ++nNonConformingInterfaces;
+            }
+        }
+    }
+
+    if (nNonConformingInterfaces == 0) {
+        log::cout() << "   No non-conforming interfaces found!" << std::endl;
+        return 2;
+    }
+
+    log::cout() << " Number of non-conforming interfaces: " << nNonConformingInterfaces << std::endl;
+
+    return 0;
+}
+
+/*!
+* Subtest 003
+*
+* Testing the threaded build of the interfaces on polyhedra and polygons.
+*/
+int subtest_003()
+{
+    log::cout() << "Testing the threaded build of the interfaces on polyhedra" << std::endl;
+
+    std::unique_ptr<VolUnstructured> patch3D = createPatch(3);
+    fillPolyhedralPatch(24, true, patch3D.get());
+    patch3D->initializeAdjacencies();
+
+    if (!checkThreadedInterfaces(patch3D.get())) {
+        return 3;
+    }
+
+    log::cout() << "Testing the threaded build of the interfaces on polygons" << std::endl;
+
+    std::unique_ptr<VolUnstructured> patch2D = createPatch(2);
+    fillPolygonalPatch(120, patch2D.get());
+    patch2D->initializeAdjacencies();
+
+    if (!checkThreadedInterfaces(patch2D.get())) {
+        return 3;
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 004
+*
+* Testing partial rebuilds of the interfaces after deleting cells.
+*/
+int subtest_004()
+{
+    log::cout() << "Testing partial rebuilds of the interfaces" << std::endl;
+
+    std::unique_ptr<VolUnstructured> patch = createPatch(3);
+    fillPolyhedralPatch(24, true, patch.get());
+    patch->initializeAdjacencies();
+
+    std::map<InterfaceKey, InterfaceData> interfaces;
+    if (!buildInterfaces(patch.get(), true, &interfaces)) {
+        return 4;
+    }
+
+    // Delete some cells and update the interfaces
+    log::cout() << " Deleting cells..." << std::endl;
+
+    std::vector<long> deletedIds;
+    for (const Cell &cell : patch->getCells()) {
+        if (cell.getId() % 7 == 3) {
+            deletedIds.push_back(cell.getId());
+        }
+    }
+
+    for (long cellId : deletedIds) {
+        patch->deleteCell(cellId);
+    }
+
+#if BITPIT_ENABLE_OPENMP==1
+    int nMaxThreads = omp_get_max_threads();
+    omp_set_num_threads(std::max(nMaxThreads, 4));
+#endif
+
+    patch->update();
+
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nMaxThreads);
+#endif
+
+    std::map<InterfaceKey, InterfaceData> updatedInterfaces;
+    if (!gatherInterfaces(*patch, &updatedInterfaces)) {
+        return 4;
+    }
+
+    // Rebuild the interfaces from scratch
+    //
+    // The patch has holes in the storage of the cells.
+    std::map<InterfaceKey, InterfaceData> serialInterfaces;
+    if (!checkThreadedInterfaces(patch.get(), &serialInterfaces)) {
+        return 4;
+    }
+
+    if (updatedInterfaces != serialInterfaces) {
+        log::cout() << "   Updated interfaces don't match the expected ones!" << std::endl;
+        return 4;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_COMBINE);
+
+    // Run the subtests
+    int status = 0;
+    try {
+        for (int (*subtest)() : {subtest_001, subtest_002, subtest_003, subtest_004}) {
+            status = subtest();
+            if (status != 0) {
+                break;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        status = 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
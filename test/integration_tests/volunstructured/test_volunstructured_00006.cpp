@@ -0,0 +1,303 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2023 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+/*!
+* Fill the specified 3D patch with a grid of cubes split in elements of
+* different types.
+*
+* Each cube is filled with a hexahedron, a polyhedron, two wedges or six
+* pyramids whose apex is the center of the cube. Cubes split in pyramids
+* or wedges expose faces that don't match the faces of the neighbouring
+* cubes, those faces are border faces.
+*
+* \param nCells is the number of cubes along each direction
+* \param patch is the patch that will be filled
+*/
+void fillPatch(int nCells, VolUnstructured *patch)
+{
+    auto latticeVertexId = [nCells](int i, int j, int k) -> long {
+        return (k * (nCells + 1) + j) * (nCells + 1) + i;
+    };
+
+    for (int k = 0; k <= nCells; ++k) {
+        for (int j = 0; j <= nCells; ++j) {
+            for (int i = 0; i <= nCells; ++i) {
+                patch->addVertex({{double(i), double(j), double(k)}}, latticeVertexId(i, j, k));
+            }
+        }
+    }
+
+    const ReferenceElementInfo &hexahedronInfo = ReferenceElementInfo::getInfo(ElementType::HEXAHEDRON);
+
+    for (int k = 0; k < nCells; ++k) {
+        for (int j = 0; j < nCells; ++j) {
+            for (int i = 0; i < nCells; ++i) {
+                std::array<long, 8> v = {{
+                    latticeVertexId(i, j, k), latticeVertexId(i + 1, j, k), latticeVertexId(i + 1, j + 1, k), latticeVertexId(i, j + 1, k),
+                    latticeVertexId(i, j, k + 1), latticeVertexId(i + 1, j, k + 1), latticeVertexId(i + 1, j + 1, k + 1), latticeVertexId(i, j + 1, k + 1)
+                }};
+
+                switch ((i + j + k) % 4) {
+
+                case 0:
+                    patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(v.begin(), v.end()));
+                    break;
+
+                case 1:
+                {
+                    std::vector<long> connect = {hexahedronInfo.nFaces};
+                    for (int face = 0; face < hexahedronInfo.nFaces; ++face) {
+                        connect.push_back(4);
+                        for (int n = 0; n < 4; ++n) {
+                            connect.push_back(v[hexahedronInfo.faceConnectStorage[face][n]]);
+                        }
+                    }
+                    patch->addCell(ElementType::POLYHEDRON, connect);
+                    break;
+                }
+
+                case 2:
+                    patch->addCell(ElementType::WEDGE, std::vector<long>{v[0], v[2], v[1], v[4], v[6], v[5]});
+                    patch->addCell(ElementType::WEDGE, std::vector<long>{v[0], v[3], v[2], v[4], v[7], v[6]});
+                    break;
+
+                default:
+                {
+                    // The base of the pyramids is the reversed outward face of
+                    // the cube, hence its normal points towards the apex.
+                    long apexId = patch->addVertex({{i + 0.5, j + 0.5, k + 0.5}})->getId();
+                    for (int face = 0; face < hexahedronInfo.nFaces; ++face) {
+                        std::vector<long> connect;
+                        for (int n = 3; n >= 0; --n) {
+                            connect.push_back(v[hexahedronInfo.faceConnectStorage[face][n]]);
+                        }
+                        connect.push_back(apexId);
+                        patch->addCell(ElementType::PYRAMID, connect);
+                    }
+                    break;
+                }
+
+                }
+            }
+        }
+    }
+}
+
+/*!
+* Check that the cached geometric quantities match the evaluated ones.
+*
+* \param patch is the patch
+* \result Returns true if the cached quantities match the evaluated ones,
+* false otherwise.
+*/
+bool checkGeometricCache(const VolUnstructured &patch)
+{
+    const double TOLERANCE = 1e-12;
+
+    for (const Cell &cell : patch.getCells()) {
+        long cellId = cell.getId();
+        if (std::abs(patch.getCellVolume(cellId) - patch.evalCellVolume(cellId)) > TOLERANCE) {
+            log::cout() << "   Cached volume of cell " << cellId << " doesn't match the evaluated one!" << std::endl;
+            return false;
+        }
+
+        if (norm2(patch.getCellCentroid(cellId) - patch.evalCellCentroid(cellId)) > TOLERANCE) {
+            log::cout() << "   Cached centroid of cell " << cellId << " doesn't match the evaluated one!" << std::endl;
+            return false;
+        }
+    }
+
+    for (const Interface &interface : patch.getInterfaces()) {
+        long interfaceId = interface.getId();
+        if (std::abs(patch.getInterfaceArea(interfaceId) - patch.evalInterfaceArea(interfaceId)) > TOLERANCE) {
+            log::cout() << "   Cached area of interface " << interfaceId << " doesn't match the evaluated one!" << std::endl;
+            return false;
+        }
+
+        if (norm2(patch.getInterfaceNormal(interfaceId) - patch.evalInterfaceNormal(interfaceId)) > TOLERANCE) {
+            log::cout() << "   Cached normal of interface " << interfaceId << " doesn't match the evaluated one!" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+* Subtest 001
+*
+* Testing the geometric cache.
+*/
+int subtest_001()
+{
+    log::cout() << "Testing the geometric cache" << std::endl;
+
+    // Create the patch
+#if BITPIT_ENABLE_MPI
+    std::unique_ptr<VolUnstructured> patch(new VolUnstructured(0, 3, MPI_COMM_NULL));
+#else
+    std::unique_ptr<VolUnstructured> patch(new VolUnstructured(0, 3));
+#endif
+
+    fillPatch(12, patch.get());
+    patch->initializeAdjacencies();
+    patch->initializeInterfaces();
+
+    // Enable the cache
+    log::cout() << " Enabling the cache..." << std::endl;
+
+    patch->setGeometricCacheEnabled(true);
+    if (!patch->isGeometricCacheEnabled() || !checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    double totalVolume = 0.;
+    for (const Cell &cell : patch->getCells()) {
+        totalVolume += patch->getCellVolume(cell.getId());
+    }
+
+    if (std::abs(totalVolume - 12. * 12. * 12.) > 1e-9) {
+        log::cout() << "   Cached volume of the patch doesn't match the expected value!" << std::endl;
+        return 1;
+    }
+
+    // Alter the patch
+    //
+    // Some cells are deleted and a stretched cell is added.
+    log::cout() << " Altering the patch..." << std::endl;
+
+    patch->deleteCell(0);
+    patch->deleteCell(17);
+
+    std::vector<long> stretchedConnect;
+    stretchedConnect.push_back(patch->addVertex({{-2.0, -1.0, 0.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{ 0.0, -1.0, 0.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{ 0.0,  0.0, 0.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{-2.0,  0.0, 0.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{-2.0, -1.0, 3.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{ 0.0, -1.0, 3.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{ 0.0,  0.0, 3.0}})->getId());
+    stretchedConnect.push_back(patch->addVertex({{-2.0,  0.0, 3.0}})->getId());
+    long stretchedId = patch->addCell(ElementType::HEXAHEDRON, stretchedConnect).getId();
+
+    patch->update();
+    if (!checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    if (std::abs(patch->getCellVolume(stretchedId) - 6.) > 1e-12) {
+        log::cout() << "   Cached volume of the added cell doesn't match the expected value!" << std::endl;
+        return 1;
+    }
+
+    // Transform the patch
+    log::cout() << " Transforming the patch..." << std::endl;
+
+    patch->translate({{1.0, 2.0, 3.0}});
+    patch->scale({{2.0, 1.0, 0.5}}, {{0.0, 0.0, 0.0}});
+    patch->rotate({{0.0, 0.0, 0.0}}, {{0.0, 0.0, 1.0}}, 0.5);
+    if (!checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    // Move some vertices
+    log::cout() << " Moving some vertices..." << std::endl;
+
+    for (long vertexId : patch->getCell(stretchedId).getVertexIds()) {
+        patch->setVertexCoords(vertexId, 1.5 * patch->getVertexCoords(vertexId));
+    }
+    patch->setVertexCoords(0, patch->getVertexCoords(0) + std::array<double, 3>{{0.1, -0.2, 0.3}});
+
+    patch->update();
+    if (!checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    // Clone the patch
+    log::cout() << " Cloning the patch..." << std::endl;
+
+    std::unique_ptr<PatchKernel> clonedPatchKernel = patch->clone();
+    VolUnstructured *clonedPatch = static_cast<VolUnstructured *>(clonedPatchKernel.get());
+    if (!clonedPatch->isGeometricCacheEnabled() || !checkGeometricCache(*clonedPatch)) {
+        return 1;
+    }
+
+    clonedPatch->deleteCell(42);
+    clonedPatch->update();
+    if (!checkGeometricCache(*clonedPatch) || !checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    // Disable the cache
+    log::cout() << " Disabling the cache..." << std::endl;
+
+    patch->setGeometricCacheEnabled(false);
+    if (patch->isGeometricCacheEnabled() || !checkGeometricCache(*patch)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_COMBINE);
+
+    // Run the subtests
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
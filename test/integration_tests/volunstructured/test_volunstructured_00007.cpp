@@ -0,0 +1,558 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2023 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+typedef std::map<std::array<int, 3>, std::vector<long>> CubeCellMap;
+
+/*!
+* Add to the specified patch a polyhedron obtained merging unit cubes.
+*
+* The faces shared by two cubes are removed, all other faces of the cubes
+* become faces of the polyhedron.
+*
+* \param nCells is the number of unit cubes along each direction
+* \param origins are the indices of the lower vertex of the cubes
+* \param patch is the patch that will be filled
+* \result The id of the polyhedron.
+*/
+long addCubesPolyhedron(int nCells, const std::vector<std::array<int, 3>> &origins, VolUnstructured *patch)
+{
+    const ReferenceElementInfo &hexahedronInfo = ReferenceElementInfo::getInfo(ElementType::HEXAHEDRON);
+
+    auto vertexId = [nCells](int i, int j, int k) -> long {
+        return (static_cast<long>(k) * (nCells + 1) + j) * (nCells + 1) + i;
+    };
+
+    std::vector<std::array<long, 4>> faces;
+    std::vector<std::array<long, 4>> sortedFaces;
+    for (const std::array<int, 3> &origin : origins) {
+        int i = origin[0];
+        int j = origin[1];
+        int k = origin[2];
+
+        std::array<long, 8> cube = {{
+            vertexId(i, j, k), vertexId(i + 1, j, k), vertexId(i + 1, j + 1, k), vertexId(i, j + 1, k),
+            vertexId(i, j, k + 1), vertexId(i + 1, j, k + 1), vertexId(i + 1, j + 1, k + 1), vertexId(i, j + 1, k + 1)
+        }};
+
+        for (int face = 0; face < hexahedronInfo.nFaces; ++face) {
+            std::array<long, 4> faceVertices;
+            for (int n = 0; n < 4; ++n) {
+                faceVertices[n] = cube[hexahedronInfo.faceConnectStorage[face][n]];
+            }
+
+            std::array<long, 4> sortedFaceVertices = faceVertices;
+            std::sort(sortedFaceVertices.begin(), sortedFaceVertices.end());
+
+            faces.push_back(faceVertices);
+            sortedFaces.push_back(sortedFaceVertices);
+        }
+    }
+
+    std::vector<long> connect = {0};
+    for (std::size_t n = 0; n < faces.size(); ++n) {
+        if (std::count(sortedFaces.begin(), sortedFaces.end(), sortedFaces[n]) > 1) {
+            continue;
+        }
+
+        ++connect[0];
+        connect.push_back(4);
+        connect.insert(connect.end(), faces[n].begin(), faces[n].end());
+    }
+
+    return patch->addCell(ElementType::POLYHEDRON, connect).getId();
+}
+
+/*!
+* Fill the specified patch with a grid of non-convex polyhedra and standard
+* elements.
+*
+* The unit cubes of the grid are grouped in blocks of 2x2x2 cubes, blocks
+* are filled with:
+*  - a polyhedron made of seven cubes, whose notch is filled by a hexahedron;
+*  - an L-shaped polyhedron made of six cubes, whose notch is filled by a
+*    polyhedron made of two cubes;
+*  - hexahedra and pairs of wedges.
+*
+* \param nCells is the number of unit cubes along each direction (should be
+* an even number)
+* \param patch is the patch that will be filled
+* \param[out] cubeCells on output will contain, for each unit cube, the cells
+* that cover the cube
+* \param[out] notches on output will contain, for each non-convex polyhedron,
+* the center of a cube that lies in its notch
+*/
+void fillPatch(int nCells, VolUnstructured *patch, CubeCellMap *cubeCells,
+               std::vector<std::pair<long, std::array<double, 3>>> *notches)
+{
+    auto vertexId = [nCells](int i, int j, int k) -> long {
+        return (static_cast<long>(k) * (nCells + 1) + j) * (nCells + 1) + i;
+    };
+
+    for (int k = 0; k <= nCells; ++k) {
+        for (int j = 0; j <= nCells; ++j) {
+            for (int i = 0; i <= nCells; ++i) {
+                patch->addVertex({{double(i), double(j), double(k)}}, vertexId(i, j, k));
+            }
+        }
+    }
+
+    for (int K = 0; K < nCells; K += 2) {
+        for (int J = 0; J < nCells; J += 2) {
+            for (int I = 0; I < nCells; I += 2) {
+                std::vector<std::array<int, 3>> blockCubes;
+                for (int n = 0; n < 8; ++n) {
+                    blockCubes.push_back({{I + n % 2, J + (n / 2) % 2, K + n / 4}});
+                }
+
+                int blockType = (I / 2 + J / 2 + K / 2) % 3;
+                switch (blockType) {
+
+                case 0:
+                {
+                    // Polyhedron made of seven cubes with a hexahedron in the notch
+                    std::vector<std::array<int, 3>> polyhedronCubes(blockCubes.begin(), blockCubes.end() - 1);
+                    long polyhedronId = addCubesPolyhedron(nCells, polyhedronCubes, patch);
+                    for (const std::array<int, 3> &cube : polyhedronCubes) {
+                        (*cubeCells)[cube].push_back(polyhedronId);
+                    }
+
+                    const std::array<int, 3> &notch = blockCubes.back();
+                    int i = notch[0];
+                    int j = notch[1];
+                    int k = notch[2];
+                    long hexahedronId = patch->addCell(ElementType::HEXAHEDRON, std::vector<long>{
+                        vertexId(i, j, k), vertexId(i + 1, j, k), vertexId(i + 1, j + 1, k), vertexId(i, j + 1, k),
+                        vertexId(i, j, k + 1), vertexId(i + 1, j, k + 1), vertexId(i + 1, j + 1, k + 1), vertexId(i, j + 1, k + 1)
+                    }).getId();
+                    (*cubeCells)[notch].push_back(hexahedronId);
+
+                    notches->push_back({polyhedronId, {{i + 0.5, j + 0.5, k + 0.5}}});
+                    break;
+                }
+
+                case 1:
+                {
+                    // L-shaped polyhedron with a polyhedron made of two cubes in the notch
+                    std::vector<std::array<int, 3>> polyhedronCubes;
+                    std::vector<std::array<int, 3>> notchCubes;
+                    for (const std::array<int, 3> &cube : blockCubes) {
+                        if (cube[2] == K + 1 && cube[1] == J + 1) {
+                            notchCubes.push_back(cube);
+                        } else {
+                            polyhedronCubes.push_back(cube);
+                        }
+                    }
+
+                    long polyhedronId = addCubesPolyhedron(nCells, polyhedronCubes, patch);
+                    for (const std::array<int, 3> &cube : polyhedronCubes) {
+                        (*cubeCells)[cube].push_back(polyhedronId);
+                    }
+
+                    long notchId = addCubesPolyhedron(nCells, notchCubes, patch);
+                    for (const std::array<int, 3> &cube : notchCubes) {
+                        (*cubeCells)[cube].push_back(notchId);
+
+                        notches->push_back({polyhedronId, {{cube[0] + 0.5, cube[1] + 0.5, cube[2] + 0.5}}});
+                    }
+                    break;
+                }
+
+                default:
+                {
+                    // Hexahedra and pairs of wedges
+                    for (const std::array<int, 3> &cube : blockCubes) {
+                        int i = cube[0];
+                        int j = cube[1];
+                        int k = cube[2];
+                        std::array<long, 8> v = {{
+                            vertexId(i, j, k), vertexId(i + 1, j, k), vertexId(i + 1, j + 1, k), vertexId(i, j + 1, k),
+                            vertexId(i, j, k + 1), vertexId(i + 1, j, k + 1), vertexId(i + 1, j + 1, k + 1), vertexId(i, j + 1, k + 1)
+                        }};
+
+                        if ((i + j + k) % 2 == 0) {
+                            (*cubeCells)[cube].push_back(patch->addCell(ElementType::HEXAHEDRON, std::vector<long>(v.begin(), v.end())).getId());
+                        } else {
+                            (*cubeCells)[cube].push_back(patch->addCell(ElementType::WEDGE, std::vector<long>{v[0], v[2], v[1], v[4], v[6], v[5]}).getId());
+                            (*cubeCells)[cube].push_back(patch->addCell(ElementType::WEDGE, std::vector<long>{v[0], v[3], v[2], v[4], v[7], v[6]}).getId());
+                        }
+                    }
+                    break;
+                }
+
+                }
+            }
+        }
+    }
+}
+
+/*!
+* Create a 3D patch.
+*
+* \result The newly created patch.
+*/
+std::unique_ptr<VolUnstructured> createPatch()
+{
+#if BITPIT_ENABLE_MPI==1
+    return std::unique_ptr<VolUnstructured>(new VolUnstructured(3, MPI_COMM_NULL));
+#else
+    return std::unique_ptr<VolUnstructured>(new VolUnstructured(3));
+#endif
+}
+
+/*!
+* Get the unit cube that contains the specified point.
+*
+* \param nCells is the number of unit cubes along each direction
+* \param offset is the offset of the grid
+* \param point is the point
+* \param[out] cube on output will contain the indices of the cube
+* \result Returns true if the point is inside the grid, false otherwise.
+*/
+bool findCube(int nCells, const std::array<double, 3> &offset, const std::array<double, 3> &point, std::array<int, 3> *cube)
+{
+    for (int d = 0; d < 3; ++d) {
+        double coordinate = point[d] - offset[d];
+        if (coordinate < 0. || coordinate >= nCells) {
+            return false;
+        }
+
+        (*cube)[d] = static_cast<int>(std::floor(coordinate));
+    }
+
+    return true;
+}
+
+/*!
+* Check the location of the specified points.
+*
+* \param patch is the patch
+* \param nCells is the number of unit cubes along each direction
+* \param offset is the offset of the grid
+* \param cubeCells are the cells that cover each unit cube
+* \param points are the points
+* \result Returns zero if the points are correctly located, a non-zero value
+* otherwise.
+*/
+int checkLocation(const VolUnstructured &patch, int nCells, const std::array<double, 3> &offset,
+                  const CubeCellMap &cubeCells, const std::vector<std::array<double, 3>> &points)
+{
+    int nPoints = points.size();
+    std::vector<long> batchIds(nPoints);
+    patch.locatePoint(nPoints, points.data(), batchIds.data());
+
+    for (int n = 0; n < nPoints; ++n) {
+        const std::array<double, 3> &point = points[n];
+
+        long cellId = patch.locatePoint(point);
+        if (batchIds[n] != cellId) {
+            log::cout() << "   Single and batched lookups don't match for point " << point << std::endl;
+            return 1;
+        }
+
+        std::array<int, 3> cube;
+        if (!findCube(nCells, offset, point, &cube)) {
+            if (cellId != Cell::NULL_ID || patch.isPointInside(point)) {
+                log::cout() << "   Point " << point << " should be outside the patch" << std::endl;
+                return 1;
+            }
+
+            continue;
+        }
+
+        const std::vector<long> &expectedIds = cubeCells.at(cube);
+        if (std::find(expectedIds.begin(), expectedIds.end(), cellId) == expectedIds.end()) {
+            log::cout() << "   Point " << point << " has been located in cell " << cellId << std::endl;
+            return 1;
+        }
+
+        if (!patch.isPointInside(cellId, point)) {
+            log::cout() << "   Point " << point << " should be inside cell " << cellId << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 001
+*
+* Testing point location on non-convex polyhedra and standard elements.
+*/
+int subtest_001()
+{
+    log::cout() << "Testing point location on non-convex polyhedra and standard elements" << std::endl;
+
+    const int N_CELLS = 8;
+    const std::array<double, 3> OFFSET = {{0., 0., 0.}};
+
+    std::unique_ptr<VolUnstructured> patch = createPatch();
+
+    CubeCellMap cubeCells;
+    std::vector<std::pair<long, std::array<double, 3>>> notches;
+    fillPatch(N_CELLS, patch.get(), &cubeCells, &notches);
+
+    log::cout() << " Cells: " << patch->getCellCount() << ", notch points: " << notches.size() << std::endl;
+
+    // Points in the notches are not inside the polyhedra
+    log::cout() << " Checking points in the notches of the polyhedra..." << std::endl;
+    for (const auto &notch : notches) {
+        if (patch->isPointInside(notch.first, notch.second)) {
+            log::cout() << "   Point " << notch.second << " should be outside polyhedron " << notch.first << std::endl;
+            return 1;
+        }
+    }
+
+    // Locate the centers of the cubes
+    log::cout() << " Locating cube centers..." << std::endl;
+
+    std::vector<std::array<double, 3>> centers;
+    for (const auto &entry : cubeCells) {
+        const std::array<int, 3> &cube = entry.first;
+        centers.push_back({{cube[0] + 0.5, cube[1] + 0.5, cube[2] + 0.5}});
+    }
+
+    if (checkLocation(*patch, N_CELLS, OFFSET, cubeCells, centers) != 0) {
+        return 1;
+    }
+
+    // Locate random points
+    log::cout() << " Locating random points..." << std::endl;
+
+    std::srand(1);
+
+    const int N_POINTS = 2000;
+    std::vector<std::array<double, 3>> points(N_POINTS);
+    for (std::array<double, 3> &point : points) {
+        for (int d = 0; d < 3; ++d) {
+            point[d] = (1.25 * N_CELLS) * (double(std::rand()) / RAND_MAX) - 0.125 * N_CELLS;
+        }
+    }
+
+    if (checkLocation(*patch, N_CELLS, OFFSET, cubeCells, points) != 0) {
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    // Locate global points
+    //
+    // The patch is not partitioned, hence all the points are located on
+    // the current process.
+    log::cout() << " Locating global points..." << std::endl;
+
+    std::vector<long> globalIds(N_POINTS);
+    std::vector<int> globalRanks(N_POINTS);
+    patch->locateGlobalPoint(N_POINTS, points.data(), globalIds.data(), globalRanks.data());
+    for (int n = 0; n < N_POINTS; ++n) {
+        long expectedId = patch->locatePoint(points[n]);
+        int expectedRank = (expectedId != Cell::NULL_ID) ? patch->getRank() : -1;
+        if (globalIds[n] != expectedId || globalRanks[n] != expectedRank) {
+            log::cout() << "   Global lookup doesn't match for point " << points[n] << std::endl;
+            return 1;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing point location after patch alterations.
+*/
+int subtest_002()
+{
+    log::cout() << "Testing point location after patch alterations" << std::endl;
+
+    const int N_CELLS = 4;
+
+    std::unique_ptr<VolUnstructured> patch = createPatch();
+
+    CubeCellMap cubeCells;
+    std::vector<std::pair<long, std::array<double, 3>>> notches;
+    fillPatch(N_CELLS, patch.get(), &cubeCells, &notches);
+
+    std::vector<std::array<double, 3>> centers;
+    for (const auto &entry : cubeCells) {
+        const std::array<int, 3> &cube = entry.first;
+        centers.push_back({{cube[0] + 0.5, cube[1] + 0.5, cube[2] + 0.5}});
+    }
+
+    std::array<double, 3> offset = {{0., 0., 0.}};
+    if (checkLocation(*patch, N_CELLS, offset, cubeCells, centers) != 0) {
+        return 1;
+    }
+
+    // Translate the patch
+    log::cout() << " Locating points after translating the patch..." << std::endl;
+
+    std::array<double, 3> translation = {{0.5, 0.25, -0.75}};
+    patch->translate(translation);
+    offset += translation;
+    for (std::array<double, 3> &center : centers) {
+        center += translation;
+    }
+
+    std::vector<std::array<double, 3>> points = centers;
+    points.push_back({{0.1, 0.1, 0.1}});
+    points.push_back({{N_CELLS + 0.4, 0.1, 0.1}});
+    if (checkLocation(*patch, N_CELLS, offset, cubeCells, points) != 0) {
+        return 1;
+    }
+
+    // Delete the cells that fill the notches
+    log::cout() << " Locating points after deleting cells..." << std::endl;
+
+    std::vector<std::array<double, 3>> notchPoints;
+    for (auto &entry : cubeCells) {
+        std::vector<long> &cells = entry.second;
+        if (cells.size() != 1 || patch->getCell(cells[0]).getType() != ElementType::HEXAHEDRON) {
+            continue;
+        }
+
+        const std::array<int, 3> &cube = entry.first;
+        std::array<double, 3> center = {{cube[0] + 0.5, cube[1] + 0.5, cube[2] + 0.5}};
+        center += offset;
+        notchPoints.push_back(center);
+
+        patch->deleteCell(cells[0]);
+        cells.clear();
+    }
+
+    for (const std::array<double, 3> &point : notchPoints) {
+        if (patch->locatePoint(point) != Cell::NULL_ID) {
+            log::cout() << "   Point " << point << " should not be located after deleting its cell" << std::endl;
+            return 1;
+        }
+    }
+
+    // Fill one of the holes with a new cell
+    log::cout() << " Locating points after adding cells..." << std::endl;
+
+    std::array<double, 3> holePoint = notchPoints.front();
+    std::array<int, 3> holeCube;
+    findCube(N_CELLS, offset, holePoint, &holeCube);
+
+    auto vertexId = [N_CELLS](int i, int j, int k) -> long {
+        return (static_cast<long>(k) * (N_CELLS + 1) + j) * (N_CELLS + 1) + i;
+    };
+
+    int i = holeCube[0];
+    int j = holeCube[1];
+    int k = holeCube[2];
+    long holeId = patch->addCell(ElementType::HEXAHEDRON, std::vector<long>{
+        vertexId(i, j, k), vertexId(i + 1, j, k), vertexId(i + 1, j + 1, k), vertexId(i, j + 1, k),
+        vertexId(i, j, k + 1), vertexId(i + 1, j, k + 1), vertexId(i + 1, j + 1, k + 1), vertexId(i, j + 1, k + 1)
+    }).getId();
+
+    if (patch->locatePoint(holePoint) != holeId) {
+        log::cout() << "   Point " << holePoint << " should be located in the new cell" << std::endl;
+        return 1;
+    }
+
+    // Move the vertices
+    log::cout() << " Locating points after moving the vertices..." << std::endl;
+
+    std::array<double, 3> shift = {{0., 0., 2. * N_CELLS}};
+    for (const Vertex &vertex : patch->getVertices()) {
+        long id = vertex.getId();
+        patch->setVertexCoords(id, patch->getVertexCoords(id) + shift);
+    }
+
+    if (patch->locatePoint(holePoint) != Cell::NULL_ID) {
+        log::cout() << "   Point " << holePoint << " should not be located after moving the vertices" << std::endl;
+        return 1;
+    } else if (patch->locatePoint(holePoint + shift) != holeId) {
+        log::cout() << "   Point " << (holePoint + shift) << " should be located in the moved cell" << std::endl;
+        return 1;
+    }
+
+    // Change the tolerance
+    log::cout() << " Locating points after changing the tolerance..." << std::endl;
+
+    patch->setTol(1e-8);
+    if (patch->locatePoint(holePoint + shift) != holeId) {
+        log::cout() << "   Point " << (holePoint + shift) << " should be located after changing the tolerance" << std::endl;
+        return 1;
+    }
+
+    patch->resetTol();
+    if (patch->locatePoint(holePoint + shift) != holeId) {
+        log::cout() << "   Point " << (holePoint + shift) << " should be located after resetting the tolerance" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_COMBINE);
+
+    // Run the subtests
+    int status = 0;
+    try {
+        for (int (*subtest)() : {subtest_001, subtest_002}) {
+            status = subtest();
+            if (status != 0) {
+                break;
+            }
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        status = 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
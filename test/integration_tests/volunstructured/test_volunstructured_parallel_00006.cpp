@@ -0,0 +1,229 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2021 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+/*!
+* Evaluate the rank that owns the specified block of the grid.
+*
+* \param block is the index of the block along the x direction
+* \param nBlocks is the number of blocks along the x direction
+* \param nProcs is the number of processes
+* \result The rank that owns the specified block.
+*/
+int evalBlockRank(int block, int nBlocks, int nProcs)
+{
+    return std::min(nProcs - 1, block * nProcs / nBlocks);
+}
+
+/*!
+* Subtest 001
+*
+* Testing global point location on a partitioned 2D patch made of
+* non-convex polygons.
+*
+* The unit squares of the grid are grouped in blocks of 3x2 squares, each
+* block contains a U-shaped polygon and two triangles that fill the notch
+* of the polygon.
+*
+* \param rank is the rank of the process
+* \param nProcs is the number of processes
+*/
+int subtest_001(int rank, int nProcs)
+{
+    const int N_BLOCKS_X = 6;
+    const int N_BLOCKS_Y = 3;
+    const int N_CELLS_X  = 3 * N_BLOCKS_X;
+    const int N_CELLS_Y  = 2 * N_BLOCKS_Y;
+
+    log::cout() << "Testing global point location on a partitioned patch" << std::endl;
+
+    // Create the patch
+    std::unique_ptr<VolUnstructured> patch(new VolUnstructured(2, MPI_COMM_WORLD));
+    patch->setVertexAutoIndexing(false);
+
+    auto vertexId = [N_CELLS_X](int i, int j) -> long {
+        return static_cast<long>(j) * (N_CELLS_X + 1) + i;
+    };
+
+    std::unordered_map<long, int> cellRanks;
+    if (rank == 0) {
+        for (int j = 0; j <= N_CELLS_Y; ++j) {
+            for (int i = 0; i <= N_CELLS_X; ++i) {
+                patch->addVertex({{double(i), double(j), 0.}}, vertexId(i, j));
+            }
+        }
+
+        for (int J = 0; J < N_BLOCKS_Y; ++J) {
+            for (int I = 0; I < N_BLOCKS_X; ++I) {
+                int i = 3 * I;
+                int j = 2 * J;
+
+                std::vector<long> polygonConnect = {12,
+                    vertexId(i,     j), vertexId(i + 1, j),     vertexId(i + 2, j),     vertexId(i + 3, j),
+                    vertexId(i + 3, j + 1), vertexId(i + 3, j + 2), vertexId(i + 2, j + 2), vertexId(i + 2, j + 1),
+                    vertexId(i + 1, j + 1), vertexId(i + 1, j + 2), vertexId(i,     j + 2), vertexId(i,     j + 1)
+                };
+
+                int blockRank = evalBlockRank(I, N_BLOCKS_X, nProcs);
+                cellRanks[patch->addCell(ElementType::POLYGON, polygonConnect).getId()] = blockRank;
+                cellRanks[patch->addCell(ElementType::TRIANGLE, std::vector<long>{vertexId(i + 1, j + 1), vertexId(i + 2, j + 1), vertexId(i + 2, j + 2)}).getId()] = blockRank;
+                cellRanks[patch->addCell(ElementType::TRIANGLE, std::vector<long>{vertexId(i + 1, j + 1), vertexId(i + 2, j + 2), vertexId(i + 1, j + 2)}).getId()] = blockRank;
+            }
+        }
+    }
+
+    patch->initializeAdjacencies();
+
+    // Partition the patch
+    patch->partition(cellRanks, true, true);
+
+    log::cout() << " Internal cell count: " << patch->getInternalCellCount() << std::endl;
+    log::cout() << " Ghost cell count:    " << patch->getGhostCellCount() << std::endl;
+
+    // Generate the points
+    //
+    // All the processes generate the same points, but each process looks
+    // for a different subset of them. The last process doesn't look for
+    // any point.
+    const int N_POINTS = 1000;
+
+    std::srand(1);
+
+    std::vector<std::array<double, 3>> points(N_POINTS);
+    for (std::array<double, 3> &point : points) {
+        point[0] = (N_CELLS_X + 2.) * (double(std::rand()) / RAND_MAX) - 1.;
+        point[1] = (N_CELLS_Y + 2.) * (double(std::rand()) / RAND_MAX) - 1.;
+        point[2] = 0.;
+    }
+
+    std::vector<int> localIndexes;
+    for (int n = 0; n < N_POINTS; ++n) {
+        if (nProcs == 1 || n % (nProcs - 1) == rank) {
+            localIndexes.push_back(n);
+        }
+    }
+
+    std::vector<std::array<double, 3>> localPoints;
+    for (int n : localIndexes) {
+        localPoints.push_back(points[n]);
+    }
+
+    // Locate the points
+    log::cout() << " Locating " << localPoints.size() << " points..." << std::endl;
+
+    int nLocalPoints = localPoints.size();
+    std::vector<long> localIds(nLocalPoints);
+    std::vector<int> localRanks(nLocalPoints);
+    patch->locateGlobalPoint(nLocalPoints, localPoints.data(), localIds.data(), localRanks.data());
+
+    // Gather the results
+    std::vector<long> ids(N_POINTS, 0);
+    std::vector<int> ranks(N_POINTS, 0);
+    for (int k = 0; k < nLocalPoints; ++k) {
+        ids[localIndexes[k]]   = localIds[k];
+        ranks[localIndexes[k]] = localRanks[k];
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, ids.data(), N_POINTS, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, ranks.data(), N_POINTS, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    // Check the results
+    log::cout() << " Checking the location of the points..." << std::endl;
+
+    for (int n = 0; n < N_POINTS; ++n) {
+        const std::array<double, 3> &point = points[n];
+
+        int expectedRank = -1;
+        if (point[0] >= 0. && point[0] < N_CELLS_X && point[1] >= 0. && point[1] < N_CELLS_Y) {
+            expectedRank = evalBlockRank(static_cast<int>(std::floor(point[0])) / 3, N_BLOCKS_X, nProcs);
+        }
+
+        if (ranks[n] != expectedRank) {
+            log::cout() << "   Point " << point << " has been located on rank " << ranks[n] << std::endl;
+            return 1;
+        }
+
+        if (expectedRank < 0) {
+            if (ids[n] != Cell::NULL_ID) {
+                log::cout() << "   Point " << point << " should be outside the patch" << std::endl;
+                return 1;
+            }
+        } else if (expectedRank == rank) {
+            if (!patch->getCells().exists(ids[n]) || !patch->getCell(ids[n]).isInterior()) {
+                log::cout() << "   Point " << point << " has not been located in an interior cell" << std::endl;
+                return 1;
+            }
+
+            if (!patch->isPointInside(ids[n], point) || patch->locatePoint(point) != ids[n]) {
+                log::cout() << "   Point " << point << " has been located in the wrong cell" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Initialize the logger
+    log::manager().initialize(log::MODE_SEPARATE, false, nProcs, rank);
+    log::cout() << log::fileVerbosity(log::LEVEL_INFO);
+    log::cout() << log::disableConsole();
+
+    // Run the subtests
+    int status;
+    try {
+        status = subtest_001(rank, nProcs);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+
+    return status;
+}